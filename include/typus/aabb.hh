@@ -0,0 +1,142 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_AABB_HH
+#define TYPUS_AABB_HH
+
+#include <algorithm>
+#include <limits>
+#include <ostream>
+
+#include <typus/vec3.hh>
+
+namespace typus {
+
+/**
+ * \brief Axis-aligned bounding box. 
+ *
+ * A default-constructed box is empty, with min at +infinity and max at 
+ * -infinity, so extending it by a point yields a box containing just that 
+ * point.
+ */
+template <typename T>
+struct aabb {
+    aabb(): min(std::numeric_limits<T>::infinity(), 
+                std::numeric_limits<T>::infinity(), 
+                std::numeric_limits<T>::infinity()),
+            max(-std::numeric_limits<T>::infinity(), 
+                -std::numeric_limits<T>::infinity(), 
+                -std::numeric_limits<T>::infinity()) {
+    }
+
+    aabb(const vec3<T> &pmin, const vec3<T> &pmax): min(pmin), max(pmax) {
+    }
+
+    bool empty() const {
+        return min.x > max.x || min.y > max.y || min.z > max.z;
+    }
+
+    aabb &extend(const vec3<T> &p) {
+        min = vec3<T>(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+        max = vec3<T>(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+        return *this;
+    }
+
+    aabb &extend(const aabb &rhs) {
+        min = vec3<T>(std::min(min.x, rhs.min.x), std::min(min.y, rhs.min.y), 
+                      std::min(min.z, rhs.min.z));
+        max = vec3<T>(std::max(max.x, rhs.max.x), std::max(max.y, rhs.max.y), 
+                      std::max(max.z, rhs.max.z));
+        return *this;
+    }
+
+    vec3<T> center() const {
+        return (min + max) * T(0.5);
+    }
+
+    vec3<T> extent() const {
+        return max - min;
+    }
+
+    /**
+     * \brief The surface area, used as the probability of a ray hitting the 
+     *     box by the surface area heuristic. Zero for empty boxes.
+     */
+    T surface_area() const {
+        if (this->empty()) {
+            return T(0);
+        }
+        vec3<T> e = this->extent();
+        return T(2) * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+
+    bool contains(const vec3<T> &p) const {
+        return p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y &&
+               p.z >= min.z && p.z <= max.z;
+    }
+
+    bool overlaps(const aabb &rhs) const {
+        return min.x <= rhs.max.x && max.x >= rhs.min.x && 
+               min.y <= rhs.max.y && max.y >= rhs.min.y &&
+               min.z <= rhs.max.z && max.z >= rhs.min.z;
+    }
+
+    /**
+     * \brief Slab test of the ray origin + t * dir for t in [t_min, t_max], 
+     *     given the component-wise reciprocal of dir. On a hit, t_min and 
+     *     t_max are narrowed to the entry and exit distances.
+     */
+    bool intersect(const vec3<T> &origin, const vec3<T> &inv_dir, 
+                   T &t_min, T &t_max) const {
+        T tx0 = (min.x - origin.x) * inv_dir.x, tx1 = (max.x - origin.x) * inv_dir.x;
+        T ty0 = (min.y - origin.y) * inv_dir.y, ty1 = (max.y - origin.y) * inv_dir.y;
+        T tz0 = (min.z - origin.z) * inv_dir.z, tz1 = (max.z - origin.z) * inv_dir.z;
+        T t0 = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), 
+                        std::max(std::min(tz0, tz1), t_min));
+        T t1 = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), 
+                        std::min(std::max(tz0, tz1), t_max));
+        if (t0 > t1) {
+            return false;
+        }
+        t_min = t0;
+        t_max = t1;
+        return true;
+    }
+
+    vec3<T> min;
+    vec3<T> max;
+};
+
+template <typename T>
+bool operator == (const aabb<T> &lhs, const aabb<T> &rhs) {
+    return lhs.min == rhs.min && lhs.max == rhs.max;
+}
+
+template <typename T>
+bool operator != (const aabb<T> &lhs, const aabb<T> &rhs) {
+    return !operator==(lhs, rhs);
+}
+
+template <typename T>
+std::ostream &operator <<(std::ostream &s, const aabb<T> &b) {
+    return (s << "{" << b.min << ", " << b.max << "}");
+}
+
+using aabb_f = aabb<f32>;
+
+} // namespace
+
+#endif // TYPUS_AABB_HH
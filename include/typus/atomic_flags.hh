@@ -0,0 +1,236 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_ATOMIC_FLAGS_HH
+#define TYPUS_ATOMIC_FLAGS_HH
+
+#include <atomic>
+
+#include "flags.hh"
+
+
+namespace typus {
+
+/**
+ * \brief Lock-free flags<E> that can be modified concurrently from multiple 
+ *     threads.
+ *
+ * All read-modify-write operations map to a single atomic instruction (or 
+ * compare-exchange loop where the hardware lacks one) on the underlying 
+ * integer type of E. Every operation takes an optional memory order that 
+ * defaults to std::memory_order_seq_cst, like std::atomic.
+ *
+ * \code
+ * atomic_flags<State> state;
+ * // connection thread
+ * state.set(State::Connected, std::memory_order_release);
+ * // any other thread
+ * if (state.test(State::Connected, std::memory_order_acquire)) { ... }
+ * \endcode
+ */
+template <typename E>
+class atomic_flags {
+public:
+    using flag_storage_type = typename flags<E>::flag_storage_type;
+
+    /**
+     * \brief Construct new atomic flags without any bits set.
+     */
+    atomic_flags(): bits_(0) {}
+
+    explicit atomic_flags(flags<E> value): bits_(value.bits()) {}
+
+    explicit atomic_flags(E value): bits_(details::to_bits(value)) {}
+
+    atomic_flags(const atomic_flags<E> &) = delete;
+    atomic_flags<E> &operator=(const atomic_flags<E> &) = delete;
+
+    /**
+     * \brief Atomically read the current flags.
+     */
+    flags<E> load(std::memory_order order = std::memory_order_seq_cst) const {
+        return flags<E>::from_bits(bits_.load(order));
+    }
+
+    /**
+     * \brief Atomically replace the current flags with \p value.
+     */
+    void store(flags<E> value, 
+               std::memory_order order = std::memory_order_seq_cst) {
+        bits_.store(value.bits(), order);
+    }
+
+    /**
+     * \brief Atomically replace the current flags with \p value and return 
+     *     the previous flags.
+     */
+    flags<E> exchange(flags<E> value, 
+                      std::memory_order order = std::memory_order_seq_cst) {
+        return flags<E>::from_bits(bits_.exchange(value.bits(), order));
+    }
+
+    /**
+     * \brief Set the bits of \p value, leaving all other bits untouched.
+     */
+    void set(E value, std::memory_order order = std::memory_order_seq_cst) {
+        bits_.fetch_or(details::to_bits(value), order);
+    }
+
+    void set(flags<E> value, 
+             std::memory_order order = std::memory_order_seq_cst) {
+        bits_.fetch_or(value.bits(), order);
+    }
+
+    /**
+     * \brief Clear the bits of \p value, leaving all other bits untouched.
+     */
+    void clear(E value, std::memory_order order = std::memory_order_seq_cst) {
+        bits_.fetch_and(static_cast<flag_storage_type>(~details::to_bits(value)), 
+                        order);
+    }
+
+    void clear(flags<E> value, 
+               std::memory_order order = std::memory_order_seq_cst) {
+        bits_.fetch_and(static_cast<flag_storage_type>(~value.bits()), order);
+    }
+
+    /**
+     * \brief Sets all bits to zero.
+     */
+    void clear_all(std::memory_order order = std::memory_order_seq_cst) {
+        bits_.store(0, order);
+    }
+
+    /**
+     * \brief Test whether all bits of \p value are set.
+     */
+    bool test(E value, 
+              std::memory_order order = std::memory_order_seq_cst) const {
+        return this->load(order).is_set(value);
+    }
+
+    /**
+     * \brief Set the bits of \p value and return whether they were all set 
+     *     before.
+     *
+     * Exactly one of several threads racing to set the same single-bit flag
+     * observes false, which makes this suitable for one-time initialization
+     * or claiming ownership.
+     */
+    bool test_and_set(E value, 
+                      std::memory_order order = std::memory_order_seq_cst) {
+        return this->fetch_or(value, order).is_set(value);
+    }
+
+    /**
+     * \brief Atomically OR \p value into the flags, returning the previous
+     *     flags.
+     */
+    flags<E> fetch_or(E value, 
+                      std::memory_order order = std::memory_order_seq_cst) {
+        return flags<E>::from_bits(bits_.fetch_or(details::to_bits(value), 
+                                                  order));
+    }
+
+    flags<E> fetch_or(flags<E> value, 
+                      std::memory_order order = std::memory_order_seq_cst) {
+        return flags<E>::from_bits(bits_.fetch_or(value.bits(), order));
+    }
+
+    /**
+     * \brief Atomically AND \p value into the flags, returning the previous 
+     *     flags.
+     */
+    flags<E> fetch_and(E value, 
+                       std::memory_order order = std::memory_order_seq_cst) {
+        return flags<E>::from_bits(bits_.fetch_and(details::to_bits(value), 
+                                                   order));
+    }
+
+    flags<E> fetch_and(flags<E> value, 
+                       std::memory_order order = std::memory_order_seq_cst) {
+        return flags<E>::from_bits(bits_.fetch_and(value.bits(), order));
+    }
+
+    /**
+     * \brief Atomically XOR \p value into the flags, returning the previous 
+     *     flags.
+     */
+    flags<E> fetch_xor(flags<E> value, 
+                       std::memory_order order = std::memory_order_seq_cst) {
+        return flags<E>::from_bits(bits_.fetch_xor(value.bits(), order));
+    }
+
+    /**
+     * \brief Replace the flags with \p desired if they are equal to 
+     *     \p expected. 
+     * 
+     * On failure, \p expected is updated to the current flags. Like 
+     * std::atomic::compare_exchange_weak, this may fail spuriously and is 
+     * meant to be called in a loop.
+     */
+    bool compare_exchange_weak(flags<E> &expected, flags<E> desired,
+                               std::memory_order success,
+                               std::memory_order failure) {
+        flag_storage_type bits = expected.bits();
+        bool rv = bits_.compare_exchange_weak(bits, desired.bits(), 
+                                              success, failure);
+        expected = flags<E>::from_bits(bits);
+        return rv;
+    }
+
+    bool compare_exchange_weak(flags<E> &expected, flags<E> desired,
+                               std::memory_order order = std::memory_order_seq_cst) {
+        flag_storage_type bits = expected.bits();
+        bool rv = bits_.compare_exchange_weak(bits, desired.bits(), order);
+        expected = flags<E>::from_bits(bits);
+        return rv;
+    }
+
+    /**
+     * \brief Like \ref compare_exchange_weak, but never fails spuriously.
+     */
+    bool compare_exchange_strong(flags<E> &expected, flags<E> desired,
+                                 std::memory_order success,
+                                 std::memory_order failure) {
+        flag_storage_type bits = expected.bits();
+        bool rv = bits_.compare_exchange_strong(bits, desired.bits(), 
+                                                success, failure);
+        expected = flags<E>::from_bits(bits);
+        return rv;
+    }
+
+    bool compare_exchange_strong(flags<E> &expected, flags<E> desired,
+                                 std::memory_order order = std::memory_order_seq_cst) {
+        flag_storage_type bits = expected.bits();
+        bool rv = bits_.compare_exchange_strong(bits, desired.bits(), order);
+        expected = flags<E>::from_bits(bits);
+        return rv;
+    }
+
+    /**
+     * \brief Whether the operations are implemented without locks. This is 
+     *     the case for all integer widths on mainstream platforms.
+     */
+    bool is_lock_free() const {
+        return bits_.is_lock_free();
+    }
+private:
+    std::atomic<flag_storage_type> bits_;
+};
+
+}
+#endif // TYPUS_ATOMIC_FLAGS_HH
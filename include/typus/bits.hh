@@ -0,0 +1,116 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_BITS_HH
+#define TYPUS_BITS_HH
+
+#include <cstddef>
+
+#include <typus/numbers.hh>
+
+
+namespace typus {
+
+namespace detail {
+
+// steps of the portable popcount, split up to fit C++11 constexpr rules
+constexpr u64 popcount_pairs(u64 x) {
+    return x - ((x >> 1) & 0x5555555555555555ull);
+}
+
+constexpr u64 popcount_nibbles(u64 x) {
+    return (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+}
+
+constexpr u64 popcount_bytes(u64 x) {
+    return (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+}
+
+}
+
+/**
+ * \brief Number of set bits in \p x.
+ */
+constexpr u32 popcount(u64 x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<u32>(__builtin_popcountll(x));
+#else
+    return static_cast<u32>((detail::popcount_bytes(
+        detail::popcount_nibbles(detail::popcount_pairs(x))) * 
+        0x0101010101010101ull) >> 56);
+#endif
+}
+
+/**
+ * \brief \p x with all but the lowest set bit cleared. Compiles to blsi when
+ *     BMI1 is available.
+ */
+constexpr u64 lowest_bit(u64 x) {
+    return x & (~x + 1);
+}
+
+/**
+ * \brief Index of the lowest set bit of \p x.
+ *
+ * \pre x is not zero.
+ */
+constexpr u32 count_trailing_zeros(u64 x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<u32>(__builtin_ctzll(x));
+#else
+    return popcount(lowest_bit(x) - 1);
+#endif
+}
+
+/**
+ * \brief \p x with the lowest set bit cleared. Compiles to blsr when BMI1 is
+ *    available.
+ */
+constexpr u64 clear_lowest_bit(u64 x) {
+    return x & (x - 1);
+}
+
+/**
+ * \brief The number of set bits in \p x below bit \p i.
+ */
+constexpr u32 rank(u64 x, u32 i) {
+    return popcount(i >= 64 ? x : x & ((u64(1) << i) - 1));
+}
+
+/**
+ * \brief The index of the n-th (zero-based) set bit of \p x.
+ *
+ * \pre x has more than n bits set.
+ */
+constexpr u32 select(u64 x, u32 n) {
+    return n == 0 ? count_trailing_zeros(x) : select(clear_lowest_bit(x), n - 1);
+}
+
+/**
+ * \brief Invokes \p func with the index of every set bit in \p x, in 
+ *     increasing order, offset by \p base.
+ */
+template <typename F>
+inline void for_each_set_bit(u64 x, std::size_t base, F && func) {
+    while (x) {
+        func(base + count_trailing_zeros(x));
+        x = clear_lowest_bit(x);
+    }
+}
+
+} // namespace typus
+
+#endif // TYPUS_BITS_HH
@@ -0,0 +1,134 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_BLOCK_CACHE_HH
+#define TYPUS_BLOCK_CACHE_HH
+
+#include <cstddef>
+#include <new>
+
+
+namespace typus {
+
+namespace detail {
+
+// thread-local cache of fixed-size memory blocks. Blocks may be released on a
+// different thread than the one that allocated them, they then simply end up
+// in the cache of the releasing thread.
+template <std::size_t Size>
+class block_cache {
+public:
+    static void *allocate() {
+        free_list &list = local();
+        if (list.head) {
+            node *n = list.head;
+            list.head = n->next;
+            --list.count;
+            return n;
+        }
+        return ::operator new(Size);
+    }
+
+    static void deallocate(void *block) {
+        free_list &list = local();
+        if (list.count < max_cached) {
+            node *n = static_cast<node*>(block);
+            n->next = list.head;
+            list.head = n;
+            ++list.count;
+            return;
+        }
+        ::operator delete(block);
+    }
+private:
+    struct node {
+        node *next;
+    };
+
+    struct free_list {
+        node *head = nullptr;
+        std::size_t count = 0;
+
+        ~free_list() {
+            while (head) {
+                node *n = head;
+                head = n->next;
+                ::operator delete(n);
+            }
+        }
+    };
+
+    static free_list &local() {
+        static thread_local free_list list;
+        return list;
+    }
+
+    static const std::size_t max_cached = 64;
+};
+
+// size class used for pooling blocks of n bytes. Zero means the block is too
+// large to be pooled and is allocated with operator new directly.
+constexpr std::size_t pool_size_class(std::size_t n) {
+    return n <= 64 ? 64 : 
+           n <= 128 ? 128 : 
+           n <= 256 ? 256 : 
+           n <= 512 ? 512 : 
+           n <= 1024 ? 1024 : 0;
+}
+
+// allocates blocks of a size known at compile-time, going through the block
+// cache if the block is small enough.
+template <std::size_t Size, std::size_t Class=pool_size_class(Size)>
+struct pooled_allocator {
+    static void *allocate() { return block_cache<Class>::allocate(); }
+    static void deallocate(void *p) { block_cache<Class>::deallocate(p); }
+};
+
+template <std::size_t Size>
+struct pooled_allocator<Size, 0> {
+    static void *allocate() { return ::operator new(Size); }
+    static void deallocate(void *p) { ::operator delete(p); }
+};
+
+// allocate a pooled block of a size only known at runtime. The same size must
+// be passed to deallocate_block.
+inline void *allocate_block(std::size_t n) {
+    switch (pool_size_class(n)) {
+        case 64: return block_cache<64>::allocate();
+        case 128: return block_cache<128>::allocate();
+        case 256: return block_cache<256>::allocate();
+        case 512: return block_cache<512>::allocate();
+        case 1024: return block_cache<1024>::allocate();
+        default: return ::operator new(n);
+    }
+}
+
+inline void deallocate_block(void *p, std::size_t n) {
+    switch (pool_size_class(n)) {
+        case 64: block_cache<64>::deallocate(p); return;
+        case 128: block_cache<128>::deallocate(p); return;
+        case 256: block_cache<256>::deallocate(p); return;
+        case 512: block_cache<512>::deallocate(p); return;
+        case 1024: block_cache<1024>::deallocate(p); return;
+        default: ::operator delete(p); return;
+    }
+}
+
+} // namespace detail
+
+} // namespace typus
+
+#endif // TYPUS_BLOCK_CACHE_HH
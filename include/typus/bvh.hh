@@ -0,0 +1,723 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_BVH_HH
+#define TYPUS_BVH_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "aabb.hh"
+#include "assert.hh"
+#include "bits.hh"
+#include "mem_view.hh"
+#include "numbers.hh"
+#include "vec3.hh"
+
+
+namespace typus {
+
+/**
+ * \brief A ray origin + t * direction, for t in [t_min, t_max].
+ */
+template <typename T>
+struct ray {
+    ray(): t_min(0), t_max(std::numeric_limits<T>::infinity()) {}
+
+    ray(const vec3<T> &o, const vec3<T> &d, T tmin = T(0), 
+        T tmax = std::numeric_limits<T>::infinity()):
+        origin(o), direction(d), t_min(tmin), t_max(tmax) {
+    }
+
+    vec3<T> at(T t) const {
+        return origin + direction * t;
+    }
+
+    vec3<T> origin;
+    vec3<T> direction;
+    T t_min;
+    T t_max;
+};
+
+/**
+ * \brief The closest intersection of a ray with a triangle mesh. u and v are 
+ *     the barycentric coordinates of the hit point with respect to the 
+ *     second and third vertex.
+ */
+template <typename T>
+struct ray_hit {
+    u32 primitive = std::numeric_limits<u32>::max();
+    T t = std::numeric_limits<T>::infinity();
+    T u = T(0);
+    T v = T(0);
+};
+
+/**
+ * \brief A node of a \ref bvh, 32 bytes for f32.
+ *
+ * Nodes are stored in depth-first order. The left child of an interior node 
+ * directly follows its parent, offset holds the index of the right child. 
+ * For leaves, offset is the first of count consecutive primitives in 
+ * \ref bvh::primitives.
+ */
+template <typename T>
+struct bvh_node {
+    T   min[3];
+    u32 offset;
+    T   max[3];
+    u32 count;
+
+    bool is_leaf() const { return count != 0; }
+};
+
+static_assert(sizeof(bvh_node<f32>) == 32, "bvh_node<f32> must be 32 bytes");
+
+/**
+ * \brief Construction parameters of a \ref bvh.
+ */
+struct bvh_build_options {
+    // number of bins per axis for evaluating the surface area heuristic
+    u32 bins = 16;
+    // nodes with more primitives are always split, if possible
+    u32 max_leaf_size = 8;
+    // relative cost of visiting a node and intersecting a primitive
+    f32 traversal_cost = 1.0f;
+    f32 intersection_cost = 1.0f;
+};
+
+namespace detail {
+
+template <typename T>
+inline T component(const vec3<T> &v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+template <typename T>
+inline T dot3(const vec3<T> &a, const vec3<T> &b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+template <typename T>
+inline vec3<T> reciprocal(const vec3<T> &v) {
+    return vec3<T>(T(1) / v.x, T(1) / v.y, T(1) / v.z);
+}
+
+// slab test of a node against the ray. On a hit, t_entry is the distance
+// at which the ray enters the box.
+template <typename T>
+inline bool intersect_node(const bvh_node<T> &n, const vec3<T> &origin, 
+                           const vec3<T> &inv_dir, T t_min, T t_max, 
+                           T &t_entry) {
+    T tx0 = (n.min[0] - origin.x) * inv_dir.x, tx1 = (n.max[0] - origin.x) * inv_dir.x;
+    T ty0 = (n.min[1] - origin.y) * inv_dir.y, ty1 = (n.max[1] - origin.y) * inv_dir.y;
+    T tz0 = (n.min[2] - origin.z) * inv_dir.z, tz1 = (n.max[2] - origin.z) * inv_dir.z;
+    T t0 = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), 
+                    std::max(std::min(tz0, tz1), t_min));
+    T t1 = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), 
+                    std::min(std::max(tz0, tz1), t_max));
+    t_entry = t0;
+    return t0 <= t1;
+}
+
+}
+
+/**
+ * \brief Bounding volume hierarchy over primitives given by their bounding 
+ *     boxes.
+ *
+ * Built top-down with the surface area heuristic (SAH), evaluated on a fixed 
+ * number of bins per axis. The hierarchy only knows the bounds of the 
+ * primitives; the traversal functions call back for the actual 
+ * ray-primitive intersection, see \ref triangle_bvh for triangle meshes.
+ *
+ * Traversal uses a short stack of 64 entries and visits the nearer child 
+ * first, so closest-hit queries can skip subtrees beyond the closest hit 
+ * found so far.
+ */
+template <typename T>
+class bvh {
+public:
+    static constexpr u32 max_depth = 64;
+
+    /**
+     * \brief Build the hierarchy over primitives with the given bounds, 
+     *     replacing the previous contents.
+     */
+    void build(mem_view<const aabb<T>> bounds, 
+               const bvh_build_options &options = bvh_build_options());
+
+    bool empty() const { return nodes_.empty(); }
+
+    const std::vector<bvh_node<T>> &nodes() const { return nodes_; }
+
+    /**
+     * \brief Indices of the primitives in leaf order. Leaves reference 
+     *     ranges of this array.
+     */
+    const std::vector<u32> &primitives() const { return primitives_; }
+
+    /**
+     * \brief Find the closest hit along \p r.
+     *
+     * Calls intersect(slot, r, t_max) for candidate primitives, where slot 
+     * is the position in \ref primitives. It must return whether the 
+     * primitive is hit closer than t_max and, if so, lower t_max to the 
+     * distance of the hit. Returns whether any primitive was hit.
+     */
+    template <typename F>
+    bool closest_hit(const ray<T> &r, F &&intersect) const;
+
+    /**
+     * \brief Whether any primitive is hit along \p r. Stops at the first hit.
+     *
+     * intersect(slot, r, t_max) must return whether the primitive is hit at 
+     * a distance in [r.t_min, t_max].
+     */
+    template <typename F>
+    bool any_hit(const ray<T> &r, F &&intersect) const;
+
+    /**
+     * \brief Closest-hit traversal of N rays at once. 
+     *
+     * A node is visited if any of the rays hits its bounds, and leaf 
+     * primitives are only intersected with those rays. The per-node box 
+     * tests run over all N rays in a loop with a fixed trip count that is 
+     * vectorized by the compiler. Coherent rays, e.g. neighbouring camera 
+     * rays, visit mostly the same nodes, which amortizes the memory 
+     * accesses.
+     *
+     * intersect(slot, lane, rays[lane], t_max) is called like for 
+     * \ref closest_hit. Returns a bit mask of the rays with a hit.
+     */
+    template <std::size_t N, typename F>
+    u32 closest_hit(const ray<T> (&rays)[N], F &&intersect) const;
+
+    /**
+     * \brief Any-hit traversal of N rays at once. Returns a bit mask of the 
+     *     rays that hit any primitive.
+     */
+    template <std::size_t N, typename F>
+    u32 any_hit(const ray<T> (&rays)[N], F &&intersect) const;
+private:
+    struct stack_entry {
+        u32 node;
+        T   t_entry;
+    };
+
+    template <bool AnyHit, typename F>
+    bool traverse(const ray<T> &r, F &&intersect) const;
+
+    template <bool AnyHit, std::size_t N, typename F>
+    u32 traverse(const ray<T> (&rays)[N], F &&intersect) const;
+
+    u32 build_node(mem_view<const aabb<T>> bounds, u32 begin, u32 end, 
+                   u32 depth, const bvh_build_options &options);
+
+    void make_leaf(u32 index, u32 begin, u32 end) {
+        nodes_[index].offset = begin;
+        nodes_[index].count = end - begin;
+    }
+
+private:
+    std::vector<bvh_node<T>>    nodes_;
+    std::vector<u32>            primitives_;
+    // scratch space for construction
+    std::vector<vec3<T>>        centroids_;
+};
+
+template <typename T>
+constexpr u32 bvh<T>::max_depth;
+
+template <typename T>
+void bvh<T>::build(mem_view<const aabb<T>> bounds, 
+                   const bvh_build_options &options) {
+    TYPUS_REQUIRES(bounds.size() < std::numeric_limits<u32>::max());
+    TYPUS_REQUIRES(options.bins >= 2 && options.max_leaf_size >= 1);
+    const u32 n = u32(bounds.size());
+    nodes_.clear();
+    primitives_.resize(n);
+    centroids_.resize(n);
+    for (u32 i = 0; i < n; ++i) {
+        primitives_[i] = i;
+        centroids_[i] = bounds[i].center();
+    }
+    if (n == 0) {
+        return;
+    }
+    nodes_.reserve(2 * n - 1);
+    this->build_node(bounds, 0, n, 1, options);
+    centroids_.clear();
+    centroids_.shrink_to_fit();
+}
+
+template <typename T>
+u32 bvh<T>::build_node(mem_view<const aabb<T>> bounds, u32 begin, u32 end, 
+                       u32 depth, const bvh_build_options &options) {
+    const u32 index = u32(nodes_.size());
+    nodes_.emplace_back();
+    aabb<T> box, centroid_box;
+    for (u32 i = begin; i < end; ++i) {
+        box.extend(bounds[primitives_[i]]);
+        centroid_box.extend(centroids_[primitives_[i]]);
+    }
+    bvh_node<T> &node = nodes_[index];
+    node.min[0] = box.min.x; node.min[1] = box.min.y; node.min[2] = box.min.z;
+    node.max[0] = box.max.x; node.max[1] = box.max.y; node.max[2] = box.max.z;
+    const u32 count = end - begin;
+    if (count == 1 || depth >= max_depth) {
+        this->make_leaf(index, begin, end);
+        return index;
+    }
+
+    // find the split plane with the lowest SAH cost among the bin 
+    // boundaries of all axes. Costs are scaled by the parent's surface area.
+    struct bin {
+        aabb<T> box;
+        u32     count = 0;
+    };
+    const u32 num_bins = options.bins;
+    std::vector<bin> bins(num_bins);
+    std::vector<T> right_cost(num_bins);
+    T best_cost = std::numeric_limits<T>::infinity();
+    int best_axis = -1;
+    u32 best_bin = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        const T lo = detail::component(centroid_box.min, axis);
+        const T extent = detail::component(centroid_box.max, axis) - lo;
+        if (!(extent > T(0))) {
+            continue;
+        }
+        const T scale = T(num_bins) / extent;
+        std::fill(bins.begin(), bins.end(), bin());
+        for (u32 i = begin; i < end; ++i) {
+            const u32 p = primitives_[i];
+            u32 b = u32((detail::component(centroids_[p], axis) - lo) * scale);
+            b = std::min(b, num_bins - 1);
+            bins[b].box.extend(bounds[p]);
+            ++bins[b].count;
+        }
+        // right_cost[b]: cost of the primitives in bins b..num_bins-1
+        aabb<T> right_box;
+        u32 right_count = 0;
+        for (u32 b = num_bins - 1; b > 0; --b) {
+            right_box.extend(bins[b].box);
+            right_count += bins[b].count;
+            right_cost[b] = right_box.surface_area() * T(right_count);
+        }
+        aabb<T> left_box;
+        u32 left_count = 0;
+        for (u32 b = 0; b + 1 < num_bins; ++b) {
+            left_box.extend(bins[b].box);
+            left_count += bins[b].count;
+            if (left_count == 0 || left_count == count) {
+                continue;
+            }
+            const T cost = left_box.surface_area() * T(left_count) + right_cost[b + 1];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = b;
+            }
+        }
+    }
+
+    const T area = box.surface_area();
+    const T leaf_cost = T(options.intersection_cost) * T(count) * area;
+    const T split_cost = T(options.traversal_cost) * area + 
+                         T(options.intersection_cost) * best_cost;
+    u32 mid;
+    if (best_axis < 0) {
+        // all centroids coincide, no plane separates them
+        if (count <= options.max_leaf_size) {
+            this->make_leaf(index, begin, end);
+            return index;
+        }
+        mid = begin + count / 2;
+    } else {
+        if (split_cost >= leaf_cost && count <= options.max_leaf_size) {
+            this->make_leaf(index, begin, end);
+            return index;
+        }
+        const T lo = detail::component(centroid_box.min, best_axis);
+        const T scale = T(num_bins) / 
+                        (detail::component(centroid_box.max, best_axis) - lo);
+        const vec3<T> *centroids = centroids_.data();
+        u32 *split = std::partition(primitives_.data() + begin, 
+                                    primitives_.data() + end, [&](u32 p) {
+            u32 b = u32((detail::component(centroids[p], best_axis) - lo) * scale);
+            return std::min(b, num_bins - 1) <= best_bin;
+        });
+        mid = u32(split - primitives_.data());
+    }
+    this->build_node(bounds, begin, mid, depth + 1, options);
+    const u32 right = this->build_node(bounds, mid, end, depth + 1, options);
+    nodes_[index].offset = right;
+    nodes_[index].count = 0;
+    return index;
+}
+
+template <typename T>
+template <typename F>
+bool bvh<T>::closest_hit(const ray<T> &r, F &&intersect) const {
+    return this->template traverse<false>(r, intersect);
+}
+
+template <typename T>
+template <typename F>
+bool bvh<T>::any_hit(const ray<T> &r, F &&intersect) const {
+    return this->template traverse<true>(r, intersect);
+}
+
+template <typename T>
+template <bool AnyHit, typename F>
+bool bvh<T>::traverse(const ray<T> &r, F &&intersect) const {
+    if (nodes_.empty()) {
+        return false;
+    }
+    const vec3<T> inv_dir = detail::reciprocal(r.direction);
+    T t_max = r.t_max;
+    T t_entry;
+    if (!detail::intersect_node(nodes_[0], r.origin, inv_dir, r.t_min, t_max, 
+                                t_entry)) {
+        return false;
+    }
+    stack_entry stack[max_depth];
+    u32 stack_size = 0;
+    u32 index = 0;
+    bool hit = false;
+    for (;;) {
+        const bvh_node<T> &node = nodes_[index];
+        if (node.is_leaf()) {
+            for (u32 s = node.offset; s < node.offset + node.count; ++s) {
+                if (intersect(s, r, t_max)) {
+                    hit = true;
+                    if (AnyHit) {
+                        return true;
+                    }
+                }
+            }
+        } else {
+            const u32 left = index + 1, right = node.offset;
+            T t_left, t_right;
+            const bool hit_left = detail::intersect_node(nodes_[left], r.origin, 
+                inv_dir, r.t_min, t_max, t_left);
+            const bool hit_right = detail::intersect_node(nodes_[right], r.origin, 
+                inv_dir, r.t_min, t_max, t_right);
+            if (hit_left && hit_right) {
+                if (t_right < t_left) {
+                    stack[stack_size++] = stack_entry{left, t_left};
+                    index = right;
+                } else {
+                    stack[stack_size++] = stack_entry{right, t_right};
+                    index = left;
+                }
+                continue;
+            }
+            if (hit_left || hit_right) {
+                index = hit_left ? left : right;
+                continue;
+            }
+        }
+        // pop the next subtree that may still contain a closer hit
+        for (;;) {
+            if (stack_size == 0) {
+                return hit;
+            }
+            const stack_entry &top = stack[--stack_size];
+            if (top.t_entry <= t_max) {
+                index = top.node;
+                break;
+            }
+        }
+    }
+}
+
+template <typename T>
+template <std::size_t N, typename F>
+u32 bvh<T>::closest_hit(const ray<T> (&rays)[N], F &&intersect) const {
+    return this->template traverse<false>(rays, intersect);
+}
+
+template <typename T>
+template <std::size_t N, typename F>
+u32 bvh<T>::any_hit(const ray<T> (&rays)[N], F &&intersect) const {
+    return this->template traverse<true>(rays, intersect);
+}
+
+template <typename T>
+template <bool AnyHit, std::size_t N, typename F>
+u32 bvh<T>::traverse(const ray<T> (&rays)[N], F &&intersect) const {
+    static_assert(N >= 1 && N <= 32, "packets hold between 1 and 32 rays");
+    if (nodes_.empty()) {
+        return 0;
+    }
+    // structure-of-arrays copy of the rays for the vectorized box tests
+    T ox[N], oy[N], oz[N], ix[N], iy[N], iz[N], t_min[N], t_max[N];
+    for (std::size_t l = 0; l < N; ++l) {
+        ox[l] = rays[l].origin.x;
+        oy[l] = rays[l].origin.y;
+        oz[l] = rays[l].origin.z;
+        ix[l] = T(1) / rays[l].direction.x;
+        iy[l] = T(1) / rays[l].direction.y;
+        iz[l] = T(1) / rays[l].direction.z;
+        t_min[l] = rays[l].t_min;
+        t_max[l] = rays[l].t_max;
+    }
+    const u32 all_lanes = N == 32 ? ~u32(0) : (u32(1) << N) - 1;
+    u32 done = 0;
+    u32 hits = 0;
+    // the lanes hitting node n, and the closest entry distance among them
+    auto test = [&](const bvh_node<T> &n, T &nearest) -> u32 {
+        u32 mask = 0;
+        T entry = std::numeric_limits<T>::infinity();
+        for (std::size_t l = 0; l < N; ++l) {
+            T tx0 = (n.min[0] - ox[l]) * ix[l], tx1 = (n.max[0] - ox[l]) * ix[l];
+            T ty0 = (n.min[1] - oy[l]) * iy[l], ty1 = (n.max[1] - oy[l]) * iy[l];
+            T tz0 = (n.min[2] - oz[l]) * iz[l], tz1 = (n.max[2] - oz[l]) * iz[l];
+            T t0 = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), 
+                            std::max(std::min(tz0, tz1), t_min[l]));
+            T t1 = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), 
+                            std::min(std::max(tz0, tz1), t_max[l]));
+            const bool h = t0 <= t1;
+            mask |= u32(h) << l;
+            entry = std::min(entry, h ? t0 : std::numeric_limits<T>::infinity());
+        }
+        nearest = entry;
+        return mask & ~done;
+    };
+    T nearest;
+    u32 active = test(nodes_[0], nearest);
+    if (active == 0) {
+        return 0;
+    }
+    u32 stack[max_depth];
+    u32 stack_size = 0;
+    u32 index = 0;
+    for (;;) {
+        const bvh_node<T> &node = nodes_[index];
+        if (node.is_leaf()) {
+            for (u32 s = node.offset; s < node.offset + node.count; ++s) {
+                for (u32 lanes = active & ~done; lanes; lanes &= lanes - 1) {
+                    const u32 l = count_trailing_zeros(lanes);
+                    if (intersect(s, l, rays[l], t_max[l])) {
+                        hits |= u32(1) << l;
+                        if (AnyHit) {
+                            done |= u32(1) << l;
+                        }
+                    }
+                }
+            }
+            if (AnyHit && done == all_lanes) {
+                return hits;
+            }
+        } else {
+            const u32 left = index + 1, right = node.offset;
+            T t_left, t_right;
+            const u32 mask_left = test(nodes_[left], t_left);
+            const u32 mask_right = test(nodes_[right], t_right);
+            if (mask_left && mask_right) {
+                if (t_right < t_left) {
+                    stack[stack_size++] = left;
+                    index = right;
+                } else {
+                    stack[stack_size++] = right;
+                    index = left;
+                }
+                active = t_right < t_left ? mask_right : mask_left;
+                continue;
+            }
+            if (mask_left || mask_right) {
+                index = mask_left ? left : right;
+                active = mask_left | mask_right;
+                continue;
+            }
+        }
+        // the t_max of the rays may have shrunk since a node was pushed, so
+        // it is tested again
+        for (;;) {
+            if (stack_size == 0) {
+                return hits;
+            }
+            index = stack[--stack_size];
+            active = test(nodes_[index], nearest);
+            if (active) {
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * \brief Möller-Trumbore intersection of \p r with the triangle (v0, v0 + e1, 
+ *     v0 + e2). On a hit at a distance in [r.t_min, t_max], returns true and
+ *     stores the distance and barycentric coordinates.
+ */
+template <typename T>
+inline bool intersect_triangle(const ray<T> &r, const vec3<T> &v0, 
+                               const vec3<T> &e1, const vec3<T> &e2, T t_max,
+                               T &t, T &u, T &v) {
+    const vec3<T> p = cross(r.direction, e2);
+    const T det = detail::dot3(e1, p);
+    if (det == T(0)) {
+        return false;
+    }
+    const T inv_det = T(1) / det;
+    const vec3<T> s = r.origin - v0;
+    u = detail::dot3(s, p) * inv_det;
+    if (u < T(0) || u > T(1)) {
+        return false;
+    }
+    const vec3<T> q = cross(s, e1);
+    v = detail::dot3(r.direction, q) * inv_det;
+    if (v < T(0) || u + v > T(1)) {
+        return false;
+    }
+    t = detail::dot3(e2, q) * inv_det;
+    return t >= r.t_min && t <= t_max;
+}
+
+/**
+ * \brief A \ref bvh over the triangles of an indexed mesh.
+ *
+ * The triangles are copied in leaf order, as a vertex and two edges each, 
+ * so the primitives of a leaf are contiguous in memory. Hits report the 
+ * index of the triangle in the original index array.
+ */
+template <typename T>
+class triangle_bvh {
+public:
+    /**
+     * \brief Build over the triangles (indices[3 * i], indices[3 * i + 1], 
+     *     indices[3 * i + 2]) of \p vertices.
+     */
+    void build(mem_view<const vec3<T>> vertices, mem_view<const u32> indices,
+               const bvh_build_options &options = bvh_build_options()) {
+        TYPUS_REQUIRES(indices.size() % 3 == 0);
+        const std::size_t n = indices.size() / 3;
+        std::vector<aabb<T>> bounds(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            bounds[i].extend(vertices[indices[3 * i]])
+                     .extend(vertices[indices[3 * i + 1]])
+                     .extend(vertices[indices[3 * i + 2]]);
+        }
+        bvh_.build(mem_view<const aabb<T>>(bounds.data(), bounds.data() + n), 
+                   options);
+        triangles_.resize(n);
+        for (std::size_t s = 0; s < n; ++s) {
+            const u32 i = bvh_.primitives()[s];
+            const vec3<T> &v0 = vertices[indices[3 * i]];
+            triangles_[s] = triangle{v0, vertices[indices[3 * i + 1]] - v0, 
+                                     vertices[indices[3 * i + 2]] - v0};
+        }
+    }
+
+    std::size_t size() const { return triangles_.size(); }
+
+    const bvh<T> &hierarchy() const { return bvh_; }
+
+    /**
+     * \brief The closest triangle hit by \p r. Returns whether there was 
+     *     one; \p hit is only written in that case.
+     */
+    bool closest_hit(const ray<T> &r, ray_hit<T> &hit) const {
+        ray_hit<T> candidate;
+        bool found = bvh_.closest_hit(r, [&](u32 s, const ray<T> &rr, T &t_max) {
+            return this->intersect(s, rr, t_max, candidate);
+        });
+        if (found) {
+            hit = candidate;
+            hit.primitive = bvh_.primitives()[candidate.primitive];
+        }
+        return found;
+    }
+
+    /**
+     * \brief Whether \p r hits any triangle, e.g. for shadow rays.
+     */
+    bool any_hit(const ray<T> &r) const {
+        return bvh_.any_hit(r, [&](u32 s, const ray<T> &rr, T &t_max) {
+            const triangle &tri = triangles_[s];
+            T t, u, v;
+            return intersect_triangle(rr, tri.v0, tri.e1, tri.e2, t_max, t, u, v);
+        });
+    }
+
+    /**
+     * \brief Packet version of \ref closest_hit. Returns a bit mask of the 
+     *     rays with a hit, the hits of the other rays are not written.
+     */
+    template <std::size_t N>
+    u32 closest_hit(const ray<T> (&rays)[N], ray_hit<T> (&hits)[N]) const {
+        ray_hit<T> candidates[N];
+        u32 mask = bvh_.closest_hit(rays, 
+            [&](u32 s, u32 lane, const ray<T> &rr, T &t_max) {
+                return this->intersect(s, rr, t_max, candidates[lane]);
+            });
+        for (u32 lanes = mask; lanes; lanes &= lanes - 1) {
+            const u32 l = count_trailing_zeros(lanes);
+            hits[l] = candidates[l];
+            hits[l].primitive = bvh_.primitives()[candidates[l].primitive];
+        }
+        return mask;
+    }
+
+    /**
+     * \brief Packet version of \ref any_hit. Returns a bit mask of the rays
+     *     hitting any triangle.
+     */
+    template <std::size_t N>
+    u32 any_hit(const ray<T> (&rays)[N]) const {
+        return bvh_.any_hit(rays, [&](u32 s, u32, const ray<T> &rr, T &t_max) {
+            const triangle &tri = triangles_[s];
+            T t, u, v;
+            return intersect_triangle(rr, tri.v0, tri.e1, tri.e2, t_max, t, u, v);
+        });
+    }
+private:
+    struct triangle {
+        vec3<T> v0;
+        vec3<T> e1;
+        vec3<T> e2;
+    };
+
+    // on a hit, stores the slot (not yet mapped to the triangle index), 
+    // distance and barycentric coordinates in hit
+    bool intersect(u32 s, const ray<T> &r, T &t_max, ray_hit<T> &hit) const {
+        const triangle &tri = triangles_[s];
+        T t, u, v;
+        if (!intersect_triangle(r, tri.v0, tri.e1, tri.e2, t_max, t, u, v)) {
+            return false;
+        }
+        t_max = t;
+        hit.primitive = s;
+        hit.t = t;
+        hit.u = u;
+        hit.v = v;
+        return true;
+    }
+
+private:
+    bvh<T>                  bvh_;
+    std::vector<triangle>   triangles_;
+};
+
+using ray_f = ray<f32>;
+using triangle_bvh_f = triangle_bvh<f32>;
+
+}
+#endif // TYPUS_BVH_HH
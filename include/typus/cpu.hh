@@ -0,0 +1,200 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_CPU_HH
+#define TYPUS_CPU_HH
+
+#include <cstdlib>
+#include <cstring>
+
+#include <typus/numbers.hh>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   define TYPUS_HAS_CPUID 1
+#   include <cpuid.h>
+#endif
+
+namespace typus {
+
+/**
+ * \brief Instruction set extensions of the CPU we run on, as reported by 
+ *     CPUID. 
+ *
+ * AVX and AVX-512 features are only reported if the operating system saves 
+ * the wider registers on context switches, as the instructions fault 
+ * otherwise. On other architectures and compilers, all features are false.
+ */
+struct cpu_features {
+    bool sse2 = false;
+    bool sse4_1 = false;
+    bool sse4_2 = false;
+    bool popcnt = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+    bool bmi1 = false;
+    bool bmi2 = false;
+    bool avx512f = false;
+    bool avx512dq = false;
+    bool avx512bw = false;
+    bool avx512vl = false;
+};
+
+/**
+ * \brief Instruction set levels kernels are written for. 
+ *
+ * Each level includes the ones before it:
+ *
+ *  - sse2: baseline x86-64
+ *  - avx2: AVX2, FMA, F16C and BMI1/2, as on Haswell and later
+ *  - avx512: AVX-512 F, DQ, BW and VL, as on Skylake-SP and later
+ */
+enum class simd_isa {
+    scalar,
+    sse2,
+    avx2,
+    avx512
+};
+
+/**
+ * \brief Lower-case name of \p isa, as accepted by TYPUS_SIMD_ISA.
+ */
+inline const char *simd_isa_name(simd_isa isa) {
+    switch (isa) {
+        case simd_isa::sse2: return "sse2";
+        case simd_isa::avx2: return "avx2";
+        case simd_isa::avx512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+/**
+ * \brief Parse the name of a level. Returns false and leaves \p isa 
+ *     untouched if \p name isn't one.
+ */
+inline bool parse_simd_isa(const char *name, simd_isa &isa) {
+    const simd_isa all[] = { simd_isa::scalar, simd_isa::sse2, simd_isa::avx2, 
+                             simd_isa::avx512 };
+    for (simd_isa candidate : all) {
+        if (std::strcmp(name, simd_isa_name(candidate)) == 0) {
+            isa = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace detail {
+
+#if defined(TYPUS_HAS_CPUID)
+inline u64 read_xcr0() {
+    u32 eax, edx;
+    // xgetbv, spelled as bytes for assemblers that don't know it
+    __asm__ volatile(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (u64(edx) << 32) | eax;
+}
+#endif
+
+inline cpu_features detect_cpu_features() {
+    cpu_features f;
+#if defined(TYPUS_HAS_CPUID)
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return f;
+    }
+    f.sse2 = (edx >> 26) & 1;
+    f.sse4_1 = (ecx >> 19) & 1;
+    f.sse4_2 = (ecx >> 20) & 1;
+    f.popcnt = (ecx >> 23) & 1;
+    const bool osxsave = (ecx >> 27) & 1;
+    const u64 xcr0 = osxsave ? read_xcr0() : 0;
+    // XMM and YMM state, and additionally opmask and ZMM state for AVX-512
+    const bool avx_state = (xcr0 & 0x6) == 0x6;
+    const bool avx512_state = (xcr0 & 0xe6) == 0xe6;
+    f.avx = avx_state && ((ecx >> 28) & 1);
+    f.fma = f.avx && ((ecx >> 12) & 1);
+    f.f16c = f.avx && ((ecx >> 29) & 1);
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        f.bmi1 = (ebx >> 3) & 1;
+        f.avx2 = f.avx && ((ebx >> 5) & 1);
+        f.bmi2 = (ebx >> 8) & 1;
+        f.avx512f = avx512_state && ((ebx >> 16) & 1);
+        f.avx512dq = f.avx512f && ((ebx >> 17) & 1);
+        f.avx512bw = f.avx512f && ((ebx >> 30) & 1);
+        f.avx512vl = f.avx512f && ((ebx >> 31) & 1);
+    }
+#endif
+    return f;
+}
+
+inline simd_isa simd_isa_of(const cpu_features &f) {
+    if (!f.sse2) {
+        return simd_isa::scalar;
+    }
+    if (!(f.avx2 && f.fma && f.f16c && f.bmi1 && f.bmi2)) {
+        return simd_isa::sse2;
+    }
+    if (!(f.avx512f && f.avx512dq && f.avx512bw && f.avx512vl)) {
+        return simd_isa::avx2;
+    }
+    return simd_isa::avx512;
+}
+
+// The override can only lower the level: running instructions the CPU 
+// lacks would fault. Unknown names are ignored.
+inline simd_isa apply_simd_isa_override(simd_isa detected, const char *value) {
+    simd_isa requested = detected;
+    if (value && parse_simd_isa(value, requested) && requested < detected) {
+        return requested;
+    }
+    return detected;
+}
+
+} // namespace detail
+
+/**
+ * \brief Features of the CPU we run on. Detected on first use.
+ */
+inline const cpu_features &cpu() {
+    static const cpu_features features = detail::detect_cpu_features();
+    return features;
+}
+
+/**
+ * \brief The highest level the CPU supports, ignoring TYPUS_SIMD_ISA.
+ */
+inline simd_isa detected_simd_isa() {
+    return detail::simd_isa_of(cpu());
+}
+
+/**
+ * \brief The level dispatched kernels run at. 
+ *
+ * That's the highest level the CPU supports, unless the TYPUS_SIMD_ISA 
+ * environment variable names a lower one (scalar, sse2, avx2 or avx512), 
+ * e.g. to benchmark each kernel variant on one machine. The environment is 
+ * read once, on first use.
+ */
+inline simd_isa active_simd_isa() {
+    static const simd_isa isa = detail::apply_simd_isa_override(
+        detected_simd_isa(), std::getenv("TYPUS_SIMD_ISA"));
+    return isa;
+}
+
+} // namespace
+
+#endif // TYPUS_CPU_HH
@@ -0,0 +1,149 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_DISPATCH_HH
+#define TYPUS_DISPATCH_HH
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include <typus/assert.hh>
+#include <typus/cpu.hh>
+
+/**
+ * \brief Attributes compiling one function for a higher level than the rest 
+ *     of the translation unit, so all variants of a kernel can live in one 
+ *     header. Intrinsics of that level may be used in the function body, 
+ *     and GCC and clang vectorize it for the wider registers. Code under 
+ *     these attributes must only be called after checking the CPU, e.g. 
+ *     through a \ref dispatched table.
+ *
+ * TYPUS_TARGET_F16C only asks for the half-precision conversions, so kernels 
+ * using nothing else may also be called directly from code compiled for 
+ * F16C without AVX2.
+ *
+ * TYPUS_HAS_TARGET_ATTRIBUTE is defined if the attributes are supported; 
+ * otherwise only variants the whole translation unit is compiled for can 
+ * be provided.
+ */
+#if defined(TYPUS_HAS_CPUID)
+#   define TYPUS_HAS_TARGET_ATTRIBUTE 1
+#   define TYPUS_TARGET_SSE2 __attribute__((target("sse2")))
+#   define TYPUS_TARGET_AVX2 __attribute__((target("avx2,fma,f16c,bmi,bmi2")))
+#   define TYPUS_TARGET_F16C __attribute__((target("avx,f16c")))
+#   define TYPUS_TARGET_AVX512 \
+        __attribute__((target("avx2,fma,f16c,bmi,bmi2,avx512f,avx512dq,avx512bw,avx512vl")))
+#else
+#   define TYPUS_TARGET_SSE2
+#   define TYPUS_TARGET_AVX2
+#   define TYPUS_TARGET_F16C
+#   define TYPUS_TARGET_AVX512
+#endif
+
+namespace typus {
+
+/**
+ * \brief A function-pointer table holding variants of one kernel for 
+ *     different instruction set levels. 
+ *
+ * The scalar variant is required; the others are registered with add(), 
+ * either next to the kernel or from translation units compiled with 
+ * different flags. The first call resolves the table to the best variant 
+ * for \ref active_simd_isa and caches the pointer, so later calls cost one 
+ * atomic load and an indirect call. Calls are thread-safe, but add() is 
+ * not: register all variants before the table may be called concurrently, 
+ * e.g. during static initialization as below. Registering a variant after 
+ * the first call re-resolves the table.
+ *
+ *     using sum_fn = f32 (*)(const f32 *, std::size_t);
+ *     static dispatched<sum_fn> &sum_table() {
+ *         static dispatched<sum_fn> table(sum_scalar);
+ *         return table;
+ *     }
+ *     // in sum_avx2.cc, compiled with -mavx2:
+ *     static const bool registered = 
+ *         (sum_table().add(simd_isa::avx2, sum_avx2), true);
+ *
+ * This is portable function multiversioning: ifunc resolvers would save the 
+ * atomic load, but are specific to ELF and GNU toolchains.
+ */
+template <typename F>
+class dispatched {
+public:
+    explicit dispatched(F scalar): resolved_(nullptr) {
+        TYPUS_REQUIRES(scalar != nullptr);
+        for (std::size_t i = 0; i < num_levels; ++i) {
+            variants_[i] = nullptr;
+        }
+        variants_[0] = scalar;
+    }
+
+    dispatched(const dispatched &) = delete;
+    dispatched &operator=(const dispatched &) = delete;
+
+    /**
+     * \brief Register \p variant for \p isa, replacing any earlier one. 
+     *     Must not run concurrently with other calls to add(), get() or 
+     *     resolve().
+     */
+    dispatched &add(simd_isa isa, F variant) {
+        variants_[std::size_t(isa)] = variant;
+        resolved_.store(nullptr, std::memory_order_release);
+        return *this;
+    }
+
+    /**
+     * \brief The best registered variant not above \p isa. For calling a 
+     *     specific variant, e.g. in tests and benchmarks; \p isa must be 
+     *     supported by the CPU.
+     */
+    F resolve(simd_isa isa) const {
+        for (std::size_t i = std::size_t(isa); i > 0; --i) {
+            if (variants_[i]) {
+                return variants_[i];
+            }
+        }
+        return variants_[0];
+    }
+
+    /**
+     * \brief The variant for \ref active_simd_isa, resolved on first use.
+     */
+    F get() const {
+        F f = resolved_.load(std::memory_order_acquire);
+        if (!f) {
+            // racing threads resolve to the same pointer
+            f = this->resolve(active_simd_isa());
+            resolved_.store(f, std::memory_order_release);
+        }
+        return f;
+    }
+
+    template <typename... Args>
+    auto operator()(Args&&... args) const -> decltype((*this->get())(std::forward<Args>(args)...)) {
+        return (*this->get())(std::forward<Args>(args)...);
+    }
+
+private:
+    static constexpr std::size_t num_levels = std::size_t(simd_isa::avx512) + 1;
+    F variants_[num_levels];
+    mutable std::atomic<F> resolved_;
+};
+
+} // namespace
+
+#endif // TYPUS_DISPATCH_HH
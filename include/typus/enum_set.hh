@@ -0,0 +1,393 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_ENUM_SET_HH
+#define TYPUS_ENUM_SET_HH
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+
+#include "assert.hh"
+#include "bits.hh"
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#elif defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+
+
+namespace typus {
+
+namespace detail {
+
+// bitwise operations on 64-bit words, with SIMD overloads for the vector 
+// widths enabled at compile time.
+struct or_words {
+    static u64 apply(u64 a, u64 b) { return a | b; }
+#if defined(__SSE2__)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+#endif
+#if defined(__AVX2__)
+    static __m256i apply(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+#endif
+};
+
+struct and_words {
+    static u64 apply(u64 a, u64 b) { return a & b; }
+#if defined(__SSE2__)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_and_si128(a, b); }
+#endif
+#if defined(__AVX2__)
+    static __m256i apply(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+#endif
+};
+
+// a & ~b
+struct and_not_words {
+    static u64 apply(u64 a, u64 b) { return a & ~b; }
+#if defined(__SSE2__)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_andnot_si128(b, a); }
+#endif
+#if defined(__AVX2__)
+    static __m256i apply(__m256i a, __m256i b) { return _mm256_andnot_si256(b, a); }
+#endif
+};
+
+struct xor_words {
+    static u64 apply(u64 a, u64 b) { return a ^ b; }
+#if defined(__SSE2__)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_xor_si128(a, b); }
+#endif
+#if defined(__AVX2__)
+    static __m256i apply(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+#endif
+};
+
+// dst[i] = Op(dst[i], src[i]) for n words
+template <typename Op>
+inline void transform_words(u64 *dst, const u64 *src, std::size_t n) {
+    std::size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), Op::apply(a, b));
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 2 <= n; i += 2) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), Op::apply(a, b));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = Op::apply(dst[i], src[i]);
+    }
+}
+
+// whether Op(a[i], b[i]) is non-zero for any of the n words
+template <typename Op>
+inline bool any_words(const u64 *a, const u64 *b, std::size_t n) {
+    std::size_t i = 0;
+    u64 acc = 0;
+#if defined(__AVX2__)
+    __m256i acc256 = _mm256_setzero_si256();
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        acc256 = _mm256_or_si256(acc256, Op::apply(x, y));
+    }
+    acc |= !_mm256_testz_si256(acc256, acc256);
+#endif
+#if defined(__SSE2__)
+    __m128i acc128 = _mm_setzero_si128();
+    for (; i + 2 <= n; i += 2) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        acc128 = _mm_or_si128(acc128, Op::apply(x, y));
+    }
+    acc |= _mm_movemask_epi8(_mm_cmpeq_epi8(acc128, _mm_setzero_si128())) != 0xffff;
+#endif
+    for (; i < n; ++i) {
+        acc |= Op::apply(a[i], b[i]);
+    }
+    return acc != 0;
+}
+
+}
+
+/**
+ * \brief A set of enumerators of E, indexed by their value.
+ *
+ * Unlike \ref flags, the enumerators are consecutive ordinals (0, 1, 2, ...)
+ * rather than powers of two, and the set is not limited by the width of the 
+ * underlying type: it holds a bit for every value from 0 to MaxValue, 
+ * stored in an array of 64-bit words.
+ *
+ * The bulk operations (union, intersection, difference, subset and 
+ * intersection tests) process 4 words at a time with AVX2 or 2 words with 
+ * SSE2, depending on the instruction sets enabled at compile time, and 
+ * contain no data-dependent branches.
+ */
+template <typename E, E MaxValue>
+class enum_set {
+public:
+    static constexpr std::size_t bit_count = 
+        static_cast<std::size_t>(MaxValue) + 1;
+    static constexpr std::size_t word_count = (bit_count + 63) / 64;
+
+    /**
+     * \brief Construct an empty set.
+     */
+    enum_set(): words_() {}
+
+    /**
+     * \brief Construct a set containing all values of the initializer list.
+     */
+    enum_set(std::initializer_list<E> values): words_() {
+        for (E value : values) {
+            this->insert(value);
+        }
+    }
+
+    /**
+     * \brief Add \p value to the set.
+     */
+    void insert(E value) {
+        std::size_t i = ordinal(value);
+        words_[i / 64] |= u64(1) << (i % 64);
+    }
+
+    /**
+     * \brief Remove \p value from the set.
+     */
+    void erase(E value) {
+        std::size_t i = ordinal(value);
+        words_[i / 64] &= ~(u64(1) << (i % 64));
+    }
+
+    /**
+     * \brief Whether \p value is contained in the set.
+     */
+    bool contains(E value) const {
+        std::size_t i = ordinal(value);
+        return (words_[i / 64] >> (i % 64)) & 1u;
+    }
+
+    /**
+     * \brief Remove all values.
+     */
+    void clear() {
+        for (std::size_t i = 0; i < word_count; ++i) {
+            words_[i] = 0;
+        }
+    }
+
+    /**
+     * \brief The number of values in the set.
+     */
+    std::size_t count() const {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            n += popcount(words_[i]);
+        }
+        return n;
+    }
+
+    /**
+     * \brief Whether the set contains at least one value.
+     */
+    bool any() const {
+        return detail::any_words<detail::or_words>(words_, words_, word_count);
+    }
+
+    bool none() const {
+        return !this->any();
+    }
+
+    /**
+     * \brief Whether all values of this set are contained in \p rhs.
+     */
+    bool is_subset_of(const enum_set &rhs) const {
+        return !detail::any_words<detail::and_not_words>(words_, rhs.words_,
+                                                         word_count);
+    }
+
+    /**
+     * \brief Whether this set and \p rhs have at least one value in common.
+     */
+    bool intersects(const enum_set &rhs) const {
+        return detail::any_words<detail::and_words>(words_, rhs.words_, 
+                                                    word_count);
+    }
+
+    /**
+     * \brief Union
+     */
+    enum_set &operator|=(const enum_set &rhs) {
+        detail::transform_words<detail::or_words>(words_, rhs.words_, word_count);
+        return *this;
+    }
+
+    /**
+     * \brief Intersection
+     */
+    enum_set &operator&=(const enum_set &rhs) {
+        detail::transform_words<detail::and_words>(words_, rhs.words_, 
+                                                   word_count);
+        return *this;
+    }
+
+    /**
+     * \brief Difference: removes all values contained in \p rhs.
+     */
+    enum_set &operator-=(const enum_set &rhs) {
+        detail::transform_words<detail::and_not_words>(words_, rhs.words_, 
+                                                       word_count);
+        return *this;
+    }
+
+    /**
+     * \brief Symmetric difference
+     */
+    enum_set &operator^=(const enum_set &rhs) {
+        detail::transform_words<detail::xor_words>(words_, rhs.words_, 
+                                                   word_count);
+        return *this;
+    }
+
+    enum_set operator|(const enum_set &rhs) const {
+        enum_set rv(*this);
+        rv |= rhs;
+        return rv;
+    }
+
+    enum_set operator&(const enum_set &rhs) const {
+        enum_set rv(*this);
+        rv &= rhs;
+        return rv;
+    }
+
+    enum_set operator-(const enum_set &rhs) const {
+        enum_set rv(*this);
+        rv -= rhs;
+        return rv;
+    }
+
+    enum_set operator^(const enum_set &rhs) const {
+        enum_set rv(*this);
+        rv ^= rhs;
+        return rv;
+    }
+
+    bool operator==(const enum_set &rhs) const {
+        return !detail::any_words<detail::xor_words>(words_, rhs.words_, 
+                                                     word_count);
+    }
+
+    bool operator!=(const enum_set &rhs) const {
+        return !this->operator==(rhs);
+    }
+
+    /**
+     * \brief Forward iterator over the contained values in increasing order.
+     *
+     * Skips empty words and uses ctz to find the next value in a word, so 
+     * iteration cost is proportional to the number of values and words.
+     */
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = E;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const E*;
+        using reference = E;
+
+        E operator*() const {
+            return static_cast<E>(word_ * 64 + count_trailing_zeros(bits_));
+        }
+
+        iterator &operator++() {
+            bits_ = clear_lowest_bit(bits_);
+            this->skip_empty_words();
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator rv(*this);
+            ++(*this);
+            return rv;
+        }
+
+        bool operator==(const iterator &rhs) const {
+            return word_ == rhs.word_ && bits_ == rhs.bits_;
+        }
+
+        bool operator!=(const iterator &rhs) const {
+            return !this->operator==(rhs);
+        }
+    private:
+        friend class enum_set;
+
+        iterator(const u64 *words, std::size_t word): 
+            words_(words), word_(word), 
+            bits_(word < word_count ? words[word] : 0) {
+            this->skip_empty_words();
+        }
+
+        void skip_empty_words() {
+            while (bits_ == 0 && word_ < word_count) {
+                ++word_;
+                bits_ = word_ < word_count ? words_[word_] : 0;
+            }
+        }
+
+        const u64 *words_;
+        std::size_t word_;
+        u64 bits_;
+    };
+
+    iterator begin() const { return iterator(words_, 0); }
+    iterator end() const { return iterator(words_, word_count); }
+
+    /**
+     * \brief The underlying words. Bit i % 64 of word i / 64 is set when the
+     *     value with ordinal i is contained in the set.
+     */
+    const u64 *words() const { return words_; }
+private:
+    static std::size_t ordinal(E value) {
+        std::size_t i = static_cast<std::size_t>(value);
+        TYPUS_REQUIRES(i < bit_count);
+        return i;
+    }
+
+    alignas(32) u64 words_[word_count];
+};
+
+template <typename E, E MaxValue>
+constexpr std::size_t enum_set<E, MaxValue>::bit_count;
+
+template <typename E, E MaxValue>
+constexpr std::size_t enum_set<E, MaxValue>::word_count;
+
+} // namespace typus
+
+#endif // TYPUS_ENUM_SET_HH
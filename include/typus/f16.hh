@@ -0,0 +1,268 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_F16_HH
+#define TYPUS_F16_HH
+
+#include <cstring>
+#include <ostream>
+
+#include <typus/dispatch.hh>
+#include <typus/mem_view.hh>
+#include <typus/numbers.hh>
+
+#if defined(__F16C__) || defined(TYPUS_HAS_TARGET_ATTRIBUTE)
+#   include <immintrin.h>
+#   define TYPUS_HAS_F16C_KERNELS 1
+#endif
+
+namespace typus {
+
+namespace detail {
+
+inline u32 f32_bits(f32 value) {
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline f32 f32_from_bits(u32 bits) {
+    f32 value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * \brief Portable f32 to IEEE binary16 conversion, rounding to nearest even 
+ *     like the F16C instructions. NaNs stay NaNs but lose their payload.
+ */
+inline u16 f32_to_f16_bits_soft(f32 value) {
+    const u32 denorm_magic = ((127 - 15) + (23 - 10) + 1) << 23;
+    u32 f = f32_bits(value);
+    const u32 sign = (f >> 16) & 0x8000;
+    f &= 0x7fffffff;
+    u32 h;
+    if (f >= 0x47800000) {
+        // too large for a half, infinity or NaN
+        h = f > 0x7f800000 ? 0x7e00 : 0x7c00;
+    } else if (f < (113u << 23)) {
+        // the result is a subnormal or zero. Adding the magic number makes 
+        // the FPU do the rounding and shift the mantissa into place.
+        h = f32_bits(f32_from_bits(f) + f32_from_bits(denorm_magic)) - denorm_magic;
+    } else {
+        const u32 mantissa_odd = (f >> 13) & 1;
+        // rebias the exponent and round, letting carries propagate into the 
+        // exponent
+        f += (u32(15 - 127) << 23) + 0xfff;
+        f += mantissa_odd;
+        h = f >> 13;
+    }
+    return u16(h | sign);
+}
+
+inline f32 f16_bits_to_f32_soft(u16 h) {
+    const u32 shifted_exp = 0x7c00 << 13;
+    u32 f = u32(h & 0x7fff) << 13;
+    const u32 exp = f & shifted_exp;
+    f += (127 - 15) << 23;
+    if (exp == shifted_exp) {
+        // infinity or NaN
+        f += (128 - 16) << 23;
+    } else if (exp == 0) {
+        // zero or subnormal, renormalized by the FPU
+        f += 1 << 23;
+        f = f32_bits(f32_from_bits(f) - f32_from_bits(113u << 23));
+    }
+    return f32_from_bits(f | u32(h & 0x8000) << 16);
+}
+
+inline u16 f32_to_f16_bits(f32 value) {
+#if defined(__F16C__)
+    return u16(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT));
+#else
+    return f32_to_f16_bits_soft(value);
+#endif
+}
+
+inline f32 f16_bits_to_f32(u16 h) {
+#if defined(__F16C__)
+    return _cvtsh_ss(h);
+#else
+    return f16_bits_to_f32_soft(h);
+#endif
+}
+
+} // namespace detail
+
+/**
+ * \brief IEEE 754 half-precision float, a storage format for data that is 
+ *     bandwidth rather than compute bound.
+ *
+ * f16 converts implicitly from and to f32 and all arithmetic happens in f32. 
+ * With 11 significant bits, values are exact to about 3 decimal digits; the 
+ * largest finite value is 65504. Conversion uses the F16C instructions when 
+ * compiled with F16C support, and a branch-light software fallback 
+ * otherwise. Both round to nearest even.
+ */
+class f16 {
+public:
+    f16() = default;
+
+    f16(f32 value): bits_(detail::f32_to_f16_bits(value)) {
+    }
+
+    operator f32() const {
+        return detail::f16_bits_to_f32(bits_);
+    }
+
+    static f16 from_bits(u16 bits) {
+        f16 h;
+        h.bits_ = bits;
+        return h;
+    }
+
+    u16 bits() const {
+        return bits_;
+    }
+
+    f16 &operator+=(f32 rhs) { return *this = f32(*this) + rhs; }
+    f16 &operator-=(f32 rhs) { return *this = f32(*this) - rhs; }
+    f16 &operator*=(f32 rhs) { return *this = f32(*this) * rhs; }
+    f16 &operator/=(f32 rhs) { return *this = f32(*this) / rhs; }
+
+private:
+    u16 bits_ = 0;
+};
+
+static_assert(sizeof(f16) == 2, "f16 must be 16 bits wide");
+
+inline std::ostream &operator <<(std::ostream &s, f16 h) {
+    return (s << f32(h));
+}
+
+namespace detail {
+
+using f32_to_f16_fn = void (*)(const f32 *, u16 *, std::size_t);
+using f16_to_f32_fn = void (*)(const u16 *, f32 *, std::size_t);
+
+inline void f32_to_f16_scalar(const f32 *src, u16 *dst, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        dst[i] = f32_to_f16_bits(src[i]);
+    }
+}
+
+inline void f16_to_f32_scalar(const u16 *src, f32 *dst, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        dst[i] = f16_bits_to_f32(src[i]);
+    }
+}
+
+#if defined(TYPUS_HAS_F16C_KERNELS)
+// Eight at a time with F16C, which is part of the avx2 level. The kernels 
+// are compiled for F16C only, so to_f16 and to_f32 may call them directly 
+// when the translation unit is compiled for F16C but not AVX2. The tail goes 
+// through a buffer rather than the scalar conversion, which doesn't use 
+// F16C unless the whole translation unit is compiled for it.
+TYPUS_TARGET_F16C inline void f32_to_f16_f16c(const f32 *src, u16 *dst, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+    }
+    if (i < n) {
+        f32 in[8] = {};
+        u16 out[8];
+        std::memcpy(in, src + i, (n - i) * sizeof(f32));
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), h);
+        std::memcpy(dst + i, out, (n - i) * sizeof(u16));
+    }
+}
+
+TYPUS_TARGET_F16C inline void f16_to_f32_f16c(const u16 *src, f32 *dst, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+    if (i < n) {
+        u16 in[8] = {};
+        f32 out[8];
+        std::memcpy(in, src + i, (n - i) * sizeof(u16));
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        _mm256_storeu_ps(out, _mm256_cvtph_ps(h));
+        std::memcpy(dst + i, out, (n - i) * sizeof(f32));
+    }
+}
+#endif
+
+/**
+ * \brief Variants of the bulk conversions. Exposed for tests and benchmarks; 
+ *     to_f16 and to_f32 pick the variant for the CPU we run on.
+ */
+inline dispatched<f32_to_f16_fn> &f32_to_f16_kernels() {
+    static dispatched<f32_to_f16_fn> kernels(f32_to_f16_scalar);
+#if defined(TYPUS_HAS_F16C_KERNELS)
+    static const bool registered = (kernels.add(simd_isa::avx2, f32_to_f16_f16c), true);
+    (void)registered;
+#endif
+    return kernels;
+}
+
+inline dispatched<f16_to_f32_fn> &f16_to_f32_kernels() {
+    static dispatched<f16_to_f32_fn> kernels(f16_to_f32_scalar);
+#if defined(TYPUS_HAS_F16C_KERNELS)
+    static const bool registered = (kernels.add(simd_isa::avx2, f16_to_f32_f16c), true);
+    (void)registered;
+#endif
+    return kernels;
+}
+
+} // namespace detail
+
+/**
+ * \brief Convert in.size() floats to half precision, eight at a time with 
+ *     F16C. Without compiling for F16C, the F16C variant is picked at run 
+ *     time if the CPU supports it.
+ */
+inline void to_f16(mem_view<const f32> in, mem_view<f16> out) {
+    TYPUS_REQUIRES(in.size() == out.size());
+    u16 *dst = reinterpret_cast<u16*>(out.begin());
+#if defined(__F16C__)
+    detail::f32_to_f16_f16c(in.begin(), dst, in.size());
+#else
+    detail::f32_to_f16_kernels()(in.begin(), dst, in.size());
+#endif
+}
+
+/**
+ * \brief Convert in.size() halfs to single precision, eight at a time with 
+ *     F16C. Without compiling for F16C, the F16C variant is picked at run 
+ *     time if the CPU supports it.
+ */
+inline void to_f32(mem_view<const f16> in, mem_view<f32> out) {
+    TYPUS_REQUIRES(in.size() == out.size());
+    const u16 *src = reinterpret_cast<const u16*>(in.begin());
+#if defined(__F16C__)
+    detail::f16_to_f32_f16c(src, out.begin(), in.size());
+#else
+    detail::f16_to_f32_kernels()(src, out.begin(), in.size());
+#endif
+}
+
+} // namespace
+
+#endif // TYPUS_F16_HH
@@ -0,0 +1,109 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_FAST_MATH_HH
+#define TYPUS_FAST_MATH_HH
+
+#include <cmath>
+
+#include <typus/numbers.hh>
+
+#if defined(__AVX__)
+#   include <immintrin.h>
+#elif defined(__SSE__)
+#   include <xmmintrin.h>
+#endif
+
+
+namespace typus {
+
+/**
+ * \brief Approximate 1/sqrt(x). 
+ *
+ * For f32 on x86 this is the rsqrtss estimate refined with one 
+ * Newton-Raphson step, with a relative error below 1e-6 instead of the
+ * ~3.7e-4 of the estimate alone. Other types fall back to 1/std::sqrt(x).
+ */
+template <typename T>
+inline T rsqrt_fast(T x) {
+    return T(1) / std::sqrt(x);
+}
+
+#if defined(__SSE__)
+
+// y' = y * (1.5 - 0.5 * x * y * y)
+inline __m128 rsqrt_fast_ps(__m128 x) {
+    __m128 y = _mm_rsqrt_ps(x);
+    __m128 half_x = _mm_mul_ps(_mm_set1_ps(0.5f), x);
+    return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), 
+                                    _mm_mul_ps(half_x, _mm_mul_ps(y, y))));
+}
+
+inline f32 rsqrt_fast(f32 x) {
+    return _mm_cvtss_f32(rsqrt_fast_ps(_mm_set_ss(x)));
+}
+
+#endif
+
+#if defined(__AVX__)
+
+inline __m256 rsqrt_fast_ps(__m256 x) {
+    __m256 y = _mm256_rsqrt_ps(x);
+    __m256 half_x = _mm256_mul_ps(_mm256_set1_ps(0.5f), x);
+    return _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.5f), 
+                                          _mm256_mul_ps(half_x, _mm256_mul_ps(y, y))));
+}
+
+#endif
+
+/**
+ * \brief Math policy computing square roots and divisions at full precision.
+ */
+struct precise_math {
+    // 1/sqrt(x), storing sqrt(x) in root
+    template <typename T>
+    static T inverse_sqrt(T x, T &root) {
+        root = std::sqrt(x);
+        return T(1) / root;
+    }
+};
+
+/**
+ * \brief Math policy trading precision for speed, based on \ref rsqrt_fast.
+ */
+struct fast_math {
+    template <typename T>
+    static T inverse_sqrt(T x, T &root) {
+        T r = rsqrt_fast(x);
+        root = x * r;
+        return r;
+    }
+};
+
+/**
+ * \brief The policy used by normalize() and friends unless one is passed 
+ *     explicitly. Define TYPUS_FAST_MATH before including any typus header 
+ *     (or on the compiler command-line) to make \ref fast_math the default.
+ */
+#if defined(TYPUS_FAST_MATH)
+using default_math = fast_math;
+#else
+using default_math = precise_math;
+#endif
+
+} // namespace
+
+#endif // TYPUS_FAST_MATH_HH
@@ -17,15 +17,38 @@
 #ifndef TYPUS_FLAGS_HH
 #define TYPUS_FLAGS_HH
 
+#include <iterator>
 #include <type_traits>
 #include <initializer_list>
 
+#include "bits.hh"
+
 
 namespace typus {
 
 template <typename E>
 class flags;
 
+/**
+ * \brief The bits of E that correspond to valid enum values.
+ *
+ * Used by \ref flags::operator~ and \ref flags::all. Defaults to all bits of
+ * the underlying type; specialize it to restrict the mask:
+ *
+ * \code
+ * template <>
+ * struct valid_flags<Permission> : 
+ *     std::integral_constant<int, Read | Write | Execute> {};
+ * \endcode
+ */
+template <typename E>
+struct valid_flags : 
+    std::integral_constant<typename std::underlying_type<E>::type,
+                           static_cast<typename std::underlying_type<E>::type>(
+                             ~typename std::make_unsigned<
+                               typename std::underlying_type<E>::type>::type(0))> {
+};
+
 namespace details {
 
 template <typename E>
@@ -112,7 +135,26 @@ public:
     TYPUS_BOOLEAN_OP(|, const flags<E> &)
     TYPUS_BOOLEAN_OP(&, E)
     TYPUS_BOOLEAN_OP(&, const flags<E> &)
+    TYPUS_BOOLEAN_OP(^, E)
+    TYPUS_BOOLEAN_OP(^, const flags<E> &)
 
+    /**
+     * \brief The complement of these flags, restricted to the bits in 
+     *     valid_flags<E>.
+     */
+    constexpr flags<E> operator~() const {
+        return flags<E>(from_bits_tag{}, 
+                        static_cast<flag_storage_type>(~bits_ & 
+                                                       valid_flags<E>::value));
+    }
+
+    /**
+     * \brief Construct flags from raw bits, e.g. previously obtained through 
+     *     \ref bits.
+     */
+    static constexpr flags<E> from_bits(flag_storage_type bits) {
+        return flags<E>(from_bits_tag{}, bits);
+    }
 
     /**
      * \brief Access the underlying bits of this flags.
@@ -134,6 +176,115 @@ public:
     constexpr bool is_set(E value) const {
         return (bits_ & details::to_bits(value)) == details::to_bits(value);
     }
+
+    /**
+     * \brief The number of set bits.
+     */
+    constexpr u32 count() const {
+        return popcount(this->unsigned_bits());
+    }
+
+    /**
+     * \brief Whether at least one bit is set.
+     */
+    constexpr bool any() const {
+        return bits_ != 0;
+    }
+
+    /**
+     * \brief Whether no bit is set.
+     */
+    constexpr bool none() const {
+        return bits_ == 0;
+    }
+
+    /**
+     * \brief Whether all bits in valid_flags<E> are set.
+     */
+    constexpr bool all() const {
+        return (bits_ & valid_flags<E>::value) == valid_flags<E>::value;
+    }
+
+    /**
+     * \brief The number of set bits below the (single bit) \p value. 
+     *
+     * Together with \ref select, this allows to map the set flags to dense 
+     * indices, e.g. for indexing a compact array with one entry per set flag.
+     */
+    constexpr u32 rank(E value) const {
+        return typus::rank(this->unsigned_bits(), 
+                           count_trailing_zeros(to_unsigned(
+                               details::to_bits(value))));
+    }
+
+    /**
+     * \brief The n-th (zero-based) set flag.
+     *
+     * \pre More than n bits are set.
+     */
+    constexpr E select(u32 n) const {
+        return static_cast<E>(u64(1) << typus::select(this->unsigned_bits(), n));
+    }
+
+    /**
+     * \brief Forward iterator over the set bits, yielding each as an enum 
+     *     value with a single bit set, from the lowest to the highest.
+     *
+     * Every increment clears the lowest set bit, so iteration takes time 
+     * proportional to the number of set bits rather than the number of 
+     * enumerators.
+     */
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = E;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const E*;
+        using reference = E;
+
+        constexpr iterator(): bits_(0) {}
+
+        explicit constexpr iterator(u64 bits): bits_(bits) {}
+
+        E operator*() const {
+            return static_cast<E>(u64(1) << count_trailing_zeros(bits_));
+        }
+
+        iterator &operator++() {
+            bits_ = clear_lowest_bit(bits_);
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator rv(*this);
+            ++(*this);
+            return rv;
+        }
+
+        bool operator==(const iterator &rhs) const { return bits_ == rhs.bits_; }
+        bool operator!=(const iterator &rhs) const { return bits_ != rhs.bits_; }
+    private:
+        u64 bits_;
+    };
+
+    iterator begin() const { return iterator(this->unsigned_bits()); }
+    iterator end() const { return iterator(); }
+private:
+    struct from_bits_tag {};
+
+    constexpr flags(from_bits_tag, flag_storage_type bits): bits_(bits) {}
+
+    using unsigned_storage_type = 
+        typename std::make_unsigned<flag_storage_type>::type;
+
+    static constexpr u64 to_unsigned(flag_storage_type bits) {
+        return static_cast<u64>(static_cast<unsigned_storage_type>(bits));
+    }
+
+    constexpr u64 unsigned_bits() const {
+        return to_unsigned(bits_);
+    }
+
 private:
     flag_storage_type bits_;
 };
@@ -146,7 +297,12 @@ inline flags<E> operator | (E lhs, const flags<E> & rhs) {
 
 template <typename E>
 inline flags<E> operator & (E lhs, const flags<E> &rhs) {
-    return rhs | lhs;
+    return rhs & lhs;
+}
+
+template <typename E>
+inline flags<E> operator ^ (E lhs, const flags<E> &rhs) {
+    return rhs ^ lhs;
 }
 
 #undef TYPUS_BOOLEAN_OP
@@ -0,0 +1,307 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_FLAGS_COLUMN_HH
+#define TYPUS_FLAGS_COLUMN_HH
+
+#include <cstddef>
+#include <vector>
+
+#include "assert.hh"
+#include "bits.hh"
+#include "flags.hh"
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#endif
+
+
+namespace typus {
+
+/**
+ * \brief A conjunction of bit tests on flags<E>, evaluated by 
+ *     \ref flags_column.
+ *
+ * A row matches if all bits in all_of are set, none of the bits in none_of 
+ * are set and, if any_of is not empty, at least one of the bits in any_of is 
+ * set. For example, `is_set(A) && !is_set(B)` for single-bit A and B is 
+ * written as
+ *
+ * \code
+ * flags_predicate<E>().set(A).not_set(B)
+ * \endcode
+ */
+template <typename E>
+struct flags_predicate {
+    flags<E> all_of;
+    flags<E> none_of;
+    flags<E> any_of;
+
+    flags_predicate<E> &set(E value) {
+        all_of |= value;
+        return *this;
+    }
+
+    flags_predicate<E> &not_set(E value) {
+        none_of |= value;
+        return *this;
+    }
+
+    flags_predicate<E> &any_set(flags<E> values) {
+        any_of |= values;
+        return *this;
+    }
+
+    bool operator()(flags<E> value) const {
+        return (value.bits() & all_of.bits()) == all_of.bits() &&
+               (value.bits() & none_of.bits()) == 0 &&
+               (any_of.none() || (value.bits() & any_of.bits()) != 0);
+    }
+};
+
+/**
+ * \brief Column of flags<E> values, one per row, stored as bit-planes.
+ *
+ * Bit b of all rows is stored contiguously in plane b, 64 rows per word. 
+ * Evaluating a \ref flags_predicate only reads the planes of the bits the 
+ * predicate refers to, e.g. two bits per row for `is_set(A) && !is_set(B)`, 
+ * instead of the full flags value of every row, and combines them 256 rows at 
+ * a time with AVX2 when it is enabled at compile time.
+ *
+ * Planes are padded to a multiple of 4 words, the padding bits are always 
+ * zero.
+ */
+template <typename E>
+class flags_column {
+public:
+    using flag_storage_type = typename flags<E>::flag_storage_type;
+    static constexpr std::size_t plane_count = sizeof(flag_storage_type) * 8;
+
+    flags_column(): size_(0) {}
+
+    /**
+     * \brief The number of rows.
+     */
+    std::size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    /**
+     * \brief The number of 64-bit words per plane, including padding.
+     */
+    std::size_t word_count() const { return planes_[0].size(); }
+
+    void reserve(std::size_t rows) {
+        for (auto &plane : planes_) {
+            plane.reserve(padded_word_count(rows));
+        }
+    }
+
+    /**
+     * \brief Append a row.
+     */
+    void push_back(flags<E> value) {
+        if (size_ == word_count() * 64) {
+            for (auto &plane : planes_) {
+                plane.resize(padded_word_count(size_ + 1), 0);
+            }
+        }
+        const std::size_t word = size_ / 64;
+        const u64 bit = u64(1) << (size_ % 64);
+        for_each_set_bit(to_unsigned(value.bits()), 0, [&](std::size_t b) {
+            planes_[b][word] |= bit;
+        });
+        ++size_;
+    }
+
+    void push_back(E value) {
+        this->push_back(flags<E>(value));
+    }
+
+    /**
+     * \brief Replace the flags of \p row.
+     */
+    void set(std::size_t row, flags<E> value) {
+        TYPUS_REQUIRES(row < size_);
+        const std::size_t word = row / 64;
+        const u64 bit = u64(1) << (row % 64);
+        const u64 bits = to_unsigned(value.bits());
+        for (std::size_t b = 0; b < plane_count; ++b) {
+            u64 &w = planes_[b][word];
+            w = (bits >> b) & 1 ? (w | bit) : (w & ~bit);
+        }
+    }
+
+    /**
+     * \brief The flags of \p row, gathered from all planes.
+     */
+    flags<E> operator[](std::size_t row) const {
+        TYPUS_REQUIRES(row < size_);
+        const std::size_t word = row / 64;
+        const u32 shift = row % 64;
+        u64 bits = 0;
+        for (std::size_t b = 0; b < plane_count; ++b) {
+            bits |= ((planes_[b][word] >> shift) & 1) << b;
+        }
+        return flags<E>::from_bits(static_cast<flag_storage_type>(bits));
+    }
+
+    /**
+     * \brief The words of plane \p bit, one bit per row.
+     */
+    const u64 *plane(std::size_t bit) const {
+        TYPUS_REQUIRES(bit < plane_count);
+        return planes_[bit].data();
+    }
+
+    void clear() {
+        for (auto &plane : planes_) {
+            plane.clear();
+        }
+        size_ = 0;
+    }
+
+    /**
+     * \brief Evaluate \p predicate for all rows, producing a selection 
+     *     bitmap with bit (i % 64) of word (i / 64) set for matching rows i.
+     *
+     * The bitmap has \ref word_count words.
+     */
+    std::vector<u64> select(const flags_predicate<E> &predicate) const {
+        std::vector<u64> selection(this->word_count());
+        this->select(predicate, selection.data());
+        return selection;
+    }
+
+    /**
+     * \brief Like \ref select, but writes the bitmap to \p selection which 
+     *     must hold at least \ref word_count words.
+     */
+    void select(const flags_predicate<E> &predicate, u64 *selection) const;
+
+    /**
+     * \brief The indices of all rows matching \p predicate, in ascending 
+     *     order.
+     *
+     * \pre The column has less than 2^32 rows.
+     */
+    std::vector<u32> select_indices(const flags_predicate<E> &predicate) const {
+        TYPUS_REQUIRES(size_ <= u64(1) << 32);
+        std::vector<u64> selection = this->select(predicate);
+        std::vector<u32> indices;
+        for (std::size_t i = 0; i < selection.size(); ++i) {
+            for_each_set_bit(selection[i], i * 64, [&](std::size_t row) {
+                indices.push_back(static_cast<u32>(row));
+            });
+        }
+        return indices;
+    }
+
+    /**
+     * \brief The number of rows matching \p predicate.
+     */
+    std::size_t count(const flags_predicate<E> &predicate) const {
+        std::vector<u64> selection = this->select(predicate);
+        std::size_t n = 0;
+        for (u64 word : selection) {
+            n += popcount(word);
+        }
+        return n;
+    }
+private:
+    using unsigned_storage_type = 
+        typename std::make_unsigned<flag_storage_type>::type;
+
+    static u64 to_unsigned(flag_storage_type bits) {
+        return static_cast<u64>(static_cast<unsigned_storage_type>(bits));
+    }
+
+    static std::size_t padded_word_count(std::size_t rows) {
+        return (rows + 255) / 256 * 4;
+    }
+
+    void collect_planes(flags<E> value, std::vector<const u64*> &out) const {
+        for_each_set_bit(to_unsigned(value.bits()), 0, [&](std::size_t b) {
+            out.push_back(planes_[b].data());
+        });
+    }
+
+private:
+    std::vector<u64>    planes_[plane_count];
+    std::size_t         size_;
+};
+
+template <typename E>
+constexpr std::size_t flags_column<E>::plane_count;
+
+template <typename E>
+void flags_column<E>::select(const flags_predicate<E> &predicate, 
+                             u64 *selection) const {
+    std::vector<const u64*> all_of, none_of, any_of;
+    this->collect_planes(predicate.all_of, all_of);
+    this->collect_planes(predicate.none_of, none_of);
+    this->collect_planes(predicate.any_of, any_of);
+    const std::size_t words = this->word_count();
+    std::size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= words; i += 4) {
+        __m256i match = _mm256_set1_epi64x(-1);
+        for (const u64 *p : all_of) {
+            match = _mm256_and_si256(match, 
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+        }
+        for (const u64 *p : none_of) {
+            match = _mm256_andnot_si256(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)), 
+                match);
+        }
+        if (!any_of.empty()) {
+            __m256i any = _mm256_setzero_si256();
+            for (const u64 *p : any_of) {
+                any = _mm256_or_si256(any, 
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+            }
+            match = _mm256_and_si256(match, any);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(selection + i), match);
+    }
+#endif
+    for (; i < words; ++i) {
+        u64 match = ~u64(0);
+        for (const u64 *p : all_of) {
+            match &= p[i];
+        }
+        for (const u64 *p : none_of) {
+            match &= ~p[i];
+        }
+        if (!any_of.empty()) {
+            u64 any = 0;
+            for (const u64 *p : any_of) {
+                any |= p[i];
+            }
+            match &= any;
+        }
+        selection[i] = match;
+    }
+    // rows past the end would match predicates without all_of/any_of bits
+    for (std::size_t w = size_ / 64; w < words; ++w) {
+        const std::size_t first = w * 64;
+        selection[w] &= first >= size_ ? 0 : (u64(1) << (size_ - first)) - 1;
+    }
+}
+
+}
+#endif // TYPUS_FLAGS_COLUMN_HH
@@ -0,0 +1,509 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_FUTURE_HH
+#define TYPUS_FUTURE_HH
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "assert.hh"
+#include "block_cache.hh"
+#include "result.hh"
+
+
+namespace typus {
+
+template <typename T, typename E>
+class future;
+
+template <typename T, typename E>
+class promise;
+
+/**
+ * \brief Executor that runs tasks immediately on the calling thread.
+ *
+ * Executors passed to \ref future::then must provide a member function
+ * template execute(F&&) that eventually invokes the (move-only) task exactly
+ * once.
+ */
+struct inline_executor {
+    template <typename F>
+    void execute(F && task) {
+        task();
+    }
+};
+
+namespace detail {
+
+// type-erased, move-only single argument callback. Small callables are stored
+// in-place, larger ones are moved to the heap.
+template <typename Arg>
+class callback {
+public:
+    callback(): target_(nullptr), invoke_(nullptr), destroy_(nullptr) {}
+
+    callback(const callback &) = delete;
+    callback &operator=(const callback &) = delete;
+
+    ~callback() {
+        this->reset();
+    }
+
+    template <typename F>
+    void assign(F && func) {
+        using fn_type = typename std::decay<F>::type;
+        using in_place = std::integral_constant<bool,
+            sizeof(fn_type) <= sizeof(buffer_type) &&
+            alignof(fn_type) <= alignof(buffer_type)>;
+        TYPUS_REQUIRES(this->empty());
+        this->emplace<fn_type>(std::forward<F>(func), in_place{});
+        invoke_ = &callback::invoke<fn_type>;
+    }
+
+    bool empty() const { return target_ == nullptr; }
+
+    void operator()(Arg && arg) {
+        invoke_(target_, std::move(arg));
+    }
+
+    void reset() {
+        if (target_) {
+            destroy_(target_);
+            target_ = nullptr;
+        }
+    }
+private:
+    template <typename F, typename G>
+    void emplace(G && func, std::true_type) {
+        target_ = ::new (&buffer_) F(std::forward<G>(func));
+        destroy_ = &callback::destroy_in_place<F>;
+    }
+
+    template <typename F, typename G>
+    void emplace(G && func, std::false_type) {
+        target_ = new F(std::forward<G>(func));
+        destroy_ = &callback::destroy_on_heap<F>;
+    }
+
+    template <typename F>
+    static void invoke(void *target, Arg && arg) {
+        (*static_cast<F*>(target))(std::move(arg));
+    }
+
+    template <typename F>
+    static void destroy_in_place(void *target) {
+        static_cast<F*>(target)->~F();
+    }
+
+    template <typename F>
+    static void destroy_on_heap(void *target) {
+        delete static_cast<F*>(target);
+    }
+
+    using buffer_type = typename std::aligned_storage<6 * sizeof(void*),
+                                                      alignof(void*)>::type;
+    buffer_type buffer_;
+    void *target_;
+    void (*invoke_)(void *, Arg &&);
+    void (*destroy_)(void *);
+};
+
+// State shared between a promise and its future. All synchronization goes
+// through a single atomic word: the lower two bits record whether the result
+// and the continuation have been set, the remaining bits hold the reference
+// count. Whoever sets the second of the two bits runs the continuation.
+template <typename T, typename E>
+class shared_state {
+public:
+    enum : unsigned {
+        has_result = 1u,
+        has_continuation = 2u,
+        ref_one = 4u
+    };
+
+    static shared_state *create() {
+        static_assert(alignof(shared_state) <= alignof(std::max_align_t),
+                      "over-aligned results are not supported");
+        void *block = pooled_allocator<sizeof(shared_state)>::allocate();
+        return ::new (block) shared_state;
+    }
+
+    void add_ref() {
+        state_.fetch_add(ref_one, std::memory_order_relaxed);
+    }
+
+    void release() {
+        unsigned prev = state_.fetch_sub(ref_one, std::memory_order_acq_rel);
+        if ((prev & ~(ref_one - 1)) == ref_one) {
+            this->destroy(prev);
+        }
+    }
+
+    bool ready() const {
+        return (state_.load(std::memory_order_acquire) & has_result) != 0;
+    }
+
+    template <typename R>
+    void set_result(R && value) {
+        ::new (&slot_) result<T, E>(std::forward<R>(value));
+        unsigned prev = state_.fetch_or(has_result, std::memory_order_acq_rel);
+        TYPUS_REQUIRES((prev & has_result) == 0);
+        if (prev & has_continuation) {
+            this->run_continuation();
+        }
+    }
+
+    template <typename F>
+    void set_continuation(F && func) {
+        continuation_.assign(std::forward<F>(func));
+        unsigned prev = state_.fetch_or(has_continuation,
+                                        std::memory_order_acq_rel);
+        TYPUS_REQUIRES((prev & has_continuation) == 0);
+        if (prev & has_result) {
+            this->run_continuation();
+        }
+    }
+
+    result<T, E> take() {
+        TYPUS_REQUIRES(this->ready());
+        return std::move(this->stored());
+    }
+private:
+    shared_state(): state_(ref_one) {}
+
+    result<T, E> &stored() {
+        return reinterpret_cast<result<T, E>&>(slot_);
+    }
+
+    void run_continuation() {
+        continuation_(std::move(this->stored()));
+        continuation_.reset();
+    }
+
+    void destroy(unsigned state) {
+        if (state & has_result) {
+            this->stored().~result<T, E>();
+        }
+        this->~shared_state();
+        pooled_allocator<sizeof(shared_state)>::deallocate(this);
+    }
+
+    typename std::aligned_storage<sizeof(result<T, E>),
+                                  alignof(result<T, E>)>::type slot_;
+    callback<result<T, E>> continuation_;
+    std::atomic<unsigned> state_;
+};
+
+// wraps the return type of a continuation into a result, unless it already
+// is one.
+template <typename R, typename E>
+struct as_result {
+    using type = result<R, E>;
+};
+
+template <typename U, typename E>
+struct as_result<result<U, E>, E> {
+    using type = result<U, E>;
+};
+
+// task submitted to the executor once the antecedent result is available.
+template <typename F, typename T, typename E, typename U>
+struct then_task {
+    F func;
+    result<T, E> arg;
+    promise<U, E> next;
+
+    void operator()() {
+        next.set_result(func(std::move(arg)));
+    }
+};
+
+// continuation installed in the antecedent's shared state.
+template <typename F, typename X, typename T, typename E, typename U>
+struct then_continuation {
+    F func;
+    X *executor;
+    promise<U, E> next;
+
+    void operator()(result<T, E> && arg) {
+        executor->execute(then_task<F, T, E, U>{
+            std::move(func), std::move(arg), std::move(next)
+        });
+    }
+};
+
+} // namespace detail
+
+
+/**
+ * \brief Producing end of a single-shot, asynchronous result<T, E>.
+ *
+ * A promise is satisfied exactly once by one of \ref set_value,
+ * \ref set_error or \ref set_result. Satisfying the promise never blocks. If
+ * the promise is destroyed without being satisfied, the future receives
+ * result<T, E>::fail().
+ */
+template <typename T, typename E=bool>
+class promise {
+public:
+    promise():
+        state_(detail::shared_state<T, E>::create()),
+        satisfied_(false), future_retrieved_(false) {
+    }
+
+    promise(const promise &) = delete;
+    promise &operator=(const promise &) = delete;
+
+    promise(promise && rhs):
+        state_(rhs.state_), satisfied_(rhs.satisfied_),
+        future_retrieved_(rhs.future_retrieved_) {
+        rhs.state_ = nullptr;
+    }
+
+    promise &operator=(promise && rhs) {
+        if (this != &rhs) {
+            this->abandon();
+            state_ = rhs.state_;
+            satisfied_ = rhs.satisfied_;
+            future_retrieved_ = rhs.future_retrieved_;
+            rhs.state_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~promise() {
+        this->abandon();
+    }
+
+    /**
+     * \brief Obtain the future associated with this promise.
+     *
+     * \pre The future has not been retrieved before.
+     */
+    future<T, E> get_future() {
+        TYPUS_REQUIRES(state_ != nullptr && !future_retrieved_);
+        future_retrieved_ = true;
+        state_->add_ref();
+        return future<T, E>(state_);
+    }
+
+    /**
+     * \brief Satisfy the promise with a value.
+     */
+    void set_value(const T &value) {
+        this->set_result(result<T, E>(value));
+    }
+
+    /**
+     * \brief Satisfy the promise with a value through move construction.
+     */
+    void set_value(T && value) {
+        this->set_result(result<T, E>(std::move(value)));
+    }
+
+    /**
+     * \brief Satisfy the promise with an error.
+     */
+    void set_error(E error) {
+        this->set_result(result<T, E>::fail(error));
+    }
+
+    /**
+     * \brief Satisfy the promise with the given result. Runs the
+     *     continuation of the future on this thread, if one is installed.
+     *
+     * \pre The promise has not been satisfied before.
+     */
+    void set_result(result<T, E> value) {
+        TYPUS_REQUIRES(state_ != nullptr && !satisfied_);
+        satisfied_ = true;
+        state_->set_result(std::move(value));
+    }
+private:
+    void abandon() {
+        if (!state_) {
+            return;
+        }
+        if (!satisfied_) {
+            state_->set_result(result<T, E>::fail());
+        }
+        state_->release();
+        state_ = nullptr;
+    }
+
+    detail::shared_state<T, E> *state_;
+    bool satisfied_;
+    bool future_retrieved_;
+};
+
+
+/**
+ * \brief Consuming end of a single-shot, asynchronous result<T, E>.
+ *
+ * The result can either be retrieved with \ref get, or be handed to a
+ * continuation with \ref then. Both consume the future.
+ */
+template <typename T, typename E=bool>
+class future {
+public:
+    typedef T value_type;
+    typedef E error_type;
+
+    template <typename F>
+    using continuation_result =
+        typename detail::as_result<
+            typename std::result_of<F(result<T, E>)>::type, E>::type;
+
+    /**
+     * \brief Construct a future without associated state.
+     */
+    future(): state_(nullptr) {}
+
+    future(const future &) = delete;
+    future &operator=(const future &) = delete;
+
+    future(future && rhs): state_(rhs.state_) {
+        rhs.state_ = nullptr;
+    }
+
+    future &operator=(future && rhs) {
+        if (this != &rhs) {
+            this->reset();
+            state_ = rhs.state_;
+            rhs.state_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~future() {
+        this->reset();
+    }
+
+    /**
+     * \brief Whether the future refers to a shared state.
+     */
+    bool valid() const { return state_ != nullptr; }
+
+    /**
+     * \brief Whether the result is available. Never blocks.
+     */
+    bool ready() const {
+        TYPUS_REQUIRES(this->valid());
+        return state_->ready();
+    }
+
+    /**
+     * \brief Busy-waits until the result is available.
+     *
+     * Spins for a short while before yielding to other threads, which keeps
+     * hand-off latency low when the producer is about to finish.
+     */
+    void wait() const {
+        TYPUS_REQUIRES(this->valid());
+        for (int i = 0; i < 1024; ++i) {
+            if (state_->ready()) {
+                return;
+            }
+        }
+        while (!state_->ready()) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * \brief Wait for and extract the result.
+     *
+     * \post The future is no longer valid.
+     */
+    result<T, E> get() {
+        this->wait();
+        result<T, E> value = state_->take();
+        this->reset();
+        return value;
+    }
+
+    /**
+     * \brief Attach a continuation that is run inline, either on the thread
+     *     that satisfies the promise or, if the result is already available,
+     *     on the calling thread.
+     *
+     * \p func is invoked with result<T, E>&& and may either return a
+     * result<U, E> or a plain U.
+     *
+     * \post The future is no longer valid.
+     */
+    template <typename F>
+    future<typename continuation_result<F>::value_type, E> then(F && func) {
+        static inline_executor executor;
+        return this->then(executor, std::forward<F>(func));
+    }
+
+    /**
+     * \brief Attach a continuation that is submitted to \p executor once the
+     *    result is available.
+     *
+     * The executor must outlive the completion of this future.
+     *
+     * \post The future is no longer valid.
+     */
+    template <typename X, typename F>
+    future<typename continuation_result<F>::value_type, E>
+    then(X & executor, F && func) {
+        using U = typename continuation_result<F>::value_type;
+        using fn_type = typename std::decay<F>::type;
+        TYPUS_REQUIRES(this->valid());
+        promise<U, E> next;
+        future<U, E> next_future = next.get_future();
+        state_->set_continuation(
+            detail::then_continuation<fn_type, X, T, E, U>{
+                std::forward<F>(func), &executor, std::move(next)
+        });
+        this->reset();
+        return next_future;
+    }
+private:
+    friend class promise<T, E>;
+
+    explicit future(detail::shared_state<T, E> *state): state_(state) {}
+
+    void reset() {
+        if (state_) {
+            state_->release();
+            state_ = nullptr;
+        }
+    }
+
+    detail::shared_state<T, E> *state_;
+};
+
+/**
+ * \brief Create a future that is already satisfied with \p value.
+ */
+template <typename T, typename E=bool>
+future<T, E> make_ready_future(result<T, E> value) {
+    promise<T, E> p;
+    future<T, E> f = p.get_future();
+    p.set_result(std::move(value));
+    return f;
+}
+
+} // namespace typus
+
+#endif // TYPUS_FUTURE_HH
@@ -0,0 +1,275 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_MATRIX_HH
+#define TYPUS_MATRIX_HH
+
+#include <cmath>
+#include <ostream>
+
+#include <typus/numbers.hh>
+#include <typus/vec3.hh>
+
+namespace typus {
+
+/**
+ * \brief Row-major 3x3 matrix, e.g. a rotation or scale. 
+ *
+ * Vectors are column vectors, so m * v transforms v, and (a * b) * v 
+ * applies b first.
+ */
+template <typename T>
+struct mat3 {
+    /**
+     * \brief The identity.
+     */
+    mat3(): m{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}} {
+    }
+
+    mat3(T m00, T m01, T m02, T m10, T m11, T m12, T m20, T m21, T m22): 
+        m{{m00, m01, m02}, {m10, m11, m12}, {m20, m21, m22}} {
+    }
+
+    static mat3 identity() {
+        return mat3();
+    }
+
+    static mat3 scale(const vec3<T> &s) {
+        return mat3(s.x, 0, 0, 0, s.y, 0, 0, 0, s.z);
+    }
+
+    /**
+     * \brief Rotation by \p angle radians around the unit vector \p axis, 
+     *     counter-clockwise when looking down the axis.
+     */
+    static mat3 rotation(const vec3<T> &axis, T angle) {
+        const T c = std::cos(angle), s = std::sin(angle), t = 1 - c;
+        const T x = axis.x, y = axis.y, z = axis.z;
+        return mat3(t * x * x + c,     t * x * y - s * z, t * x * z + s * y,
+                    t * x * y + s * z, t * y * y + c,     t * y * z - s * x,
+                    t * x * z - s * y, t * y * z + s * x, t * z * z + c);
+    }
+
+    T &operator()(std::size_t row, std::size_t col) {
+        return m[row][col];
+    }
+
+    T operator()(std::size_t row, std::size_t col) const {
+        return m[row][col];
+    }
+
+    vec3<T> row(std::size_t r) const {
+        return vec3<T>(m[r][0], m[r][1], m[r][2]);
+    }
+
+    vec3<T> col(std::size_t c) const {
+        return vec3<T>(m[0][c], m[1][c], m[2][c]);
+    }
+
+    vec3<T> operator*(const vec3<T> &v) const {
+        return vec3<T>(m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+                       m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+                       m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+    }
+
+    mat3 operator*(const mat3 &rhs) const {
+        mat3 r;
+        for (std::size_t i = 0; i < 3; ++i) {
+            for (std::size_t j = 0; j < 3; ++j) {
+                r.m[i][j] = m[i][0] * rhs.m[0][j] + m[i][1] * rhs.m[1][j] + 
+                            m[i][2] * rhs.m[2][j];
+            }
+        }
+        return r;
+    }
+
+    mat3 transposed() const {
+        return mat3(m[0][0], m[1][0], m[2][0], m[0][1], m[1][1], m[2][1],
+                    m[0][2], m[1][2], m[2][2]);
+    }
+
+    T determinant() const {
+        return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+               m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+               m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    }
+
+    /**
+     * \brief The inverse, computed from the adjugate. The result is not 
+     *     finite for singular matrices. For rotations, prefer transposed().
+     */
+    mat3 inverse() const {
+        const T f = 1 / this->determinant();
+        return mat3((m[1][1] * m[2][2] - m[1][2] * m[2][1]) * f,
+                    (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * f,
+                    (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * f,
+                    (m[1][2] * m[2][0] - m[1][0] * m[2][2]) * f,
+                    (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * f,
+                    (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * f,
+                    (m[1][0] * m[2][1] - m[1][1] * m[2][0]) * f,
+                    (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * f,
+                    (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * f);
+    }
+
+    T m[3][3];
+};
+
+/**
+ * \brief Row-major 4x4 matrix for affine transforms in homogeneous 
+ *     coordinates.
+ *
+ * The upper-left 3x3 block is the linear part and the last column the 
+ * translation. The last row is kept for interoperability, but 
+ * transform_point() and transform_direction() assume it to be (0, 0, 0, 1), 
+ * i.e. there is no perspective divide.
+ */
+template <typename T>
+struct mat4 {
+    /**
+     * \brief The identity.
+     */
+    mat4(): m{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}} {
+    }
+
+    /**
+     * \brief The affine transform p -> linear * p + translation.
+     */
+    mat4(const mat3<T> &linear, const vec3<T> &translation): 
+        m{{linear.m[0][0], linear.m[0][1], linear.m[0][2], translation.x},
+          {linear.m[1][0], linear.m[1][1], linear.m[1][2], translation.y},
+          {linear.m[2][0], linear.m[2][1], linear.m[2][2], translation.z},
+          {0, 0, 0, 1}} {
+    }
+
+    static mat4 identity() {
+        return mat4();
+    }
+
+    static mat4 translation(const vec3<T> &t) {
+        return mat4(mat3<T>(), t);
+    }
+
+    T &operator()(std::size_t row, std::size_t col) {
+        return m[row][col];
+    }
+
+    T operator()(std::size_t row, std::size_t col) const {
+        return m[row][col];
+    }
+
+    mat3<T> linear() const {
+        return mat3<T>(m[0][0], m[0][1], m[0][2], m[1][0], m[1][1], m[1][2],
+                       m[2][0], m[2][1], m[2][2]);
+    }
+
+    vec3<T> translation() const {
+        return vec3<T>(m[0][3], m[1][3], m[2][3]);
+    }
+
+    vec3<T> transform_point(const vec3<T> &p) const {
+        return vec3<T>(m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+                       m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+                       m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]);
+    }
+
+    /**
+     * \brief Applies the linear part only, as appropriate for directions 
+     *     and offsets. Normals need the inverse transpose instead.
+     */
+    vec3<T> transform_direction(const vec3<T> &d) const {
+        return vec3<T>(m[0][0] * d.x + m[0][1] * d.y + m[0][2] * d.z,
+                       m[1][0] * d.x + m[1][1] * d.y + m[1][2] * d.z,
+                       m[2][0] * d.x + m[2][1] * d.y + m[2][2] * d.z);
+    }
+
+    mat4 operator*(const mat4 &rhs) const {
+        mat4 r;
+        for (std::size_t i = 0; i < 4; ++i) {
+            for (std::size_t j = 0; j < 4; ++j) {
+                r.m[i][j] = m[i][0] * rhs.m[0][j] + m[i][1] * rhs.m[1][j] + 
+                            m[i][2] * rhs.m[2][j] + m[i][3] * rhs.m[3][j];
+            }
+        }
+        return r;
+    }
+
+    /**
+     * \brief Inverse of an affine transform. 
+     */
+    mat4 affine_inverse() const {
+        const mat3<T> inv = this->linear().inverse();
+        const vec3<T> t = inv * this->translation();
+        return mat4(inv, vec3<T>(-t.x, -t.y, -t.z));
+    }
+
+    T m[4][4];
+};
+
+template <typename T>
+bool operator == (const mat3<T> &lhs, const mat3<T> &rhs) {
+    for (std::size_t i = 0; i < 3; ++i) {
+        for (std::size_t j = 0; j < 3; ++j) {
+            if (lhs.m[i][j] != rhs.m[i][j]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename T>
+bool operator != (const mat3<T> &lhs, const mat3<T> &rhs) {
+    return !operator==(lhs, rhs);
+}
+
+template <typename T>
+bool operator == (const mat4<T> &lhs, const mat4<T> &rhs) {
+    for (std::size_t i = 0; i < 4; ++i) {
+        for (std::size_t j = 0; j < 4; ++j) {
+            if (lhs.m[i][j] != rhs.m[i][j]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename T>
+bool operator != (const mat4<T> &lhs, const mat4<T> &rhs) {
+    return !operator==(lhs, rhs);
+}
+
+template <typename T>
+std::ostream &operator <<(std::ostream &s, const mat3<T> &m) {
+    return (s << "{" << m.row(0) << ", " << m.row(1) << ", " << m.row(2) << "}");
+}
+
+template <typename T>
+std::ostream &operator <<(std::ostream &s, const mat4<T> &m) {
+    s << "{";
+    for (std::size_t i = 0; i < 4; ++i) {
+        s << (i ? ", {" : "{") << m.m[i][0] << ", " << m.m[i][1] << ", " 
+          << m.m[i][2] << ", " << m.m[i][3] << "}";
+    }
+    return (s << "}");
+}
+
+using mat3_f = mat3<f32>;
+using mat4_f = mat4<f32>;
+
+} // namespace
+
+#endif // TYPUS_MATRIX_HH
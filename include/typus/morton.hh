@@ -0,0 +1,267 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_MORTON_HH
+#define TYPUS_MORTON_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "aabb.hh"
+#include "assert.hh"
+#include "mem_view.hh"
+#include "numbers.hh"
+#include "parallel.hh"
+#include "radix_sort.hh"
+#include "vec3.hh"
+
+#if defined(__BMI2__)
+#   include <immintrin.h>
+#endif
+
+
+namespace typus {
+
+/**
+ * \brief Number of bits per coordinate of 3D Morton and Hilbert codes.
+ */
+constexpr u32 morton_bits = 21;
+
+namespace detail {
+
+// inserts two zero bits above each of the lowest 21 bits of x
+inline u64 spread_bits_3(u64 x) {
+    x &= 0x1fffff;
+    x = (x | x << 32) & 0x1f00000000ffffull;
+    x = (x | x << 16) & 0x1f0000ff0000ffull;
+    x = (x | x << 8) & 0x100f00f00f00f00full;
+    x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+    x = (x | x << 2) & 0x1249249249249249ull;
+    return x;
+}
+
+// inverse of spread_bits_3
+inline u32 compact_bits_3(u64 x) {
+    x &= 0x1249249249249249ull;
+    x = (x ^ (x >> 2)) & 0x10c30c30c30c30c3ull;
+    x = (x ^ (x >> 4)) & 0x100f00f00f00f00full;
+    x = (x ^ (x >> 8)) & 0x1f0000ff0000ffull;
+    x = (x ^ (x >> 16)) & 0x1f00000000ffffull;
+    x = (x ^ (x >> 32)) & 0x1fffffull;
+    return u32(x);
+}
+
+}
+
+/**
+ * \brief Interleave the lowest 21 bits of x, y and z into a 63-bit Morton 
+ *     code, with x in the least significant position of every triple.
+ *
+ * Uses BMI2's pdep when enabled at compile time, and bit-twiddling 
+ * otherwise. Note that pdep is microcoded and slow on AMD CPUs before Zen 3;
+ * compile without -mbmi2 for those.
+ */
+inline u64 morton_encode(u32 x, u32 y, u32 z) {
+#if defined(__BMI2__)
+    return _pdep_u64(x, 0x1249249249249249ull) | 
+           _pdep_u64(y, 0x2492492492492492ull) |
+           _pdep_u64(z, 0x4924924924924924ull);
+#else
+    return detail::spread_bits_3(x) | (detail::spread_bits_3(y) << 1) | 
+           (detail::spread_bits_3(z) << 2);
+#endif
+}
+
+inline void morton_decode(u64 code, u32 &x, u32 &y, u32 &z) {
+#if defined(__BMI2__)
+    x = u32(_pext_u64(code, 0x1249249249249249ull));
+    y = u32(_pext_u64(code, 0x2492492492492492ull));
+    z = u32(_pext_u64(code, 0x4924924924924924ull));
+#else
+    x = detail::compact_bits_3(code);
+    y = detail::compact_bits_3(code >> 1);
+    z = detail::compact_bits_3(code >> 2);
+#endif
+}
+
+/**
+ * \brief Index of the 21-bit coordinates (x, y, z) along a 3D Hilbert curve.
+ *
+ * Unlike the Morton curve, consecutive Hilbert indices are always adjacent 
+ * cells, which gives somewhat better locality at a higher encoding cost. 
+ * Implements J. Skilling, "Programming the Hilbert curve" (2004).
+ */
+inline u64 hilbert_encode(u32 x, u32 y, u32 z) {
+    u32 v[3] = { x & 0x1fffff, y & 0x1fffff, z & 0x1fffff };
+    const u32 m = u32(1) << (morton_bits - 1);
+    // inverse undo
+    for (u32 q = m; q > 1; q >>= 1) {
+        const u32 p = q - 1;
+        for (int i = 0; i < 3; ++i) {
+            if (v[i] & q) {
+                v[0] ^= p;
+            } else {
+                const u32 t = (v[0] ^ v[i]) & p;
+                v[0] ^= t;
+                v[i] ^= t;
+            }
+        }
+    }
+    // gray encode
+    v[1] ^= v[0];
+    v[2] ^= v[1];
+    u32 t = 0;
+    for (u32 q = m; q > 1; q >>= 1) {
+        if (v[2] & q) {
+            t ^= q - 1;
+        }
+    }
+    v[0] ^= t;
+    v[1] ^= t;
+    v[2] ^= t;
+    // the transposed index has v[0] as the most significant bit per level
+    return morton_encode(v[2], v[1], v[0]);
+}
+
+inline void hilbert_decode(u64 index, u32 &x, u32 &y, u32 &z) {
+    u32 v[3];
+    morton_decode(index, v[2], v[1], v[0]);
+    // gray decode
+    u32 t = v[2] >> 1;
+    v[2] ^= v[1];
+    v[1] ^= v[0];
+    v[0] ^= t;
+    // undo excess work
+    for (u32 q = 2; q != (u32(1) << morton_bits); q <<= 1) {
+        const u32 p = q - 1;
+        for (int i = 2; i >= 0; --i) {
+            if (v[i] & q) {
+                v[0] ^= p;
+            } else {
+                const u32 s = (v[0] ^ v[i]) & p;
+                v[0] ^= s;
+                v[i] ^= s;
+            }
+        }
+    }
+    x = v[0];
+    y = v[1];
+    z = v[2];
+}
+
+/**
+ * \brief Maps points within bounds to the 21-bit integer grid used by the 
+ *     Morton and Hilbert encodings. Points outside are clamped.
+ */
+template <typename T>
+class morton_quantizer {
+public:
+    explicit morton_quantizer(const aabb<T> &bounds): min_(bounds.min) {
+        const T cells = T((u32(1) << morton_bits) - 1);
+        const vec3<T> e = bounds.extent();
+        scale_ = vec3<T>(e.x > T(0) ? cells / e.x : T(0), 
+                         e.y > T(0) ? cells / e.y : T(0),
+                         e.z > T(0) ? cells / e.z : T(0));
+    }
+
+    void quantize(const vec3<T> &p, u32 &x, u32 &y, u32 &z) const {
+        x = quantize((p.x - min_.x) * scale_.x);
+        y = quantize((p.y - min_.y) * scale_.y);
+        z = quantize((p.z - min_.z) * scale_.z);
+    }
+
+    u64 morton(const vec3<T> &p) const {
+        u32 x, y, z;
+        this->quantize(p, x, y, z);
+        return morton_encode(x, y, z);
+    }
+
+    u64 hilbert(const vec3<T> &p) const {
+        u32 x, y, z;
+        this->quantize(p, x, y, z);
+        return hilbert_encode(x, y, z);
+    }
+private:
+    static u32 quantize(T v) {
+        const T max = T((u32(1) << morton_bits) - 1);
+        return u32(std::min(std::max(v, T(0)), max));
+    }
+
+    vec3<T> min_;
+    vec3<T> scale_;
+};
+
+enum class space_filling_curve {
+    morton,
+    hilbert
+};
+
+/**
+ * \brief The permutation that sorts \p points along a space-filling curve 
+ *     over their bounding box: order[i] is the index of the i-th point on 
+ *     the curve.
+ *
+ * Encoding and the radix sort run on \p num_threads threads (0 for one per 
+ * hardware thread). Apply the order to the points and any attached payload 
+ * arrays with \ref apply_order.
+ */
+template <typename T>
+std::vector<u32> space_filling_order(mem_view<const vec3<T>> points, 
+                                     space_filling_curve curve = space_filling_curve::morton,
+                                     unsigned num_threads = 1) {
+    TYPUS_REQUIRES(points.size() < (u64(1) << 32));
+    const std::size_t n = points.size();
+    num_threads = thread_count_for(n, num_threads);
+    aabb<T> bounds;
+    for (const vec3<T> &p : points) {
+        bounds.extend(p);
+    }
+    const morton_quantizer<T> quantizer(bounds);
+    std::vector<u64> keys(n);
+    std::vector<u32> order(n);
+    const vec3<T> *p = points.begin();
+    parallel_for_chunks(n, num_threads, 
+                        [&](unsigned, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            keys[i] = curve == space_filling_curve::morton ? 
+                      quantizer.morton(p[i]) : quantizer.hilbert(p[i]);
+            order[i] = u32(i);
+        }
+    });
+    radix_sort_pairs(mem_view<u64>(keys.data(), keys.data() + n),
+                     mem_view<u32>(order.data(), order.data() + n), 
+                     3 * morton_bits, num_threads);
+    return order;
+}
+
+/**
+ * \brief Reorder \p data such that data[i] becomes the old data[order[i]].
+ */
+template <typename U>
+void apply_order(const std::vector<u32> &order, std::vector<U> &data) {
+    TYPUS_REQUIRES(order.size() == data.size());
+    std::vector<U> reordered;
+    reordered.reserve(data.size());
+    for (u32 i : order) {
+        reordered.push_back(data[i]);
+    }
+    data.swap(reordered);
+}
+
+} // namespace
+
+#endif // TYPUS_MORTON_HH
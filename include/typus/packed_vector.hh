@@ -0,0 +1,474 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_PACKED_VECTOR_HH
+#define TYPUS_PACKED_VECTOR_HH
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#include <typus/assert.hh>
+#include <typus/dispatch.hh>
+#include <typus/mem_view.hh>
+#include <typus/numbers.hh>
+
+#if defined(TYPUS_HAS_TARGET_ATTRIBUTE)
+#   include <immintrin.h>
+#endif
+
+namespace typus {
+
+namespace detail {
+
+// Storage ends with this many zero words past the last element, so reading 
+// the word after the one an element starts in, and the 16-byte loads of the 
+// SIMD unpack, stay inside the allocation.
+constexpr std::size_t packed_padding_words = 2;
+
+template <unsigned Bits>
+constexpr u64 packed_value_mask() {
+    return (u64(1) << Bits) - 1;
+}
+
+constexpr u64 low_bits_mask(unsigned n) {
+    return (u64(1) << n) - 1;
+}
+
+// Elements may straddle two words. The high part is shifted in two steps so 
+// the shift count stays below 64 when the element doesn't straddle, in which 
+// case it is zero.
+template <unsigned Bits>
+inline u32 packed_get(const u64 *words, std::size_t i) {
+    const std::size_t bit = i * Bits;
+    const u64 *w = words + (bit >> 6);
+    const unsigned offset = bit & 63;
+    const u64 value = (w[0] >> offset) | ((w[1] << 1) << (63 - offset));
+    return u32(value & packed_value_mask<Bits>());
+}
+
+template <unsigned Bits>
+inline void packed_set(u64 *words, std::size_t i, u32 value) {
+    const std::size_t bit = i * Bits;
+    u64 *w = words + (bit >> 6);
+    const unsigned offset = bit & 63;
+    const u64 mask = packed_value_mask<Bits>();
+    const u64 v = value & mask;
+    w[0] = (w[0] & ~(mask << offset)) | (v << offset);
+    w[1] = (w[1] & ~((mask >> 1) >> (63 - offset))) | ((v >> 1) >> (63 - offset));
+}
+
+template <unsigned Bits>
+inline void unpack_scalar(const u64 *words, std::size_t first, std::size_t n, u32 *out) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = packed_get<Bits>(words, first + i);
+    }
+}
+
+#if defined(TYPUS_HAS_TARGET_ATTRIBUTE)
+// Eight elements at a time. Eight elements start at a byte boundary and 
+// span Bits bytes. Each 128-bit half of the register gets the 16 bytes 
+// holding four of them, pshufb moves the four bytes holding each element 
+// into its lane, and a per-lane shift and mask extract it. An element and its 
+// offset into the byte must fit in 32 bits, hence at most 25 bits. The byte 
+// addressing relies on x86 being little-endian.
+template <unsigned Bits>
+TYPUS_TARGET_AVX2 inline void unpack_avx2(const u64 *words, std::size_t first, 
+                                          std::size_t n, u32 *out) {
+    static_assert(Bits <= 25, "elements must fit in 32 bits with their bit offset");
+    const std::size_t head = std::min(n, (8 - first % 8) % 8);
+    unpack_scalar<Bits>(words, first, head, out);
+    std::size_t i = head;
+    const unsigned high_byte = (4 * Bits) >> 3;
+    alignas(32) u8 control[32];
+    alignas(32) u32 shifts[8];
+    for (unsigned lane = 0; lane < 8; ++lane) {
+        const unsigned bit = lane * Bits - (lane >= 4 ? 8 * high_byte : 0);
+        shifts[lane] = bit & 7;
+        for (unsigned k = 0; k < 4; ++k) {
+            control[4 * lane + k] = u8((bit >> 3) + k);
+        }
+    }
+    const __m256i ctl = _mm256_load_si256(reinterpret_cast<const __m256i*>(control));
+    const __m256i shift = _mm256_load_si256(reinterpret_cast<const __m256i*>(shifts));
+    const __m256i mask = _mm256_set1_epi32(int(packed_value_mask<Bits>()));
+    const u8 *bytes = reinterpret_cast<const u8*>(words);
+    for (; i + 8 <= n; i += 8) {
+        const u8 *p = bytes + (((first + i) * Bits) >> 3);
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + high_byte));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        v = _mm256_shuffle_epi8(v, ctl);
+        v = _mm256_and_si256(_mm256_srlv_epi32(v, shift), mask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+    }
+    unpack_scalar<Bits>(words, first + i, n - i, out + i);
+}
+
+// The same with 64-bit lanes for wider elements, four at a time. Four 
+// elements span at most 16 bytes, and each lane gets eight bytes.
+template <unsigned Bits>
+TYPUS_TARGET_AVX2 inline void unpack_avx2_wide(const u64 *words, std::size_t first, 
+                                               std::size_t n, u32 *out) {
+    static_assert(Bits <= 32, "elements must fit in 64 bits with their bit offset");
+    std::size_t i = 0;
+    const unsigned high_byte = (2 * Bits) >> 3;
+    alignas(32) u8 control[32];
+    alignas(32) u64 shifts[4];
+    for (unsigned lane = 0; lane < 4; ++lane) {
+        const unsigned bit = lane * Bits - (lane >= 2 ? 8 * high_byte : 0);
+        shifts[lane] = bit & 7;
+        for (unsigned k = 0; k < 8; ++k) {
+            control[8 * lane + k] = u8((bit >> 3) + k);
+        }
+    }
+    const __m256i ctl = _mm256_load_si256(reinterpret_cast<const __m256i*>(control));
+    const __m256i shift = _mm256_load_si256(reinterpret_cast<const __m256i*>(shifts));
+    const __m256i mask = _mm256_set1_epi64x(i64(packed_value_mask<Bits>()));
+    // the low 32 bits of each 64-bit lane
+    const __m256i even = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    const u8 *bytes = reinterpret_cast<const u8*>(words);
+    // a block of four starts at bit (first + i) * Bits, anywhere from 0 to 7 
+    // bits into its first byte depending on first and Bits. That offset is 
+    // added to the per-lane shifts.
+    for (; i + 4 <= n; i += 4) {
+        const std::size_t bit = (first + i) * Bits;
+        const u8 *p = bytes + (bit >> 3);
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + high_byte));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        v = _mm256_shuffle_epi8(v, ctl);
+        v = _mm256_and_si256(_mm256_srlv_epi64(v, _mm256_add_epi64(shift, 
+            _mm256_set1_epi64x(i64(bit & 7)))), mask);
+        v = _mm256_permutevar8x32_epi32(v, even);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(v));
+    }
+    unpack_scalar<Bits>(words, first + i, n - i, out + i);
+}
+
+template <unsigned Bits>
+inline void add_unpack_variants(dispatched<void (*)(const u64 *, std::size_t, 
+                                                    std::size_t, u32 *)> &kernels, 
+                                std::true_type) {
+    kernels.add(simd_isa::avx2, unpack_avx2<Bits>);
+}
+
+template <unsigned Bits>
+inline void add_unpack_variants(dispatched<void (*)(const u64 *, std::size_t, 
+                                                    std::size_t, u32 *)> &kernels, 
+                                std::false_type) {
+    kernels.add(simd_isa::avx2, unpack_avx2_wide<Bits>);
+}
+#else
+template <unsigned Bits, typename Table, typename Fits>
+inline void add_unpack_variants(Table &, Fits) {
+}
+#endif
+
+/**
+ * \brief Variants of the bulk unpack. Exposed for tests and benchmarks; 
+ *     packed_vector::unpack picks the variant for the CPU we run on.
+ */
+template <unsigned Bits>
+inline dispatched<void (*)(const u64 *, std::size_t, std::size_t, u32 *)> &unpack_kernels() {
+    static dispatched<void (*)(const u64 *, std::size_t, std::size_t, u32 *)> 
+        kernels(unpack_scalar<Bits>);
+    static const bool registered = (add_unpack_variants<Bits>(
+        kernels, std::integral_constant<bool, Bits <= 25>()), true);
+    (void)registered;
+    return kernels;
+}
+
+} // namespace detail
+
+/**
+ * \brief A vector of unsigned integers stored with Bits bits each. 
+ *
+ * Meant for many small values, e.g. IDs below 2^20 or counters below 2^12, 
+ * which take 20 or 12 instead of 32 bits each. Elements are read and 
+ * written by value in O(1), by combining the at most two 64-bit words an 
+ * element spans. Bulk unpack() and pack() convert ranges from and to 
+ * arrays of u32, unpack() with AVX2 when the CPU supports it.
+ *
+ * Stored values must fit in Bits bits, which is checked with 
+ * TYPUS_REQUIRES; without checks, larger values are truncated. Like 
+ * small_vector, the capacity doubles when appending to a full vector.
+ */
+template <unsigned Bits>
+class packed_vector {
+    static_assert(Bits >= 1 && Bits <= 32, "packed_vector holds 1 to 32 bits per element");
+public:
+    static constexpr unsigned bits = Bits;
+
+    packed_vector(): words_(nullptr), size_(0), capacity_(0) {
+    }
+
+    /**
+     * \brief \p n elements with value zero.
+     */
+    explicit packed_vector(std::size_t n): packed_vector() {
+        this->resize(n);
+    }
+
+    packed_vector(const packed_vector &rhs): packed_vector() {
+        this->assign_from(rhs);
+    }
+
+    packed_vector(packed_vector &&rhs): 
+        words_(rhs.words_), size_(rhs.size_), capacity_(rhs.capacity_) {
+        rhs.words_ = nullptr;
+        rhs.size_ = rhs.capacity_ = 0;
+    }
+
+    packed_vector &operator=(const packed_vector &rhs) {
+        if (this != &rhs) {
+            this->clear();
+            this->assign_from(rhs);
+        }
+        return *this;
+    }
+
+    packed_vector &operator=(packed_vector &&rhs) {
+        if (this != &rhs) {
+            std::free(words_);
+            words_ = rhs.words_;
+            size_ = rhs.size_;
+            capacity_ = rhs.capacity_;
+            rhs.words_ = nullptr;
+            rhs.size_ = rhs.capacity_ = 0;
+        }
+        return *this;
+    }
+
+    ~packed_vector() {
+        std::free(words_);
+    }
+
+    /**
+     * \brief The largest value an element can hold.
+     */
+    static constexpr u32 max_value() {
+        return u32(detail::packed_value_mask<Bits>());
+    }
+
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    /**
+     * \brief Bytes allocated for the elements, including the padding words.
+     */
+    std::size_t storage_bytes() const {
+        return capacity_ ? words_for(capacity_) * sizeof(u64) : 0;
+    }
+
+    /**
+     * \brief The packed storage: element i occupies bits i * Bits to 
+     *     (i + 1) * Bits - 1, counting from bit 0 of the first word.
+     */
+    const u64 *words() const { return words_; }
+
+    u32 operator[](std::size_t i) const {
+        TYPUS_REQUIRES(i < size_);
+        return detail::packed_get<Bits>(words_, i);
+    }
+
+    u32 get(std::size_t i) const {
+        return (*this)[i];
+    }
+
+    /**
+     * \brief Set element \p i to \p value.
+     */
+    void set(std::size_t i, u32 value) {
+        TYPUS_REQUIRES(i < size_);
+        TYPUS_REQUIRES(value <= max_value());
+        detail::packed_set<Bits>(words_, i, value);
+    }
+
+    u32 back() const {
+        TYPUS_REQUIRES(!this->empty());
+        return (*this)[size_ - 1];
+    }
+
+    /**
+     * \brief Append \p value.
+     */
+    void push_back(u32 value) {
+        if (size_ < capacity_) {
+            ++size_;
+            this->set(size_ - 1, value);
+            return;
+        }
+        this->push_back_slow_path(value);
+    }
+
+    void pop_back() {
+        TYPUS_REQUIRES(!this->empty());
+        this->set(size_ - 1, 0);
+        --size_;
+    }
+
+    /**
+     * \brief Resize to \p n elements. New elements are zero.
+     */
+    void resize(std::size_t n) {
+        if (n < size_) {
+            this->zero_from(n);
+        } else if (n > capacity_) {
+            this->grow_to_hold_at_least(n);
+        }
+        size_ = n;
+    }
+
+    void reserve(std::size_t n) {
+        if (n > capacity_) {
+            this->grow_to_hold_at_least(n);
+        }
+    }
+
+    /**
+     * \brief Remove all elements, keeping the capacity.
+     */
+    void clear() {
+        this->zero_from(0);
+        size_ = 0;
+    }
+
+    /**
+     * \brief Read out.size() elements starting at \p first into \p out.
+     */
+    void unpack(std::size_t first, mem_view<u32> out) const {
+        TYPUS_REQUIRES(first + out.size() <= size_);
+        if (out.size()) {
+            detail::unpack_kernels<Bits>()(words_, first, out.size(), out.begin());
+        }
+    }
+
+    /**
+     * \brief Overwrite in.size() elements starting at \p first with the 
+     *     values of \p in.
+     */
+    void pack(std::size_t first, mem_view<const u32> in);
+
+    /**
+     * \brief Append the values of \p in.
+     */
+    void append(mem_view<const u32> in) {
+        const std::size_t first = size_;
+        this->resize(size_ + in.size());
+        this->pack(first, in);
+    }
+
+private:
+    static std::size_t words_for(std::size_t n) {
+        return (n * Bits + 63) / 64 + detail::packed_padding_words;
+    }
+
+    // copies the elements of rhs into this empty vector
+    void assign_from(const packed_vector &rhs) {
+        if (rhs.size_) {
+            this->reserve(rhs.size_);
+            std::memcpy(words_, rhs.words_, words_for(rhs.size_) * sizeof(u64));
+            size_ = rhs.size_;
+        }
+    }
+
+    // clears the bits of elements from index n on, so bits past size() 
+    // are zero
+    void zero_from(std::size_t n) {
+        if (!words_) {
+            return;
+        }
+        const std::size_t bit = n * Bits;
+        const std::size_t word = bit >> 6;
+        words_[word] &= detail::low_bits_mask(bit & 63);
+        const std::size_t used = words_for(size_);
+        if (used > word + 1) {
+            std::memset(words_ + word + 1, 0, (used - word - 1) * sizeof(u64));
+        }
+    }
+
+    void grow_to_hold_at_least(std::size_t n);
+    void push_back_slow_path(u32 value);
+
+    u64 *words_;
+    std::size_t size_;
+    std::size_t capacity_;
+};
+
+template <unsigned Bits>
+constexpr unsigned packed_vector<Bits>::bits;
+
+template <unsigned Bits>
+void packed_vector<Bits>::grow_to_hold_at_least(std::size_t n) {
+    const std::size_t new_capacity = std::max(n, std::max(2 * capacity_, std::size_t(16)));
+    TYPUS_REQUIRES(new_capacity > capacity_);
+    const std::size_t old_words = capacity_ ? words_for(capacity_) : 0;
+    const std::size_t new_words = words_for(new_capacity);
+    u64 *new_words_ptr = static_cast<u64*>(std::realloc(words_, new_words * sizeof(u64)));
+    if (!new_words_ptr) {
+        throw std::bad_alloc();
+    }
+    std::memset(new_words_ptr + old_words, 0, (new_words - old_words) * sizeof(u64));
+    words_ = new_words_ptr;
+    capacity_ = new_capacity;
+}
+
+template <unsigned Bits>
+void packed_vector<Bits>::push_back_slow_path(u32 value) {
+    TYPUS_REQUIRES(size_ == capacity_);
+    this->grow_to_hold_at_least(size_ + 1);
+    ++size_;
+    this->set(size_ - 1, value);
+}
+
+// Values are collected in a 64-bit accumulator that is written out whenever 
+// it fills up, so each word is written once. Bits of the first and last 
+// word outside the range are kept.
+template <unsigned Bits>
+void packed_vector<Bits>::pack(std::size_t first, mem_view<const u32> in) {
+    TYPUS_REQUIRES(first + in.size() <= size_);
+    if (in.empty()) {
+        return;
+    }
+    const std::size_t bit = first * Bits;
+    u64 *w = words_ + (bit >> 6);
+    unsigned fill = bit & 63;
+    u64 acc = *w & detail::low_bits_mask(fill);
+    for (const u32 *p = in.begin(); p != in.end(); ++p) {
+        TYPUS_REQUIRES(*p <= max_value());
+        const u64 v = *p & detail::packed_value_mask<Bits>();
+        acc |= v << fill;
+        fill += Bits;
+        if (fill >= 64) {
+            *w++ = acc;
+            fill -= 64;
+            // the part of v that didn't fit; v >> Bits is zero if none
+            acc = v >> (Bits - fill);
+        }
+    }
+    if (fill) {
+        const u64 keep = ~detail::low_bits_mask(fill);
+        *w = (*w & keep) | acc;
+    }
+}
+
+} // namespace
+
+#endif // TYPUS_PACKED_VECTOR_HH
@@ -0,0 +1,83 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_PARALLEL_HH
+#define TYPUS_PARALLEL_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+
+namespace typus {
+
+/**
+ * \brief The number of threads to use when the caller passes 0: the number 
+ *     of hardware threads, or 1 if unknown.
+ */
+inline unsigned default_thread_count() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * \brief The number of threads to split n items over: \p num_threads (0 for 
+ *     \ref default_thread_count), but at most one per \p min_per_thread 
+ *     items, since it's not worth spawning threads for small inputs.
+ */
+inline unsigned thread_count_for(std::size_t n, unsigned num_threads, 
+                                 std::size_t min_per_thread = 16384) {
+    if (num_threads == 0) {
+        num_threads = default_thread_count();
+    }
+    return unsigned(std::max<std::size_t>(1, 
+        std::min<std::size_t>(num_threads, n / min_per_thread)));
+}
+
+/**
+ * \brief Split [0, n) into \p num_threads contiguous chunks of (almost) equal 
+ *     size and call func(chunk, begin, end) for each of them, chunk 0 on the 
+ *     calling thread and the others on new threads. Returns once all calls 
+ *     have finished.
+ *
+ * Chunk c always covers the same range for a given n and num_threads, so 
+ * per-chunk results can be combined deterministically by the caller. Passing
+ * 0 for num_threads uses \ref default_thread_count.
+ */
+template <typename F>
+void parallel_for_chunks(std::size_t n, unsigned num_threads, F &&func) {
+    if (num_threads == 0) {
+        num_threads = default_thread_count();
+    }
+    const std::size_t chunk_size = (n + num_threads - 1) / num_threads;
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (unsigned c = 1; c < num_threads; ++c) {
+        const std::size_t begin = std::min(n, c * chunk_size);
+        const std::size_t end = std::min(n, begin + chunk_size);
+        threads.emplace_back([&func, c, begin, end]() {
+            func(c, begin, end);
+        });
+    }
+    func(0u, std::size_t(0), std::min(n, chunk_size));
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace
+
+#endif // TYPUS_PARALLEL_HH
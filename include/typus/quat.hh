@@ -0,0 +1,129 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_QUAT_HH
+#define TYPUS_QUAT_HH
+
+#include <cmath>
+#include <ostream>
+
+#include <typus/matrix.hh>
+#include <typus/numbers.hh>
+#include <typus/vec3.hh>
+
+namespace typus {
+
+/**
+ * \brief Quaternion w + xi + yj + zk. Unit quaternions represent rotations.
+ *
+ * Composition follows the matrix convention: (a * b).rotate(v) rotates by b 
+ * first, and to_mat3() of a product is the product of the matrices.
+ */
+template <typename T>
+struct quat {
+    /**
+     * \brief The identity rotation.
+     */
+    quat() = default;
+
+    quat(T pw, T px, T py, T pz): w(pw), x(px), y(py), z(pz) {
+    }
+
+    static quat identity() {
+        return quat();
+    }
+
+    /**
+     * \brief Rotation by \p angle radians around the unit vector \p axis, 
+     *     same as \ref mat3::rotation.
+     */
+    static quat from_axis_angle(const vec3<T> &axis, T angle) {
+        const T s = std::sin(angle / 2);
+        return quat(std::cos(angle / 2), axis.x * s, axis.y * s, axis.z * s);
+    }
+
+    quat operator*(const quat &rhs) const {
+        return quat(w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z,
+                    w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+                    w * rhs.y - x * rhs.z + y * rhs.w + z * rhs.x,
+                    w * rhs.z + x * rhs.y - y * rhs.x + z * rhs.w);
+    }
+
+    /**
+     * \brief The conjugate, which is the inverse rotation for unit 
+     *     quaternions.
+     */
+    quat conjugate() const {
+        return quat(w, -x, -y, -z);
+    }
+
+    T norm() const {
+        return std::sqrt(w * w + x * x + y * y + z * z);
+    }
+
+    quat normalized() const {
+        const T f = 1 / this->norm();
+        return quat(w * f, x * f, y * f, z * f);
+    }
+
+    /**
+     * \brief Rotate \p v, assuming this is a unit quaternion. 
+     * 
+     * Uses v + 2w(u x v) + 2u x (u x v) with u = (x, y, z), which is cheaper 
+     * than the full product q v q*. For many vectors, to_mat3() is cheaper 
+     * still.
+     */
+    vec3<T> rotate(const vec3<T> &v) const {
+        const vec3<T> u(x, y, z);
+        const vec3<T> t = cross(u, v) * T(2);
+        return v + t * w + cross(u, t);
+    }
+
+    mat3<T> to_mat3() const {
+        const T xx = x * x, yy = y * y, zz = z * z;
+        const T xy = x * y, xz = x * z, yz = y * z;
+        const T wx = w * x, wy = w * y, wz = w * z;
+        return mat3<T>(1 - 2 * (yy + zz), 2 * (xy - wz),     2 * (xz + wy),
+                       2 * (xy + wz),     1 - 2 * (xx + zz), 2 * (yz - wx),
+                       2 * (xz - wy),     2 * (yz + wx),     1 - 2 * (xx + yy));
+    }
+
+    T w = 1;
+    T x = 0;
+    T y = 0;
+    T z = 0;
+};
+
+template <typename T>
+bool operator == (const quat<T> &lhs, const quat<T> &rhs) {
+    return lhs.w == rhs.w && lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+}
+
+template <typename T>
+bool operator != (const quat<T> &lhs, const quat<T> &rhs) {
+    return !operator==(lhs, rhs);
+}
+
+template <typename T>
+std::ostream &operator <<(std::ostream &s, const quat<T> &q) {
+    return (s << "{" << q.w << ", " << q.x << ", " << q.y << ", " << q.z << "}");
+}
+
+using quat_f = quat<f32>;
+
+} // namespace
+
+#endif // TYPUS_QUAT_HH
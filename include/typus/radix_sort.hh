@@ -0,0 +1,103 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_RADIX_SORT_HH
+#define TYPUS_RADIX_SORT_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "assert.hh"
+#include "mem_view.hh"
+#include "numbers.hh"
+#include "parallel.hh"
+
+
+namespace typus {
+
+/**
+ * \brief Stable LSD radix sort of (key, value) pairs by key, 8 bits per pass.
+ *
+ * Only the lowest \p key_bits bits of the keys are considered; higher bits 
+ * are kept in the keys, but don't affect the order. Passes in 
+ * which all keys have the same digit are skipped. Each pass builds one 
+ * histogram per chunk of the input and then scatters the chunks 
+ * concurrently, on \p num_threads threads (0 for one per hardware thread). 
+ * The result does not depend on the number of threads.
+ */
+inline void radix_sort_pairs(mem_view<u64> keys, mem_view<u32> values, 
+                             u32 key_bits = 64, unsigned num_threads = 1) {
+    TYPUS_REQUIRES(keys.size() == values.size());
+    TYPUS_REQUIRES(key_bits <= 64);
+    const std::size_t n = keys.size();
+    num_threads = thread_count_for(n, num_threads);
+    const std::size_t radix = 256;
+    std::vector<u64> key_buffer(n);
+    std::vector<u32> value_buffer(n);
+    std::vector<std::size_t> histograms(num_threads * radix);
+    u64 *src_keys = keys.begin(), *dst_keys = key_buffer.data();
+    u32 *src_values = values.begin(), *dst_values = value_buffer.data();
+    for (u32 shift = 0; shift < key_bits; shift += 8) {
+        // the last digit may have less than 8 bits
+        const u64 digit_mask = key_bits - shift >= 8 ? 0xff : 
+                               (u64(1) << (key_bits - shift)) - 1;
+        std::fill(histograms.begin(), histograms.end(), 0);
+        parallel_for_chunks(n, num_threads, 
+                            [&](unsigned chunk, std::size_t begin, std::size_t end) {
+            std::size_t *histogram = histograms.data() + chunk * radix;
+            for (std::size_t i = begin; i < end; ++i) {
+                ++histogram[(src_keys[i] >> shift) & digit_mask];
+            }
+        });
+        // digit-major, chunk-minor exclusive prefix sum
+        std::size_t running = 0;
+        bool single_digit = false;
+        for (std::size_t d = 0; d < radix; ++d) {
+            std::size_t digit_count = 0;
+            for (unsigned c = 0; c < num_threads; ++c) {
+                std::size_t &count = histograms[c * radix + d];
+                const std::size_t next = running + count;
+                digit_count += count;
+                count = running;
+                running = next;
+            }
+            single_digit = single_digit || digit_count == n;
+        }
+        if (single_digit) {
+            continue;
+        }
+        parallel_for_chunks(n, num_threads, 
+                            [&](unsigned chunk, std::size_t begin, std::size_t end) {
+            std::size_t *next = histograms.data() + chunk * radix;
+            for (std::size_t i = begin; i < end; ++i) {
+                const std::size_t slot = next[(src_keys[i] >> shift) & digit_mask]++;
+                dst_keys[slot] = src_keys[i];
+                dst_values[slot] = src_values[i];
+            }
+        });
+        std::swap(src_keys, dst_keys);
+        std::swap(src_values, dst_values);
+    }
+    if (src_keys != keys.begin()) {
+        std::copy(src_keys, src_keys + n, keys.begin());
+        std::copy(src_values, src_values + n, values.begin());
+    }
+}
+
+} // namespace
+
+#endif // TYPUS_RADIX_SORT_HH
@@ -0,0 +1,376 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_REDUCE_HH
+#define TYPUS_REDUCE_HH
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <typus/aabb.hh>
+#include <typus/assert.hh>
+#include <typus/matrix.hh>
+#include <typus/mem_view.hh>
+#include <typus/parallel.hh>
+#include <typus/vec3.hh>
+
+namespace typus {
+
+/**
+ * \brief How the reductions below add up many values.
+ *
+ * - naive adds in T, with 16 interleaved partial sums. Fastest, but for 
+ *   f32 the error grows linearly with the number of points.
+ * - kahan carries a compensation term per partial sum, which makes the 
+ *   error independent of the number of points at about twice the cost. 
+ *   It does not survive -ffast-math, which may optimize the compensation 
+ *   away.
+ * - pairwise sums blocks of 256 points naively and adds the block sums in a 
+ *   balanced tree. The error grows with log(n), and it is almost as fast as 
+ *   naive.
+ */
+enum class summation {
+    naive,
+    kahan,
+    pairwise
+};
+
+struct reduce_options {
+    summation mode = summation::pairwise;
+    // number of threads (0 for one per hardware thread). Inputs are split 
+    // into one contiguous chunk per thread, so for a given thread count the 
+    // result is deterministic.
+    unsigned num_threads = 1;
+};
+
+namespace detail {
+
+// The reductions sum K values per point, computed by f(point, values). 
+// Consecutive points are accumulated in separate lanes, which allows the 
+// compiler to vectorize the loop: for the plain sum, 16 lanes of three 
+// components line up with 48 floats, three registers of up to 16 floats.
+const std::size_t sum_lanes = 16;
+
+template <typename T, std::size_t K>
+inline void add_lanes(T (&acc)[sum_lanes][K], T (&out)[K]) {
+    for (std::size_t k = 0; k < K; ++k) {
+        T sum = 0;
+        for (std::size_t j = 0; j < sum_lanes; ++j) {
+            sum += acc[j][k];
+        }
+        out[k] = sum;
+    }
+}
+
+template <typename T, std::size_t K, typename F>
+void sum_naive(const vec3<T> *p, std::size_t n, const F &f, T (&out)[K]) {
+    T acc[sum_lanes][K] = {};
+    std::size_t i = 0;
+    for (; i + sum_lanes <= n; i += sum_lanes) {
+        for (std::size_t j = 0; j < sum_lanes; ++j) {
+            T v[K];
+            f(p[i + j], v);
+            for (std::size_t k = 0; k < K; ++k) {
+                acc[j][k] += v[k];
+            }
+        }
+    }
+    for (; i < n; ++i) {
+        T v[K];
+        f(p[i], v);
+        for (std::size_t k = 0; k < K; ++k) {
+            acc[0][k] += v[k];
+        }
+    }
+    add_lanes(acc, out);
+}
+
+template <typename T>
+inline void kahan_add(T &sum, T &compensation, T value) {
+    const T y = value - compensation;
+    const T t = sum + y;
+    compensation = (t - sum) - y;
+    sum = t;
+}
+
+template <typename T, std::size_t K, typename F>
+void sum_kahan(const vec3<T> *p, std::size_t n, const F &f, T (&out)[K]) {
+    T acc[sum_lanes][K] = {}, comp[sum_lanes][K] = {};
+    std::size_t i = 0;
+    for (; i + sum_lanes <= n; i += sum_lanes) {
+        for (std::size_t j = 0; j < sum_lanes; ++j) {
+            T v[K];
+            f(p[i + j], v);
+            for (std::size_t k = 0; k < K; ++k) {
+                kahan_add(acc[j][k], comp[j][k], v[k]);
+            }
+        }
+    }
+    for (; i < n; ++i) {
+        T v[K];
+        f(p[i], v);
+        for (std::size_t k = 0; k < K; ++k) {
+            kahan_add(acc[0][k], comp[0][k], v[k]);
+        }
+    }
+    for (std::size_t k = 0; k < K; ++k) {
+        T sum = 0, c = 0;
+        for (std::size_t j = 0; j < sum_lanes; ++j) {
+            kahan_add(sum, c, acc[j][k]);
+            kahan_add(sum, c, -comp[j][k]);
+        }
+        out[k] = sum - c;
+    }
+}
+
+template <typename T, std::size_t K, typename F>
+void sum_pairwise(const vec3<T> *p, std::size_t n, const F &f, T (&out)[K]) {
+    const std::size_t block = 256;
+    if (n <= block) {
+        sum_naive(p, n, f, out);
+        return;
+    }
+    // split at a multiple of the block size, so the leaves are full blocks
+    const std::size_t half = (n / block + 1) / 2 * block;
+    T lhs[K], rhs[K];
+    sum_pairwise(p, half, f, lhs);
+    sum_pairwise(p + half, n - half, f, rhs);
+    for (std::size_t k = 0; k < K; ++k) {
+        out[k] = lhs[k] + rhs[k];
+    }
+}
+
+template <typename T, std::size_t K, typename F>
+void parallel_sum(mem_view<const vec3<T>> points, const reduce_options &options, 
+                  const F &f, T (&out)[K]) {
+    const std::size_t n = points.size();
+    const unsigned num_threads = thread_count_for(n, options.num_threads);
+    std::vector<T> partial(num_threads * K);
+    const vec3<T> *p = points.begin();
+    parallel_for_chunks(n, num_threads, 
+                        [&](unsigned chunk, std::size_t begin, std::size_t end) {
+        T sum[K];
+        switch (options.mode) {
+            case summation::naive:
+                sum_naive(p + begin, end - begin, f, sum);
+                break;
+            case summation::kahan:
+                sum_kahan(p + begin, end - begin, f, sum);
+                break;
+            case summation::pairwise:
+                sum_pairwise(p + begin, end - begin, f, sum);
+                break;
+        }
+        std::copy(sum, sum + K, partial.begin() + chunk * K);
+    });
+    // a handful of partial sums, compensated regardless of the mode
+    for (std::size_t k = 0; k < K; ++k) {
+        T sum = 0, c = 0;
+        for (unsigned chunk = 0; chunk < num_threads; ++chunk) {
+            kahan_add(sum, c, partial[chunk * K + k]);
+        }
+        out[k] = sum - c;
+    }
+}
+
+// 16 points are 48 components, which fill three registers of four, eight 
+// or sixteen floats with the same axis pattern every iteration.
+template <typename T>
+void bounds_lanes(const vec3<T> *p, std::size_t n, aabb<T> &out) {
+    const std::size_t width = 48;
+    const T *c = reinterpret_cast<const T*>(p);
+    T lo[width], hi[width];
+    for (std::size_t j = 0; j < width; j += 3) {
+        lo[j] = out.min.x; lo[j + 1] = out.min.y; lo[j + 2] = out.min.z;
+        hi[j] = out.max.x; hi[j + 1] = out.max.y; hi[j + 2] = out.max.z;
+    }
+    std::size_t i = 0;
+    for (; i + width <= 3 * n; i += width) {
+        for (std::size_t j = 0; j < width; ++j) {
+            lo[j] = c[i + j] < lo[j] ? c[i + j] : lo[j];
+            hi[j] = c[i + j] > hi[j] ? c[i + j] : hi[j];
+        }
+    }
+    // lanes that saw no points still hold the empty box, so merge them as 
+    // boxes rather than as points
+    for (std::size_t j = 0; j < width; j += 3) {
+        out.extend(aabb<T>(vec3<T>(lo[j], lo[j + 1], lo[j + 2]), 
+                           vec3<T>(hi[j], hi[j + 1], hi[j + 2])));
+    }
+    for (std::size_t k = i / 3; k < n; ++k) {
+        out.extend(p[k]);
+    }
+}
+
+} // namespace detail
+
+/**
+ * \brief The sum of all points.
+ */
+template <typename T>
+vec3<T> sum(mem_view<const vec3<T>> points, 
+            const reduce_options &options = reduce_options()) {
+    T s[3];
+    detail::parallel_sum(points, options, [](const vec3<T> &p, T (&v)[3]) {
+        v[0] = p.x;
+        v[1] = p.y;
+        v[2] = p.z;
+    }, s);
+    return vec3<T>(s[0], s[1], s[2]);
+}
+
+/**
+ * \brief The mean of all points. \p points must not be empty.
+ */
+template <typename T>
+vec3<T> centroid(mem_view<const vec3<T>> points, 
+                 const reduce_options &options = reduce_options()) {
+    TYPUS_REQUIRES(!points.empty());
+    return sum(points, options) * (T(1) / T(points.size()));
+}
+
+/**
+ * \brief The bounding box of all points, empty for no points. Split over 
+ *     options.num_threads; the summation mode does not apply.
+ */
+template <typename T>
+aabb<T> bounds(mem_view<const vec3<T>> points, 
+               const reduce_options &options = reduce_options()) {
+    const std::size_t n = points.size();
+    const unsigned num_threads = thread_count_for(n, options.num_threads);
+    std::vector<aabb<T>> partial(num_threads);
+    const vec3<T> *p = points.begin();
+    parallel_for_chunks(n, num_threads, 
+                        [&](unsigned chunk, std::size_t begin, std::size_t end) {
+        detail::bounds_lanes(p + begin, end - begin, partial[chunk]);
+    });
+    aabb<T> result;
+    for (const aabb<T> &b : partial) {
+        result.extend(b);
+    }
+    return result;
+}
+
+/**
+ * \brief The covariance matrix of the points, normalized by the number of 
+ *     points. \p points must not be empty.
+ *
+ * Computed in two passes, the second one over the offsets from the 
+ * centroid, which avoids the cancellation of the one-pass formula 
+ * E[xy] - E[x]E[y] for points far from the origin.
+ */
+template <typename T>
+mat3<T> covariance(mem_view<const vec3<T>> points, 
+                   const reduce_options &options = reduce_options()) {
+    const vec3<T> c = centroid(points, options);
+    T s[6];
+    detail::parallel_sum(points, options, [&c](const vec3<T> &p, T (&v)[6]) {
+        const T dx = p.x - c.x, dy = p.y - c.y, dz = p.z - c.z;
+        v[0] = dx * dx;
+        v[1] = dx * dy;
+        v[2] = dx * dz;
+        v[3] = dy * dy;
+        v[4] = dy * dz;
+        v[5] = dz * dz;
+    }, s);
+    const T f = T(1) / T(points.size());
+    return mat3<T>(s[0] * f, s[1] * f, s[2] * f, 
+                   s[1] * f, s[3] * f, s[4] * f, 
+                   s[2] * f, s[4] * f, s[5] * f);
+}
+
+/**
+ * \brief The unit eigenvector of the largest eigenvalue of the symmetric 
+ *     matrix \p m, e.g. a covariance matrix.
+ *
+ * The eigenvalue is computed in closed form and the eigenvector from the 
+ * cross products of the rows of m - lambda I, in f64. The sign is chosen 
+ * such that the component with the largest magnitude is positive. If the 
+ * largest eigenvalue is not unique, any unit vector of its eigenspace is 
+ * returned.
+ */
+template <typename T>
+vec3<T> principal_axis(const mat3<T> &m) {
+    using vec3_d = vec3<f64>;
+    const f64 a00 = m(0, 0), a11 = m(1, 1), a22 = m(2, 2);
+    const f64 a01 = m(0, 1), a02 = m(0, 2), a12 = m(1, 2);
+    const f64 p1 = a01 * a01 + a02 * a02 + a12 * a12;
+    vec3_d axis(1, 0, 0);
+    if (p1 == 0) {
+        // diagonal: the axis of the largest diagonal element
+        if (a11 > a00 && a11 >= a22) {
+            axis = vec3_d(0, 1, 0);
+        } else if (a22 > a00 && a22 > a11) {
+            axis = vec3_d(0, 0, 1);
+        }
+        return vec3<T>(T(axis.x), T(axis.y), T(axis.z));
+    }
+    const f64 q = (a00 + a11 + a22) / 3;
+    const f64 p2 = (a00 - q) * (a00 - q) + (a11 - q) * (a11 - q) + 
+                   (a22 - q) * (a22 - q) + 2 * p1;
+    const f64 p = std::sqrt(p2 / 6);
+    const mat3<f64> b((a00 - q) / p, a01 / p, a02 / p, 
+                      a01 / p, (a11 - q) / p, a12 / p, 
+                      a02 / p, a12 / p, (a22 - q) / p);
+    const f64 r = std::max(-1.0, std::min(1.0, b.determinant() / 2));
+    const f64 lambda = q + 2 * p * std::cos(std::acos(r) / 3);
+
+    const vec3_d r0(a00 - lambda, a01, a02);
+    const vec3_d r1(a01, a11 - lambda, a12);
+    const vec3_d r2(a02, a12, a22 - lambda);
+    const vec3_d candidates[3] = { cross(r0, r1), cross(r0, r2), cross(r1, r2) };
+    f64 best = 0;
+    for (const vec3_d &c : candidates) {
+        if (c.normSquared() > best) {
+            best = c.normSquared();
+            axis = c;
+        }
+    }
+    if (best <= 1e-20 * p2 * p2) {
+        // m - lambda I has rank one: the eigenspace is the plane orthogonal 
+        // to its largest row
+        vec3_d row = r0;
+        if (r1.normSquared() > row.normSquared()) row = r1;
+        if (r2.normSquared() > row.normSquared()) row = r2;
+        const vec3_d other = std::fabs(row.x) < std::fabs(row.y) ? 
+                             vec3_d(1, 0, 0) : vec3_d(0, 1, 0);
+        axis = cross(row, other);
+    }
+    axis = axis * (1 / std::sqrt(axis.normSquared()));
+    const f64 largest = std::fabs(axis.x) >= std::fabs(axis.y) ? 
+        (std::fabs(axis.x) >= std::fabs(axis.z) ? axis.x : axis.z) :
+        (std::fabs(axis.y) >= std::fabs(axis.z) ? axis.y : axis.z);
+    if (largest < 0) {
+        axis = axis * -1.0;
+    }
+    return vec3<T>(T(axis.x), T(axis.y), T(axis.z));
+}
+
+/**
+ * \brief The direction of largest variance of the points, see \ref 
+ *     covariance and \ref principal_axis(const mat3<T>&).
+ */
+template <typename T>
+vec3<T> principal_axis(mem_view<const vec3<T>> points, 
+                       const reduce_options &options = reduce_options()) {
+    return principal_axis(covariance(points, options));
+}
+
+} // namespace
+
+#endif // TYPUS_REDUCE_HH
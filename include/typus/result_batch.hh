@@ -0,0 +1,302 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_RESULT_BATCH_HH
+#define TYPUS_RESULT_BATCH_HH
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "assert.hh"
+#include "bits.hh"
+#include "result.hh"
+
+
+namespace typus {
+
+/**
+ * \brief A sequence of results, stored column-wise.
+ *
+ * Compared to std::vector<result<T, E>>, the values are stored in one 
+ * contiguous array without per-element flags or padding, whether element i 
+ * holds a value is stored in a bitmap and errors are kept in a sparse side 
+ * table ordered by index. Testing whether all elements are ok is O(1), and 
+ * iterating over the successful elements only touches the set bits of the 
+ * bitmap.
+ *
+ * The value slot of a failed element holds a default-constructed T, so T must
+ * be default-constructible.
+ */
+template <typename T, typename E=bool>
+class result_batch {
+public:
+    typedef T value_type;
+    typedef E error_type;
+
+    result_batch() = default;
+
+    /**
+     * \brief Construct a batch from a range of result<T, E>.
+     */
+    template <typename I>
+    result_batch(I begin, I end) {
+        for (; begin != end; ++begin) {
+            this->push_back(*begin);
+        }
+    }
+
+    /**
+     * \brief The number of elements, successful or not.
+     */
+    std::size_t size() const { return values_.size(); }
+
+    bool empty() const { return values_.empty(); }
+
+    /**
+     * \brief The number of failed elements.
+     */
+    std::size_t error_count() const { return errors_.size(); }
+
+    /**
+     * \brief Whether all elements hold a value. O(1).
+     */
+    bool all_ok() const { return errors_.empty(); }
+
+    /**
+     * \brief Whether element \p i holds a value.
+     */
+    bool ok(std::size_t i) const {
+        TYPUS_REQUIRES(i < this->size());
+        return (ok_bits_[i / 64] >> (i % 64)) & 1u;
+    }
+
+    void reserve(std::size_t n) {
+        values_.reserve(n);
+        ok_bits_.reserve((n + 63) / 64);
+    }
+
+    /**
+     * \brief Append a successful element.
+     */
+    void push_back(const T & value) {
+        values_.push_back(value);
+        this->push_bit(true);
+    }
+
+    void push_back(T && value) {
+        values_.push_back(std::move(value));
+        this->push_bit(true);
+    }
+
+    /**
+     * \brief Append a failed element.
+     */
+    void push_error(E error) {
+        errors_.emplace_back(values_.size(), error);
+        values_.emplace_back();
+        this->push_bit(false);
+    }
+
+    /**
+     * \brief Append the value or error held by \p value.
+     */
+    void push_back(const result<T, E> & value) {
+        if (value.ok()) {
+            this->push_back(value.value());
+        } else {
+            this->push_error(value.error());
+        }
+    }
+
+    /**
+     * \brief Mark element \p i as failed, e.g. after validating the values.
+     *
+     * \pre Element i holds a value.
+     */
+    void fail(std::size_t i, E error) {
+        TYPUS_REQUIRES(this->ok(i));
+        ok_bits_[i / 64] &= ~(u64(1) << (i % 64));
+        auto pos = std::lower_bound(errors_.begin(), errors_.end(), i, 
+                                    index_less{});
+        errors_.emplace(pos, i, error);
+    }
+
+    /**
+     * \brief Mark every successful element whose value satisfies \p pred as
+     *     failed with \p error.
+     *
+     * The predicate is evaluated for all slots, 64 at a time, without 
+     * branching on its outcome, which allows the compiler to vectorize the
+     * loop for simple predicates. Only newly failed elements are added to
+     * the error table.
+     */
+    template <typename P>
+    void fail_if(P && pred, E error) {
+        std::vector<std::pair<std::size_t, E>> failed;
+        const std::size_t n = this->size();
+        for (std::size_t w = 0; w < ok_bits_.size(); ++w) {
+            const std::size_t begin = w * 64;
+            const std::size_t end = std::min(begin + 64, n);
+            u64 mask = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                mask |= u64(pred(values_[i]) ? 1 : 0) << (i - begin);
+            }
+            mask &= ok_bits_[w];
+            ok_bits_[w] &= ~mask;
+            for_each_set_bit(mask, begin, [&](std::size_t i) {
+                failed.emplace_back(i, error);
+            });
+        }
+        if (failed.empty()) {
+            return;
+        }
+        std::vector<std::pair<std::size_t, E>> merged;
+        merged.reserve(errors_.size() + failed.size());
+        std::merge(errors_.begin(), errors_.end(), failed.begin(), failed.end(),
+                   std::back_inserter(merged), 
+                   [](const std::pair<std::size_t, E> & lhs, 
+                      const std::pair<std::size_t, E> & rhs) {
+            return lhs.first < rhs.first;
+        });
+        errors_.swap(merged);
+    }
+
+    /**
+     * \brief Access value of element \p i in-place.
+     *
+     * \pre Element i holds a value.
+     */
+    const T & value(std::size_t i) const {
+        TYPUS_REQUIRES(this->ok(i));
+        return values_[i];
+    }
+
+    T & value(std::size_t i) {
+        TYPUS_REQUIRES(this->ok(i));
+        return values_[i];
+    }
+
+    /**
+     * \brief The error of element \p i. O(log(error_count())).
+     *
+     * \pre Element i does not hold a value.
+     */
+    E error(std::size_t i) const {
+        TYPUS_REQUIRES(!this->ok(i));
+        auto pos = std::lower_bound(errors_.begin(), errors_.end(), i, 
+                                    index_less{});
+        return pos->second;
+    }
+
+    /**
+     * \brief Element \p i converted to a result.
+     */
+    result<T, E> operator[](std::size_t i) const {
+        if (this->ok(i)) {
+            return result<T, E>(values_[i]);
+        }
+        return result<T, E>::fail(this->error(i));
+    }
+
+    /**
+     * \brief Convert the batch to a vector of results.
+     */
+    std::vector<result<T, E>> to_results() const {
+        std::vector<result<T, E>> results;
+        results.reserve(this->size());
+        for (std::size_t i = 0; i < this->size(); ++i) {
+            results.push_back((*this)[i]);
+        }
+        return results;
+    }
+
+    /**
+     * \brief Invoke \p func(index, value) for every successful element, in 
+     *     order of increasing index.
+     */
+    template <typename F>
+    void for_each_ok(F && func) {
+        for (std::size_t w = 0; w < ok_bits_.size(); ++w) {
+            for_each_set_bit(ok_bits_[w], w * 64, [&](std::size_t i) {
+                func(i, values_[i]);
+            });
+        }
+    }
+
+    template <typename F>
+    void for_each_ok(F && func) const {
+        for (std::size_t w = 0; w < ok_bits_.size(); ++w) {
+            for_each_set_bit(ok_bits_[w], w * 64, [&](std::size_t i) {
+                func(i, values_[i]);
+            });
+        }
+    }
+
+    /**
+     * \brief Invoke \p func(index, error) for every failed element, in order
+     *     of increasing index. Only touches the error side table.
+     */
+    template <typename F>
+    void for_each_error(F && func) const {
+        for (const auto & e : errors_) {
+            func(e.first, e.second);
+        }
+    }
+
+    /**
+     * \brief The contiguous value array. Slots of failed elements hold 
+     *     default-constructed values.
+     */
+    const T * values() const { return values_.data(); }
+    T * values() { return values_.data(); }
+
+    /**
+     * \brief The success bitmap: bit i % 64 of word i / 64 is set when 
+     *     element i holds a value. Bits past size() are zero.
+     */
+    const u64 * ok_bits() const { return ok_bits_.data(); }
+
+    void clear() {
+        values_.clear();
+        ok_bits_.clear();
+        errors_.clear();
+    }
+private:
+    struct index_less {
+        bool operator()(const std::pair<std::size_t, E> & lhs, 
+                        std::size_t rhs) const {
+            return lhs.first < rhs;
+        }
+    };
+
+    void push_bit(bool ok) {
+        std::size_t i = values_.size() - 1;
+        if (i % 64 == 0) {
+            ok_bits_.push_back(0);
+        }
+        ok_bits_.back() |= u64(ok) << (i % 64);
+    }
+
+    std::vector<T> values_;
+    std::vector<u64> ok_bits_;
+    std::vector<std::pair<std::size_t, E>> errors_;
+};
+
+} // namespace typus
+
+#endif // TYPUS_RESULT_BATCH_HH
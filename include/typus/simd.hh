@@ -0,0 +1,823 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_SIMD_HH
+#define TYPUS_SIMD_HH
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include <typus/cpu.hh>
+#include <typus/numbers.hh>
+
+#if defined(__GNUC__) || defined(__clang__)
+#   define TYPUS_HAS_VECTOR_EXTENSIONS 1
+#   if defined(__SSE2__)
+#       include <immintrin.h>
+#   endif
+#endif
+
+namespace typus {
+
+template <typename T, std::size_t N>
+class simd;
+
+template <typename T, std::size_t N>
+class simd_mask;
+
+/**
+ * \brief The register width the packs are compiled for, in bytes. 
+ *     native_simd<T> fills one register of this size.
+ */
+#if defined(__AVX512F__)
+constexpr std::size_t native_simd_bytes = 64;
+#elif defined(__AVX__)
+constexpr std::size_t native_simd_bytes = 32;
+#else
+constexpr std::size_t native_simd_bytes = 16;
+#endif
+
+template <typename T>
+using native_simd = simd<T, native_simd_bytes / sizeof(T)>;
+
+namespace detail {
+
+template <std::size_t Size>
+struct simd_mask_element;
+
+template <> struct simd_mask_element<1> { using type = i8; };
+template <> struct simd_mask_element<2> { using type = i16; };
+template <> struct simd_mask_element<4> { using type = i32; };
+template <> struct simd_mask_element<8> { using type = i64; };
+
+template <typename T, std::size_t N>
+struct simd_tag {};
+
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS)
+
+// GCC and clang vector extensions provide the element-wise operators, and 
+// compile to SSE2, AVX2 or AVX-512 instructions depending on the target, 
+// or to scalar code for widths the target lacks.
+template <typename T, std::size_t N>
+struct simd_vector {
+    typedef T type __attribute__((vector_size(sizeof(T) * N)));
+};
+
+#else
+
+// Portable fallback: the same operators as lane loops over an array.
+template <typename T, std::size_t N>
+struct lane_array {
+    T &operator[](std::size_t i) { return v[i]; }
+    const T &operator[](std::size_t i) const { return v[i]; }
+    T v[N];
+};
+
+template <typename T, std::size_t N>
+struct simd_vector {
+    using type = lane_array<T, N>;
+};
+
+#   define TYPUS_LANE_OPERATOR(op) \
+    template <typename T, std::size_t N> \
+    lane_array<T, N> operator op(const lane_array<T, N> &a, const lane_array<T, N> &b) { \
+        lane_array<T, N> r; \
+        for (std::size_t i = 0; i < N; ++i) r[i] = a[i] op b[i]; \
+        return r; \
+    } \
+    template <typename T, std::size_t N> \
+    lane_array<T, N> operator op(const lane_array<T, N> &a, T b) { \
+        lane_array<T, N> r; \
+        for (std::size_t i = 0; i < N; ++i) r[i] = a[i] op b; \
+        return r; \
+    }
+
+TYPUS_LANE_OPERATOR(+)
+TYPUS_LANE_OPERATOR(-)
+TYPUS_LANE_OPERATOR(*)
+TYPUS_LANE_OPERATOR(/)
+TYPUS_LANE_OPERATOR(&)
+TYPUS_LANE_OPERATOR(|)
+TYPUS_LANE_OPERATOR(^)
+TYPUS_LANE_OPERATOR(<<)
+TYPUS_LANE_OPERATOR(>>)
+#   undef TYPUS_LANE_OPERATOR
+
+template <typename T, std::size_t N>
+lane_array<T, N> operator~(const lane_array<T, N> &a) {
+    lane_array<T, N> r;
+    for (std::size_t i = 0; i < N; ++i) r[i] = ~a[i];
+    return r;
+}
+
+template <typename T, std::size_t N>
+lane_array<T, N> operator-(const lane_array<T, N> &a) {
+    lane_array<T, N> r;
+    for (std::size_t i = 0; i < N; ++i) r[i] = -a[i];
+    return r;
+}
+
+#   define TYPUS_LANE_COMPARISON(op) \
+    template <typename T, std::size_t N> \
+    lane_array<typename simd_mask_element<sizeof(T)>::type, N> operator op( \
+            const lane_array<T, N> &a, const lane_array<T, N> &b) { \
+        lane_array<typename simd_mask_element<sizeof(T)>::type, N> r; \
+        for (std::size_t i = 0; i < N; ++i) r[i] = a[i] op b[i] ? -1 : 0; \
+        return r; \
+    }
+
+TYPUS_LANE_COMPARISON(==)
+TYPUS_LANE_COMPARISON(!=)
+TYPUS_LANE_COMPARISON(<)
+TYPUS_LANE_COMPARISON(<=)
+TYPUS_LANE_COMPARISON(>)
+TYPUS_LANE_COMPARISON(>=)
+#   undef TYPUS_LANE_COMPARISON
+
+#endif
+
+template <typename T, std::size_t N>
+using simd_register = typename simd_vector<T, N>::type;
+
+template <typename T, std::size_t N>
+using mask_register = simd_register<typename simd_mask_element<sizeof(T)>::type, N>;
+
+template <typename To, typename From>
+inline To bit_cast(const From &from) {
+    static_assert(sizeof(To) == sizeof(From), "bit_cast needs equal sizes");
+    To to;
+    std::memcpy(&to, &from, sizeof(to));
+    return to;
+}
+
+template <typename T, std::size_t N>
+inline void broadcast(T value, simd_register<T, N> &r) {
+    for (std::size_t i = 0; i < N; ++i) {
+        r[i] = value;
+    }
+}
+
+// mask ? a : b, lane by lane. GCC and clang accept the conditional operator 
+// on vectors, which lets them match a < b ? a : b to minps and the like. 
+// Otherwise masks are all ones or all zeros per lane, so bit operations do.
+template <typename T, std::size_t N>
+inline void blend(const mask_register<T, N> &m, const simd_register<T, N> &a,
+                  const simd_register<T, N> &b, simd_register<T, N> &r) {
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS)
+    r = m ? a : b;
+#else
+    using M = mask_register<T, N>;
+    r = bit_cast<simd_register<T, N>>((bit_cast<M>(a) & m) | (bit_cast<M>(b) & ~m));
+#endif
+}
+
+// mask_bits: one bit per lane, from the sign bits of the mask lanes. 
+template <typename M>
+inline u64 mask_bits(const M &m, std::size_t n) {
+    u64 bits = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        bits |= u64(m[i] != 0) << i;
+    }
+    return bits;
+}
+
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS) && defined(__SSE2__)
+inline u64 mask_bits(const mask_register<f32, 4> &m, std::size_t) {
+    return u64(_mm_movemask_ps(bit_cast<__m128>(m)));
+}
+
+inline u64 mask_bits(const mask_register<f64, 2> &m, std::size_t) {
+    return u64(_mm_movemask_pd(bit_cast<__m128d>(m)));
+}
+
+inline u64 mask_bits(const mask_register<i8, 16> &m, std::size_t) {
+    return u64(_mm_movemask_epi8(bit_cast<__m128i>(m)));
+}
+#endif
+
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS) && defined(__AVX__)
+inline u64 mask_bits(const mask_register<f32, 8> &m, std::size_t) {
+    return u64(_mm256_movemask_ps(bit_cast<__m256>(m)));
+}
+
+inline u64 mask_bits(const mask_register<f64, 4> &m, std::size_t) {
+    return u64(_mm256_movemask_pd(bit_cast<__m256d>(m)));
+}
+#endif
+
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS) && defined(__AVX2__)
+inline u64 mask_bits(const mask_register<i8, 32> &m, std::size_t) {
+    return u64(u32(_mm256_movemask_epi8(bit_cast<__m256i>(m))));
+}
+#endif
+
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS) && defined(__AVX512F__)
+inline u64 mask_bits(const mask_register<f32, 16> &m, std::size_t) {
+    return _mm512_cmplt_epi32_mask(bit_cast<__m512i>(m), _mm512_setzero_si512());
+}
+
+inline u64 mask_bits(const mask_register<f64, 8> &m, std::size_t) {
+    return _mm512_cmplt_epi64_mask(bit_cast<__m512i>(m), _mm512_setzero_si512());
+}
+#endif
+
+// Masked loads and stores don't touch memory of inactive lanes, so they 
+// may be used for the tail of an array. The generic versions branch per 
+// lane; AVX/AVX2 and AVX-512 have instructions for 32 and 64-bit lanes.
+template <typename T, std::size_t N>
+inline void load_masked(const T *p, const mask_register<T, N> &m,
+                        simd_register<T, N> &r, simd_tag<T, N>) {
+    broadcast<T, N>(T(0), r);
+    for (std::size_t i = 0; i < N; ++i) {
+        if (m[i]) {
+            r[i] = p[i];
+        }
+    }
+}
+
+template <typename T, std::size_t N>
+inline void store_masked(T *p, const mask_register<T, N> &m, 
+                         const simd_register<T, N> &v, simd_tag<T, N>) {
+    for (std::size_t i = 0; i < N; ++i) {
+        if (m[i]) {
+            p[i] = v[i];
+        }
+    }
+}
+
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS) && defined(__AVX__)
+inline void load_masked(const f32 *p, const mask_register<f32, 4> &m,
+                        simd_register<f32, 4> &r, simd_tag<f32, 4>) {
+    r = bit_cast<simd_register<f32, 4>>(_mm_maskload_ps(p, bit_cast<__m128i>(m)));
+}
+
+inline void load_masked(const f32 *p, const mask_register<f32, 8> &m,
+                        simd_register<f32, 8> &r, simd_tag<f32, 8>) {
+    r = bit_cast<simd_register<f32, 8>>(_mm256_maskload_ps(p, bit_cast<__m256i>(m)));
+}
+
+inline void load_masked(const f64 *p, const mask_register<f64, 4> &m,
+                        simd_register<f64, 4> &r, simd_tag<f64, 4>) {
+    r = bit_cast<simd_register<f64, 4>>(_mm256_maskload_pd(p, bit_cast<__m256i>(m)));
+}
+
+inline void store_masked(f32 *p, const mask_register<f32, 8> &m, 
+                         const simd_register<f32, 8> &v, simd_tag<f32, 8>) {
+    _mm256_maskstore_ps(p, bit_cast<__m256i>(m), bit_cast<__m256>(v));
+}
+
+inline void store_masked(f64 *p, const mask_register<f64, 4> &m, 
+                         const simd_register<f64, 4> &v, simd_tag<f64, 4>) {
+    _mm256_maskstore_pd(p, bit_cast<__m256i>(m), bit_cast<__m256d>(v));
+}
+#endif
+
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS) && defined(__AVX2__)
+#   define TYPUS_SIMD_MASKED_32(T) \
+    inline void load_masked(const T *p, const mask_register<T, 8> &m, \
+                            simd_register<T, 8> &r, simd_tag<T, 8>) { \
+        r = bit_cast<simd_register<T, 8>>(_mm256_maskload_epi32( \
+            reinterpret_cast<const int*>(p), bit_cast<__m256i>(m))); \
+    } \
+    inline void store_masked(T *p, const mask_register<T, 8> &m, \
+                             const simd_register<T, 8> &v, simd_tag<T, 8>) { \
+        _mm256_maskstore_epi32(reinterpret_cast<int*>(p), bit_cast<__m256i>(m), \
+                               bit_cast<__m256i>(v)); \
+    }
+
+TYPUS_SIMD_MASKED_32(i32)
+TYPUS_SIMD_MASKED_32(u32)
+#   undef TYPUS_SIMD_MASKED_32
+#endif
+
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS) && defined(__AVX512F__)
+inline void load_masked(const f32 *p, const mask_register<f32, 16> &m,
+                        simd_register<f32, 16> &r, simd_tag<f32, 16>) {
+    r = bit_cast<simd_register<f32, 16>>(
+        _mm512_maskz_loadu_ps(__mmask16(mask_bits(m, 16)), p));
+}
+
+inline void store_masked(f32 *p, const mask_register<f32, 16> &m, 
+                         const simd_register<f32, 16> &v, simd_tag<f32, 16>) {
+    _mm512_mask_storeu_ps(p, __mmask16(mask_bits(m, 16)), bit_cast<__m512>(v));
+}
+
+#   define TYPUS_SIMD_MASKED_32(T) \
+    inline void load_masked(const T *p, const mask_register<T, 16> &m, \
+                            simd_register<T, 16> &r, simd_tag<T, 16>) { \
+        r = bit_cast<simd_register<T, 16>>( \
+            _mm512_maskz_loadu_epi32(__mmask16(mask_bits(m, 16)), p)); \
+    } \
+    inline void store_masked(T *p, const mask_register<T, 16> &m, \
+                             const simd_register<T, 16> &v, simd_tag<T, 16>) { \
+        _mm512_mask_storeu_epi32(p, __mmask16(mask_bits(m, 16)), bit_cast<__m512i>(v)); \
+    }
+
+TYPUS_SIMD_MASKED_32(i32)
+TYPUS_SIMD_MASKED_32(u32)
+#   undef TYPUS_SIMD_MASKED_32
+#endif
+
+// Gathers load base[index[i]] for each lane. Hardware gathers exist for 
+// 32-bit indices with AVX2 and AVX-512. The masked forms with a zero source 
+// are used, as the plain ones read an undefined register, which GCC 12 
+// warns about.
+template <typename T, std::size_t N>
+inline void gather(const T *base, const simd_register<i32, N> &index,
+                   simd_register<T, N> &r, simd_tag<T, N>) {
+    for (std::size_t i = 0; i < N; ++i) {
+        r[i] = base[index[i]];
+    }
+}
+
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS) && defined(__AVX2__)
+inline void gather(const f32 *base, const simd_register<i32, 4> &index,
+                   simd_register<f32, 4> &r, simd_tag<f32, 4>) {
+    r = bit_cast<simd_register<f32, 4>>(
+        _mm_mask_i32gather_ps(_mm_setzero_ps(), base, bit_cast<__m128i>(index),
+                              _mm_castsi128_ps(_mm_set1_epi32(-1)), 4));
+}
+
+inline void gather(const f32 *base, const simd_register<i32, 8> &index,
+                   simd_register<f32, 8> &r, simd_tag<f32, 8>) {
+    r = bit_cast<simd_register<f32, 8>>(
+        _mm256_mask_i32gather_ps(_mm256_setzero_ps(), base, bit_cast<__m256i>(index),
+                                 _mm256_castsi256_ps(_mm256_set1_epi32(-1)), 4));
+}
+
+inline void gather(const f64 *base, const simd_register<i32, 4> &index,
+                   simd_register<f64, 4> &r, simd_tag<f64, 4>) {
+    r = bit_cast<simd_register<f64, 4>>(
+        _mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, bit_cast<__m128i>(index),
+                                 _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8));
+}
+
+#   define TYPUS_SIMD_GATHER_32(T) \
+    inline void gather(const T *base, const simd_register<i32, 4> &index, \
+                       simd_register<T, 4> &r, simd_tag<T, 4>) { \
+        r = bit_cast<simd_register<T, 4>>(_mm_mask_i32gather_epi32( \
+            _mm_setzero_si128(), reinterpret_cast<const int*>(base), \
+            bit_cast<__m128i>(index), _mm_set1_epi32(-1), 4)); \
+    } \
+    inline void gather(const T *base, const simd_register<i32, 8> &index, \
+                       simd_register<T, 8> &r, simd_tag<T, 8>) { \
+        r = bit_cast<simd_register<T, 8>>(_mm256_mask_i32gather_epi32( \
+            _mm256_setzero_si256(), reinterpret_cast<const int*>(base), \
+            bit_cast<__m256i>(index), _mm256_set1_epi32(-1), 4)); \
+    }
+
+TYPUS_SIMD_GATHER_32(i32)
+TYPUS_SIMD_GATHER_32(u32)
+#   undef TYPUS_SIMD_GATHER_32
+#endif
+
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS) && defined(__AVX512F__)
+inline void gather(const f32 *base, const simd_register<i32, 16> &index,
+                   simd_register<f32, 16> &r, simd_tag<f32, 16>) {
+    r = bit_cast<simd_register<f32, 16>>(
+        _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xffff, 
+                                 bit_cast<__m512i>(index), base, 4));
+}
+
+inline void gather(const f64 *base, const simd_register<i32, 8> &index,
+                   simd_register<f64, 8> &r, simd_tag<f64, 8>) {
+    r = bit_cast<simd_register<f64, 8>>(
+        _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xff, 
+                                 bit_cast<__m256i>(index), base, 8));
+}
+
+#   define TYPUS_SIMD_GATHER_32(T) \
+    inline void gather(const T *base, const simd_register<i32, 16> &index, \
+                       simd_register<T, 16> &r, simd_tag<T, 16>) { \
+        r = bit_cast<simd_register<T, 16>>( \
+            _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xffff, \
+                                        bit_cast<__m512i>(index), base, 4)); \
+    }
+
+TYPUS_SIMD_GATHER_32(i32)
+TYPUS_SIMD_GATHER_32(u32)
+#   undef TYPUS_SIMD_GATHER_32
+#endif
+
+// Runtime permutation r[i] = v[index[i] % N]. GCC's __builtin_shuffle 
+// compiles to pshufb, vpermps or vpermd where available, but needs indices 
+// of the same width as the elements.
+template <typename T, std::size_t N>
+inline void shuffle(const simd_register<T, N> &v, const simd_register<i32, N> &index,
+                    simd_register<T, N> &r, std::false_type) {
+    for (std::size_t i = 0; i < N; ++i) {
+        r[i] = v[std::size_t(index[i]) % N];
+    }
+}
+
+template <typename T, std::size_t N>
+inline void shuffle(const simd_register<T, N> &v, const simd_register<i32, N> &index,
+                    simd_register<T, N> &r, std::true_type) {
+    r = __builtin_shuffle(v, index);
+}
+
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS) && !defined(__clang__)
+template <typename T>
+using has_builtin_shuffle = std::integral_constant<bool, sizeof(T) == 4>;
+#else
+template <typename T>
+using has_builtin_shuffle = std::false_type;
+#endif
+
+} // namespace detail
+
+/**
+ * \brief Lane mask of a \ref simd<T, N>, the result of comparisons and the 
+ *     input of \ref select and the masked loads and stores.
+ */
+template <typename T, std::size_t N>
+class simd_mask {
+public:
+    using register_type = detail::mask_register<T, N>;
+
+    /**
+     * \brief All lanes inactive.
+     */
+    simd_mask() {
+        detail::broadcast<typename detail::simd_mask_element<sizeof(T)>::type, N>(0, m_);
+    }
+
+    explicit simd_mask(const register_type &m): m_(m) {
+    }
+
+    /**
+     * \brief Lane i is active if bit i of \p bits is set.
+     */
+    static simd_mask from_bits(u64 bits) {
+        register_type m;
+        for (std::size_t i = 0; i < N; ++i) {
+            m[i] = (bits >> i) & 1 ? -1 : 0;
+        }
+        return simd_mask(m);
+    }
+
+    /**
+     * \brief The first \p count lanes active, e.g. for the tail of an array.
+     */
+    static simd_mask first(std::size_t count) {
+        register_type m;
+        for (std::size_t i = 0; i < N; ++i) {
+            m[i] = i < count ? -1 : 0;
+        }
+        return simd_mask(m);
+    }
+
+    bool operator[](std::size_t i) const {
+        return m_[i] != 0;
+    }
+
+    /**
+     * \brief One bit per lane, lane 0 in the lowest bit. Uses movemask 
+     *     where available.
+     */
+    u64 to_bits() const {
+        return detail::mask_bits(m_, N);
+    }
+
+    bool any() const { return this->to_bits() != 0; }
+    bool none() const { return this->to_bits() == 0; }
+    bool all() const { 
+        return this->to_bits() == (N == 64 ? ~u64(0) : (u64(1) << N) - 1); 
+    }
+
+    const register_type &native() const { return m_; }
+
+    friend simd_mask operator&(const simd_mask &a, const simd_mask &b) {
+        return simd_mask(a.m_ & b.m_);
+    }
+
+    friend simd_mask operator|(const simd_mask &a, const simd_mask &b) {
+        return simd_mask(a.m_ | b.m_);
+    }
+
+    friend simd_mask operator^(const simd_mask &a, const simd_mask &b) {
+        return simd_mask(a.m_ ^ b.m_);
+    }
+
+    friend simd_mask operator~(const simd_mask &a) {
+        return simd_mask(~a.m_);
+    }
+
+private:
+    register_type m_;
+};
+
+/**
+ * \brief A pack of N values of type T, operated on lane by lane.
+ *
+ * T is one of the scalar types of numbers.hh and N a power of two. With 
+ * GCC and clang, the pack is a vector extension type, which compiles to 
+ * SSE2, AVX2 or AVX-512 instructions depending on the target, and to scalar 
+ * code otherwise. Masked loads and stores, gathers and movemasks use 
+ * intrinsics where the target has them. Other compilers get a lane-by-lane 
+ * fallback. \ref native_simd<T> is the pack that fills one register.
+ *
+ * Packs wider than 16 bytes are over-aligned, which std::vector doesn't 
+ * honour before C++17. Keep them in registers and local variables, and use 
+ * load() and store() to move data from and to arrays.
+ */
+template <typename T, std::size_t N>
+class simd {
+    static_assert(std::is_arithmetic<T>::value, "simd needs an arithmetic type");
+    static_assert(N > 0 && N <= 64 && (N & (N - 1)) == 0, 
+                  "simd needs a power of two of at most 64 lanes");
+public:
+    using value_type = T;
+    using mask_type = simd_mask<T, N>;
+    using register_type = detail::simd_register<T, N>;
+    using index_type = simd<i32, N>;
+
+    static constexpr std::size_t size() { return N; }
+
+    /**
+     * \brief All lanes zero.
+     */
+    simd() {
+        detail::broadcast<T, N>(T(0), v_);
+    }
+
+    /**
+     * \brief All lanes set to \p value. Implicit, so scalars can be mixed 
+     *     with packs in expressions.
+     */
+    simd(T value) {
+        detail::broadcast<T, N>(value, v_);
+    }
+
+    explicit simd(const register_type &v): v_(v) {
+    }
+
+    /**
+     * \brief Lanes set to 0, 1, ..., N - 1.
+     */
+    static simd iota() {
+        register_type v;
+        for (std::size_t i = 0; i < N; ++i) {
+            v[i] = T(i);
+        }
+        return simd(v);
+    }
+
+    static simd load(const T *p) {
+        register_type v;
+        std::memcpy(&v, p, sizeof(v));
+        return simd(v);
+    }
+
+    /**
+     * \brief Load from \p p, which must be aligned to sizeof(simd).
+     */
+    static simd load_aligned(const T *p) {
+        register_type v;
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS)
+        std::memcpy(&v, __builtin_assume_aligned(p, sizeof(v)), sizeof(v));
+#else
+        std::memcpy(&v, p, sizeof(v));
+#endif
+        return simd(v);
+    }
+
+    /**
+     * \brief Load the active lanes from \p p, and set the others to zero. 
+     *     Memory of inactive lanes is not accessed.
+     */
+    static simd load_masked(const T *p, const mask_type &m) {
+        register_type v;
+        detail::load_masked(p, m.native(), v, detail::simd_tag<T, N>());
+        return simd(v);
+    }
+
+    void store(T *p) const {
+        std::memcpy(p, &v_, sizeof(v_));
+    }
+
+    void store_aligned(T *p) const {
+#if defined(TYPUS_HAS_VECTOR_EXTENSIONS)
+        std::memcpy(__builtin_assume_aligned(p, sizeof(v_)), &v_, sizeof(v_));
+#else
+        std::memcpy(p, &v_, sizeof(v_));
+#endif
+    }
+
+    /**
+     * \brief Store the active lanes to \p p. Memory of inactive lanes is not 
+     *     accessed.
+     */
+    void store_masked(T *p, const mask_type &m) const {
+        detail::store_masked(p, m.native(), v_, detail::simd_tag<T, N>());
+    }
+
+    T operator[](std::size_t i) const {
+        return v_[i];
+    }
+
+    const register_type &native() const { return v_; }
+
+    simd &operator+=(const simd &rhs) { v_ = v_ + rhs.v_; return *this; }
+    simd &operator-=(const simd &rhs) { v_ = v_ - rhs.v_; return *this; }
+    simd &operator*=(const simd &rhs) { v_ = v_ * rhs.v_; return *this; }
+    simd &operator/=(const simd &rhs) { v_ = v_ / rhs.v_; return *this; }
+
+    friend simd operator+(const simd &a, const simd &b) { return simd(a.v_ + b.v_); }
+    friend simd operator-(const simd &a, const simd &b) { return simd(a.v_ - b.v_); }
+    friend simd operator*(const simd &a, const simd &b) { return simd(a.v_ * b.v_); }
+    friend simd operator/(const simd &a, const simd &b) { return simd(a.v_ / b.v_); }
+    friend simd operator-(const simd &a) { return simd(-a.v_); }
+
+    // bitwise operators and shifts, for integral T only. Shifts by a pack 
+    // shift each lane by its own count.
+    friend simd operator&(const simd &a, const simd &b) { 
+        return simd(integral(a.v_) & b.v_); 
+    }
+    friend simd operator|(const simd &a, const simd &b) { 
+        return simd(integral(a.v_) | b.v_); 
+    }
+    friend simd operator^(const simd &a, const simd &b) { 
+        return simd(integral(a.v_) ^ b.v_); 
+    }
+    friend simd operator~(const simd &a) { return simd(~integral(a.v_)); }
+    friend simd operator<<(const simd &a, const simd &b) { 
+        return simd(integral(a.v_) << b.v_); 
+    }
+    friend simd operator>>(const simd &a, const simd &b) { 
+        return simd(integral(a.v_) >> b.v_); 
+    }
+    friend simd operator<<(const simd &a, int count) { 
+        return simd(integral(a.v_) << T(count)); 
+    }
+    friend simd operator>>(const simd &a, int count) { 
+        return simd(integral(a.v_) >> T(count)); 
+    }
+
+    friend mask_type operator==(const simd &a, const simd &b) { return mask(a.v_ == b.v_); }
+    friend mask_type operator!=(const simd &a, const simd &b) { return mask(a.v_ != b.v_); }
+    friend mask_type operator<(const simd &a, const simd &b) { return mask(a.v_ < b.v_); }
+    friend mask_type operator<=(const simd &a, const simd &b) { return mask(a.v_ <= b.v_); }
+    friend mask_type operator>(const simd &a, const simd &b) { return mask(a.v_ > b.v_); }
+    friend mask_type operator>=(const simd &a, const simd &b) { return mask(a.v_ >= b.v_); }
+
+private:
+    static const register_type &integral(const register_type &v) {
+        static_assert(std::is_integral<T>::value, 
+                      "bitwise operators need an integral type");
+        return v;
+    }
+
+    // comparisons yield a vector of signed integers, which is converted to 
+    // the mask register, a no-op for the vector extensions
+    template <typename M>
+    static mask_type mask(const M &m) {
+        typename mask_type::register_type r;
+        static_assert(sizeof(r) == sizeof(m), "mask needs equal sizes");
+        std::memcpy(&r, &m, sizeof(r));
+        return mask_type(r);
+    }
+
+    register_type v_;
+};
+
+/**
+ * \brief r[i] = m[i] ? a[i] : b[i]
+ */
+template <typename T, std::size_t N>
+inline simd<T, N> select(const simd_mask<T, N> &m, const simd<T, N> &a, 
+                         const simd<T, N> &b) {
+    typename simd<T, N>::register_type r;
+    detail::blend<T, N>(m.native(), a.native(), b.native(), r);
+    return simd<T, N>(r);
+}
+
+/**
+ * \brief Lane-wise std::min and std::max, with the same operand order, 
+ *     which maps to minps/maxps.
+ */
+template <typename T, std::size_t N>
+inline simd<T, N> min(const simd<T, N> &a, const simd<T, N> &b) {
+    return select(b < a, b, a);
+}
+
+template <typename T, std::size_t N>
+inline simd<T, N> max(const simd<T, N> &a, const simd<T, N> &b) {
+    return select(a < b, b, a);
+}
+
+/**
+ * \brief r[i] = base[index[i]]
+ */
+template <typename T, std::size_t N>
+inline simd<T, N> gather(const T *base, const simd<i32, N> &index) {
+    typename simd<T, N>::register_type r;
+    detail::gather(base, index.native(), r, detail::simd_tag<T, N>());
+    return simd<T, N>(r);
+}
+
+/**
+ * \brief r[i] = v[index[i] % N]
+ */
+template <typename T, std::size_t N>
+inline simd<T, N> shuffle(const simd<T, N> &v, const simd<i32, N> &index) {
+    typename simd<T, N>::register_type r;
+    detail::shuffle<T, N>(v.native(), index.native(), r, 
+                          detail::has_builtin_shuffle<T>());
+    return simd<T, N>(r);
+}
+
+namespace detail {
+
+// Horizontal reductions add the upper half of the lanes onto the lower 
+// half until one lane is left, which vectorizes into shuffles.
+template <typename T, std::size_t N, typename Op>
+inline T reduce(const simd<T, N> &v, Op op) {
+    T lanes[N];
+    v.store(lanes);
+    for (std::size_t width = N / 2; width > 0; width /= 2) {
+        for (std::size_t i = 0; i < width; ++i) {
+            lanes[i] = op(lanes[i], lanes[i + width]);
+        }
+    }
+    return lanes[0];
+}
+
+} // namespace detail
+
+template <typename T, std::size_t N>
+inline T reduce_add(const simd<T, N> &v) {
+    return detail::reduce(v, [](T a, T b) { return T(a + b); });
+}
+
+template <typename T, std::size_t N>
+inline T reduce_min(const simd<T, N> &v) {
+    return detail::reduce(v, [](T a, T b) { return b < a ? b : a; });
+}
+
+template <typename T, std::size_t N>
+inline T reduce_max(const simd<T, N> &v) {
+    return detail::reduce(v, [](T a, T b) { return b > a ? b : a; });
+}
+
+/**
+ * \brief The level this translation unit is compiled for, with the levels 
+ *     defined as in \ref simd_isa. 
+ */
+constexpr simd_isa compiled_simd_isa() {
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__AVX512BW__) && defined(__AVX512VL__)
+    return simd_isa::avx512;
+#elif defined(__AVX2__) && defined(__FMA__) && defined(__F16C__) && defined(__BMI__) && defined(__BMI2__)
+    return simd_isa::avx2;
+#elif defined(__SSE2__)
+    return simd_isa::sse2;
+#else
+    return simd_isa::scalar;
+#endif
+}
+
+/**
+ * \brief Pick the variant of a kernel for \ref active_simd_isa, i.e. the 
+ *     CPU we run on unless overridden by TYPUS_SIMD_ISA. 
+ *
+ * native_simd is bound to the instruction set at compile time, so variants 
+ * using it live in translation units compiled with different flags (e.g. 
+ * -mavx2). Pass the variants that exist, nullptr for the others; the scalar 
+ * one is required. Resolve once and keep the pointer:
+ *
+ *     static const auto kernel = select_simd(sum_scalar, sum_sse2, sum_avx2);
+ *
+ * For variants registered from several places, see \ref dispatched.
+ */
+template <typename F>
+F select_simd(F scalar, F sse2, F avx2 = nullptr, F avx512 = nullptr) {
+    const simd_isa isa = active_simd_isa();
+    if (avx512 && isa >= simd_isa::avx512) {
+        return avx512;
+    }
+    if (avx2 && isa >= simd_isa::avx2) {
+        return avx2;
+    }
+    if (sse2 && isa >= simd_isa::sse2) {
+        return sse2;
+    }
+    return scalar;
+}
+
+} // namespace
+
+#endif // TYPUS_SIMD_HH
@@ -0,0 +1,515 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_SPATIAL_GRID_HH
+#define TYPUS_SPATIAL_GRID_HH
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "assert.hh"
+#include "mem_view.hh"
+#include "numbers.hh"
+#include "parallel.hh"
+#include "vec3.hh"
+
+
+namespace typus {
+
+/**
+ * \brief Outcome of \ref spatial_grid::update.
+ */
+struct spatial_grid_update {
+    // number of points that moved to a different cell
+    std::size_t moved = 0;
+    // whether the grid was built from scratch instead of moving the points 
+    // between buckets
+    bool        rebuilt = false;
+};
+
+/**
+ * \brief Spatial hash over vec3<T> points for radius and k-nearest-neighbour 
+ *     queries.
+ *
+ * Space is divided into cubic cells of cell_size, and every cell is hashed 
+ * into a table with one bucket per point (rounded to a power of two). The 
+ * points are counting-sorted by bucket, so the points of a bucket are 
+ * contiguous in memory and a query touches only the buckets of the cells 
+ * overlapping its search region. Cells that collide in the same bucket are 
+ * told apart by their cell key. Every bucket is followed by a few free slots,
+ * which let \ref update move points between buckets without sorting again.
+ *
+ * Queries return indices into the array passed to \ref build. A cell size 
+ * close to the typical query radius works best.
+ */
+template <typename T>
+class spatial_grid {
+public:
+    explicit spatial_grid(T cell_size): 
+        cell_size_(cell_size), inv_cell_size_(T(1) / cell_size), mask_(0) {
+        TYPUS_REQUIRES(cell_size > T(0));
+    }
+
+    T cell_size() const { return cell_size_; }
+
+    std::size_t size() const { return slots_.size(); }
+
+    bool empty() const { return slots_.empty(); }
+
+    /**
+     * \brief Index \p points, replacing the previous contents.
+     *
+     * Construction runs on \p num_threads threads (0 for one per hardware 
+     * thread). The result does not depend on the number of threads.
+     *
+     * \pre points has less than 2^32 elements.
+     */
+    void build(mem_view<const vec3<T>> points, unsigned num_threads = 1);
+
+    /**
+     * \brief Update the index for new positions of the same points, e.g. 
+     *     after a simulation step.
+     *
+     * Positions of points that remain in their cell are updated in place. 
+     * A point that moved to a different cell is removed from its old bucket 
+     * and appended to the free slots of its new bucket. If that bucket is 
+     * full, the buckets up to the next one with a free slot are shifted by 
+     * one slot; all other buckets are left untouched. The grid is only built 
+     * from scratch, reusing the existing buffers, if more than an eighth of 
+     * the points moved or no free slot is left after the new bucket.
+     *
+     * \pre points has the same size as the points passed to \ref build.
+     */
+    spatial_grid_update update(mem_view<const vec3<T>> points, 
+                               unsigned num_threads = 1);
+
+    /**
+     * \brief Call func(index, distance_squared) for every point within 
+     *     \p radius of \p p, in no particular order.
+     */
+    template <typename F>
+    void for_each_in_radius(const vec3<T> &p, T radius, F &&func) const;
+
+    /**
+     * \brief Append the indices of all points within \p radius of \p p to 
+     *     \p out, in no particular order.
+     */
+    void query_radius(const vec3<T> &p, T radius, std::vector<u32> &out) const {
+        this->for_each_in_radius(p, radius, [&out](u32 index, T) {
+            out.push_back(index);
+        });
+    }
+
+    /**
+     * \brief Store the indices of the \p k points closest to \p p in 
+     *     \p out, ordered by increasing distance. Fewer than k indices are 
+     *     returned if the grid contains less than k points.
+     *
+     * Searches rings of cells of increasing size around p, until no point 
+     * outside of the searched cells can be closer than the k-th best.
+     */
+    void query_knn(const vec3<T> &p, std::size_t k, std::vector<u32> &out) const;
+private:
+    struct cell {
+        i32 x, y, z;
+    };
+
+    cell cell_of(const vec3<T> &p) const {
+        return cell{i32(std::floor(p.x * inv_cell_size_)), 
+                    i32(std::floor(p.y * inv_cell_size_)),
+                    i32(std::floor(p.z * inv_cell_size_))};
+    }
+
+    static i32 clamp_coord(T v, i32 lo, i32 hi) {
+        return v < T(lo) ? lo : (v > T(hi) ? hi : i32(v));
+    }
+
+    // the cell of p, clamped to the bounds of the occupied cells. Avoids
+    // overflow for queries far away from the points.
+    cell clamped_cell_of(const vec3<T> &p) const {
+        return cell{
+            clamp_coord(std::floor(p.x * inv_cell_size_), min_cell_.x, max_cell_.x),
+            clamp_coord(std::floor(p.y * inv_cell_size_), min_cell_.y, max_cell_.y),
+            clamp_coord(std::floor(p.z * inv_cell_size_), min_cell_.z, max_cell_.z)
+        };
+    }
+
+    // unique for cells less than 2^20 cells apart on each axis
+    static u64 key_of(cell c) {
+        const u64 m = (u64(1) << 21) - 1;
+        return ((u64(u32(c.x)) & m) << 42) | ((u64(u32(c.y)) & m) << 21) | 
+               (u64(u32(c.z)) & m);
+    }
+
+    std::size_t bucket_of(cell c) const {
+        return ((u64(u32(c.x)) * 73856093u) ^ (u64(u32(c.y)) * 19349663u) ^ 
+                (u64(u32(c.z)) * 83492791u)) & mask_;
+    }
+
+    template <typename F>
+    void for_each_in_cell(cell c, F &&func) const {
+        const std::size_t bucket = this->bucket_of(c);
+        const u64 key = key_of(c);
+        for (u32 s = bucket_start_[bucket]; s != bucket_end_[bucket]; ++s) {
+            if (keys_[s] == key) {
+                func(s);
+            }
+        }
+    }
+
+    static T distance_squared(const vec3<T> &a, const vec3<T> &b) {
+        return (a - b).normSquared();
+    }
+
+    // free slots behind a bucket of count points
+    static u32 slack_for(u32 count) {
+        return 1 + count / 4;
+    }
+
+    void extend_bounds(cell c) {
+        min_cell_ = cell{std::min(min_cell_.x, c.x), std::min(min_cell_.y, c.y),
+                         std::min(min_cell_.z, c.z)};
+        max_cell_ = cell{std::max(max_cell_.x, c.x), std::max(max_cell_.y, c.y),
+                         std::max(max_cell_.z, c.z)};
+    }
+
+    // remove point index from its bucket, filling the hole with the last 
+    // point of the bucket
+    void remove_point(u32 index);
+
+    // free a slot at the end of the full bucket by shifting the following 
+    // buckets up to the next one with a free slot by one. Returns false if 
+    // there is none.
+    bool make_room(std::size_t bucket);
+
+    // append point index at position p to the free slots of its bucket. 
+    // Returns false if no free slot could be found.
+    bool insert_point(u32 index, const vec3<T> &p);
+
+private:
+    T                       cell_size_;
+    T                       inv_cell_size_;
+    std::size_t             mask_;
+    // first sorted slot of every bucket, followed by the number of slots
+    std::vector<u32>        bucket_start_;
+    // one past the last occupied slot of every bucket. The slots up to the 
+    // start of the next bucket are free.
+    std::vector<u32>        bucket_end_;
+    // per sorted slot: index into the original points, position and cell key
+    std::vector<u32>        indices_;
+    std::vector<vec3<T>>    positions_;
+    std::vector<u64>        keys_;
+    // per original point: its sorted slot
+    std::vector<u32>        slots_;
+    // bounds of the occupied cells
+    cell                    min_cell_;
+    cell                    max_cell_;
+    // per original point: its bucket
+    std::vector<u32>        point_buckets_;
+    // per original point: cell key, scratch space for build
+    std::vector<u64>        point_keys_;
+    // per chunk and bucket: count, then next slot. Scratch space for build
+    std::vector<u32>        histograms_;
+};
+
+template <typename T>
+void spatial_grid<T>::build(mem_view<const vec3<T>> points, 
+                            unsigned num_threads) {
+    const std::size_t n = points.size();
+    TYPUS_REQUIRES(n < (u64(1) << 32));
+    num_threads = thread_count_for(n, num_threads);
+
+    std::size_t table_size = 1;
+    while (table_size < n) {
+        table_size *= 2;
+    }
+    mask_ = table_size - 1;
+    point_buckets_.resize(n);
+    point_keys_.resize(n);
+    histograms_.assign(num_threads * table_size, 0);
+    std::vector<cell> chunk_min(num_threads), chunk_max(num_threads);
+    const vec3<T> *p = points.begin();
+
+    // pass 1: cell, bucket and histogram per chunk
+    parallel_for_chunks(n, num_threads, 
+                        [&](unsigned chunk, std::size_t begin, std::size_t end) {
+        u32 *histogram = histograms_.data() + chunk * table_size;
+        const i32 max = std::numeric_limits<i32>::max();
+        const i32 min = std::numeric_limits<i32>::min();
+        cell lo{max, max, max};
+        cell hi{min, min, min};
+        for (std::size_t i = begin; i < end; ++i) {
+            cell c = this->cell_of(p[i]);
+            u32 bucket = u32(this->bucket_of(c));
+            point_buckets_[i] = bucket;
+            point_keys_[i] = key_of(c);
+            ++histogram[bucket];
+            lo = cell{std::min(lo.x, c.x), std::min(lo.y, c.y), std::min(lo.z, c.z)};
+            hi = cell{std::max(hi.x, c.x), std::max(hi.y, c.y), std::max(hi.z, c.z)};
+        }
+        chunk_min[chunk] = lo;
+        chunk_max[chunk] = hi;
+    });
+    min_cell_ = chunk_min[0];
+    max_cell_ = chunk_max[0];
+    for (unsigned c = 1; c < num_threads; ++c) {
+        this->extend_bounds(chunk_min[c]);
+        this->extend_bounds(chunk_max[c]);
+    }
+
+    // pass 2: exclusive prefix sum, bucket-major and chunk-minor so that 
+    // every chunk gets its own contiguous range within a bucket. The free 
+    // slots of a bucket follow its last chunk.
+    bucket_start_.resize(table_size + 1);
+    bucket_end_.resize(table_size);
+    u32 running = 0;
+    for (std::size_t b = 0; b < table_size; ++b) {
+        bucket_start_[b] = running;
+        for (unsigned c = 0; c < num_threads; ++c) {
+            u32 &count = histograms_[c * table_size + b];
+            const u32 next = running + count;
+            count = running;
+            running = next;
+        }
+        bucket_end_[b] = running;
+        running += slack_for(running - bucket_start_[b]);
+    }
+    bucket_start_[table_size] = running;
+
+    // pass 3: scatter
+    indices_.resize(running);
+    positions_.resize(running);
+    keys_.resize(running);
+    slots_.resize(n);
+    parallel_for_chunks(n, num_threads, 
+                        [&](unsigned chunk, std::size_t begin, std::size_t end) {
+        u32 *next_slot = histograms_.data() + chunk * table_size;
+        for (std::size_t i = begin; i < end; ++i) {
+            const u32 slot = next_slot[point_buckets_[i]]++;
+            indices_[slot] = u32(i);
+            positions_[slot] = p[i];
+            keys_[slot] = point_keys_[i];
+            slots_[i] = slot;
+        }
+    });
+}
+
+template <typename T>
+void spatial_grid<T>::remove_point(u32 index) {
+    const u32 slot = slots_[index];
+    const u32 last = --bucket_end_[point_buckets_[index]];
+    indices_[slot] = indices_[last];
+    positions_[slot] = positions_[last];
+    keys_[slot] = keys_[last];
+    slots_[indices_[slot]] = slot;
+}
+
+template <typename T>
+bool spatial_grid<T>::make_room(std::size_t bucket) {
+    const std::size_t table_size = bucket_end_.size();
+    std::size_t b = bucket + 1;
+    while (b < table_size && bucket_end_[b] == bucket_start_[b + 1]) {
+        ++b;
+    }
+    if (b == table_size) {
+        return false;
+    }
+    // move the first point of every bucket to the slot just past its end, 
+    // which the bucket after it has just given up
+    for (; b > bucket; --b) {
+        const u32 first = bucket_start_[b];
+        const u32 slot = bucket_end_[b];
+        if (first != slot) {
+            indices_[slot] = indices_[first];
+            positions_[slot] = positions_[first];
+            keys_[slot] = keys_[first];
+            slots_[indices_[slot]] = slot;
+        }
+        ++bucket_start_[b];
+        ++bucket_end_[b];
+    }
+    return true;
+}
+
+template <typename T>
+bool spatial_grid<T>::insert_point(u32 index, const vec3<T> &p) {
+    const cell c = this->cell_of(p);
+    const u32 bucket = u32(this->bucket_of(c));
+    if (bucket_end_[bucket] == bucket_start_[bucket + 1] && 
+        !this->make_room(bucket)) {
+        return false;
+    }
+    const u32 slot = bucket_end_[bucket]++;
+    indices_[slot] = index;
+    positions_[slot] = p;
+    keys_[slot] = key_of(c);
+    slots_[index] = slot;
+    point_buckets_[index] = bucket;
+    this->extend_bounds(c);
+    return true;
+}
+
+template <typename T>
+spatial_grid_update spatial_grid<T>::update(mem_view<const vec3<T>> points, 
+                                            unsigned num_threads) {
+    TYPUS_REQUIRES(points.size() == slots_.size());
+    const std::size_t n = points.size();
+    num_threads = thread_count_for(n, num_threads);
+    std::vector<std::vector<u32>> moved(num_threads);
+    const vec3<T> *p = points.begin();
+    parallel_for_chunks(n, num_threads, 
+                        [&](unsigned chunk, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const u32 slot = slots_[i];
+            if (key_of(this->cell_of(p[i])) == keys_[slot]) {
+                positions_[slot] = p[i];
+            } else {
+                moved[chunk].push_back(u32(i));
+            }
+        }
+    });
+    spatial_grid_update stats;
+    for (const auto &chunk : moved) {
+        stats.moved += chunk.size();
+    }
+    if (stats.moved > n / 8) {
+        this->build(points, num_threads);
+        stats.rebuilt = true;
+        return stats;
+    }
+    // remove all moved points before inserting any, so that points moving 
+    // in opposite directions between two cells free each other's slots
+    for (const auto &chunk : moved) {
+        for (u32 index : chunk) {
+            this->remove_point(index);
+        }
+    }
+    for (const auto &chunk : moved) {
+        for (u32 index : chunk) {
+            if (!this->insert_point(index, p[index])) {
+                this->build(points, num_threads);
+                stats.rebuilt = true;
+                return stats;
+            }
+        }
+    }
+    return stats;
+}
+
+template <typename T>
+template <typename F>
+void spatial_grid<T>::for_each_in_radius(const vec3<T> &p, T radius, 
+                                         F &&func) const {
+    if (this->empty()) {
+        return;
+    }
+    const vec3<T> extent(radius, radius, radius);
+    const cell lo = this->clamped_cell_of(p - extent);
+    const cell hi = this->clamped_cell_of(p + extent);
+    const T radius_squared = radius * radius;
+    for (i32 z = lo.z; z <= hi.z; ++z) {
+        for (i32 y = lo.y; y <= hi.y; ++y) {
+            for (i32 x = lo.x; x <= hi.x; ++x) {
+                this->for_each_in_cell(cell{x, y, z}, [&](u32 slot) {
+                    const T d = distance_squared(positions_[slot], p);
+                    if (d <= radius_squared) {
+                        func(indices_[slot], d);
+                    }
+                });
+            }
+        }
+    }
+}
+
+template <typename T>
+void spatial_grid<T>::query_knn(const vec3<T> &p, std::size_t k, 
+                                std::vector<u32> &out) const {
+    out.clear();
+    if (k == 0 || this->empty()) {
+        return;
+    }
+    // max-heap on distance of the best k candidates so far
+    std::vector<std::pair<T, u32>> best;
+    best.reserve(k + 1);
+    auto visit = [&](u32 slot) {
+        const T d = distance_squared(positions_[slot], p);
+        if (best.size() < k || d < best.front().first) {
+            best.emplace_back(d, indices_[slot]);
+            std::push_heap(best.begin(), best.end());
+            if (best.size() > k) {
+                std::pop_heap(best.begin(), best.end());
+                best.pop_back();
+            }
+        }
+    };
+    const cell c = this->clamped_cell_of(p);
+    for (i32 ring = 0; ; ++ring) {
+        for (i32 z = std::max(c.z - ring, min_cell_.z); 
+             z <= std::min(c.z + ring, max_cell_.z); ++z) {
+            for (i32 y = std::max(c.y - ring, min_cell_.y); 
+                 y <= std::min(c.y + ring, max_cell_.y); ++y) {
+                // on the inner rows of the ring, only the two end cells 
+                // belong to the ring
+                const bool full_row = z == c.z - ring || z == c.z + ring ||
+                                      y == c.y - ring || y == c.y + ring;
+                const i32 step = full_row ? 1 : std::max(1, 2 * ring);
+                for (i32 x = c.x - ring; x <= c.x + ring; x += step) {
+                    if (x >= min_cell_.x && x <= max_cell_.x) {
+                        this->for_each_in_cell(cell{x, y, z}, visit);
+                    }
+                }
+            }
+        }
+        const bool covers_all = c.x - ring <= min_cell_.x && 
+                                c.y - ring <= min_cell_.y &&
+                                c.z - ring <= min_cell_.z &&
+                                c.x + ring >= max_cell_.x && 
+                                c.y + ring >= max_cell_.y &&
+                                c.z + ring >= max_cell_.z;
+        if (covers_all) {
+            break;
+        }
+        if (best.size() == k) {
+            // distance from p to the closest point outside of the searched 
+            // block of cells, or 0 if p lies outside of the block
+            T bound = std::numeric_limits<T>::max();
+            const T lo[3] = { T(c.x - ring) * cell_size_, 
+                              T(c.y - ring) * cell_size_,
+                              T(c.z - ring) * cell_size_ };
+            const T q[3] = { p.x, p.y, p.z };
+            for (int axis = 0; axis < 3; ++axis) {
+                const T hi = lo[axis] + T(2 * ring + 1) * cell_size_;
+                bound = std::min(bound, std::max(T(0), std::min(q[axis] - lo[axis], 
+                                                                hi - q[axis])));
+            }
+            if (best.front().first <= bound * bound) {
+                break;
+            }
+        }
+    }
+    std::sort_heap(best.begin(), best.end());
+    out.reserve(best.size());
+    for (const auto &candidate : best) {
+        out.push_back(candidate.second);
+    }
+}
+
+}
+#endif // TYPUS_SPATIAL_GRID_HH
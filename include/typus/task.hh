@@ -0,0 +1,258 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_TASK_HH
+#define TYPUS_TASK_HH
+
+#if __cplusplus < 202002L
+#   error "typus/task.hh requires C++20 coroutine support"
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "assert.hh"
+#include "block_cache.hh"
+#include "result.hh"
+
+
+namespace typus {
+
+template <typename R>
+class task;
+
+namespace detail {
+
+template <typename R>
+struct is_result : std::false_type {};
+
+template <typename T, typename E>
+struct is_result<result<T, E>> : std::true_type {};
+
+// Awaiter for co_await on a result inside a task<result<U, E>>. If the result
+// holds a value, the coroutine continues with the extracted value. Otherwise
+// the error is stored as the task's result and control is transferred to the
+// awaiting coroutine. The failed coroutine is never resumed, its frame is 
+// released when the task object goes out of scope.
+template <typename T, typename E, typename P>
+struct result_awaiter {
+    result<T, E> value;
+
+    bool await_ready() const noexcept {
+        return value.ok();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+        h.promise().set_failed(value);
+        return h.promise().continuation();
+    }
+
+    T await_resume() {
+        return value.extract();
+    }
+};
+
+// resumes the awaiting coroutine, if any, when a task completes.
+struct final_awaiter {
+    bool await_ready() const noexcept { return false; }
+
+    template <typename P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+        return h.promise().continuation();
+    }
+
+    void await_resume() const noexcept {}
+};
+
+template <typename R>
+class task_promise {
+public:
+    task<R> get_return_object() noexcept;
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+
+    final_awaiter final_suspend() const noexcept { return {}; }
+
+    template <typename V>
+    void return_value(V && value) {
+        value_.emplace(std::forward<V>(value));
+    }
+
+    void unhandled_exception() {
+        std::terminate();
+    }
+
+    // co_await result<T, E> short-circuits on error. Only available when the
+    // task itself produces a result with the same error type.
+    template <typename T, typename E>
+    result_awaiter<T, E, task_promise> await_transform(result<T, E> value) {
+        static_assert(is_result<R>::value, 
+                      "co_await on result requires a task<result<U, E>>");
+        static_assert(std::is_same<E, typename R::error_type>::value,
+                      "error types must match");
+        return { std::move(value) };
+    }
+
+    template <typename A>
+    A && await_transform(A && awaitable) noexcept {
+        return std::forward<A>(awaitable);
+    }
+
+    // whether the task holds its value. Also true for coroutines that were
+    // suspended for good by a failed co_await on a result.
+    bool has_value() const noexcept {
+        return value_.has_value();
+    }
+
+    void set_failed(const R & failed) {
+        value_.emplace(failed);
+    }
+
+    std::coroutine_handle<> continuation() const noexcept {
+        return continuation_;
+    }
+
+    void set_continuation(std::coroutine_handle<> h) noexcept {
+        continuation_ = h;
+    }
+
+    R take() {
+        TYPUS_REQUIRES(value_.has_value());
+        return std::move(*value_);
+    }
+
+    // coroutine frames are served from the thread-local block cache.
+    static void *operator new(std::size_t n) {
+        return allocate_block(n);
+    }
+
+    static void operator delete(void *p, std::size_t n) {
+        deallocate_block(p, n);
+    }
+private:
+    std::optional<R> value_;
+    std::coroutine_handle<> continuation_ = std::noop_coroutine();
+};
+
+} // namespace detail
+
+
+/**
+ * \brief A lazily started coroutine producing a value of type R.
+ *
+ * The coroutine body runs when the task is awaited with co_await, or when
+ * \ref get is called. Typically R is a result<T, E>; inside such a coroutine,
+ * co_await on a result<U, E> evaluates to the contained value or completes
+ * the task with the error, a portable replacement for the TRY macro:
+ *
+ * \code
+ * task<result<int, error>> parse_and_add(std::string a, std::string b) {
+ *     int x = co_await parse(a);
+ *     int y = co_await parse(b);
+ *     co_return x + y;
+ * }
+ * \endcode
+ *
+ * Coroutine frames are allocated from a thread-local pool of fixed-size 
+ * blocks, so short-lived tasks do not hit the heap in steady state.
+ */
+template <typename R>
+class task {
+public:
+    using promise_type = detail::task_promise<R>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+
+    task(task && rhs) noexcept: handle_(std::exchange(rhs.handle_, nullptr)) {
+    }
+
+    task &operator=(task && rhs) noexcept {
+        if (this != &rhs) {
+            this->reset();
+            handle_ = std::exchange(rhs.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~task() {
+        this->reset();
+    }
+
+    /**
+     * \brief Whether the coroutine has produced its value.
+     */
+    bool done() const {
+        TYPUS_REQUIRES(handle_);
+        return handle_.promise().has_value();
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().set_continuation(awaiting);
+        return handle_;
+    }
+
+    R await_resume() {
+        return handle_.promise().take();
+    }
+
+    /**
+     * \brief Run the coroutine to completion on the calling thread and 
+     *    return its value.
+     *
+     * \pre The coroutine does not wait for events outside of its own chain
+     *     of tasks.
+     */
+    R get() {
+        TYPUS_REQUIRES(handle_);
+        handle_.resume();
+        TYPUS_REQUIRES(this->done());
+        return handle_.promise().take();
+    }
+private:
+    friend class detail::task_promise<R>;
+
+    explicit task(handle_type h): handle_(h) {}
+
+    void reset() {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = nullptr;
+        }
+    }
+
+    handle_type handle_;
+};
+
+namespace detail {
+
+template <typename R>
+task<R> task_promise<R>::get_return_object() noexcept {
+    return task<R>(std::coroutine_handle<task_promise>::from_promise(*this));
+}
+
+} // namespace detail
+
+} // namespace typus
+
+#endif // TYPUS_TASK_HH
@@ -0,0 +1,278 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_TRANSFORM_HH
+#define TYPUS_TRANSFORM_HH
+
+#include <algorithm>
+#include <cstddef>
+
+#include <typus/assert.hh>
+#include <typus/matrix.hh>
+#include <typus/mem_view.hh>
+#include <typus/parallel.hh>
+#include <typus/quat.hh>
+#include <typus/vec3.hh>
+#include <typus/vec3_soa.hh>
+
+#if defined(__AVX__)
+#   include <immintrin.h>
+#elif defined(__SSE__)
+#   include <xmmintrin.h>
+#endif
+
+namespace typus {
+
+namespace detail {
+
+template <bool Translate, typename T>
+inline void transform_aos(const mat4<T> &m, const vec3<T> *in, vec3<T> *out, 
+                          std::size_t n) {
+    // a local copy can't alias out, which lets the compiler vectorize
+    const mat4<T> local = m;
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = Translate ? local.transform_point(in[i]) : 
+                             local.transform_direction(in[i]);
+    }
+}
+
+#if defined(__SSE__) && !defined(__AVX512F__)
+// Four vec3_f are three registers: a = x0 y0 z0 x1, b = y1 z1 x2 y2 and 
+// c = z2 x3 y3 z3. They are transposed to x, y and z registers, transformed 
+// with broadcast matrix coefficients and transposed back. With AVX-512, 
+// the compiler vectorizes the generic loop with two-source permutes, which 
+// beats these shuffles, so it is used instead.
+template <bool Translate>
+inline void transform_aos(const mat4<f32> &m, const vec3<f32> *in, 
+                          vec3<f32> *out, std::size_t n) {
+    __m128 c[3][4];
+    for (std::size_t r = 0; r < 3; ++r) {
+        for (std::size_t k = 0; k < 4; ++k) {
+            c[r][k] = _mm_set1_ps(m.m[r][k]);
+        }
+    }
+    std::size_t i = 0;
+#   if defined(__AVX__)
+    // the same shuffles on eight points, with points 0-3 in the lower and 
+    // points 4-7 in the upper 128-bit lane of each register
+    __m256 c8[3][4];
+    for (std::size_t r = 0; r < 3; ++r) {
+        for (std::size_t k = 0; k < 4; ++k) {
+            c8[r][k] = _mm256_set1_ps(m.m[r][k]);
+        }
+    }
+    auto load2 = [](const f32 *lo) {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)), 
+                                    _mm_loadu_ps(lo + 12), 1);
+    };
+    auto store2 = [](f32 *lo, __m256 v) {
+        _mm_storeu_ps(lo, _mm256_castps256_ps128(v));
+        _mm_storeu_ps(lo + 12, _mm256_extractf128_ps(v, 1));
+    };
+    for (; i + 8 <= n; i += 8) {
+        const f32 *src = reinterpret_cast<const f32*>(in + i);
+        const __m256 a = load2(src);
+        const __m256 b = load2(src + 4);
+        const __m256 d = load2(src + 8);
+        const __m256 x2y2x3y3 = _mm256_shuffle_ps(b, d, _MM_SHUFFLE(2, 1, 3, 2));
+        const __m256 y0z0y1z1 = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));
+        const __m256 x = _mm256_shuffle_ps(a, x2y2x3y3, _MM_SHUFFLE(2, 0, 3, 0));
+        const __m256 y = _mm256_shuffle_ps(y0z0y1z1, x2y2x3y3, _MM_SHUFFLE(3, 1, 2, 0));
+        const __m256 z = _mm256_shuffle_ps(y0z0y1z1, d, _MM_SHUFFLE(3, 0, 3, 1));
+        __m256 t[3];
+        for (std::size_t r = 0; r < 3; ++r) {
+            t[r] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c8[r][0], x), 
+                                               _mm256_mul_ps(c8[r][1], y)),
+                                 _mm256_mul_ps(c8[r][2], z));
+            if (Translate) {
+                t[r] = _mm256_add_ps(t[r], c8[r][3]);
+            }
+        }
+        const __m256 xy_lo = _mm256_unpacklo_ps(t[0], t[1]);
+        const __m256 xy_hi = _mm256_unpackhi_ps(t[0], t[1]);
+        const __m256 z0z1x1y1 = _mm256_shuffle_ps(t[2], xy_lo, _MM_SHUFFLE(3, 2, 1, 0));
+        const __m256 z2z3x3y3 = _mm256_shuffle_ps(t[2], xy_hi, _MM_SHUFFLE(3, 2, 3, 2));
+        f32 *dst = reinterpret_cast<f32*>(out + i);
+        store2(dst, _mm256_shuffle_ps(xy_lo, z0z1x1y1, _MM_SHUFFLE(2, 0, 1, 0)));
+        store2(dst + 4, _mm256_shuffle_ps(z0z1x1y1, xy_hi, _MM_SHUFFLE(1, 0, 1, 3)));
+        store2(dst + 8, _mm256_shuffle_ps(z2z3x3y3, z2z3x3y3, _MM_SHUFFLE(1, 3, 2, 0)));
+    }
+#   endif
+    for (; i + 4 <= n; i += 4) {
+        const f32 *src = reinterpret_cast<const f32*>(in + i);
+        const __m128 a = _mm_loadu_ps(src);
+        const __m128 b = _mm_loadu_ps(src + 4);
+        const __m128 d = _mm_loadu_ps(src + 8);
+        const __m128 x2y2x3y3 = _mm_shuffle_ps(b, d, _MM_SHUFFLE(2, 1, 3, 2));
+        const __m128 y0z0y1z1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));
+        const __m128 x = _mm_shuffle_ps(a, x2y2x3y3, _MM_SHUFFLE(2, 0, 3, 0));
+        const __m128 y = _mm_shuffle_ps(y0z0y1z1, x2y2x3y3, _MM_SHUFFLE(3, 1, 2, 0));
+        const __m128 z = _mm_shuffle_ps(y0z0y1z1, d, _MM_SHUFFLE(3, 0, 3, 1));
+        __m128 t[3];
+        for (std::size_t r = 0; r < 3; ++r) {
+            t[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[r][0], x), _mm_mul_ps(c[r][1], y)),
+                              _mm_mul_ps(c[r][2], z));
+            if (Translate) {
+                t[r] = _mm_add_ps(t[r], c[r][3]);
+            }
+        }
+        const __m128 xy_lo = _mm_unpacklo_ps(t[0], t[1]);
+        const __m128 xy_hi = _mm_unpackhi_ps(t[0], t[1]);
+        const __m128 z0z1x1y1 = _mm_shuffle_ps(t[2], xy_lo, _MM_SHUFFLE(3, 2, 1, 0));
+        const __m128 z2z3x3y3 = _mm_shuffle_ps(t[2], xy_hi, _MM_SHUFFLE(3, 2, 3, 2));
+        f32 *dst = reinterpret_cast<f32*>(out + i);
+        _mm_storeu_ps(dst, _mm_shuffle_ps(xy_lo, z0z1x1y1, _MM_SHUFFLE(2, 0, 1, 0)));
+        _mm_storeu_ps(dst + 4, _mm_shuffle_ps(z0z1x1y1, xy_hi, _MM_SHUFFLE(1, 0, 1, 3)));
+        _mm_storeu_ps(dst + 8, _mm_shuffle_ps(z2z3x3y3, z2z3x3y3, _MM_SHUFFLE(1, 3, 2, 0)));
+    }
+    for (; i < n; ++i) {
+        out[i] = Translate ? m.transform_point(in[i]) : m.transform_direction(in[i]);
+    }
+}
+#endif
+
+// The kernel holds a copy of the coefficients rather than a pointer to the 
+// matrix, so the compiler knows the stores to out don't modify them and 
+// keeps them in registers.
+template <typename T, bool Translate>
+struct transform_kernel {
+    T m[3][4];
+    soa_pointers<T> in;
+    soa_out_pointers<T> out;
+
+    template <typename V>
+    void apply(std::size_t i) const {
+        using L = lanes<V>;
+        V x = L::load(in.x + i), y = L::load(in.y + i), z = L::load(in.z + i);
+        T *dst[3] = { out.x, out.y, out.z };
+        for (std::size_t r = 0; r < 3; ++r) {
+            V t = L::splat(m[r][0]) * x + L::splat(m[r][1]) * y + 
+                  L::splat(m[r][2]) * z;
+            if (Translate) {
+                t = t + L::splat(m[r][3]);
+            }
+            L::store(dst[r] + i, t);
+        }
+    }
+};
+
+template <bool Translate, typename T>
+void transform_aos_parallel(const mat4<T> &m, mem_view<const vec3<T>> in, 
+                            mem_view<vec3<T>> out, unsigned num_threads) {
+    TYPUS_REQUIRES(out.size() >= in.size());
+    const std::size_t n = in.size();
+    const vec3<T> *src = in.begin();
+    vec3<T> *dst = out.begin();
+    parallel_for_chunks(n, thread_count_for(n, num_threads), 
+                        [&](unsigned, std::size_t begin, std::size_t end) {
+        transform_aos<Translate>(m, src + begin, dst + begin, end - begin);
+    });
+}
+
+template <bool Translate, typename T>
+void transform_soa_parallel(const mat4<T> &m, const vec3_soa<T> &in, 
+                            vec3_soa<T> &out, unsigned num_threads) {
+    out.resize(in.size());
+    const std::size_t n = in.size();
+    parallel_for_chunks(n, thread_count_for(n, num_threads), 
+                        [&](unsigned, std::size_t begin, std::size_t end) {
+        transform_kernel<T, Translate> kernel{
+            {{m.m[0][0], m.m[0][1], m.m[0][2], m.m[0][3]},
+             {m.m[1][0], m.m[1][1], m.m[1][2], m.m[1][3]},
+             {m.m[2][0], m.m[2][1], m.m[2][2], m.m[2][3]}},
+            soa_pointers<T>(in), soa_out_pointers<T>(out)};
+        kernel.in.x += begin; kernel.in.y += begin; kernel.in.z += begin;
+        kernel.out.x += begin; kernel.out.y += begin; kernel.out.z += begin;
+        apply_kernel<T>(end - begin, kernel);
+    });
+}
+
+} // namespace detail
+
+/**
+ * \brief out[i] = m.transform_point(in[i]) for all points of \p in.
+ *
+ * The batch transforms are vectorized, for vec3_f arrays by transposing 
+ * four points at a time into SIMD registers, and split over \p num_threads 
+ * threads (0 for one per hardware thread) for large inputs. \p out must 
+ * hold in.size() elements and may be the same array as \p in, but must not 
+ * overlap it otherwise.
+ */
+template <typename T>
+void transform_points(const mat4<T> &m, mem_view<const vec3<T>> in, 
+                      mem_view<vec3<T>> out, unsigned num_threads = 1) {
+    detail::transform_aos_parallel<true>(m, in, out, num_threads);
+}
+
+/**
+ * \brief out[i] = m.transform_direction(in[i]), which ignores the 
+ *     translation.
+ */
+template <typename T>
+void transform_directions(const mat4<T> &m, mem_view<const vec3<T>> in, 
+                          mem_view<vec3<T>> out, unsigned num_threads = 1) {
+    detail::transform_aos_parallel<false>(m, in, out, num_threads);
+}
+
+template <typename T>
+void transform_points(const mat3<T> &m, mem_view<const vec3<T>> in, 
+                      mem_view<vec3<T>> out, unsigned num_threads = 1) {
+    detail::transform_aos_parallel<false>(mat4<T>(m, vec3<T>()), in, out, num_threads);
+}
+
+/**
+ * \brief Rotate all points by the unit quaternion \p q. Converts \p q to a 
+ *     matrix once, which is cheaper than quat::rotate per point.
+ */
+template <typename T>
+void transform_points(const quat<T> &q, mem_view<const vec3<T>> in, 
+                      mem_view<vec3<T>> out, unsigned num_threads = 1) {
+    detail::transform_aos_parallel<false>(mat4<T>(q.to_mat3(), vec3<T>()), 
+                                          in, out, num_threads);
+}
+
+/**
+ * \brief SoA version of \ref transform_points. \p out is resized to the size 
+ *     of \p in and may be the same object.
+ */
+template <typename T>
+void transform_points(const mat4<T> &m, const vec3_soa<T> &in, vec3_soa<T> &out, 
+                      unsigned num_threads = 1) {
+    detail::transform_soa_parallel<true>(m, in, out, num_threads);
+}
+
+template <typename T>
+void transform_directions(const mat4<T> &m, const vec3_soa<T> &in, 
+                          vec3_soa<T> &out, unsigned num_threads = 1) {
+    detail::transform_soa_parallel<false>(m, in, out, num_threads);
+}
+
+template <typename T>
+void transform_points(const mat3<T> &m, const vec3_soa<T> &in, vec3_soa<T> &out, 
+                      unsigned num_threads = 1) {
+    detail::transform_soa_parallel<false>(mat4<T>(m, vec3<T>()), in, out, num_threads);
+}
+
+template <typename T>
+void transform_points(const quat<T> &q, const vec3_soa<T> &in, vec3_soa<T> &out, 
+                      unsigned num_threads = 1) {
+    detail::transform_soa_parallel<false>(mat4<T>(q.to_mat3(), vec3<T>()), 
+                                          in, out, num_threads);
+}
+
+} // namespace
+
+#endif // TYPUS_TRANSFORM_HH
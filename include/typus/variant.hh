@@ -17,8 +17,10 @@
 #ifndef TYPUS_VARIANT_HH
 #define TYPUS_VARIANT_HH
 
+#include <cstdint>
 #include <type_traits>
 #include <tuple>
+#include <utility>
 
 namespace typus {
 
@@ -34,6 +36,26 @@ struct index_of :
 template <typename T>
 struct NOT_A_VALID_ALTERNATIVE {};
 
+template <std::size_t ...Is>
+struct index_list {};
+
+// index_list<0, ..., N-1>; C++11 replacement for std::make_index_sequence.
+template <std::size_t N, std::size_t ...Is>
+struct make_index_list : make_index_list<N - 1, N - 1, Is...> {};
+
+template <std::size_t ...Is>
+struct make_index_list<0, Is...> {
+    using type = index_list<Is...>;
+};
+
+template <bool ...Bs>
+struct bool_pack {};
+
+// true when all of the boolean arguments are true
+template <bool ...Bs>
+struct all_of : std::is_same<bool_pack<true, Bs...>, bool_pack<Bs..., true>> {
+};
+
 
 // used for calling the correct destructor
 struct destroy_stored_object {
@@ -50,9 +72,143 @@ struct copy_stored_object {
 
     template <typename T>
     void operator()(const T & object) {
-        new (&storage) T { object };
-        object.~T();
+        new (&storage) T(object);
+    }
+};
+
+// use for move construction
+template <typename S>
+struct move_stored_object {
+    S &storage;
+
+    template <typename T>
+    void operator()(T & object) {
+        new (&storage) T(std::move(object));
+    }
+};
+
+// invokes func on the storage reinterpreted as T. One instantiation per 
+// alternative makes up the dispatch table used by variant::visit.
+template <typename R, typename F, typename T, typename S>
+R invoke_as(F & func, S & storage) {
+    return func(reinterpret_cast<T&>(storage));
+}
+
+// table of function pointers indexed by the index of the selected 
+// alternative, so visitation costs a single indirect call regardless of the 
+// number of alternatives.
+template <typename R, typename F, typename S, typename ...Ts>
+struct dispatch_table {
+    using function = R (*)(F &, S &);
+    static constexpr function entries[sizeof...(Ts)] = {
+        &invoke_as<R, F, Ts, S>...
+    };
+};
+
+template <typename R, typename F, typename S, typename ...Ts>
+constexpr typename dispatch_table<R, F, S, Ts...>::function
+dispatch_table<R, F, S, Ts...>::entries[sizeof...(Ts)];
+
+// the type returned by invoking a visitor of type F on a T
+template <typename F, typename T>
+using visit_result_t = decltype(std::declval<F&>()(std::declval<T&>()));
+
+// smallest unsigned integer type that can hold the index of N alternatives
+template <std::size_t N>
+using index_type_for = 
+    typename std::conditional<(N <= 0xff), std::uint8_t,
+        typename std::conditional<(N <= 0xffff), std::uint16_t, 
+                                  std::uint32_t>::type>::type;
+
+template <typename ...Ts>
+using is_trivial_variant = all_of<(std::is_trivially_copyable<Ts>::value &&
+                                   std::is_trivially_destructible<Ts>::value)...>;
+
+// holder for the storage and index of a variant. This class is required, 
+// because we want copy, move and destruction to be trivial when they are 
+// trivial for all alternatives, which is only possible when the special 
+// member functions are defaulted.
+//
+// The index is placed after the storage and uses the smallest sufficient 
+// type, so the variant only grows by the index rounded up to the alignment of 
+// the alternatives: one byte for variant<u8, char>, but a whole u64 for 
+// variant<u32, u64>. The tail padding of the alternatives themselves is not 
+// reused, because their copy and move operations are free to overwrite it.
+template <bool, typename ...Ts>
+class variant_storage {
+protected:
+    using storage = typename std::aligned_union<0u, Ts...>::type;
+    using index_type = index_type_for<sizeof...(Ts)>;
+    using nothrow_move_constructible = all_of<
+        std::is_nothrow_move_constructible<Ts>::value...>;
+
+    variant_storage(index_type index): index_(index) {}
+
+    variant_storage(const variant_storage &rhs): index_(rhs.index_) {
+        this->dispatch(copy_stored_object<storage>{ storage_ }, rhs.storage_);
+    }
+
+    variant_storage(variant_storage &&rhs) 
+        noexcept(nothrow_move_constructible::value): index_(rhs.index_) {
+        this->dispatch(move_stored_object<storage>{ storage_ }, rhs.storage_);
+    }
+
+    variant_storage &operator=(const variant_storage &rhs) {
+        if (this == &rhs) {
+            return *this;
+        }
+        this->destroy_stored_object();
+        index_ = rhs.index_;
+        this->dispatch(copy_stored_object<storage>{ storage_ }, rhs.storage_);
+        return *this;
+    }
+
+    variant_storage &operator=(variant_storage &&rhs) 
+        noexcept(nothrow_move_constructible::value) {
+        if (this == &rhs) {
+            return *this;
+        }
+        this->destroy_stored_object();
+        index_ = rhs.index_;
+        this->dispatch(move_stored_object<storage>{ storage_ }, rhs.storage_);
+        return *this;
+    }
+
+    ~variant_storage() {
+        this->destroy_stored_object();
     }
+
+    void destroy_stored_object() {
+        this->dispatch(details::destroy_stored_object{}, storage_);
+    }
+private:
+    // dispatch on our own index, but operate on the given storage
+    template <typename F, typename S>
+    void dispatch(F func, S &s) {
+        using qualified_storage = typename std::remove_reference<S>::type;
+        using table = typename std::conditional<
+            std::is_const<qualified_storage>::value,
+            dispatch_table<void, F, const storage, const Ts...>,
+            dispatch_table<void, F, storage, Ts...>>::type;
+        table::entries[index_](func, s);
+    }
+protected:
+    storage storage_;
+    index_type index_;
+};
+
+template <typename ...Ts>
+class variant_storage<true, Ts...> {
+protected:
+    using storage = typename std::aligned_union<0u, Ts...>::type;
+    using index_type = index_type_for<sizeof...(Ts)>;
+
+    variant_storage(index_type index): index_(index) {}
+
+    void destroy_stored_object() {}
+
+    storage storage_;
+    index_type index_;
 };
 
 }
@@ -61,119 +217,267 @@ struct copy_stored_object {
  * \brief A data type holding one of multiple alternatives.
  */
 template <typename ...Ts>
-class variant {
+class variant : 
+    public details::variant_storage<details::is_trivial_variant<Ts...>::value,
+                                    Ts...> {
 private:
+    using base = 
+        details::variant_storage<details::is_trivial_variant<Ts...>::value,
+                                 Ts...>;
+    using storage = typename base::storage;
+
     // helper template for retrieving the index of the provided type
     template <typename T>
     using index_of = 
         typename details::index_of<0, T, Ts..., 
                                    details::NOT_A_VALID_ALTERNATIVE<T>>;
+
+    template <typename T>
+    using decay_t = typename std::decay<T>::type;
+
+    // restricts the forwarding constructor and assignment to alternatives, so
+    // they don't hijack copy and move of the variant itself.
+    template <typename T>
+    using enable_if_alternative = typename std::enable_if<
+        !std::is_same<decay_t<T>, variant>::value>::type;
 public:
     // helper template for retrieving the type of the Nth alternative
     template <std::size_t N>
     using type_of = typename std::tuple_element<N, std::tuple<Ts...>>::type;
 
 public:
-    variant(): index_(0) {
-        new (&storage_) type_of<0>{};
+    variant(): base(0) {
+        new (&this->storage_) type_of<0>{};
     }
 
-    template <typename T>
-    explicit variant(const T& rhs): index_(index_of<T>()) {
-        new (&storage_) T{rhs};
+    /**
+     * \brief Construct a variant holding \p rhs, either by copy or by move.
+     */
+    template <typename T, typename = enable_if_alternative<T>>
+    explicit variant(T && rhs): base(index_of<decay_t<T>>()) {
+        new (&this->storage_) decay_t<T>(std::forward<T>(rhs));
     }
 
-    explicit variant(const variant &rhs): index_(rhs.index_) {
-        details::copy_stored_object<storage> in_place_copier{ storage_ };
-        rhs.visit(in_place_copier);
-    }
+    variant(const variant &rhs) = default;
 
-    ~variant() {
-        this->destroy_stored_object();
-    }
+    /**
+     * \brief Move-construct a variant. \p rhs keeps its alternative, but the 
+     *     object it holds is left in a moved-from state.
+     */
+    variant(variant &&rhs) = default;
+
+    ~variant() = default;
 
     /**
      * \brief The index of the selected alternative 
      */
-    std::size_t index() const { return index_; }
+    std::size_t index() const { return this->index_; }
     
     template <std::size_t N>
     type_of<N> & get() { 
-        return reinterpret_cast<type_of<N>&>(storage_); 
+        return reinterpret_cast<type_of<N>&>(this->storage_); 
     }
 
     template <std::size_t N>
     const type_of<N> & get() const { 
-        return reinterpret_cast<const type_of<N>&>(storage_); 
+        return reinterpret_cast<const type_of<N>&>(this->storage_); 
     }
 
     template <typename T>
     T & get() {
-        return reinterpret_cast<T&>(storage_);
+        return reinterpret_cast<T&>(this->storage_);
     }
     template <typename T>
     const T & get() const {
-        return reinterpret_cast<const T&>(storage_);
+        return reinterpret_cast<const T&>(this->storage_);
     }
 
-    template <typename T>
-    variant &operator=(const T& rhs) {
+    /**
+     * \brief Assign \p rhs to the variant. If the variant already holds an
+     *     alternative of the same type, the object is assigned to, otherwise 
+     *     the held object is destroyed and a new one is constructed in place.
+     */
+    template <typename T, typename = enable_if_alternative<T>>
+    variant &operator=(T && rhs) {
+        using type = decay_t<T>;
+        if (this->index_ == index_of<type>()) {
+            this->get<type>() = std::forward<T>(rhs);
+            return *this;
+        }
         this->destroy_stored_object();
-        index_ = index_of<T>();
-        new (&storage_) T{rhs};
+        this->index_ = index_of<type>();
+        new (&this->storage_) type(std::forward<T>(rhs));
         return *this;
     }
 
-    variant &operator=(const variant& rhs) {
+    variant &operator=(const variant& rhs) = default;
+
+    variant &operator=(variant&& rhs) = default;
+
+    /**
+     * \brief Destroy the held object and construct the Nth alternative in
+     *     place from \p args.
+     */
+    template <std::size_t N, typename ...As>
+    type_of<N> & emplace(As &&...args) {
         this->destroy_stored_object();
-        index_ = rhs.index();
-        details::copy_stored_object<storage> in_place_copier{ storage_ };
-        rhs.visit(in_place_copier);
-        return *this;
+        this->index_ = N;
+        return *new (&this->storage_) type_of<N>(std::forward<As>(args)...);
     }
 
-    template <typename F>
-    void visit(F& func) {
-        this->visit_stored_object<F, 0, Ts...>(func);
+    /**
+     * \brief Destroy the held object and construct an alternative of type T
+     *     in place from \p args.
+     */
+    template <typename T, typename ...As>
+    T & emplace(As &&...args) {
+        return this->emplace<index_of<T>::value>(std::forward<As>(args)...);
     }
 
+    /**
+     * \brief Invoke \p func with the selected alternative and return its 
+     *     result.
+     *
+     * Dispatch goes through a table of function pointers indexed by 
+     * \ref index, so the cost does not depend on the number of 
+     * alternatives. \p func must return the same type for all alternatives.
+     */
     template <typename F>
-    void visit(F& func) const {
-        this->visit_stored_object<F, 0, Ts...>(func);
+    auto visit(F && func) -> 
+        details::visit_result_t<typename std::remove_reference<F>::type,
+                                type_of<0>> {
+        using fn = typename std::remove_reference<F>::type;
+        using result_type = details::visit_result_t<fn, type_of<0>>;
+        using table = details::dispatch_table<result_type, fn, storage, Ts...>;
+        return table::entries[this->index_](func, this->storage_);
     }
-private:
-    void destroy_stored_object() {
-        details::destroy_stored_object destroyer{};
-        this->visit(destroyer);
-    }
-    template <typename F, std::size_t I>
-    void visit_stored_object(F &func) {}
 
-    template <typename F, std::size_t I, typename X, typename ...Xs>
-    void visit_stored_object(F &func) {
-        if (I == index_) {
-            func(reinterpret_cast<X&>(storage_));
-        }
-        this->visit_stored_object<F, I+1,Xs...>(func);
+    template <typename F>
+    auto visit(F && func) const -> 
+        details::visit_result_t<typename std::remove_reference<F>::type, 
+                                const type_of<0>> {
+        using fn = typename std::remove_reference<F>::type;
+        using result_type = details::visit_result_t<fn, const type_of<0>>;
+        using table = details::dispatch_table<result_type, fn, const storage,
+                                              const Ts...>;
+        return table::entries[this->index_](func, this->storage_);
     }
+};
 
-    template <typename F, std::size_t I>
-    void visit_stored_object(F &func) const {}
+namespace details {
 
-    template <typename F, std::size_t I, typename X, typename ...Xs>
-    void visit_stored_object(F &func) const {
-        if (I == index_) {
-            func(reinterpret_cast<const X&>(storage_));
-        }
-        this->visit_stored_object<F, I+1,Xs...>(func);
+template <std::size_t ...Ns>
+struct product : std::integral_constant<std::size_t, 1> {};
+
+template <std::size_t N, std::size_t ...Ns>
+struct product<N, Ns...> : 
+    std::integral_constant<std::size_t, N * product<Ns...>::value> {};
+
+// product of the Jth and all following elements of Ns
+template <std::size_t J, std::size_t ...Ns>
+struct suffix_product : std::integral_constant<std::size_t, 1> {};
+
+template <std::size_t N, std::size_t ...Ns>
+struct suffix_product<0, N, Ns...> : product<N, Ns...> {};
+
+template <std::size_t J, std::size_t N, std::size_t ...Ns>
+struct suffix_product<J, N, Ns...> : suffix_product<J - 1, Ns...> {};
+
+// Entry K of the flattened dispatch table for visiting the variants held by
+// tuple T, whose alternative counts are Ns. The Jth variant contributes the 
+// Jth digit of K in the mixed radix system defined by Ns.
+template <typename R, typename F, typename T, typename Ns, typename Js, 
+          std::size_t K>
+struct flat_invoker;
+
+template <typename R, typename F, typename T, std::size_t ...Ns, 
+          std::size_t ...Js, std::size_t K>
+struct flat_invoker<R, F, T, index_list<Ns...>, index_list<Js...>, K> {
+    static R invoke(F & func, T & variants) {
+        return func(std::get<Js>(variants).template get<
+            (K / suffix_product<Js + 1, Ns...>::value) % 
+            (suffix_product<Js, Ns...>::value / 
+             suffix_product<Js + 1, Ns...>::value)>()...);
     }
-private:
-    using storage = typename std::aligned_union<0u, Ts...>::type;
+};
 
-    storage storage_;
-    std::size_t index_;
+template <typename R, typename F, typename T, typename Ns, typename Js, 
+          typename Ks>
+struct flat_dispatch_table;
+
+template <typename R, typename F, typename T, typename Ns, typename Js, 
+          std::size_t ...Ks>
+struct flat_dispatch_table<R, F, T, Ns, Js, index_list<Ks...>> {
+    using function = R (*)(F &, T &);
+    static constexpr function entries[sizeof...(Ks)] = {
+        &flat_invoker<R, F, T, Ns, Js, Ks>::invoke...
+    };
 };
 
+template <typename R, typename F, typename T, typename Ns, typename Js, 
+          std::size_t ...Ks>
+constexpr typename flat_dispatch_table<R, F, T, Ns, Js, index_list<Ks...>>::function
+flat_dispatch_table<R, F, T, Ns, Js, index_list<Ks...>>::entries[sizeof...(Ks)];
+
+template <typename V>
+struct variant_size;
+
+template <typename ...Ts>
+struct variant_size<variant<Ts...>> : 
+    std::integral_constant<std::size_t, sizeof...(Ts)> {};
+
+template <typename V>
+using variant_size_of = variant_size<typename std::decay<V>::type>;
+
+// the type returned by invoking F on the first alternative of each variant
+template <typename F, typename ...Vs>
+using multi_visit_result_t = decltype(std::declval<F&>()(
+    std::declval<Vs&>().template get<0>()...));
+
+template <typename R, typename F, typename ...Vs, std::size_t ...Js>
+R multi_visit(F & func, index_list<Js...>, Vs & ...variants) {
+    using sizes = index_list<variant_size_of<Vs>::value...>;
+    using tuple = std::tuple<Vs&...>;
+    using table = flat_dispatch_table<
+        R, F, tuple, sizes, index_list<Js...>,
+        typename make_index_list<product<variant_size_of<Vs>::value...>::value>::type>;
+    const std::size_t indices[] = { variants.index()... };
+    const std::size_t strides[] = { 
+        suffix_product<Js + 1, variant_size_of<Vs>::value...>::value... 
+    };
+    std::size_t flat = 0;
+    for (std::size_t j = 0; j < sizeof...(Vs); ++j) {
+        flat += indices[j] * strides[j];
+    }
+    tuple t(variants...);
+    return table::entries[flat](func, t);
+}
+
+}
+
+/**
+ * \brief Invoke \p func with the selected alternatives of all \p variants.
+ *
+ * The combinations of alternatives are enumerated in a flattened table of 
+ * function pointers at compile-time, so dispatch costs a single indirect call
+ * regardless of the number of variants. Note that the table has one entry 
+ * per combination, which grows quickly with the number of variants.
+ *
+ * \p func must return the same type for all combinations.
+ */
+template <typename F, typename ...Vs>
+auto visit(F && func, Vs && ...variants) -> 
+    details::multi_visit_result_t<typename std::remove_reference<F>::type,
+                                  typename std::remove_reference<Vs>::type...> {
+    using fn = typename std::remove_reference<F>::type;
+    using result_type = details::multi_visit_result_t<
+        fn, typename std::remove_reference<Vs>::type...>;
+    return details::multi_visit<result_type, fn, 
+                                typename std::remove_reference<Vs>::type...>(
+        func, typename details::make_index_list<sizeof...(Vs)>::type{}, 
+        variants...);
+}
+
 }
 #endif // TYPUS_VARIANT_HH
 
@@ -0,0 +1,293 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_VARIANT_VECTOR_HH
+#define TYPUS_VARIANT_VECTOR_HH
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "assert.hh"
+#include "variant.hh"
+
+
+namespace typus {
+
+namespace details {
+
+// invokes func on element offset of the Ith array. One instantiation per 
+// alternative makes up the table used for visiting in insertion order.
+template <std::size_t I, typename F, typename A>
+void invoke_element(F & func, A & arrays, std::uint32_t offset) {
+    func(std::get<I>(arrays)[offset]);
+}
+
+template <typename F, typename A, typename L>
+struct element_dispatch_table;
+
+template <typename F, typename A, std::size_t ...Is>
+struct element_dispatch_table<F, A, index_list<Is...>> {
+    using function = void (*)(F &, A &, std::uint32_t);
+    static constexpr function entries[sizeof...(Is)] = {
+        &invoke_element<Is, F, A>...
+    };
+};
+
+template <typename F, typename A, std::size_t ...Is>
+constexpr typename element_dispatch_table<F, A, index_list<Is...>>::function
+element_dispatch_table<F, A, index_list<Is...>>::entries[sizeof...(Is)];
+
+}
+
+/**
+ * \brief A sequence of objects of types Ts, partitioned by type.
+ *
+ * Instead of storing one variant<Ts...> per element, every alternative gets 
+ * its own contiguous array. Each array is sized for its own element type, 
+ * and processing all elements with \ref for_each or \ref visit_all runs one 
+ * type-homogeneous loop per alternative without per-element dispatch.
+ *
+ * Optionally, the insertion order is recorded in an order index, which 
+ * allows to visit the elements in the order they were added with 
+ * \ref visit_in_order.
+ */
+template <typename ...Ts>
+class variant_vector {
+private:
+    template <typename T>
+    using index_of = 
+        typename details::index_of<0, T, Ts..., 
+                                   details::NOT_A_VALID_ALTERNATIVE<T>>;
+
+    template <typename T>
+    using decay_t = typename std::decay<T>::type;
+
+    using arrays = std::tuple<std::vector<Ts>...>;
+public:
+    // helper template for retrieving the type of the Nth alternative
+    template <std::size_t N>
+    using type_of = typename std::tuple_element<N, std::tuple<Ts...>>::type;
+
+    /**
+     * \brief Construct an empty vector. When \p keep_order is true, the 
+     *     insertion order is recorded for \ref visit_in_order.
+     */
+    explicit variant_vector(bool keep_order=false): keep_order_(keep_order) {}
+
+    /**
+     * \brief Whether the insertion order is recorded.
+     */
+    bool keeps_order() const { return keep_order_; }
+
+    /**
+     * \brief Append \p value to the array of its type.
+     */
+    template <typename T>
+    void push_back(T && value) {
+        using type = decay_t<T>;
+        this->items<type>().push_back(std::forward<T>(value));
+        this->record<type>();
+    }
+
+    /**
+     * \brief Append an object of type T constructed in-place from \p args.
+     */
+    template <typename T, typename ...As>
+    T & emplace_back(As &&...args) {
+        std::vector<T> & a = this->items<T>();
+        a.emplace_back(std::forward<As>(args)...);
+        this->record<T>();
+        return a.back();
+    }
+
+    /**
+     * \brief The contiguous array holding all elements of type T.
+     */
+    template <typename T>
+    std::vector<T> & items() {
+        return std::get<index_of<T>::value>(arrays_);
+    }
+
+    template <typename T>
+    const std::vector<T> & items() const {
+        return std::get<index_of<T>::value>(arrays_);
+    }
+
+    /**
+     * \brief The number of elements of type T.
+     */
+    template <typename T>
+    std::size_t count() const {
+        return this->items<T>().size();
+    }
+
+    /**
+     * \brief The total number of elements.
+     */
+    std::size_t size() const {
+        return this->size_of(std::integral_constant<std::size_t, 0>{});
+    }
+
+    bool empty() const {
+        return this->size() == 0;
+    }
+
+    void clear() {
+        this->clear_arrays(std::integral_constant<std::size_t, 0>{});
+        order_.clear();
+    }
+
+    /**
+     * \brief Invoke \p func on every element of type T.
+     */
+    template <typename T, typename F>
+    void for_each(F && func) {
+        for (T & item : this->items<T>()) {
+            func(item);
+        }
+    }
+
+    template <typename T, typename F>
+    void for_each(F && func) const {
+        for (const T & item : this->items<T>()) {
+            func(item);
+        }
+    }
+
+    /**
+     * \brief Invoke \p func on every element, grouped by type. 
+     *
+     * The elements of each alternative are visited in one loop, in the order
+     * of the alternatives, so \p func must be callable with all of Ts.
+     */
+    template <typename F>
+    void visit_all(F && func) {
+        this->visit_arrays(func, std::integral_constant<std::size_t, 0>{});
+    }
+
+    template <typename F>
+    void visit_all(F && func) const {
+        this->visit_arrays(func, std::integral_constant<std::size_t, 0>{});
+    }
+
+    /**
+     * \brief Invoke \p func on every element, in insertion order. Each 
+     *    element costs one indirect call.
+     *
+     * \pre The vector has been constructed with keep_order set to true.
+     */
+    template <typename F>
+    void visit_in_order(F && func) {
+        TYPUS_REQUIRES(keep_order_);
+        using fn = typename std::remove_reference<F>::type;
+        using table = details::element_dispatch_table<
+            fn, arrays, 
+            typename details::make_index_list<sizeof...(Ts)>::type>;
+        for (const entry & e : order_) {
+            table::entries[e.alternative](func, arrays_, e.offset);
+        }
+    }
+
+    template <typename F>
+    void visit_in_order(F && func) const {
+        TYPUS_REQUIRES(keep_order_);
+        using fn = typename std::remove_reference<F>::type;
+        using table = details::element_dispatch_table<
+            fn, const arrays, 
+            typename details::make_index_list<sizeof...(Ts)>::type>;
+        for (const entry & e : order_) {
+            table::entries[e.alternative](func, arrays_, e.offset);
+        }
+    }
+private:
+    // position of an element in the order index
+    struct entry {
+        std::uint32_t alternative;
+        std::uint32_t offset;
+    };
+
+    // adds the element just appended to the array of T to the order index. 
+    // Called after the append, so a throwing constructor leaves the index 
+    // untouched; if growing the index throws, the element is removed again.
+    template <typename T>
+    void record() {
+        if (!keep_order_) {
+            return;
+        }
+        std::vector<T> & a = this->items<T>();
+        try {
+            order_.push_back(entry{ 
+                static_cast<std::uint32_t>(index_of<T>::value),
+                static_cast<std::uint32_t>(a.size() - 1) 
+            });
+        } catch (...) {
+            a.pop_back();
+            throw;
+        }
+    }
+
+    std::size_t size_of(std::integral_constant<std::size_t, sizeof...(Ts)>) const {
+        return 0;
+    }
+
+    template <std::size_t I>
+    std::size_t size_of(std::integral_constant<std::size_t, I>) const {
+        return std::get<I>(arrays_).size() + 
+               this->size_of(std::integral_constant<std::size_t, I + 1>{});
+    }
+
+    void clear_arrays(std::integral_constant<std::size_t, sizeof...(Ts)>) {}
+
+    template <std::size_t I>
+    void clear_arrays(std::integral_constant<std::size_t, I>) {
+        std::get<I>(arrays_).clear();
+        this->clear_arrays(std::integral_constant<std::size_t, I + 1>{});
+    }
+
+    template <typename F>
+    void visit_arrays(F &, std::integral_constant<std::size_t, sizeof...(Ts)>) {}
+
+    template <typename F, std::size_t I>
+    void visit_arrays(F & func, std::integral_constant<std::size_t, I>) {
+        for (auto & item : std::get<I>(arrays_)) {
+            func(item);
+        }
+        this->visit_arrays(func, std::integral_constant<std::size_t, I + 1>{});
+    }
+
+    template <typename F>
+    void visit_arrays(F &, 
+                      std::integral_constant<std::size_t, sizeof...(Ts)>) const {}
+
+    template <typename F, std::size_t I>
+    void visit_arrays(F & func, std::integral_constant<std::size_t, I>) const {
+        for (const auto & item : std::get<I>(arrays_)) {
+            func(item);
+        }
+        this->visit_arrays(func, std::integral_constant<std::size_t, I + 1>{});
+    }
+
+    arrays arrays_;
+    std::vector<entry> order_;
+    bool keep_order_;
+};
+
+} // namespace typus
+
+#endif // TYPUS_VARIANT_VECTOR_HH
@@ -19,6 +19,7 @@
 #include <cmath>
 #include <ostream>
 
+#include <typus/fast_math.hh>
 #include <typus/numbers.hh>
 
 namespace typus {
@@ -68,21 +69,41 @@ struct vec3 {
         return std::sqrt(this->normSquared());
     }
 
+    template <typename Policy = default_math>
     vec3<T> normalized() const {
         vec3 r(*this);
-        r.normalize();
+        r.template normalize<Policy>();
         return r;
     }
 
+    /**
+     * \brief Scale to unit length and return the length before scaling.
+     *
+     * Policy selects between \ref precise_math and \ref fast_math, and 
+     * defaults to \ref default_math.
+     */
+    template <typename Policy = default_math>
     f32 normalize() {
-        f32 n = this->norm();
-        f32 f = 1.0f/n;
+        T n;
+        T f = Policy::inverse_sqrt(this->normSquared(), n);
         x *= f;
         y *= f;
         z *= f;
         return n;
     }
 
+    /**
+     * \brief normalized() with \ref fast_math, regardless of the default 
+     *     policy.
+     */
+    vec3<T> normalized_fast() const {
+        return this->template normalized<fast_math>();
+    }
+
+    f32 normalize_fast() {
+        return this->template normalize<fast_math>();
+    }
+
     vec3 & operator /=(T f) {
         x /= f;
         y /= f;
@@ -135,9 +156,21 @@ inline float dot(const vec3<T>& a, const vec3<T>& b) {
 }
 
 template <typename T>
+inline vec3<T> cross(const vec3<T>& a, const vec3<T>& b) {
+    return vec3<T>(a.y * b.z - a.z * b.y, 
+                   a.z * b.x - a.x * b.z, 
+                   a.x * b.y - a.y * b.x);
+}
+
+template <typename Policy = default_math, typename T>
 inline vec3<T> reflect(const vec3<T>& v, const vec3<T>& n) {
     float d = 2.0f * dot(v, n);
-    return (d * n - v).normalized();
+    return (d * n - v).template normalized<Policy>();
+}
+
+template <typename T>
+inline vec3<T> reflect_fast(const vec3<T>& v, const vec3<T>& n) {
+    return reflect<fast_math>(v, n);
 }
 
 template <typename T>
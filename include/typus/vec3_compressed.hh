@@ -0,0 +1,237 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_VEC3_COMPRESSED_HH
+#define TYPUS_VEC3_COMPRESSED_HH
+
+#include <algorithm>
+
+#include <typus/aabb.hh>
+#include <typus/f16.hh>
+#include <typus/mem_view.hh>
+#include <typus/numbers.hh>
+#include <typus/vec3.hh>
+
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+
+namespace typus {
+
+/**
+ * \brief A half-precision vec3, 6 instead of 12 bytes per point. 
+ *
+ * The relative error is at most 2^-11 per component, so the absolute error 
+ * grows with the distance from the origin. Prefer \ref vec3_q16 for 
+ * coordinates far away from the origin.
+ */
+using vec3_h = vec3<f16>;
+
+static_assert(sizeof(vec3_h) == 6, "vec3_h must be tightly packed");
+
+inline vec3_h to_vec3_h(const vec3_f &v) {
+    return vec3_h(v.x, v.y, v.z);
+}
+
+inline vec3_f to_vec3_f(const vec3_h &v) {
+    return vec3_f(v.x, v.y, v.z);
+}
+
+/**
+ * \brief Convert points to half precision, see \ref to_f16.
+ */
+inline void encode_f16(mem_view<const vec3_f> in, mem_view<vec3_h> out) {
+    TYPUS_REQUIRES(in.size() == out.size());
+    const f32 *src = reinterpret_cast<const f32*>(in.begin());
+    f16 *dst = reinterpret_cast<f16*>(out.begin());
+    to_f16(mem_view<const f32>(src, src + 3 * in.size()), 
+           mem_view<f16>(dst, dst + 3 * out.size()));
+}
+
+inline void decode_f16(mem_view<const vec3_h> in, mem_view<vec3_f> out) {
+    TYPUS_REQUIRES(in.size() == out.size());
+    const f16 *src = reinterpret_cast<const f16*>(in.begin());
+    f32 *dst = reinterpret_cast<f32*>(out.begin());
+    to_f32(mem_view<const f16>(src, src + 3 * in.size()), 
+           mem_view<f32>(dst, dst + 3 * out.size()));
+}
+
+/**
+ * \brief A point stored as 16-bit fixed point coordinates relative to a 
+ *     bounding box, see \ref q16_quantizer.
+ */
+struct vec3_q16 {
+    u16 x = 0;
+    u16 y = 0;
+    u16 z = 0;
+};
+
+static_assert(sizeof(vec3_q16) == 6, "vec3_q16 must be tightly packed");
+
+inline bool operator == (const vec3_q16 &lhs, const vec3_q16 &rhs) {
+    return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+}
+
+inline bool operator != (const vec3_q16 &lhs, const vec3_q16 &rhs) {
+    return !operator==(lhs, rhs);
+}
+
+/**
+ * \brief Maps points inside a bounding box to and from \ref vec3_q16.
+ *
+ * Each axis of the box is divided into 65535 steps, so the error per 
+ * component is at most half a step, see \ref max_error. Unlike \ref vec3_h, 
+ * the error is uniform over the box. Points outside the box are clamped to 
+ * it.
+ */
+class q16_quantizer {
+public:
+    explicit q16_quantizer(const aabb_f &bounds): min_(bounds.min) {
+        TYPUS_REQUIRES(!bounds.empty());
+        const vec3_f e = bounds.extent();
+        scale_ = vec3_f(axis_scale(e.x), axis_scale(e.y), axis_scale(e.z));
+        step_ = e * (1.0f / 65535.0f);
+    }
+
+    vec3_q16 encode(const vec3_f &p) const {
+        vec3_q16 q;
+        q.x = quantize(p.x, min_.x, scale_.x);
+        q.y = quantize(p.y, min_.y, scale_.y);
+        q.z = quantize(p.z, min_.z, scale_.z);
+        return q;
+    }
+
+    vec3_f decode(const vec3_q16 &q) const {
+        return vec3_f(min_.x + q.x * step_.x, min_.y + q.y * step_.y, 
+                      min_.z + q.z * step_.z);
+    }
+
+    /**
+     * \brief Encode in.size() points, four at a time with SSE2.
+     */
+    void encode(mem_view<const vec3_f> in, mem_view<vec3_q16> out) const;
+
+    /**
+     * \brief Decode in.size() points, four at a time with SSE2.
+     */
+    void decode(mem_view<const vec3_q16> in, mem_view<vec3_f> out) const;
+
+    /**
+     * \brief Upper bound for the per-component error of a point inside the 
+     *     box after a round trip, up to f32 rounding.
+     */
+    vec3_f max_error() const {
+        return step_ * 0.5f;
+    }
+
+private:
+    static f32 axis_scale(f32 extent) {
+        return extent > 0.0f ? 65535.0f / extent : 0.0f;
+    }
+
+    // rounds half up, which matches the truncating conversion of v + 0.5 in 
+    // the SIMD path.
+    static u16 quantize(f32 v, f32 min, f32 scale) {
+        f32 q = std::min(std::max((v - min) * scale, 0.0f), 65535.0f);
+        return u16(q + 0.5f);
+    }
+
+    vec3_f min_;
+    vec3_f scale_;
+    vec3_f step_;
+};
+
+// The SIMD loops treat the points as a flat array of floats, respectively 
+// u16. Four points are 12 components, three registers of four lanes with 
+// the axis pattern xyzx, yzxy and zxyz.
+inline void q16_quantizer::encode(mem_view<const vec3_f> in, 
+                                  mem_view<vec3_q16> out) const {
+    TYPUS_REQUIRES(in.size() == out.size());
+    const std::size_t n = in.size();
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    const f32 *src = reinterpret_cast<const f32*>(in.begin());
+    u16 *dst = reinterpret_cast<u16*>(out.begin());
+    const __m128 min0 = _mm_setr_ps(min_.x, min_.y, min_.z, min_.x);
+    const __m128 min1 = _mm_setr_ps(min_.y, min_.z, min_.x, min_.y);
+    const __m128 min2 = _mm_setr_ps(min_.z, min_.x, min_.y, min_.z);
+    const __m128 scale0 = _mm_setr_ps(scale_.x, scale_.y, scale_.z, scale_.x);
+    const __m128 scale1 = _mm_setr_ps(scale_.y, scale_.z, scale_.x, scale_.y);
+    const __m128 scale2 = _mm_setr_ps(scale_.z, scale_.x, scale_.y, scale_.z);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 max = _mm_set1_ps(65535.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    // SSE2 only has a signed saturating pack, so pack q - 32768 and flip 
+    // the sign bit afterwards.
+    const __m128i bias32 = _mm_set1_epi32(32768);
+    const __m128i bias16 = _mm_set1_epi16(i16(-32768));
+    auto lanes = [&](const f32 *p, __m128 pmin, __m128 pscale) {
+        __m128 q = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(p), pmin), pscale);
+        q = _mm_add_ps(_mm_min_ps(_mm_max_ps(q, zero), max), half);
+        return _mm_sub_epi32(_mm_cvttps_epi32(q), bias32);
+    };
+    for (; i + 4 <= n; i += 4) {
+        const f32 *p = src + 3 * i;
+        __m128i a = lanes(p, min0, scale0);
+        __m128i b = lanes(p + 4, min1, scale1);
+        __m128i c = lanes(p + 8, min2, scale2);
+        __m128i ab = _mm_xor_si128(_mm_packs_epi32(a, b), bias16);
+        __m128i cc = _mm_xor_si128(_mm_packs_epi32(c, c), bias16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * i), ab);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 3 * i + 8), cc);
+    }
+#endif
+    for (; i < n; ++i) {
+        out[i] = this->encode(in[i]);
+    }
+}
+
+inline void q16_quantizer::decode(mem_view<const vec3_q16> in, 
+                                  mem_view<vec3_f> out) const {
+    TYPUS_REQUIRES(in.size() == out.size());
+    const std::size_t n = in.size();
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    const u16 *src = reinterpret_cast<const u16*>(in.begin());
+    f32 *dst = reinterpret_cast<f32*>(out.begin());
+    const __m128 min0 = _mm_setr_ps(min_.x, min_.y, min_.z, min_.x);
+    const __m128 min1 = _mm_setr_ps(min_.y, min_.z, min_.x, min_.y);
+    const __m128 min2 = _mm_setr_ps(min_.z, min_.x, min_.y, min_.z);
+    const __m128 step0 = _mm_setr_ps(step_.x, step_.y, step_.z, step_.x);
+    const __m128 step1 = _mm_setr_ps(step_.y, step_.z, step_.x, step_.y);
+    const __m128 step2 = _mm_setr_ps(step_.z, step_.x, step_.y, step_.z);
+    const __m128i zero = _mm_setzero_si128();
+    auto lanes = [](__m128i q, __m128 pmin, __m128 pstep) {
+        return _mm_add_ps(pmin, _mm_mul_ps(_mm_cvtepi32_ps(q), pstep));
+    };
+    for (; i + 4 <= n; i += 4) {
+        const u16 *q = src + 3 * i;
+        __m128i ab = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+        __m128i c = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(q + 8));
+        f32 *p = dst + 3 * i;
+        _mm_storeu_ps(p, lanes(_mm_unpacklo_epi16(ab, zero), min0, step0));
+        _mm_storeu_ps(p + 4, lanes(_mm_unpackhi_epi16(ab, zero), min1, step1));
+        _mm_storeu_ps(p + 8, lanes(_mm_unpacklo_epi16(c, zero), min2, step2));
+    }
+#endif
+    for (; i < n; ++i) {
+        out[i] = this->decode(in[i]);
+    }
+}
+
+} // namespace
+
+#endif // TYPUS_VEC3_COMPRESSED_HH
@@ -0,0 +1,511 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_VEC3_SOA_HH
+#define TYPUS_VEC3_SOA_HH
+
+#include <cmath>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "assert.hh"
+#include "fast_math.hh"
+#include "mem_view.hh"
+#include "numbers.hh"
+#include "vec3.hh"
+
+#if defined(__AVX__)
+#   include <immintrin.h>
+#elif defined(__SSE__)
+#   include <xmmintrin.h>
+#endif
+
+
+namespace typus {
+
+/**
+ * \brief Minimal allocator returning memory aligned to Align bytes, e.g. 
+ *     for SIMD loads that should not straddle cache lines.
+ */
+template <typename T, std::size_t Align>
+struct aligned_allocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = aligned_allocator<U, Align>; };
+
+    aligned_allocator() = default;
+
+    template <typename U>
+    aligned_allocator(const aligned_allocator<U, Align> &) {}
+
+    T *allocate(std::size_t n) {
+        // over-allocate and keep the pointer returned by operator new right 
+        // in front of the aligned block.
+        void *raw = ::operator new(n * sizeof(T) + Align + sizeof(void*));
+        std::size_t addr = reinterpret_cast<std::size_t>(raw) + sizeof(void*);
+        void *aligned = reinterpret_cast<void*>((addr + Align - 1) & ~(Align - 1));
+        static_cast<void**>(aligned)[-1] = raw;
+        return static_cast<T*>(aligned);
+    }
+
+    void deallocate(T *p, std::size_t) {
+        ::operator delete(reinterpret_cast<void**>(p)[-1]);
+    }
+
+    template <typename U>
+    bool operator==(const aligned_allocator<U, Align> &) const { return true; }
+
+    template <typename U>
+    bool operator!=(const aligned_allocator<U, Align> &) const { return false; }
+};
+
+/**
+ * \brief Structure-of-arrays container of vec3<T>. 
+ *
+ * The x, y and z coordinates are stored in three separate arrays aligned to 
+ * 64 bytes. Together with the batch kernels below (add, scale, dot, cross, 
+ * norm, normalize, reflect), this allows to process many vectors at once 
+ * with SIMD instructions rather than one vec3 at a time.
+ */
+template <typename T>
+class vec3_soa {
+public:
+    using array_type = std::vector<T, aligned_allocator<T, 64>>;
+
+    vec3_soa() = default;
+
+    explicit vec3_soa(std::size_t size): x_(size), y_(size), z_(size) {}
+
+    std::size_t size() const { return x_.size(); }
+
+    bool empty() const { return x_.empty(); }
+
+    void resize(std::size_t size) {
+        x_.resize(size);
+        y_.resize(size);
+        z_.resize(size);
+    }
+
+    void reserve(std::size_t size) {
+        x_.reserve(size);
+        y_.reserve(size);
+        z_.reserve(size);
+    }
+
+    void clear() {
+        x_.clear();
+        y_.clear();
+        z_.clear();
+    }
+
+    void push_back(const vec3<T> &v) {
+        x_.push_back(v.x);
+        y_.push_back(v.y);
+        z_.push_back(v.z);
+    }
+
+    /**
+     * \brief Gathers the vector at \p index.
+     */
+    vec3<T> operator[](std::size_t index) const {
+        TYPUS_REQUIRES(index < this->size());
+        return vec3<T>(x_[index], y_[index], z_[index]);
+    }
+
+    void set(std::size_t index, const vec3<T> &v) {
+        TYPUS_REQUIRES(index < this->size());
+        x_[index] = v.x;
+        y_[index] = v.y;
+        z_[index] = v.z;
+    }
+
+    T *x() { return x_.data(); }
+    T *y() { return y_.data(); }
+    T *z() { return z_.data(); }
+    const T *x() const { return x_.data(); }
+    const T *y() const { return y_.data(); }
+    const T *z() const { return z_.data(); }
+private:
+    array_type x_;
+    array_type y_;
+    array_type z_;
+};
+
+using vec3_soa_f = vec3_soa<f32>;
+
+namespace detail {
+
+// Per-lane operations used by the batch kernels. The kernels are written 
+// once against lanes<V>, and instantiated with V = T for the scalar loop and 
+// V = f32_pack for the SIMD loop.
+template <typename V>
+struct lanes {
+    static constexpr std::size_t width = 1;
+    static V load(const V *p) { return *p; }
+    static void store(V *p, V v) { *p = v; }
+    static V splat(V v) { return v; }
+    static V sqrt(V v) { return std::sqrt(v); }
+    static V rsqrt_fast(V v) { return typus::rsqrt_fast(v); }
+};
+
+#if defined(__AVX__) || defined(__SSE__)
+#   define TYPUS_HAS_F32_PACK 1
+
+struct f32_pack {
+#   if defined(__AVX__)
+    __m256 v;
+#   else
+    __m128 v;
+#   endif
+};
+
+#   if defined(__AVX__)
+inline f32_pack operator+(f32_pack a, f32_pack b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline f32_pack operator-(f32_pack a, f32_pack b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline f32_pack operator*(f32_pack a, f32_pack b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline f32_pack operator/(f32_pack a, f32_pack b) { return {_mm256_div_ps(a.v, b.v)}; }
+
+template <>
+struct lanes<f32_pack> {
+    static constexpr std::size_t width = 8;
+    static f32_pack load(const f32 *p) { return {_mm256_loadu_ps(p)}; }
+    static void store(f32 *p, f32_pack v) { _mm256_storeu_ps(p, v.v); }
+    static f32_pack splat(f32 v) { return {_mm256_set1_ps(v)}; }
+    static f32_pack sqrt(f32_pack v) { return {_mm256_sqrt_ps(v.v)}; }
+    static f32_pack rsqrt_fast(f32_pack v) { return {rsqrt_fast_ps(v.v)}; }
+};
+#   else
+inline f32_pack operator+(f32_pack a, f32_pack b) { return {_mm_add_ps(a.v, b.v)}; }
+inline f32_pack operator-(f32_pack a, f32_pack b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline f32_pack operator*(f32_pack a, f32_pack b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline f32_pack operator/(f32_pack a, f32_pack b) { return {_mm_div_ps(a.v, b.v)}; }
+
+template <>
+struct lanes<f32_pack> {
+    static constexpr std::size_t width = 4;
+    static f32_pack load(const f32 *p) { return {_mm_loadu_ps(p)}; }
+    static void store(f32 *p, f32_pack v) { _mm_storeu_ps(p, v.v); }
+    static f32_pack splat(f32 v) { return {_mm_set1_ps(v)}; }
+    static f32_pack sqrt(f32_pack v) { return {_mm_sqrt_ps(v.v)}; }
+    static f32_pack rsqrt_fast(f32_pack v) { return {rsqrt_fast_ps(v.v)}; }
+};
+#   endif
+#endif
+
+// Runs op.template apply<V>(i) for all i in [0, n), with V = f32_pack for 
+// as many full packs as possible when T is f32, and V = T otherwise. 
+template <typename T, typename Op>
+inline std::size_t apply_packed(std::size_t, const Op &, std::false_type) {
+    return 0;
+}
+
+#if defined(TYPUS_HAS_F32_PACK)
+template <typename T, typename Op>
+inline std::size_t apply_packed(std::size_t n, const Op &op, std::true_type) {
+    const std::size_t width = lanes<f32_pack>::width;
+    std::size_t i = 0;
+    for (; i + width <= n; i += width) {
+        op.template apply<f32_pack>(i);
+    }
+    return i;
+}
+#endif
+
+template <typename T, typename Op>
+inline void apply_kernel(std::size_t n, const Op &op) {
+#if defined(TYPUS_HAS_F32_PACK)
+    using packed = std::integral_constant<bool, std::is_same<T, f32>::value>;
+#else
+    using packed = std::false_type;
+#endif
+    std::size_t i = apply_packed<T>(n, op, packed{});
+    for (; i < n; ++i) {
+        op.template apply<T>(i);
+    }
+}
+
+template <typename T>
+struct soa_pointers {
+    explicit soa_pointers(const vec3_soa<T> &v): x(v.x()), y(v.y()), z(v.z()) {}
+    const T *x;
+    const T *y;
+    const T *z;
+};
+
+template <typename T>
+struct soa_out_pointers {
+    explicit soa_out_pointers(vec3_soa<T> &v): x(v.x()), y(v.y()), z(v.z()) {}
+    T *x;
+    T *y;
+    T *z;
+};
+
+template <typename T>
+struct add_kernel {
+    soa_pointers<T> a, b;
+    soa_out_pointers<T> out;
+
+    template <typename V>
+    void apply(std::size_t i) const {
+        using L = lanes<V>;
+        L::store(out.x + i, L::load(a.x + i) + L::load(b.x + i));
+        L::store(out.y + i, L::load(a.y + i) + L::load(b.y + i));
+        L::store(out.z + i, L::load(a.z + i) + L::load(b.z + i));
+    }
+};
+
+template <typename T>
+struct scale_kernel {
+    soa_pointers<T> a;
+    T factor;
+    soa_out_pointers<T> out;
+
+    template <typename V>
+    void apply(std::size_t i) const {
+        using L = lanes<V>;
+        V f = L::splat(factor);
+        L::store(out.x + i, L::load(a.x + i) * f);
+        L::store(out.y + i, L::load(a.y + i) * f);
+        L::store(out.z + i, L::load(a.z + i) * f);
+    }
+};
+
+template <typename T>
+struct dot_kernel {
+    soa_pointers<T> a, b;
+    T *out;
+
+    template <typename V>
+    void apply(std::size_t i) const {
+        using L = lanes<V>;
+        L::store(out + i, L::load(a.x + i) * L::load(b.x + i) + 
+                          L::load(a.y + i) * L::load(b.y + i) +
+                          L::load(a.z + i) * L::load(b.z + i));
+    }
+};
+
+template <typename T>
+struct cross_kernel {
+    soa_pointers<T> a, b;
+    soa_out_pointers<T> out;
+
+    template <typename V>
+    void apply(std::size_t i) const {
+        using L = lanes<V>;
+        V ax = L::load(a.x + i), ay = L::load(a.y + i), az = L::load(a.z + i);
+        V bx = L::load(b.x + i), by = L::load(b.y + i), bz = L::load(b.z + i);
+        L::store(out.x + i, ay * bz - az * by);
+        L::store(out.y + i, az * bx - ax * bz);
+        L::store(out.z + i, ax * by - ay * bx);
+    }
+};
+
+template <typename T>
+struct norm_kernel {
+    soa_pointers<T> a;
+    T *out;
+
+    template <typename V>
+    void apply(std::size_t i) const {
+        using L = lanes<V>;
+        V x = L::load(a.x + i), y = L::load(a.y + i), z = L::load(a.z + i);
+        L::store(out + i, L::sqrt(x * x + y * y + z * z));
+    }
+};
+
+// 1/sqrt(x) per lane, as computed by Policy
+template <typename Policy>
+struct lane_inverse_sqrt;
+
+template <>
+struct lane_inverse_sqrt<precise_math> {
+    template <typename L, typename V, typename T>
+    static V apply(V x) { return L::splat(T(1)) / L::sqrt(x); }
+};
+
+template <>
+struct lane_inverse_sqrt<fast_math> {
+    template <typename L, typename V, typename T>
+    static V apply(V x) { return L::rsqrt_fast(x); }
+};
+
+// scales x, y, z by 1/norm and stores them to out, like vec3::normalize.
+template <typename Policy, typename V, typename T>
+inline void store_normalized(const soa_out_pointers<T> &out, std::size_t i, 
+                             V x, V y, V z) {
+    using L = lanes<V>;
+    V f = lane_inverse_sqrt<Policy>::template apply<L, V, T>(x * x + y * y + z * z);
+    L::store(out.x + i, x * f);
+    L::store(out.y + i, y * f);
+    L::store(out.z + i, z * f);
+}
+
+template <typename T, typename Policy>
+struct normalize_kernel {
+    soa_pointers<T> a;
+    soa_out_pointers<T> out;
+
+    template <typename V>
+    void apply(std::size_t i) const {
+        using L = lanes<V>;
+        store_normalized<Policy, V>(out, i, L::load(a.x + i), L::load(a.y + i), 
+                                    L::load(a.z + i));
+    }
+};
+
+template <typename T, typename Policy>
+struct reflect_kernel {
+    soa_pointers<T> v, n;
+    soa_out_pointers<T> out;
+
+    template <typename V>
+    void apply(std::size_t i) const {
+        using L = lanes<V>;
+        V vx = L::load(v.x + i), vy = L::load(v.y + i), vz = L::load(v.z + i);
+        V nx = L::load(n.x + i), ny = L::load(n.y + i), nz = L::load(n.z + i);
+        V d = L::splat(T(2)) * (vx * nx + vy * ny + vz * nz);
+        store_normalized<Policy, V>(out, i, d * nx - vx, d * ny - vy, d * nz - vz);
+    }
+};
+
+}
+
+/**
+ * \brief out[i] = a[i] + b[i]
+ *
+ * All batch kernels resize \p out to the size of the inputs. \p out may be 
+ * the same object as one of the inputs.
+ */
+template <typename T>
+void add(const vec3_soa<T> &a, const vec3_soa<T> &b, vec3_soa<T> &out) {
+    TYPUS_REQUIRES(a.size() == b.size());
+    out.resize(a.size());
+    detail::apply_kernel<T>(a.size(), detail::add_kernel<T>{
+        detail::soa_pointers<T>(a), detail::soa_pointers<T>(b),
+        detail::soa_out_pointers<T>(out)});
+}
+
+/**
+ * \brief out[i] = a[i] * factor
+ */
+template <typename T>
+void scale(const vec3_soa<T> &a, T factor, vec3_soa<T> &out) {
+    out.resize(a.size());
+    detail::apply_kernel<T>(a.size(), detail::scale_kernel<T>{
+        detail::soa_pointers<T>(a), factor, detail::soa_out_pointers<T>(out)});
+}
+
+/**
+ * \brief out[i] = dot(a[i], b[i]). \p out must hold a.size() elements.
+ */
+template <typename T>
+void dot(const vec3_soa<T> &a, const vec3_soa<T> &b, mem_view<T> out) {
+    TYPUS_REQUIRES(a.size() == b.size() && out.size() >= a.size());
+    detail::apply_kernel<T>(a.size(), detail::dot_kernel<T>{
+        detail::soa_pointers<T>(a), detail::soa_pointers<T>(b), out.begin()});
+}
+
+/**
+ * \brief out[i] = cross(a[i], b[i])
+ */
+template <typename T>
+void cross(const vec3_soa<T> &a, const vec3_soa<T> &b, vec3_soa<T> &out) {
+    TYPUS_REQUIRES(a.size() == b.size());
+    out.resize(a.size());
+    detail::apply_kernel<T>(a.size(), detail::cross_kernel<T>{
+        detail::soa_pointers<T>(a), detail::soa_pointers<T>(b),
+        detail::soa_out_pointers<T>(out)});
+}
+
+/**
+ * \brief out[i] = a[i].norm(). \p out must hold a.size() elements.
+ */
+template <typename T>
+void norm(const vec3_soa<T> &a, mem_view<T> out) {
+    TYPUS_REQUIRES(out.size() >= a.size());
+    detail::apply_kernel<T>(a.size(), detail::norm_kernel<T>{
+        detail::soa_pointers<T>(a), out.begin()});
+}
+
+/**
+ * \brief out[i] = a[i].normalized<Policy>()
+ */
+template <typename Policy = default_math, typename T>
+void normalize(const vec3_soa<T> &a, vec3_soa<T> &out) {
+    out.resize(a.size());
+    detail::apply_kernel<T>(a.size(), detail::normalize_kernel<T, Policy>{
+        detail::soa_pointers<T>(a), detail::soa_out_pointers<T>(out)});
+}
+
+template <typename T>
+void normalize_fast(const vec3_soa<T> &a, vec3_soa<T> &out) {
+    normalize<fast_math>(a, out);
+}
+
+/**
+ * \brief out[i] = reflect<Policy>(v[i], n[i]), see \ref reflect(const 
+ *     vec3<T>&, const vec3<T>&).
+ */
+template <typename Policy = default_math, typename T>
+void reflect(const vec3_soa<T> &v, const vec3_soa<T> &n, vec3_soa<T> &out) {
+    TYPUS_REQUIRES(v.size() == n.size());
+    out.resize(v.size());
+    detail::apply_kernel<T>(v.size(), detail::reflect_kernel<T, Policy>{
+        detail::soa_pointers<T>(v), detail::soa_pointers<T>(n),
+        detail::soa_out_pointers<T>(out)});
+}
+
+template <typename T>
+void reflect_fast(const vec3_soa<T> &v, const vec3_soa<T> &n, vec3_soa<T> &out) {
+    reflect<fast_math>(v, n, out);
+}
+
+/**
+ * \brief Transpose an array of vec3<T> to structure-of-arrays layout. 
+ */
+template <typename T>
+void to_soa(mem_view<const vec3<T>> in, vec3_soa<T> &out) {
+    out.resize(in.size());
+    T *x = out.x(), *y = out.y(), *z = out.z();
+    const vec3<T> *v = in.begin();
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        x[i] = v[i].x;
+        y[i] = v[i].y;
+        z[i] = v[i].z;
+    }
+}
+
+/**
+ * \brief Transpose structure-of-arrays back to an array of vec3<T>. \p out 
+ *     must hold in.size() elements.
+ */
+template <typename T>
+void to_aos(const vec3_soa<T> &in, mem_view<vec3<T>> out) {
+    TYPUS_REQUIRES(out.size() >= in.size());
+    const T *x = in.x(), *y = in.y(), *z = in.z();
+    vec3<T> *v = out.begin();
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        v[i].x = x[i];
+        v[i].y = y[i];
+        v[i].z = z[i];
+    }
+}
+
+}
+#endif // TYPUS_VEC3_SOA_HH
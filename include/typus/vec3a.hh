@@ -0,0 +1,351 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+
+#ifndef TYPUS_VEC3A_HH
+#define TYPUS_VEC3A_HH
+
+#include <cmath>
+#include <ostream>
+
+#include <typus/fast_math.hh>
+#include <typus/numbers.hh>
+#include <typus/vec3.hh>
+
+#if defined(__SSE__)
+#   include <xmmintrin.h>
+#endif
+
+namespace typus {
+
+/**
+ * \brief A vec3 padded to four components and aligned to their combined 
+ *     size, so it can live in a single SIMD register.
+ *
+ * vec3a has the same operations as vec3, but since the components may be 
+ * held in a register, they are accessed through x(), y() and z() rather 
+ * than as data members. The padding component is always zero.
+ *
+ * The generic version stores four T. vec3a<f32> is specialized to use an 
+ * __m128 when SSE is available.
+ */
+template <typename T>
+class alignas(4 * sizeof(T)) vec3a {
+public:
+    vec3a(): v_{0, 0, 0, 0} {}
+
+    vec3a(T px, T py, T pz): v_{px, py, pz, 0} {}
+
+    explicit vec3a(const vec3<T> &v): v_{v.x, v.y, v.z, 0} {}
+
+    vec3a(const vec3a &rhs) = default;
+
+    vec3a& operator=(const vec3a &rhs) = default;
+
+    T x() const { return v_[0]; }
+    T y() const { return v_[1]; }
+    T z() const { return v_[2]; }
+
+    vec3<T> to_vec3() const {
+        return vec3<T>(v_[0], v_[1], v_[2]);
+    }
+
+    vec3a &operator-=(const vec3a& rhs) {
+        for (int i = 0; i < 3; ++i) { v_[i] -= rhs.v_[i]; }
+        return *this;
+    }
+
+    vec3a operator-(const vec3a &rhs) const {
+        vec3a r(*this);
+        r-= rhs;
+        return r;
+    }
+
+    vec3a &operator+=(const vec3a& rhs) {
+        for (int i = 0; i < 3; ++i) { v_[i] += rhs.v_[i]; }
+        return *this;
+    }
+
+    vec3a operator+(const vec3a &rhs) const {
+        vec3a r(*this);
+        r+= rhs;
+        return r;
+    }
+
+    T normSquared() const {
+        return v_[0] * v_[0] + v_[1] * v_[1] + v_[2] * v_[2];
+    }
+
+    T norm() const {
+        return std::sqrt(this->normSquared());
+    }
+
+    template <typename Policy = default_math>
+    vec3a normalized() const {
+        vec3a r(*this);
+        r.template normalize<Policy>();
+        return r;
+    }
+
+    template <typename Policy = default_math>
+    T normalize() {
+        T n;
+        *this *= Policy::inverse_sqrt(this->normSquared(), n);
+        return n;
+    }
+
+    vec3a normalized_fast() const {
+        return this->template normalized<fast_math>();
+    }
+
+    T normalize_fast() {
+        return this->template normalize<fast_math>();
+    }
+
+    vec3a & operator /=(T f) {
+        for (int i = 0; i < 3; ++i) { v_[i] /= f; }
+        return *this;
+    }
+
+    vec3a & operator *=(T f) {
+        for (int i = 0; i < 3; ++i) { v_[i] *= f; }
+        return *this;
+    }
+
+    vec3a operator *(T f) const {
+        vec3a r(*this);
+        r *= f;
+        return r;
+    }
+
+    vec3a xxx() const { return vec3a(v_[0], v_[0], v_[0]); }
+    vec3a yyy() const { return vec3a(v_[1], v_[1], v_[1]); }
+    vec3a zzz() const { return vec3a(v_[2], v_[2], v_[2]); }
+    vec3a zyx() const { return vec3a(v_[2], v_[1], v_[0]); }
+
+    bool operator==(const vec3a &rhs) const {
+        return v_[0] == rhs.v_[0] && v_[1] == rhs.v_[1] && v_[2] == rhs.v_[2];
+    }
+private:
+    T v_[4];
+};
+
+template <typename T>
+inline T dot(const vec3a<T> &a, const vec3a<T> &b) {
+    return a.x() * b.x() + a.y() * b.y() + a.z() * b.z();
+}
+
+template <typename T>
+inline vec3a<T> cross(const vec3a<T> &a, const vec3a<T> &b) {
+    return vec3a<T>(a.y() * b.z() - a.z() * b.y(),
+                    a.z() * b.x() - a.x() * b.z(),
+                    a.x() * b.y() - a.y() * b.x());
+}
+
+#if defined(__SSE__)
+
+namespace detail {
+
+// lane i of the result is lane Ii of v
+template <int I0, int I1, int I2, int I3>
+inline __m128 shuffle_ps(__m128 v) {
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(I3, I2, I1, I0));
+}
+
+// x * x + y * y + z * z in the lowest lane, ignoring the highest lane. 
+// Measured faster than SSE4.1's dpps, which decodes to several uops.
+inline __m128 dot3_ps(__m128 a, __m128 b) {
+    __m128 m = _mm_mul_ps(a, b);
+    __m128 s = _mm_add_ss(m, shuffle_ps<1, 1, 1, 1>(m));
+    return _mm_add_ss(s, _mm_movehl_ps(m, m));
+}
+
+}
+
+template <>
+class alignas(16) vec3a<f32> {
+public:
+    vec3a(): v_(_mm_setzero_ps()) {}
+
+    vec3a(f32 px, f32 py, f32 pz): v_(_mm_set_ps(0.0f, pz, py, px)) {}
+
+    explicit vec3a(const vec3<f32> &v): vec3a(v.x, v.y, v.z) {}
+
+    explicit vec3a(__m128 v): v_(v) {}
+
+    vec3a(const vec3a &rhs) = default;
+
+    vec3a& operator=(const vec3a &rhs) = default;
+
+    f32 x() const { return _mm_cvtss_f32(v_); }
+    f32 y() const { return _mm_cvtss_f32(shuffle<1, 1, 1, 1>(v_)); }
+    f32 z() const { return _mm_cvtss_f32(_mm_movehl_ps(v_, v_)); }
+
+    vec3<f32> to_vec3() const {
+        alignas(16) f32 c[4];
+        _mm_store_ps(c, v_);
+        return vec3<f32>(c[0], c[1], c[2]);
+    }
+
+    /**
+     * \brief The register holding x, y, z and the zero padding, from the 
+     *     lowest to the highest lane.
+     */
+    __m128 simd() const { return v_; }
+
+    vec3a &operator-=(const vec3a& rhs) {
+        v_ = _mm_sub_ps(v_, rhs.v_);
+        return *this;
+    }
+
+    vec3a operator-(const vec3a &rhs) const {
+        return vec3a(_mm_sub_ps(v_, rhs.v_));
+    }
+
+    vec3a &operator+=(const vec3a& rhs) {
+        v_ = _mm_add_ps(v_, rhs.v_);
+        return *this;
+    }
+
+    vec3a operator+(const vec3a &rhs) const {
+        return vec3a(_mm_add_ps(v_, rhs.v_));
+    }
+
+    f32 normSquared() const {
+        return _mm_cvtss_f32(dot3(v_, v_));
+    }
+
+    f32 norm() const {
+        return _mm_cvtss_f32(_mm_sqrt_ss(dot3(v_, v_)));
+    }
+
+    template <typename Policy = default_math>
+    vec3a normalized() const {
+        vec3a r(*this);
+        r.template normalize<Policy>();
+        return r;
+    }
+
+    template <typename Policy = default_math>
+    f32 normalize() {
+        __m128 sq = dot3(v_, v_);
+        __m128 n;
+        __m128 f = inverse_sqrt(sq, n, Policy());
+        v_ = _mm_mul_ps(v_, shuffle<0, 0, 0, 0>(f));
+        return _mm_cvtss_f32(n);
+    }
+
+    vec3a normalized_fast() const {
+        return this->template normalized<fast_math>();
+    }
+
+    f32 normalize_fast() {
+        return this->template normalize<fast_math>();
+    }
+
+    vec3a & operator /=(f32 f) {
+        // keeps the padding at zero also for f == 0
+        v_ = _mm_div_ps(v_, _mm_set_ps(1.0f, f, f, f));
+        return *this;
+    }
+
+    vec3a & operator *=(f32 f) {
+        v_ = _mm_mul_ps(v_, _mm_set1_ps(f));
+        return *this;
+    }
+
+    vec3a operator *(f32 f) const {
+        return vec3a(_mm_mul_ps(v_, _mm_set1_ps(f)));
+    }
+
+    vec3a xxx() const { return vec3a(shuffle<0, 0, 0, 3>(v_)); }
+    vec3a yyy() const { return vec3a(shuffle<1, 1, 1, 3>(v_)); }
+    vec3a zzz() const { return vec3a(shuffle<2, 2, 2, 3>(v_)); }
+    vec3a zyx() const { return vec3a(shuffle<2, 1, 0, 3>(v_)); }
+
+    bool operator==(const vec3a &rhs) const {
+        return (_mm_movemask_ps(_mm_cmpeq_ps(v_, rhs.v_)) & 0x7) == 0x7;
+    }
+private:
+    template <int I0, int I1, int I2, int I3>
+    static __m128 shuffle(__m128 v) {
+        return detail::shuffle_ps<I0, I1, I2, I3>(v);
+    }
+
+    static __m128 dot3(__m128 a, __m128 b) {
+        return detail::dot3_ps(a, b);
+    }
+
+    // 1/sqrt and sqrt of the lowest lane
+    static __m128 inverse_sqrt(__m128 x, __m128 &root, precise_math) {
+        root = _mm_sqrt_ss(x);
+        return _mm_div_ss(_mm_set_ss(1.0f), root);
+    }
+
+    static __m128 inverse_sqrt(__m128 x, __m128 &root, fast_math) {
+        __m128 r = rsqrt_fast_ps(x);
+        root = _mm_mul_ss(x, r);
+        return r;
+    }
+
+    __m128 v_;
+};
+
+inline f32 dot(const vec3a<f32> &a, const vec3a<f32> &b) {
+    return _mm_cvtss_f32(detail::dot3_ps(a.simd(), b.simd()));
+}
+
+inline vec3a<f32> cross(const vec3a<f32> &a, const vec3a<f32> &b) {
+    // the components of a * b.yzx - a.yzx * b are in zxy order
+    __m128 a_yzx = detail::shuffle_ps<1, 2, 0, 3>(a.simd());
+    __m128 b_yzx = detail::shuffle_ps<1, 2, 0, 3>(b.simd());
+    __m128 c = _mm_sub_ps(_mm_mul_ps(a.simd(), b_yzx), 
+                          _mm_mul_ps(a_yzx, b.simd()));
+    return vec3a<f32>(detail::shuffle_ps<1, 2, 0, 3>(c));
+}
+
+#endif
+
+template <typename T>
+vec3a<T> operator*(T lhs, const vec3a<T>& rhs) {
+    return rhs * lhs;
+}
+
+template <typename Policy = default_math, typename T>
+inline vec3a<T> reflect(const vec3a<T>& v, const vec3a<T>& n) {
+    T d = T(2) * dot(v, n);
+    return (d * n - v).template normalized<Policy>();
+}
+
+template <typename T>
+inline vec3a<T> reflect_fast(const vec3a<T>& v, const vec3a<T>& n) {
+    return reflect<fast_math>(v, n);
+}
+
+template <typename T>
+bool operator != (const vec3a<T> &lhs, const vec3a<T> &rhs) {
+    return !(lhs == rhs);
+}
+
+template <typename T>
+std::ostream &operator <<(std::ostream &s, const vec3a<T> &v) {
+    return (s << "{" << v.x() << ", " << v.y() << ", " << v.z() << "}");
+}
+
+using vec3a_f = vec3a<f32>;
+
+} // namespace
+
+#endif // TYPUS_VEC3A_HH
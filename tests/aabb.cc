@@ -0,0 +1,60 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/aabb.hh>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+TEST(Aabb, empty_and_extend) {
+    aabb_f box;
+    ASSERT_TRUE(box.empty());
+    ASSERT_EQ(0.0f, box.surface_area());
+    box.extend(vec3_f(1.0f, 2.0f, 3.0f));
+    ASSERT_FALSE(box.empty());
+    ASSERT_EQ(box.min, box.max);
+    box.extend(aabb_f(vec3_f(-1.0f, 0.0f, 0.0f), vec3_f(0.0f, 4.0f, 3.0f)));
+    ASSERT_EQ(aabb_f(vec3_f(-1.0f, 0.0f, 0.0f), vec3_f(1.0f, 4.0f, 3.0f)), box);
+    ASSERT_EQ(vec3_f(0.0f, 2.0f, 1.5f), box.center());
+    ASSERT_EQ(vec3_f(2.0f, 4.0f, 3.0f), box.extent());
+    ASSERT_EQ(2.0f * (8.0f + 12.0f + 6.0f), box.surface_area());
+}
+
+TEST(Aabb, contains_and_overlaps) {
+    aabb_f box(vec3_f(0.0f, 0.0f, 0.0f), vec3_f(1.0f, 1.0f, 1.0f));
+    ASSERT_TRUE(box.contains(vec3_f(0.5f, 1.0f, 0.0f)));
+    ASSERT_FALSE(box.contains(vec3_f(0.5f, 1.5f, 0.0f)));
+    ASSERT_TRUE(box.overlaps(aabb_f(vec3_f(1.0f, 1.0f, 1.0f), vec3_f(2.0f, 2.0f, 2.0f))));
+    ASSERT_FALSE(box.overlaps(aabb_f(vec3_f(1.5f, 0.0f, 0.0f), vec3_f(2.0f, 2.0f, 2.0f))));
+}
+
+TEST(Aabb, ray_intersection) {
+    aabb_f box(vec3_f(1.0f, -1.0f, -1.0f), vec3_f(2.0f, 1.0f, 1.0f));
+    vec3_f origin(0.0f, 0.0f, 0.0f);
+    vec3_f inv_dir(1.0f, 1.0f / 0.0f, 1.0f / 0.0f);
+    f32 t_min = 0.0f, t_max = 100.0f;
+    ASSERT_TRUE(box.intersect(origin, inv_dir, t_min, t_max));
+    ASSERT_EQ(1.0f, t_min);
+    ASSERT_EQ(2.0f, t_max);
+    t_min = 0.0f;
+    t_max = 0.5f;
+    ASSERT_FALSE(box.intersect(origin, inv_dir, t_min, t_max));
+    // pointing away
+    t_min = 0.0f;
+    t_max = 100.0f;
+    ASSERT_FALSE(box.intersect(origin, vec3_f(-1.0f, 1.0f / 0.0f, 1.0f / 0.0f), 
+                               t_min, t_max));
+}
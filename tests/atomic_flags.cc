@@ -0,0 +1,124 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/atomic_flags.hh>
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+namespace {
+
+enum class State : u32 {
+    Connected = 0x01,
+    Authenticated = 0x02,
+    Closing = 0x04
+};
+
+}
+
+TEST(AtomicFlags, construction) {
+    atomic_flags<State> a;
+    ASSERT_EQ(0u, a.load().bits());
+    atomic_flags<State> b(State::Closing);
+    ASSERT_EQ(0x04u, b.load().bits());
+    atomic_flags<State> c(flags<State>(State::Connected, State::Closing));
+    ASSERT_EQ(0x05u, c.load().bits());
+    ASSERT_TRUE(c.is_lock_free());
+}
+
+TEST(AtomicFlags, set_clear_test) {
+    atomic_flags<State> a;
+    a.set(State::Connected);
+    a.set(flags<State>(State::Authenticated, State::Closing), 
+          std::memory_order_release);
+    ASSERT_EQ(0x07u, a.load(std::memory_order_acquire).bits());
+    a.clear(State::Authenticated);
+    ASSERT_TRUE(a.test(State::Connected));
+    ASSERT_FALSE(a.test(State::Authenticated, std::memory_order_relaxed));
+    a.clear(flags<State>(State::Connected, State::Closing));
+    ASSERT_TRUE(a.load().none());
+    a.store(flags<State>(State::Closing));
+    ASSERT_EQ(0x04u, a.exchange(flags<State>(State::Connected)).bits());
+    a.clear_all();
+    ASSERT_EQ(0u, a.load().bits());
+}
+
+TEST(AtomicFlags, fetch_ops_return_previous) {
+    atomic_flags<State> a(State::Connected);
+    ASSERT_EQ(0x01u, a.fetch_or(State::Closing).bits());
+    ASSERT_EQ(0x05u, a.fetch_and(State::Closing).bits());
+    ASSERT_EQ(0x04u, a.fetch_xor(flags<State>(State::Closing, 
+                                              State::Authenticated)).bits());
+    ASSERT_EQ(0x02u, a.load().bits());
+    ASSERT_FALSE(a.test_and_set(State::Connected));
+    ASSERT_TRUE(a.test_and_set(State::Connected));
+}
+
+TEST(AtomicFlags, compare_exchange) {
+    atomic_flags<State> a(State::Connected);
+    flags<State> expected(State::Closing);
+    ASSERT_FALSE(a.compare_exchange_strong(expected, 
+                                           flags<State>(State::Authenticated)));
+    ASSERT_EQ(0x01u, expected.bits());
+    ASSERT_TRUE(a.compare_exchange_strong(expected, 
+                                          flags<State>(State::Authenticated),
+                                          std::memory_order_acq_rel,
+                                          std::memory_order_acquire));
+    ASSERT_EQ(0x02u, a.load().bits());
+    while (!a.compare_exchange_weak(expected, expected | State::Closing)) {
+    }
+    ASSERT_EQ(0x06u, a.load().bits());
+}
+
+TEST(AtomicFlags, test_and_set_has_single_winner) {
+    atomic_flags<State> a;
+    std::atomic<int> winners(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&]() {
+            if (!a.test_and_set(State::Connected, std::memory_order_acq_rel)) {
+                winners.fetch_add(1);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(1, winners.load());
+}
+
+TEST(AtomicFlags, concurrent_set_and_clear) {
+    enum Bit : u64 { };
+    atomic_flags<Bit> a;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&a, i]() {
+            Bit own = static_cast<Bit>(u64(1) << i);
+            for (int j = 0; j < 10000; ++j) {
+                a.set(own, std::memory_order_relaxed);
+                a.clear(own, std::memory_order_relaxed);
+            }
+            a.set(own, std::memory_order_relaxed);
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(0xffu, a.load().bits());
+}
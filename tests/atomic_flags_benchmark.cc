@@ -0,0 +1,120 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <typus/atomic_flags.hh>
+
+namespace ty = typus;
+
+enum class State : ty::u32 { };
+
+static State bit(int i) {
+    return static_cast<State>(ty::u32(1) << (i % 32));
+}
+
+// The baseline: flags protected by a mutex, as used before atomic_flags was 
+// available.
+class locked_flags {
+public:
+    void set(State value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flags_ |= value;
+    }
+    void clear(State value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flags_ = flags_ & ~ty::flags<State>(value);
+    }
+    bool test(State value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return flags_.is_set(value);
+    }
+private:
+    std::mutex      mutex_;
+    ty::flags<State> flags_;
+};
+
+class lock_free_flags {
+public:
+    void set(State value) {
+        flags_.set(value, std::memory_order_release);
+    }
+    void clear(State value) {
+        flags_.clear(value, std::memory_order_release);
+    }
+    bool test(State value) {
+        return flags_.test(value, std::memory_order_acquire);
+    }
+private:
+    ty::atomic_flags<State> flags_;
+};
+
+// Every thread repeatedly sets, tests and clears its own bit in the shared 
+// flags. All threads hit the same cache line, so this measures behaviour 
+// under maximum contention. Returns millions of operations per second.
+template <typename F>
+double contention(int num_threads, int ops_per_thread) {
+    F flags;
+    std::vector<std::thread> threads;
+    std::vector<long> hits(num_threads, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&flags, &hits, t, ops_per_thread]() {
+            State own = bit(t);
+            long hit = 0;
+            for (int i = 0; i < ops_per_thread; i += 3) {
+                flags.set(own);
+                hit += flags.test(own);
+                flags.clear(own);
+            }
+            hits[t] = hit;
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    if (hits[0] == 0) {
+        std::cerr << "unexpected checksum\n";
+    }
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    return double(num_threads) * ops_per_thread / seconds * 1e-6;
+}
+
+int main(int argc, const char **argv) {
+    const int ops = argc > 1 ? std::atoi(argv[1]) : 3000000;
+    const int max_threads = argc > 2 ? std::atoi(argv[2]) :
+        static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::cout << "threads, mutex flags (Mops/s), atomic_flags (Mops/s)\n";
+    // powers of two, followed by max_threads itself
+    std::vector<int> thread_counts;
+    for (int n = 1; n < max_threads; n *= 2) {
+        thread_counts.push_back(n);
+    }
+    thread_counts.push_back(max_threads);
+    for (int n : thread_counts) {
+        double locked = contention<locked_flags>(n, ops);
+        double lock_free = contention<lock_free_flags>(n, ops);
+        std::cout << n << ", " << locked << ", " << lock_free << "\n";
+    }
+    return 0;
+}
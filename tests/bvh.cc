@@ -0,0 +1,192 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/bvh.hh>
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+namespace {
+
+struct soup {
+    std::vector<vec3_f> vertices;
+    std::vector<u32> indices;
+
+    mem_view<const vec3_f> vertex_view() const {
+        return mem_view<const vec3_f>(vertices.data(), 
+                                      vertices.data() + vertices.size());
+    }
+
+    mem_view<const u32> index_view() const {
+        return mem_view<const u32>(indices.data(), indices.data() + indices.size());
+    }
+};
+
+// small random triangles scattered in a cube
+soup random_triangles(std::size_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<f32> pos(-10.0f, 10.0f), off(-1.0f, 1.0f);
+    soup s;
+    for (std::size_t i = 0; i < n; ++i) {
+        vec3_f c(pos(rng), pos(rng), pos(rng));
+        for (int v = 0; v < 3; ++v) {
+            s.vertices.push_back(c + vec3_f(off(rng), off(rng), off(rng)));
+            s.indices.push_back(u32(s.vertices.size() - 1));
+        }
+    }
+    return s;
+}
+
+std::vector<ray_f> random_rays(std::size_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<f32> pos(-12.0f, 12.0f), dir(-1.0f, 1.0f);
+    std::vector<ray_f> rays;
+    for (std::size_t i = 0; i < n; ++i) {
+        rays.push_back(ray_f(vec3_f(pos(rng), pos(rng), pos(rng)),
+                             vec3_f(dir(rng), dir(rng), dir(rng)).normalized(),
+                             0.0f, i % 2 ? 5.0f : 1000.0f));
+    }
+    return rays;
+}
+
+bool brute_force(const soup &s, const ray_f &r, ray_hit<f32> &hit) {
+    bool found = false;
+    f32 t_max = r.t_max;
+    for (u32 i = 0; i < s.indices.size() / 3; ++i) {
+        const vec3_f &v0 = s.vertices[s.indices[3 * i]];
+        f32 t, u, v;
+        if (intersect_triangle(r, v0, s.vertices[s.indices[3 * i + 1]] - v0, 
+                               s.vertices[s.indices[3 * i + 2]] - v0, t_max, 
+                               t, u, v)) {
+            t_max = t;
+            hit.primitive = i;
+            hit.t = t;
+            found = true;
+        }
+    }
+    return found;
+}
+
+}
+
+TEST(Bvh, node_layout) {
+    ASSERT_EQ(32u, sizeof(bvh_node<f32>));
+}
+
+TEST(Bvh, triangle_intersection) {
+    ray_f r(vec3_f(0.25f, 0.25f, -1.0f), vec3_f(0.0f, 0.0f, 1.0f));
+    vec3_f v0(0.0f, 0.0f, 0.0f), e1(1.0f, 0.0f, 0.0f), e2(0.0f, 1.0f, 0.0f);
+    f32 t, u, v;
+    ASSERT_TRUE(intersect_triangle(r, v0, e1, e2, r.t_max, t, u, v));
+    ASSERT_FLOAT_EQ(1.0f, t);
+    ASSERT_FLOAT_EQ(0.25f, u);
+    ASSERT_FLOAT_EQ(0.25f, v);
+    ASSERT_FALSE(intersect_triangle(r, v0, e1, e2, 0.5f, t, u, v));
+    ray_f miss(vec3_f(0.75f, 0.75f, -1.0f), vec3_f(0.0f, 0.0f, 1.0f));
+    ASSERT_FALSE(intersect_triangle(miss, v0, e1, e2, miss.t_max, t, u, v));
+}
+
+TEST(Bvh, empty) {
+    triangle_bvh_f bvh;
+    soup s;
+    bvh.build(s.vertex_view(), s.index_view());
+    ray_hit<f32> hit;
+    ASSERT_FALSE(bvh.closest_hit(ray_f(vec3_f(), vec3_f(1.0f, 0.0f, 0.0f)), hit));
+    ASSERT_FALSE(bvh.any_hit(ray_f(vec3_f(), vec3_f(1.0f, 0.0f, 0.0f))));
+}
+
+TEST(Bvh, structure) {
+    soup s = random_triangles(2000, 1);
+    triangle_bvh_f bvh;
+    bvh_build_options options;
+    options.max_leaf_size = 4;
+    bvh.build(s.vertex_view(), s.index_view(), options);
+    const auto &nodes = bvh.hierarchy().nodes();
+    // every primitive is in exactly one leaf, and children are contained in 
+    // their parents
+    std::vector<int> seen(2000, 0);
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].is_leaf()) {
+            for (u32 s = nodes[i].offset; s < nodes[i].offset + nodes[i].count; ++s) {
+                ++seen[bvh.hierarchy().primitives()[s]];
+            }
+            continue;
+        }
+        for (std::size_t child : {i + 1, std::size_t(nodes[i].offset)}) {
+            for (int a = 0; a < 3; ++a) {
+                ASSERT_LE(nodes[i].min[a], nodes[child].min[a]);
+                ASSERT_GE(nodes[i].max[a], nodes[child].max[a]);
+            }
+        }
+    }
+    ASSERT_EQ(std::vector<int>(2000, 1), seen);
+}
+
+TEST(Bvh, queries_match_brute_force) {
+    soup s = random_triangles(2000, 2);
+    triangle_bvh_f bvh;
+    bvh.build(s.vertex_view(), s.index_view());
+    std::vector<ray_f> rays = random_rays(512, 3);
+    int hits = 0;
+    for (const ray_f &r : rays) {
+        ray_hit<f32> expected, actual;
+        bool found = brute_force(s, r, expected);
+        ASSERT_EQ(found, bvh.closest_hit(r, actual));
+        ASSERT_EQ(found, bvh.any_hit(r));
+        if (found) {
+            ASSERT_EQ(expected.primitive, actual.primitive);
+            ASSERT_FLOAT_EQ(expected.t, actual.t);
+            ++hits;
+        }
+    }
+    // the test is only meaningful if both cases occur
+    ASSERT_GT(hits, 50);
+    ASSERT_LT(hits, 500);
+}
+
+template <std::size_t N>
+void check_packets() {
+    soup s = random_triangles(2000, 4);
+    triangle_bvh_f bvh;
+    bvh.build(s.vertex_view(), s.index_view());
+    std::vector<ray_f> rays = random_rays(N * 64, 5);
+    for (std::size_t p = 0; p < rays.size(); p += N) {
+        ray_f packet[N];
+        ray_hit<f32> hits[N];
+        std::copy(rays.begin() + p, rays.begin() + p + N, packet);
+        u32 mask = bvh.closest_hit(packet, hits);
+        u32 any_mask = bvh.any_hit(packet);
+        for (std::size_t l = 0; l < N; ++l) {
+            ray_hit<f32> expected;
+            bool found = bvh.closest_hit(packet[l], expected);
+            ASSERT_EQ(found, bool((mask >> l) & 1));
+            ASSERT_EQ(found, bool((any_mask >> l) & 1));
+            if (found) {
+                ASSERT_EQ(expected.primitive, hits[l].primitive);
+                ASSERT_EQ(expected.t, hits[l].t);
+                ASSERT_EQ(expected.u, hits[l].u);
+            }
+        }
+    }
+}
+
+TEST(Bvh, packets) {
+    check_packets<4>();
+    check_packets<8>();
+}
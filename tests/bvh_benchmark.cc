@@ -0,0 +1,133 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <typus/bvh.hh>
+
+namespace ty = typus;
+
+template <typename F>
+double time_ms(F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// a res x res height field of overlapping sine waves over [-1, 1]^2
+void make_terrain(int res, std::vector<ty::vec3_f> &vertices, 
+                  std::vector<ty::u32> &indices) {
+    for (int j = 0; j < res; ++j) {
+        for (int i = 0; i < res; ++i) {
+            ty::f32 x = 2.0f * i / (res - 1) - 1.0f;
+            ty::f32 z = 2.0f * j / (res - 1) - 1.0f;
+            ty::f32 y = 0.1f * std::sin(7.0f * x) * std::cos(5.0f * z) + 
+                        0.03f * std::sin(31.0f * x + 17.0f * z);
+            vertices.push_back(ty::vec3_f(x, y, z));
+        }
+    }
+    for (int j = 0; j + 1 < res; ++j) {
+        for (int i = 0; i + 1 < res; ++i) {
+            ty::u32 a = j * res + i, b = a + 1, c = a + res, d = c + 1;
+            indices.insert(indices.end(), {a, b, c, b, d, c});
+        }
+    }
+}
+
+// camera looking down on the terrain at an angle
+ty::ray_f camera_ray(int x, int y, int width, int height) {
+    const ty::vec3_f eye(0.0f, 1.2f, -2.0f);
+    ty::f32 u = (x + 0.5f) / width - 0.5f, v = (y + 0.5f) / height - 0.5f;
+    ty::vec3_f dir = ty::vec3_f(u * 1.5f, -0.5f - v * 1.5f, 1.0f).normalized();
+    return ty::ray_f(eye, dir);
+}
+
+int main(int argc, const char **argv) {
+    const int res = argc > 1 ? std::atoi(argv[1]) : 512;
+    const int width = argc > 2 ? std::atoi(argv[2]) : 512;
+    const int height = width;
+    const double num_rays = double(width) * height;
+
+    std::vector<ty::vec3_f> vertices;
+    std::vector<ty::u32> indices;
+    make_terrain(res, vertices, indices);
+    ty::triangle_bvh_f bvh;
+    double build_ms = time_ms([&]() {
+        bvh.build(ty::mem_view<const ty::vec3_f>(vertices.data(), 
+                                                 vertices.data() + vertices.size()),
+                  ty::mem_view<const ty::u32>(indices.data(), 
+                                              indices.data() + indices.size()));
+    });
+
+    std::size_t hits_single = 0, hits_any = 0, hits_4 = 0, hits_8 = 0;
+    double single_ms = time_ms([&]() {
+        ty::ray_hit<ty::f32> hit;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                hits_single += bvh.closest_hit(camera_ray(x, y, width, height), hit);
+            }
+        }
+    });
+    double any_ms = time_ms([&]() {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                hits_any += bvh.any_hit(camera_ray(x, y, width, height));
+            }
+        }
+    });
+    // 2x2 and 4x2 pixel tiles, so rays of a packet are coherent
+    double packet4_ms = time_ms([&]() {
+        ty::ray_f rays[4];
+        ty::ray_hit<ty::f32> hits[4];
+        for (int y = 0; y < height; y += 2) {
+            for (int x = 0; x < width; x += 2) {
+                for (int l = 0; l < 4; ++l) {
+                    rays[l] = camera_ray(x + l % 2, y + l / 2, width, height);
+                }
+                hits_4 += ty::popcount(bvh.closest_hit(rays, hits));
+            }
+        }
+    });
+    double packet8_ms = time_ms([&]() {
+        ty::ray_f rays[8];
+        ty::ray_hit<ty::f32> hits[8];
+        for (int y = 0; y < height; y += 2) {
+            for (int x = 0; x < width; x += 4) {
+                for (int l = 0; l < 8; ++l) {
+                    rays[l] = camera_ray(x + l % 4, y + l / 4, width, height);
+                }
+                hits_8 += ty::popcount(bvh.closest_hit(rays, hits));
+            }
+        }
+    });
+    if (hits_single != hits_4 || hits_single != hits_8 || hits_single != hits_any) {
+        std::cerr << "hit count mismatch\n";
+        return 1;
+    }
+    std::cout << indices.size() / 3 << " triangles, " << bvh.hierarchy().nodes().size() 
+              << " nodes, build " << build_ms << " ms\n"
+              << width << "x" << height << " camera rays, " 
+              << 100.0 * hits_single / num_rays << "% hit (Mrays/s)\n"
+              << "  closest hit:           " << num_rays / single_ms * 1e-3 << "\n"
+              << "  any hit:               " << num_rays / any_ms * 1e-3 << "\n"
+              << "  closest hit, 4 rays:   " << num_rays / packet4_ms * 1e-3 << "\n"
+              << "  closest hit, 8 rays:   " << num_rays / packet8_ms * 1e-3 << "\n";
+    return 0;
+}
@@ -0,0 +1,75 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/cpu.hh>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+TEST(Cpu, features_include_what_we_are_compiled_for) {
+    const cpu_features &f = cpu();
+#if defined(__SSE2__)
+    EXPECT_TRUE(f.sse2);
+#endif
+#if defined(__AVX2__)
+    EXPECT_TRUE(f.avx2);
+    EXPECT_TRUE(f.avx);
+#endif
+#if defined(__AVX512F__)
+    EXPECT_TRUE(f.avx512f);
+#endif
+    // features depending on the wider registers imply AVX
+    EXPECT_TRUE(f.avx || !(f.avx2 || f.fma || f.f16c || f.avx512f));
+    EXPECT_TRUE(f.avx512f || !(f.avx512bw || f.avx512vl || f.avx512dq));
+    EXPECT_EQ(&f, &cpu());
+}
+
+TEST(Cpu, levels_follow_features) {
+    cpu_features f;
+    EXPECT_EQ(simd_isa::scalar, detail::simd_isa_of(f));
+    f.sse2 = true;
+    f.avx2 = f.fma = f.f16c = f.bmi1 = true;
+    // BMI2 missing
+    EXPECT_EQ(simd_isa::sse2, detail::simd_isa_of(f));
+    f.bmi2 = true;
+    EXPECT_EQ(simd_isa::avx2, detail::simd_isa_of(f));
+    f.avx512f = f.avx512dq = f.avx512bw = true;
+    EXPECT_EQ(simd_isa::avx2, detail::simd_isa_of(f));
+    f.avx512vl = true;
+    EXPECT_EQ(simd_isa::avx512, detail::simd_isa_of(f));
+    EXPECT_LE(active_simd_isa(), detected_simd_isa());
+}
+
+TEST(Cpu, override_only_lowers_the_level) {
+    using detail::apply_simd_isa_override;
+    EXPECT_EQ(simd_isa::avx2, apply_simd_isa_override(simd_isa::avx2, nullptr));
+    EXPECT_EQ(simd_isa::sse2, apply_simd_isa_override(simd_isa::avx2, "sse2"));
+    EXPECT_EQ(simd_isa::scalar, apply_simd_isa_override(simd_isa::avx2, "scalar"));
+    EXPECT_EQ(simd_isa::avx2, apply_simd_isa_override(simd_isa::avx2, "avx512"));
+    EXPECT_EQ(simd_isa::avx2, apply_simd_isa_override(simd_isa::avx2, "AVX2"));
+    EXPECT_EQ(simd_isa::avx2, apply_simd_isa_override(simd_isa::avx2, ""));
+}
+
+TEST(Cpu, isa_names_round_trip) {
+    for (simd_isa isa : { simd_isa::scalar, simd_isa::sse2, simd_isa::avx2, simd_isa::avx512 }) {
+        simd_isa parsed = simd_isa::scalar;
+        EXPECT_TRUE(parse_simd_isa(simd_isa_name(isa), parsed));
+        EXPECT_EQ(isa, parsed);
+    }
+    simd_isa unchanged = simd_isa::sse2;
+    EXPECT_FALSE(parse_simd_isa("neon", unchanged));
+    EXPECT_EQ(simd_isa::sse2, unchanged);
+}
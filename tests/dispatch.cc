@@ -0,0 +1,61 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/dispatch.hh>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+namespace {
+
+using kernel_fn = int (*)(int);
+
+int scalar_kernel(int x) { return x; }
+int sse2_kernel(int x) { return x + 100; }
+int avx512_kernel(int x) { return x + 300; }
+
+TYPUS_TARGET_AVX2 int avx2_kernel(int x) { return x + 200; }
+
+}
+
+TEST(Dispatch, resolves_to_best_variant_not_above_level) {
+    dispatched<kernel_fn> table(scalar_kernel);
+    EXPECT_EQ(1, table.resolve(simd_isa::avx512)(1));
+    table.add(simd_isa::sse2, sse2_kernel);
+    EXPECT_EQ(1, table.resolve(simd_isa::scalar)(1));
+    EXPECT_EQ(101, table.resolve(simd_isa::sse2)(1));
+    EXPECT_EQ(101, table.resolve(simd_isa::avx2)(1));
+    table.add(simd_isa::avx512, avx512_kernel);
+    EXPECT_EQ(101, table.resolve(simd_isa::avx2)(1));
+    EXPECT_EQ(301, table.resolve(simd_isa::avx512)(1));
+}
+
+TEST(Dispatch, calls_variant_for_active_level) {
+    dispatched<kernel_fn> table(scalar_kernel);
+    table.add(simd_isa::sse2, sse2_kernel)
+         .add(simd_isa::avx2, avx2_kernel)
+         .add(simd_isa::avx512, avx512_kernel);
+    const simd_isa isa = active_simd_isa();
+    EXPECT_EQ(table.resolve(isa), table.get());
+    EXPECT_EQ(1 + 100 * int(isa), table(1));
+}
+
+TEST(Dispatch, adding_a_variant_resolves_again) {
+    dispatched<kernel_fn> table(scalar_kernel);
+    EXPECT_EQ(1, table(1));
+    table.add(simd_isa::scalar, sse2_kernel);
+    EXPECT_EQ(101, table(1));
+}
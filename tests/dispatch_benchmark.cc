@@ -0,0 +1,96 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <typus/f16.hh>
+
+namespace ty = typus;
+
+template <typename F>
+double best_ms(F &&f) {
+    double best = 1e30;
+    for (int run = 0; run < 5; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    return best;
+}
+
+// Runs the f16 bulk conversions through each variant up to the detected 
+// level, through the dispatched entry points, and measures the cost of a 
+// dispatched call for a tiny kernel. Set TYPUS_SIMD_ISA to see the entry 
+// points follow the override.
+int main(int argc, const char **argv) {
+    const std::size_t n = argc > 1 ? std::atoll(argv[1]) : 10000000;
+    const ty::cpu_features &f = ty::cpu();
+    std::cout << "cpu: sse2 " << f.sse2 << ", avx2 " << f.avx2 << ", fma " << f.fma 
+              << ", f16c " << f.f16c << ", bmi2 " << f.bmi2 << ", avx512f " << f.avx512f 
+              << ", avx512bw " << f.avx512bw << ", avx512vl " << f.avx512vl << std::endl;
+    std::cout << "detected level " << ty::simd_isa_name(ty::detected_simd_isa()) 
+              << ", active level " << ty::simd_isa_name(ty::active_simd_isa()) << std::endl;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<ty::f32> dist(-1000.0f, 1000.0f);
+    std::vector<ty::f32> values(n), back(n);
+    for (auto &v : values) {
+        v = dist(rng);
+    }
+    std::vector<ty::u16> halfs(n);
+    std::cout << n << " values" << std::endl;
+    const ty::simd_isa levels[] = { ty::simd_isa::scalar, ty::simd_isa::sse2, 
+                                    ty::simd_isa::avx2, ty::simd_isa::avx512 };
+    for (ty::simd_isa isa : levels) {
+        if (isa > ty::detected_simd_isa()) {
+            break;
+        }
+        auto encode = ty::detail::f32_to_f16_kernels().resolve(isa);
+        auto decode = ty::detail::f16_to_f32_kernels().resolve(isa);
+        double encode_ms = best_ms([&]() { encode(values.data(), halfs.data(), n); });
+        double decode_ms = best_ms([&]() { decode(halfs.data(), back.data(), n); });
+        std::cout << ty::simd_isa_name(isa) << " variant: to_f16 " << encode_ms 
+                  << " ms, to_f32 " << decode_ms << " ms (" << back[n / 2] << ")" << std::endl;
+    }
+    ty::mem_view<const ty::f32> in(values.data(), values.data() + n);
+    ty::mem_view<ty::f16> out(reinterpret_cast<ty::f16*>(halfs.data()), 
+                              reinterpret_cast<ty::f16*>(halfs.data()) + n);
+    std::cout << "to_f16 entry point: " << best_ms([&]() { ty::to_f16(in, out); }) 
+              << " ms" << std::endl;
+
+    // per-call overhead: converting 8 values at a time, the dispatched call 
+    // against the resolved pointer held by the caller
+    const std::size_t calls = n / 8;
+    auto &kernels = ty::detail::f32_to_f16_kernels();
+    auto direct = kernels.get();
+    double dispatched_ms = best_ms([&]() {
+        for (std::size_t i = 0; i < calls; ++i) {
+            kernels(values.data() + 8 * i, halfs.data() + 8 * i, 8);
+        }
+    });
+    double direct_ms = best_ms([&]() {
+        for (std::size_t i = 0; i < calls; ++i) {
+            direct(values.data() + 8 * i, halfs.data() + 8 * i, 8);
+        }
+    });
+    std::cout << calls << " calls of 8 values: dispatched " << dispatched_ms 
+              << " ms, cached pointer " << direct_ms << " ms" << std::endl;
+    return 0;
+}
@@ -0,0 +1,87 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/enum_set.hh>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+enum class Capability : unsigned short {
+    Login = 0,
+    ReadUsers = 1,
+    WriteUsers = 63,
+    ReadAudit = 64,
+    WriteAudit = 130,
+    Last = 299
+};
+
+using capabilities = enum_set<Capability, Capability::Last>;
+
+TEST(EnumSet, size) {
+    ASSERT_EQ(300u, capabilities::bit_count);
+    ASSERT_EQ(5u, capabilities::word_count);
+}
+
+TEST(EnumSet, insert_erase_contains) {
+    capabilities caps;
+    ASSERT_TRUE(caps.none());
+    caps.insert(Capability::WriteAudit);
+    caps.insert(Capability::Last);
+    ASSERT_TRUE(caps.any());
+    ASSERT_TRUE(caps.contains(Capability::WriteAudit));
+    ASSERT_TRUE(caps.contains(Capability::Last));
+    ASSERT_FALSE(caps.contains(Capability::Login));
+    ASSERT_EQ(2u, caps.count());
+    caps.erase(Capability::WriteAudit);
+    ASSERT_FALSE(caps.contains(Capability::WriteAudit));
+    ASSERT_EQ(1u, caps.count());
+    caps.clear();
+    ASSERT_TRUE(caps.none());
+}
+
+TEST(EnumSet, set_operations) {
+    capabilities a{ Capability::Login, Capability::WriteUsers, 
+                    Capability::ReadAudit };
+    capabilities b{ Capability::ReadAudit, Capability::Last };
+    ASSERT_EQ(4u, (a | b).count());
+    ASSERT_EQ(capabilities{ Capability::ReadAudit }, a & b);
+    ASSERT_EQ((capabilities{ Capability::Login, Capability::WriteUsers }), 
+              a - b);
+    ASSERT_EQ((capabilities{ Capability::Login, Capability::WriteUsers, 
+                             Capability::Last }), a ^ b);
+    ASSERT_TRUE(a.intersects(b));
+    ASSERT_FALSE((a - b).intersects(b));
+    ASSERT_TRUE((a & b).is_subset_of(a));
+    ASSERT_TRUE((a & b).is_subset_of(b));
+    ASSERT_FALSE(a.is_subset_of(b));
+    ASSERT_TRUE(capabilities{}.is_subset_of(b));
+    ASSERT_TRUE(a != b);
+}
+
+TEST(EnumSet, iteration) {
+    capabilities caps{ Capability::Last, Capability::ReadUsers, 
+                       Capability::ReadAudit, Capability::WriteUsers };
+    std::vector<Capability> seen(caps.begin(), caps.end());
+    std::vector<Capability> expected = { 
+        Capability::ReadUsers, Capability::WriteUsers, 
+        Capability::ReadAudit, Capability::Last 
+    };
+    ASSERT_EQ(expected, seen);
+    capabilities empty;
+    ASSERT_TRUE(empty.begin() == empty.end());
+}
@@ -0,0 +1,131 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/f16.hh>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+TEST(F16, known_values) {
+    ASSERT_EQ(0x0000, f16(0.0f).bits());
+    ASSERT_EQ(0x8000, f16(-0.0f).bits());
+    ASSERT_EQ(0x3c00, f16(1.0f).bits());
+    ASSERT_EQ(0xc000, f16(-2.0f).bits());
+    ASSERT_EQ(0x7bff, f16(65504.0f).bits());
+    ASSERT_EQ(0x0001, f16(std::ldexp(1.0f, -24)).bits());
+    ASSERT_EQ(0x0400, f16(std::ldexp(1.0f, -14)).bits());
+    ASSERT_EQ(0x7c00, f16(std::numeric_limits<f32>::infinity()).bits());
+    ASSERT_EQ(0xfc00, f16(-std::numeric_limits<f32>::infinity()).bits());
+    ASSERT_TRUE(std::isnan(f32(f16(std::numeric_limits<f32>::quiet_NaN()))));
+    ASSERT_EQ(1.0f, f32(f16::from_bits(0x3c00)));
+    ASSERT_EQ(65504.0f, f32(f16::from_bits(0x7bff)));
+}
+
+TEST(F16, rounds_to_nearest_even) {
+    const f32 ulp = std::ldexp(1.0f, -10);
+    ASSERT_EQ(0x3c00, f16(1.0f + 0.5f * ulp).bits());
+    ASSERT_EQ(0x3c02, f16(1.0f + 1.5f * ulp).bits());
+    ASSERT_EQ(0x3c01, f16(1.0f + 0.75f * ulp).bits());
+    // overflow to infinity starts halfway between 65504 and 65536
+    ASSERT_EQ(0x7bff, f16(65519.0f).bits());
+    ASSERT_EQ(0x7c00, f16(65520.0f).bits());
+    // halfway between zero and the smallest subnormal
+    ASSERT_EQ(0x0000, f16(std::ldexp(1.0f, -25)).bits());
+    ASSERT_EQ(0x0001, f16(std::ldexp(1.5f, -25)).bits());
+}
+
+TEST(F16, every_half_round_trips_through_soft_conversion) {
+    for (u32 bits = 0; bits < 0x10000; ++bits) {
+        f32 value = detail::f16_bits_to_f32_soft(u16(bits));
+        if (std::isnan(value)) {
+            ASSERT_EQ(0x7c00u, bits & 0x7c00);
+            continue;
+        }
+        ASSERT_EQ(bits, detail::f32_to_f16_bits_soft(value)) << bits;
+        ASSERT_EQ(detail::f16_bits_to_f32(u16(bits)), value) << bits;
+    }
+}
+
+TEST(F16, soft_conversion_matches_default_conversion) {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<u32> dist;
+    for (int i = 0; i < 100000; ++i) {
+        f32 value = detail::f32_from_bits(dist(rng));
+        if (std::isnan(value)) {
+            continue;
+        }
+        ASSERT_EQ(detail::f32_to_f16_bits(value), 
+                  detail::f32_to_f16_bits_soft(value)) << value;
+    }
+}
+
+TEST(F16, arithmetic_happens_in_f32) {
+    f16 a(1.5f);
+    a += 2.0f;
+    ASSERT_EQ(3.5f, f32(a));
+    a *= 2.0f;
+    ASSERT_EQ(7.0f, f32(a));
+    ASSERT_EQ(14.0f, a + a);
+    ASSERT_TRUE(f16(0.5f) < a);
+}
+
+TEST(F16, bulk_conversion_matches_scalar) {
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<f32> dist(-70000.0f, 70000.0f);
+    std::vector<f32> values(37);
+    for (auto &v : values) {
+        v = dist(rng);
+    }
+    std::vector<f16> halfs(values.size());
+    std::vector<f32> back(values.size());
+    to_f16(mem_view<const f32>(values.data(), values.data() + values.size()),
+           mem_view<f16>(halfs.data(), halfs.data() + halfs.size()));
+    to_f32(mem_view<const f16>(halfs.data(), halfs.data() + halfs.size()),
+           mem_view<f32>(back.data(), back.data() + back.size()));
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(f16(values[i]).bits(), halfs[i].bits());
+        ASSERT_EQ(f32(halfs[i]), back[i]);
+    }
+}
+
+TEST(F16, every_bulk_variant_matches_scalar) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<f32> dist(-70000.0f, 70000.0f);
+    std::vector<f32> values(37);
+    for (auto &v : values) {
+        v = dist(rng);
+    }
+    const simd_isa levels[] = { simd_isa::scalar, simd_isa::sse2, simd_isa::avx2, 
+                                simd_isa::avx512 };
+    for (simd_isa isa : levels) {
+        if (isa > detected_simd_isa()) {
+            break;
+        }
+        std::vector<u16> halfs(values.size());
+        std::vector<f32> back(values.size());
+        detail::f32_to_f16_kernels().resolve(isa)(values.data(), halfs.data(), values.size());
+        detail::f16_to_f32_kernels().resolve(isa)(halfs.data(), back.data(), halfs.size());
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            ASSERT_EQ(detail::f32_to_f16_bits_soft(values[i]), halfs[i]) << simd_isa_name(isa);
+            ASSERT_EQ(detail::f16_bits_to_f32_soft(halfs[i]), back[i]) << simd_isa_name(isa);
+        }
+    }
+}
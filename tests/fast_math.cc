@@ -0,0 +1,100 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/fast_math.hh>
+#include <typus/vec3.hh>
+#include <typus/vec3a.hh>
+#include <typus/vec3_soa.hh>
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+namespace {
+
+// the error budget for fast_math, relative to the exact result
+const f32 tolerance = 1e-5f;
+
+vec3_f test_vec(int i) {
+    return vec3_f(f32(i % 13) - 6.5f, f32(i % 7) * 0.01f + 0.1f, 
+                  f32(i) * 100.0f);
+}
+
+}
+
+TEST(FastMath, rsqrt_fast) {
+    for (f32 x : {1e-20f, 1e-3f, 0.5f, 1.0f, 2.0f, 3.0f, 12345.0f, 1e20f}) {
+        f32 exact = 1.0f / std::sqrt(x);
+        ASSERT_NEAR(exact, rsqrt_fast(x), exact * tolerance) << x;
+    }
+    ASSERT_EQ(0.5, rsqrt_fast(4.0));
+}
+
+TEST(FastMath, vec3_normalize_fast) {
+    for (int i = 0; i < 100; ++i) {
+        vec3_f v = test_vec(i), w = test_vec(i);
+        f32 n = v.normalize();
+        f32 n_fast = w.normalize_fast();
+        ASSERT_NEAR(n, n_fast, n * tolerance);
+        ASSERT_NEAR(v.x, w.x, tolerance);
+        ASSERT_NEAR(v.y, w.y, tolerance);
+        ASSERT_NEAR(v.z, w.z, tolerance);
+        vec3_f r = reflect(test_vec(i), vec3_f(0.0f, 1.0f, 0.0f));
+        vec3_f r_fast = reflect_fast(test_vec(i), vec3_f(0.0f, 1.0f, 0.0f));
+        ASSERT_NEAR(r.x, r_fast.x, tolerance);
+        ASSERT_NEAR(r.y, r_fast.y, tolerance);
+        ASSERT_NEAR(r.z, r_fast.z, tolerance);
+    }
+    vec3_f v = test_vec(3);
+    ASSERT_EQ(v.normalized(), v.normalized<precise_math>());
+}
+
+TEST(FastMath, vec3a_normalize_fast) {
+    for (int i = 0; i < 100; ++i) {
+        vec3_f v = test_vec(i);
+        vec3a_f a(v);
+        f32 n = a.norm();
+        ASSERT_NEAR(n, a.normalize_fast(), n * tolerance);
+        ASSERT_NEAR(v.normalized().x, a.x(), tolerance);
+        ASSERT_NEAR(v.normalized().y, a.y(), tolerance);
+        ASSERT_NEAR(v.normalized().z, a.z(), tolerance);
+        vec3a<f64> d(v.x, v.y, v.z);
+        ASSERT_NEAR(v.normalized().z, d.normalized_fast().z(), tolerance);
+    }
+}
+
+TEST(FastMath, vec3_soa_normalize_fast) {
+    vec3_soa_f a, n, out, out_fast;
+    for (int i = 0; i < 37; ++i) {
+        a.push_back(test_vec(i));
+        n.push_back(vec3_f(1.0f, 2.0f, f32(i)).normalized());
+    }
+    normalize(a, out);
+    normalize_fast(a, out_fast);
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        ASSERT_NEAR(out[i].x, out_fast[i].x, tolerance);
+        ASSERT_NEAR(out[i].y, out_fast[i].y, tolerance);
+        ASSERT_NEAR(out[i].z, out_fast[i].z, tolerance);
+    }
+    reflect(a, n, out);
+    reflect_fast(a, n, out_fast);
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        ASSERT_NEAR(out[i].x, out_fast[i].x, tolerance);
+        ASSERT_NEAR(out[i].y, out_fast[i].y, tolerance);
+        ASSERT_NEAR(out[i].z, out_fast[i].z, tolerance);
+    }
+}
@@ -15,6 +15,8 @@
 // -----------------------------------------------------------------------------
 #include <typus/flags.hh>
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
 using namespace typus;
@@ -62,3 +64,68 @@ TEST(Flags, bit_wise_ops) {
     ASSERT_FALSE(flags_a.is_set(EnumTwo));
 }
 
+
+enum class Permission : unsigned char {
+    Read = 0x01,
+    Write = 0x02,
+    Execute = 0x04,
+    Admin = 0x10
+};
+
+namespace typus {
+
+template <>
+struct valid_flags<Permission> : std::integral_constant<unsigned char, 0x17> {};
+
+}
+
+TEST(Flags, xor_and_complement) {
+    flags<Permission> a(Permission::Read, Permission::Write);
+    flags<Permission> b = a ^ Permission::Write;
+    ASSERT_EQ(0x01, b.bits());
+    b ^= flags<Permission>(Permission::Read, Permission::Admin);
+    ASSERT_EQ(0x10, b.bits());
+    ASSERT_EQ(0x14, (~a).bits());
+    ASSERT_EQ(0x01, (Permission::Read & a).bits());
+    ASSERT_EQ(0xfeu, (~flags<Enum>(EnumOne)).bits() & 0xffu);
+}
+
+TEST(Flags, count_any_none_all) {
+    flags<Permission> empty;
+    ASSERT_EQ(0u, empty.count());
+    ASSERT_TRUE(empty.none());
+    ASSERT_FALSE(empty.any());
+    flags<Permission> some(Permission::Read, Permission::Admin);
+    ASSERT_EQ(2u, some.count());
+    ASSERT_TRUE(some.any());
+    ASSERT_FALSE(some.all());
+    ASSERT_TRUE((~empty).all());
+    ASSERT_EQ(4u, (~empty).count());
+}
+
+TEST(Flags, iteration_over_set_bits) {
+    flags<Permission> f(Permission::Admin, Permission::Read, Permission::Execute);
+    std::vector<Permission> seen;
+    for (Permission p : f) {
+        seen.push_back(p);
+    }
+    std::vector<Permission> expected = { 
+        Permission::Read, Permission::Execute, Permission::Admin 
+    };
+    ASSERT_EQ(expected, seen);
+    flags<Permission> none;
+    ASSERT_TRUE(none.begin() == none.end());
+}
+
+TEST(Flags, rank_and_select) {
+    constexpr flags<Permission> f(Permission::Admin, Permission::Read, 
+                                  Permission::Execute);
+    static_assert(f.rank(Permission::Read) == 0, "");
+    static_assert(f.rank(Permission::Execute) == 1, "");
+    static_assert(f.rank(Permission::Admin) == 2, "");
+    static_assert(f.select(1) == Permission::Execute, "");
+    static_assert(f.count() == 3, "");
+    for (u32 i = 0; i < f.count(); ++i) {
+        ASSERT_EQ(i, f.rank(f.select(i)));
+    }
+}
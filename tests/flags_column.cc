@@ -0,0 +1,93 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/flags_column.hh>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+namespace {
+
+enum class Row : u16 {
+    Active = 0x01,
+    Deleted = 0x02,
+    Dirty = 0x04,
+    Pinned = 0x8000
+};
+
+flags<Row> row_flags(std::size_t i) {
+    flags<Row> value;
+    if (i % 2 == 0) { value |= Row::Active; }
+    if (i % 3 == 0) { value |= Row::Deleted; }
+    if (i % 5 == 0) { value |= Row::Dirty; }
+    if (i % 7 == 0) { value |= Row::Pinned; }
+    return value;
+}
+
+}
+
+TEST(FlagsColumn, push_back_and_access) {
+    flags_column<Row> column;
+    ASSERT_TRUE(column.empty());
+    for (std::size_t i = 0; i < 1000; ++i) {
+        column.push_back(row_flags(i));
+    }
+    ASSERT_EQ(1000u, column.size());
+    ASSERT_EQ(0u, column.word_count() % 4);
+    for (std::size_t i = 0; i < 1000; ++i) {
+        ASSERT_EQ(row_flags(i).bits(), column[i].bits());
+    }
+    column.set(3, flags<Row>(Row::Pinned));
+    ASSERT_EQ(0x8000, column[3].bits());
+    ASSERT_EQ(row_flags(4).bits(), column[4].bits());
+    column.clear();
+    ASSERT_EQ(0u, column.size());
+}
+
+TEST(FlagsColumn, select_matches_row_wise_evaluation) {
+    flags_predicate<Row> preds[] = {
+        flags_predicate<Row>().set(Row::Active).not_set(Row::Deleted),
+        flags_predicate<Row>().not_set(Row::Deleted),
+        flags_predicate<Row>().any_set(flags<Row>(Row::Dirty, Row::Pinned)),
+        flags_predicate<Row>().set(Row::Active).set(Row::Dirty)
+                              .any_set(flags<Row>(Row::Pinned, Row::Deleted)),
+        flags_predicate<Row>()
+    };
+    // sizes around the word and padding boundaries
+    for (std::size_t n : {0, 1, 63, 64, 65, 255, 256, 257, 1000}) {
+        flags_column<Row> column;
+        for (std::size_t i = 0; i < n; ++i) {
+            column.push_back(row_flags(i));
+        }
+        for (const auto &pred : preds) {
+            std::vector<u32> expected;
+            for (std::size_t i = 0; i < n; ++i) {
+                if (pred(row_flags(i))) {
+                    expected.push_back(u32(i));
+                }
+            }
+            ASSERT_EQ(expected, column.select_indices(pred));
+            ASSERT_EQ(expected.size(), column.count(pred));
+            std::vector<u64> bitmap = column.select(pred);
+            ASSERT_EQ(column.word_count(), bitmap.size());
+            for (u32 row : expected) {
+                ASSERT_TRUE((bitmap[row / 64] >> (row % 64)) & 1);
+            }
+        }
+    }
+}
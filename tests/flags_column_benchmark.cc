@@ -0,0 +1,112 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <typus/flags_column.hh>
+
+namespace ty = typus;
+
+enum class Row : ty::u32 {
+    A = 0x01,
+    B = 0x02,
+    C = 0x04,
+    D = 0x08
+};
+
+template <typename F>
+double time_ms(int repeats, F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        f();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count() / repeats;
+}
+
+// Scans for rows with is_set(A) && !is_set(B), once over an array of 
+// flags<Row> and once over a flags_column<Row>. Both produce a selection 
+// bitmap, and row indices.
+int main(int argc, const char **argv) {
+    const std::size_t rows = argc > 1 ? std::atoll(argv[1]) : 20000000;
+    const int repeats = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<ty::u32> dist(0, 15);
+    std::vector<ty::flags<Row>> aos;
+    ty::flags_column<Row> column;
+    aos.reserve(rows);
+    column.reserve(rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+        auto value = ty::flags<Row>::from_bits(dist(rng));
+        aos.push_back(value);
+        column.push_back(value);
+    }
+
+    auto pred = ty::flags_predicate<Row>().set(Row::A).not_set(Row::B);
+
+    std::vector<ty::u64> aos_bitmap((rows + 63) / 64);
+    double aos_bitmap_ms = time_ms(repeats, [&]() {
+        for (std::size_t w = 0; w < aos_bitmap.size(); ++w) {
+            ty::u64 word = 0;
+            const std::size_t end = std::min(rows, (w + 1) * 64);
+            for (std::size_t i = w * 64; i < end; ++i) {
+                word |= ty::u64(aos[i].is_set(Row::A) && 
+                                !aos[i].is_set(Row::B)) << (i % 64);
+            }
+            aos_bitmap[w] = word;
+        }
+    });
+    std::vector<ty::u64> column_bitmap(column.word_count());
+    double column_bitmap_ms = time_ms(repeats, [&]() {
+        column.select(pred, column_bitmap.data());
+    });
+
+    std::size_t aos_count = 0, column_count = 0;
+    double aos_indices_ms = time_ms(repeats, [&]() {
+        std::vector<ty::u32> indices;
+        for (std::size_t i = 0; i < rows; ++i) {
+            if (aos[i].is_set(Row::A) && !aos[i].is_set(Row::B)) {
+                indices.push_back(ty::u32(i));
+            }
+        }
+        aos_count = indices.size();
+    });
+    double column_indices_ms = time_ms(repeats, [&]() {
+        column_count = column.select_indices(pred).size();
+    });
+    if (aos_count != column_count) {
+        std::cerr << "mismatch: " << aos_count << " vs " << column_count << "\n";
+        return 1;
+    }
+
+    const double aos_mb = rows * sizeof(ty::flags<Row>) / 1e6;
+    const double column_mb = 2 * column.word_count() * 8 / 1e6;
+    std::cout << rows << " rows, " << aos_count << " matches\n"
+              << "selection bitmap (ms)\n"
+              << "  array of flags: " << aos_bitmap_ms 
+              << " (" << aos_mb / aos_bitmap_ms << " GB/s)\n"
+              << "  flags_column:   " << column_bitmap_ms 
+              << " (" << column_mb / column_bitmap_ms << " GB/s)\n"
+              << "index list (ms)\n"
+              << "  array of flags: " << aos_indices_ms << "\n"
+              << "  flags_column:   " << column_indices_ms << "\n";
+    return 0;
+}
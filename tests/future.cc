@@ -0,0 +1,149 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/future.hh>
+
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+TEST(Future, value_set_before_get) {
+    promise<std::string> p;
+    future<std::string> f = p.get_future();
+    ASSERT_TRUE(f.valid());
+    ASSERT_FALSE(f.ready());
+    p.set_value("one");
+    ASSERT_TRUE(f.ready());
+    result<std::string> r = f.get();
+    ASSERT_TRUE(r.ok());
+    ASSERT_EQ("one", r.value());
+    ASSERT_FALSE(f.valid());
+}
+
+enum class Error {
+    Timeout, Refused
+};
+
+TEST(Future, error_is_propagated) {
+    promise<int, Error> p;
+    future<int, Error> f = p.get_future();
+    p.set_error(Error::Refused);
+    result<int, Error> r = f.get();
+    ASSERT_FALSE(r.ok());
+    ASSERT_EQ(Error::Refused, r.error());
+}
+
+TEST(Future, broken_promise_fails_future) {
+    future<int> f;
+    {
+        promise<int> p;
+        f = p.get_future();
+    }
+    ASSERT_TRUE(f.ready());
+    ASSERT_FALSE(f.get().ok());
+}
+
+TEST(Future, then_before_value) {
+    promise<int> p;
+    int seen = 0;
+    future<int> f = p.get_future().then([&seen](result<int> r) {
+        seen = r.value();
+        return r.value() * 2;
+    });
+    ASSERT_EQ(0, seen);
+    ASSERT_FALSE(f.ready());
+    p.set_value(21);
+    ASSERT_EQ(21, seen);
+    ASSERT_EQ(42, f.get().value());
+}
+
+TEST(Future, then_after_value) {
+    future<std::string> f = make_ready_future(result<int>(3))
+        .then([](result<int> r) -> result<std::string> {
+            return std::string(r.value(), 'x');
+        });
+    ASSERT_TRUE(f.ready());
+    ASSERT_EQ("xxx", f.get().value());
+}
+
+TEST(Future, then_propagates_errors_through_chain) {
+    promise<int, Error> p;
+    future<int, Error> f = p.get_future()
+        .then([](result<int, Error> r) { 
+            return r.and_then([](int v) { return v + 1; }); 
+        })
+        .then([](result<int, Error> r) { 
+            return r.and_then([](int v) { return v + 1; }); 
+        });
+    p.set_error(Error::Timeout);
+    result<int, Error> r = f.get();
+    ASSERT_FALSE(r.ok());
+    ASSERT_EQ(Error::Timeout, r.error());
+}
+
+struct counting_executor {
+    int submitted = 0;
+
+    template <typename F>
+    void execute(F && task) {
+        ++submitted;
+        task();
+    }
+};
+
+TEST(Future, then_on_executor) {
+    counting_executor executor;
+    promise<int> p;
+    future<int> f = p.get_future().then(executor, [](result<int> r) {
+        return r.value() + 1;
+    });
+    ASSERT_EQ(0, executor.submitted);
+    p.set_value(1);
+    ASSERT_EQ(1, executor.submitted);
+    ASSERT_EQ(2, f.get().value());
+}
+
+struct large_callable {
+    char padding[128];
+    int operator()(result<int> r) { return r.value() + padding[0]; }
+};
+
+TEST(Future, large_continuation) {
+    large_callable func;
+    func.padding[0] = 1;
+    promise<int> p;
+    future<int> f = p.get_future().then(func);
+    p.set_value(1);
+    ASSERT_EQ(2, f.get().value());
+}
+
+TEST(Future, cross_thread_hand_off) {
+    for (int i = 0; i < 100; ++i) {
+        promise<int> p;
+        future<int> f = p.get_future();
+        int seen = 0;
+        future<int> g = f.then([&seen](result<int> r) {
+            seen = r.value();
+            return r.value();
+        });
+        std::thread producer([&p, i]() { p.set_value(i); });
+        ASSERT_EQ(i, g.get().value());
+        ASSERT_EQ(i, seen);
+        producer.join();
+    }
+}
@@ -0,0 +1,95 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <typus/future.hh>
+
+namespace ty = typus;
+
+// Ping-pong latency: the main thread satisfies ping[i] and waits for pong[i],
+// which the echo thread satisfies as soon as it observes ping[i]. Each round 
+// trip therefore consists of two cross-thread hand-offs.
+template <typename P, typename F, typename G>
+double ping_pong(int rounds, G get) {
+    std::vector<P> ping(rounds), pong(rounds);
+    std::vector<F> ping_futures, pong_futures;
+    ping_futures.reserve(rounds);
+    pong_futures.reserve(rounds);
+    for (int i = 0; i < rounds; ++i) {
+        ping_futures.push_back(ping[i].get_future());
+        pong_futures.push_back(pong[i].get_future());
+    }
+    std::thread echo([&]() {
+        for (int i = 0; i < rounds; ++i) {
+            pong[i].set_value(get(ping_futures[i]) + 1);
+        }
+    });
+    auto start = std::chrono::steady_clock::now();
+    long long sum = 0;
+    for (int i = 0; i < rounds; ++i) {
+        ping[i].set_value(i);
+        sum += get(pong_futures[i]);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    echo.join();
+    if (sum == 0) {
+        std::cerr << "unexpected checksum\n";
+    }
+    return std::chrono::duration<double, std::nano>(stop - start).count() / rounds;
+}
+
+// Single-threaded create/satisfy/get cycle. Measures allocation and
+// synchronization overhead without any cross-thread traffic.
+template <typename P, typename F, typename G>
+double create_set_get(int rounds, G get) {
+    auto start = std::chrono::steady_clock::now();
+    long long sum = 0;
+    for (int i = 0; i < rounds; ++i) {
+        P p;
+        F f = p.get_future();
+        p.set_value(i);
+        sum += get(f);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    if (sum < 0) {
+        std::cerr << "unexpected checksum\n";
+    }
+    return std::chrono::duration<double, std::nano>(stop - start).count() / rounds;
+}
+
+int main(int argc, const char **argv) {
+    const int rounds = argc > 1 ? std::atoi(argv[1]) : 100000;
+    auto std_get = [](std::future<int> &f) { return f.get(); };
+    auto ty_get = [](ty::future<int> &f) { return f.get().value(); };
+
+    double std_rt = ping_pong<std::promise<int>, std::future<int>>(rounds, std_get);
+    double ty_rt = ping_pong<ty::promise<int>, ty::future<int>>(rounds, ty_get);
+    double std_local = create_set_get<std::promise<int>, std::future<int>>(rounds, std_get);
+    double ty_local = create_set_get<ty::promise<int>, ty::future<int>>(rounds, ty_get);
+
+    std::cout << "ping-pong round trip (ns)\n"
+              << "  std::future:   " << std_rt << "\n"
+              << "  typus::future: " << ty_rt << "\n"
+              << "create/set/get (ns)\n"
+              << "  std::future:   " << std_local << "\n"
+              << "  typus::future: " << ty_local << "\n";
+    return 0;
+}
@@ -0,0 +1,106 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/matrix.hh>
+#include <typus/quat.hh>
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+namespace {
+
+const f32 pi = 3.14159265f;
+
+void expect_near(const vec3_f &expected, const vec3_f &actual, f32 eps = 1e-5f) {
+    EXPECT_NEAR(expected.x, actual.x, eps);
+    EXPECT_NEAR(expected.y, actual.y, eps);
+    EXPECT_NEAR(expected.z, actual.z, eps);
+}
+
+void expect_near(const mat3_f &expected, const mat3_f &actual, f32 eps = 1e-5f) {
+    for (std::size_t i = 0; i < 3; ++i) {
+        for (std::size_t j = 0; j < 3; ++j) {
+            EXPECT_NEAR(expected(i, j), actual(i, j), eps) << i << ", " << j;
+        }
+    }
+}
+
+}
+
+TEST(Mat3, identity_and_scale) {
+    vec3_f v(1.0f, -2.0f, 3.0f);
+    ASSERT_EQ(v, mat3_f() * v);
+    ASSERT_EQ(mat3_f::identity(), mat3_f());
+    ASSERT_EQ(vec3_f(2.0f, -6.0f, 12.0f), 
+              mat3_f::scale(vec3_f(2.0f, 3.0f, 4.0f)) * v);
+}
+
+TEST(Mat3, rotation) {
+    mat3_f r = mat3_f::rotation(vec3_f(0.0f, 0.0f, 1.0f), pi / 2);
+    expect_near(vec3_f(0.0f, 1.0f, 0.0f), r * vec3_f(1.0f, 0.0f, 0.0f));
+    expect_near(mat3_f(), r * r.transposed());
+    EXPECT_NEAR(1.0f, r.determinant(), 1e-6f);
+}
+
+TEST(Mat3, product_and_inverse) {
+    mat3_f a(2.0f, 1.0f, 0.0f, 0.0f, 3.0f, 1.0f, 1.0f, 0.0f, 4.0f);
+    mat3_f b = mat3_f::rotation(vec3_f(1.0f, 0.0f, 0.0f), 0.3f);
+    vec3_f v(0.5f, -1.0f, 2.0f);
+    expect_near(a * (b * v), (a * b) * v);
+    expect_near(mat3_f(), a * a.inverse());
+    EXPECT_NEAR(25.0f, a.determinant(), 1e-5f);
+    ASSERT_EQ(vec3_f(2.0f, 0.0f, 1.0f), a.col(0));
+    ASSERT_EQ(vec3_f(0.0f, 3.0f, 1.0f), a.row(1));
+}
+
+TEST(Mat4, affine_transform) {
+    mat3_f r = mat3_f::rotation(vec3_f(0.0f, 1.0f, 0.0f), 0.7f);
+    vec3_f t(1.0f, 2.0f, 3.0f);
+    mat4_f m(r, t);
+    vec3_f p(-1.0f, 0.5f, 2.0f);
+    expect_near(r * p + t, m.transform_point(p));
+    expect_near(r * p, m.transform_direction(p));
+    ASSERT_EQ(t, m.translation());
+    ASSERT_EQ(r, m.linear());
+    ASSERT_EQ(p + t, mat4_f::translation(t).transform_point(p));
+    expect_near(p, m.affine_inverse().transform_point(m.transform_point(p)));
+    mat4_f n = mat4_f::translation(vec3_f(0.0f, 0.0f, -5.0f));
+    expect_near(m.transform_point(n.transform_point(p)), (m * n).transform_point(p));
+}
+
+TEST(Quat, rotation_matches_matrix) {
+    vec3_f axis = vec3_f(1.0f, 2.0f, -2.0f) * (1.0f / 3.0f);
+    quat_f q = quat_f::from_axis_angle(axis, 1.1f);
+    mat3_f r = mat3_f::rotation(axis, 1.1f);
+    vec3_f v(0.3f, -0.7f, 1.9f);
+    expect_near(r * v, q.rotate(v));
+    expect_near(r, q.to_mat3());
+    EXPECT_NEAR(1.0f, q.norm(), 1e-6f);
+    expect_near(v, q.conjugate().rotate(q.rotate(v)));
+    ASSERT_EQ(v, quat_f::identity().rotate(v));
+}
+
+TEST(Quat, composition) {
+    quat_f a = quat_f::from_axis_angle(vec3_f(0.0f, 0.0f, 1.0f), 0.4f);
+    quat_f b = quat_f::from_axis_angle(vec3_f(1.0f, 0.0f, 0.0f), -1.3f);
+    vec3_f v(1.0f, 2.0f, 3.0f);
+    expect_near(a.rotate(b.rotate(v)), (a * b).rotate(v));
+    expect_near(a.to_mat3() * b.to_mat3(), (a * b).to_mat3());
+    quat_f c(2.0f, 0.0f, 0.0f, 0.0f);
+    ASSERT_EQ(quat_f(), c.normalized());
+}
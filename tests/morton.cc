@@ -0,0 +1,168 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/morton.hh>
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+TEST(Morton, encode) {
+    ASSERT_EQ(0u, morton_encode(0, 0, 0));
+    ASSERT_EQ(1u, morton_encode(1, 0, 0));
+    ASSERT_EQ(2u, morton_encode(0, 1, 0));
+    ASSERT_EQ(4u, morton_encode(0, 0, 1));
+    ASSERT_EQ(511u, morton_encode(7, 7, 7));
+    ASSERT_EQ((u64(1) << 63) - 1, morton_encode(0x1fffff, 0x1fffff, 0x1fffff));
+}
+
+TEST(Morton, round_trip_and_portable_fallback) {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<u32> dist(0, 0x1fffff);
+    for (int i = 0; i < 10000; ++i) {
+        u32 x = dist(rng), y = dist(rng), z = dist(rng);
+        u64 code = morton_encode(x, y, z);
+        ASSERT_EQ(detail::spread_bits_3(x) | detail::spread_bits_3(y) << 1 | 
+                  detail::spread_bits_3(z) << 2, code);
+        u32 dx, dy, dz;
+        morton_decode(code, dx, dy, dz);
+        ASSERT_EQ(x, dx);
+        ASSERT_EQ(y, dy);
+        ASSERT_EQ(z, dz);
+        ASSERT_EQ(x, detail::compact_bits_3(code));
+    }
+}
+
+TEST(Hilbert, round_trip) {
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<u32> dist(0, 0x1fffff);
+    for (int i = 0; i < 10000; ++i) {
+        u32 x = dist(rng), y = dist(rng), z = dist(rng);
+        u32 dx, dy, dz;
+        hilbert_decode(hilbert_encode(x, y, z), dx, dy, dz);
+        ASSERT_EQ(x, dx);
+        ASSERT_EQ(y, dy);
+        ASSERT_EQ(z, dz);
+    }
+}
+
+TEST(Hilbert, consecutive_indices_are_adjacent) {
+    u32 px, py, pz;
+    hilbert_decode(0, px, py, pz);
+    ASSERT_EQ(0u, px + py + pz);
+    for (u64 i = 1; i < 32768; ++i) {
+        u32 x, y, z;
+        hilbert_decode(i, x, y, z);
+        ASSERT_EQ(1, std::abs(int(x) - int(px)) + std::abs(int(y) - int(py)) + 
+                     std::abs(int(z) - int(pz))) << i;
+        // the first 8^5 indices fill the 32^3 cube
+        ASSERT_LT(std::max(x, std::max(y, z)), 32u);
+        px = x; py = y; pz = z;
+    }
+}
+
+TEST(RadixSort, matches_stable_sort) {
+    for (unsigned threads : {1u, 3u}) {
+        std::mt19937 rng(3);
+        // few distinct high bits, so equal keys and skipped passes occur
+        std::uniform_int_distribution<u64> dist(0, 1000);
+        std::vector<u64> keys(100000);
+        std::vector<u32> values(keys.size());
+        std::vector<std::pair<u64, u32>> expected;
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            keys[i] = dist(rng) << 40 | (dist(rng) & 0xf);
+            values[i] = u32(i);
+            expected.emplace_back(keys[i], values[i]);
+        }
+        std::stable_sort(expected.begin(), expected.end(), 
+                         [](const std::pair<u64, u32> &a, const std::pair<u64, u32> &b) {
+            return a.first < b.first;
+        });
+        radix_sort_pairs(mem_view<u64>(keys.data(), keys.data() + keys.size()),
+                         mem_view<u32>(values.data(), values.data() + values.size()),
+                         64, threads);
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            ASSERT_EQ(expected[i].first, keys[i]);
+            ASSERT_EQ(expected[i].second, values[i]);
+        }
+    }
+}
+
+TEST(RadixSort, ignores_bits_above_key_bits) {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<u64> dist;
+    const u32 key_bits = 60;
+    const u64 low = (u64(1) << key_bits) - 1;
+    std::vector<u64> keys(10000);
+    std::vector<u32> values(keys.size());
+    std::vector<std::pair<u64, u32>> expected;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        // junk in the top four bits, few distinct values below
+        keys[i] = (dist(rng) & ~low) | (dist(rng) % 50) << 52 | (dist(rng) & 0x3);
+        values[i] = u32(i);
+        expected.emplace_back(keys[i], values[i]);
+    }
+    std::stable_sort(expected.begin(), expected.end(), 
+                     [low](const std::pair<u64, u32> &a, const std::pair<u64, u32> &b) {
+        return (a.first & low) < (b.first & low);
+    });
+    radix_sort_pairs(mem_view<u64>(keys.data(), keys.data() + keys.size()),
+                     mem_view<u32>(values.data(), values.data() + values.size()),
+                     key_bits);
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_EQ(expected[i].first, keys[i]);
+        ASSERT_EQ(expected[i].second, values[i]);
+    }
+}
+
+TEST(SpaceFillingOrder, sorts_points_along_curve) {
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<f32> dist(-5.0f, 5.0f);
+    std::vector<vec3_f> points(5000);
+    std::vector<int> payload(points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        points[i] = vec3_f(dist(rng), dist(rng), dist(rng));
+        payload[i] = int(i);
+    }
+    aabb_f bounds;
+    for (const vec3_f &p : points) {
+        bounds.extend(p);
+    }
+    morton_quantizer<f32> quantizer(bounds);
+    for (auto curve : {space_filling_curve::morton, space_filling_curve::hilbert}) {
+        std::vector<vec3_f> sorted = points;
+        std::vector<int> sorted_payload = payload;
+        std::vector<u32> order = space_filling_order(
+            mem_view<const vec3_f>(points.data(), points.data() + points.size()),
+            curve, 2);
+        apply_order(order, sorted);
+        apply_order(order, sorted_payload);
+        for (std::size_t i = 0; i < sorted.size(); ++i) {
+            ASSERT_EQ(points[sorted_payload[i]], sorted[i]);
+        }
+        for (std::size_t i = 1; i < sorted.size(); ++i) {
+            if (curve == space_filling_curve::morton) {
+                ASSERT_LE(quantizer.morton(sorted[i - 1]), quantizer.morton(sorted[i]));
+            } else {
+                ASSERT_LE(quantizer.hilbert(sorted[i - 1]), quantizer.hilbert(sorted[i]));
+            }
+        }
+    }
+}
@@ -0,0 +1,127 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <typus/morton.hh>
+#include <typus/spatial_grid.hh>
+
+namespace ty = typus;
+
+template <typename F>
+double time_ms(F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// a payload that is touched for every neighbour found, like a particle's 
+// velocity or mass in a simulation step.
+struct payload {
+    ty::f32 mass;
+    ty::f32 velocity[3];
+};
+
+// Builds a grid over the points and, for every point in array order, sums 
+// the payload of its neighbours. The array order is what a time-step loop 
+// sees, so this is where the order of the dataset matters.
+static void neighbour_pass(const char *name, const std::vector<ty::vec3_f> &points,
+                           const std::vector<payload> &payloads, ty::f32 radius) {
+    ty::mem_view<const ty::vec3_f> view(points.data(), points.data() + points.size());
+    ty::spatial_grid<ty::f32> grid(radius);
+    double build_ms = time_ms([&]() { grid.build(view, 1); });
+    double sum = 0.0;
+    std::size_t found = 0;
+    double query_ms = time_ms([&]() {
+        for (const ty::vec3_f &p : points) {
+            grid.for_each_in_radius(p, radius, [&](ty::u32 index, ty::f32) {
+                sum += payloads[index].mass * payloads[index].velocity[0];
+                ++found;
+            });
+        }
+    });
+    std::cout << name << ": build " << build_ms << " ms, neighbour pass " 
+              << query_ms << " ms (" << double(found) / points.size() 
+              << " neighbours/point, checksum " << sum << ")" << std::endl;
+}
+
+int main(int argc, const char **argv) {
+    const std::size_t n = argc > 1 ? std::atoll(argv[1]) : 1000000;
+    const unsigned threads = argc > 2 ? std::atoi(argv[2]) : ty::default_thread_count();
+    const ty::f32 extent = 100.0f;
+    const ty::f32 radius = extent * std::cbrt(30.0f / (4.18879f * n));
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<ty::f32> dist(0.0f, extent);
+    std::vector<ty::vec3_f> points(n);
+    std::vector<payload> payloads(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        points[i] = ty::vec3_f(dist(rng), dist(rng), dist(rng));
+        payloads[i] = payload{dist(rng), {dist(rng), dist(rng), dist(rng)}};
+    }
+    ty::mem_view<const ty::vec3_f> view(points.data(), points.data() + n);
+
+    std::uniform_int_distribution<ty::u32> coord(0, 0x1fffff);
+    std::vector<ty::u32> coords(3 * n);
+    for (auto &c : coords) {
+        c = coord(rng);
+    }
+    std::vector<ty::u64> codes(n);
+    double morton_encode_ms = time_ms([&]() {
+        for (std::size_t i = 0; i < n; ++i) {
+            codes[i] = ty::morton_encode(coords[3 * i], coords[3 * i + 1], coords[3 * i + 2]);
+        }
+    });
+    double hilbert_encode_ms = time_ms([&]() {
+        for (std::size_t i = 0; i < n; ++i) {
+            codes[i] = ty::hilbert_encode(coords[3 * i], coords[3 * i + 1], coords[3 * i + 2]);
+        }
+    });
+    std::vector<ty::u32> values(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        values[i] = ty::u32(i);
+    }
+    double sort_ms = time_ms([&]() {
+        ty::radix_sort_pairs(ty::mem_view<ty::u64>(codes.data(), codes.data() + n),
+                             ty::mem_view<ty::u32>(values.data(), values.data() + n),
+                             3 * ty::morton_bits, threads);
+    });
+    std::cout << n << " points, " << threads << " threads" << std::endl;
+    std::cout << "morton encode: " << morton_encode_ms << " ms" << std::endl;
+    std::cout << "hilbert encode: " << hilbert_encode_ms << " ms" << std::endl;
+    std::cout << "radix sort (63-bit keys): " << sort_ms << " ms" << std::endl;
+
+    neighbour_pass("random order", points, payloads, radius);
+    for (auto curve : {ty::space_filling_curve::morton, ty::space_filling_curve::hilbert}) {
+        std::vector<ty::vec3_f> sorted = points;
+        std::vector<payload> sorted_payloads = payloads;
+        double order_ms = time_ms([&]() {
+            std::vector<ty::u32> order = ty::space_filling_order(view, curve, threads);
+            ty::apply_order(order, sorted);
+            ty::apply_order(order, sorted_payloads);
+        });
+        bool morton = curve == ty::space_filling_curve::morton;
+        std::cout << (morton ? "morton" : "hilbert") << " reorder: " 
+                  << order_ms << " ms" << std::endl;
+        neighbour_pass(morton ? "morton order" : "hilbert order", sorted, 
+                       sorted_payloads, radius);
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <typus/vec3.hh>
+#include <typus/vec3a.hh>
+#include <typus/vec3_soa.hh>
+
+namespace ty = typus;
+
+template <typename F>
+double time_ns_per_vec(std::size_t n, int repeats, F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        f();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / 
+           (double(repeats) * n);
+}
+
+// Relative error of the fast result against normalization in double 
+// precision, measured as the distance between the unit vectors.
+struct error_stats {
+    double max = 0.0;
+    double sum = 0.0;
+    std::size_t n = 0;
+
+    void add(const ty::vec3_f &v, const ty::vec3_f &approx) {
+        double norm = std::sqrt(double(v.x) * v.x + double(v.y) * v.y + 
+                                double(v.z) * v.z);
+        double dx = approx.x - v.x / norm;
+        double dy = approx.y - v.y / norm;
+        double dz = approx.z - v.z / norm;
+        double e = std::sqrt(dx * dx + dy * dy + dz * dz);
+        max = std::max(max, e);
+        sum += e;
+        ++n;
+    }
+};
+
+int main(int argc, const char **argv) {
+    const std::size_t n = argc > 1 ? std::atoll(argv[1]) : 100000;
+    const int repeats = argc > 2 ? std::atoi(argv[2]) : 100;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<ty::f32> dist(-100.0f, 100.0f);
+    std::vector<ty::vec3_f> v(n), normals(n), out(n);
+    std::vector<ty::vec3a_f> va(n), normals_a(n), out_a(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        v[i] = ty::vec3_f(dist(rng), dist(rng), dist(rng));
+        normals[i] = ty::vec3_f(dist(rng), dist(rng), dist(rng)).normalized();
+        va[i] = ty::vec3a_f(v[i]);
+        normals_a[i] = ty::vec3a_f(normals[i]);
+    }
+    ty::vec3_soa_f soa, soa_normals, soa_out;
+    ty::to_soa(ty::mem_view<const ty::vec3_f>(v.data(), v.data() + n), soa);
+    ty::to_soa(ty::mem_view<const ty::vec3_f>(normals.data(), normals.data() + n), 
+               soa_normals);
+
+    error_stats precise_error, fast_error, soa_fast_error;
+    for (std::size_t i = 0; i < n; ++i) {
+        precise_error.add(v[i], v[i].normalized());
+        fast_error.add(v[i], v[i].normalized_fast());
+    }
+    ty::normalize_fast(soa, soa_out);
+    for (std::size_t i = 0; i < n; ++i) {
+        soa_fast_error.add(v[i], soa_out[i]);
+    }
+
+    double vec3_precise = time_ns_per_vec(n, repeats, [&]() {
+        for (std::size_t i = 0; i < n; ++i) { out[i] = v[i].normalized(); }
+    });
+    double vec3_fast = time_ns_per_vec(n, repeats, [&]() {
+        for (std::size_t i = 0; i < n; ++i) { out[i] = v[i].normalized_fast(); }
+    });
+    double vec3a_precise = time_ns_per_vec(n, repeats, [&]() {
+        for (std::size_t i = 0; i < n; ++i) { out_a[i] = va[i].normalized(); }
+    });
+    double vec3a_fast = time_ns_per_vec(n, repeats, [&]() {
+        for (std::size_t i = 0; i < n; ++i) { out_a[i] = va[i].normalized_fast(); }
+    });
+    double soa_precise = time_ns_per_vec(n, repeats, [&]() { 
+        ty::normalize(soa, soa_out); 
+    });
+    double soa_fast = time_ns_per_vec(n, repeats, [&]() { 
+        ty::normalize_fast(soa, soa_out); 
+    });
+    double reflect_precise = time_ns_per_vec(n, repeats, [&]() {
+        for (std::size_t i = 0; i < n; ++i) { out[i] = ty::reflect(v[i], normals[i]); }
+    });
+    double reflect_fast = time_ns_per_vec(n, repeats, [&]() {
+        for (std::size_t i = 0; i < n; ++i) { out[i] = ty::reflect_fast(v[i], normals[i]); }
+    });
+    double soa_reflect_precise = time_ns_per_vec(n, repeats, [&]() { 
+        ty::reflect(soa, soa_normals, soa_out); 
+    });
+    double soa_reflect_fast = time_ns_per_vec(n, repeats, [&]() { 
+        ty::reflect_fast(soa, soa_normals, soa_out); 
+    });
+
+    std::cout << "error against double precision (max / mean)\n"
+              << "  precise:         " << precise_error.max << " / " 
+              << precise_error.sum / precise_error.n << "\n"
+              << "  fast:            " << fast_error.max << " / " 
+              << fast_error.sum / fast_error.n << "\n"
+              << "  fast, batched:   " << soa_fast_error.max << " / " 
+              << soa_fast_error.sum / soa_fast_error.n << "\n"
+              << n << " vectors, ns per vector (precise / fast)\n"
+              << "  vec3_f normalize:      " << vec3_precise << " / " << vec3_fast << "\n"
+              << "  vec3a_f normalize:     " << vec3a_precise << " / " << vec3a_fast << "\n"
+              << "  vec3_soa_f normalize:  " << soa_precise << " / " << soa_fast << "\n"
+              << "  vec3_f reflect:        " << reflect_precise << " / " << reflect_fast << "\n"
+              << "  vec3_soa_f reflect:    " << soa_reflect_precise << " / " 
+              << soa_reflect_fast << "\n";
+    if (out[0].x != out[0].x || out_a[0].x() != out_a[0].x()) {
+        std::cerr << "unexpected NaN\n";
+    }
+    return 0;
+}
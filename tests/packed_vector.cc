@@ -0,0 +1,173 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/packed_vector.hh>
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+template <typename B>
+class PackedVector : public ::testing::Test {
+};
+
+// widths around the word and byte boundaries, and around the limit of the 
+// AVX2 unpack
+template <unsigned Bits>
+using width = std::integral_constant<unsigned, Bits>;
+using PackedVectorWidths = ::testing::Types<
+    width<1>, width<3>, width<7>, width<8>, width<12>, width<17>, 
+    width<20>, width<25>, width<26>, width<31>, width<32>
+>;
+TYPED_TEST_SUITE(PackedVector, PackedVectorWidths);
+
+namespace {
+
+std::vector<u32> random_values(std::size_t n, u32 max_value, unsigned seed = 1) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<u32> dist(0, max_value);
+    std::vector<u32> values(n);
+    for (auto &v : values) {
+        v = dist(rng);
+    }
+    return values;
+}
+
+mem_view<const u32> const_view(const std::vector<u32> &v) {
+    return mem_view<const u32>(v.data(), v.data() + v.size());
+}
+
+}
+
+TYPED_TEST(PackedVector, push_back_and_random_access) {
+    using vector = packed_vector<TypeParam::value>;
+    const auto values = random_values(1000, vector::max_value());
+    vector v;
+    EXPECT_TRUE(v.empty());
+    for (u32 value : values) {
+        v.push_back(value);
+    }
+    ASSERT_EQ(values.size(), v.size());
+    EXPECT_GE(v.capacity(), v.size());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(values[i], v[i]) << i;
+    }
+    EXPECT_EQ(values.back(), v.back());
+    EXPECT_LE(v.storage_bytes(), (v.capacity() * TypeParam::value + 7) / 8 + 24);
+}
+
+TYPED_TEST(PackedVector, set_leaves_neighbours_alone) {
+    using vector = packed_vector<TypeParam::value>;
+    vector v(200);
+    for (std::size_t i = 0; i < v.size(); i += 3) {
+        v.set(i, vector::max_value());
+    }
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        ASSERT_EQ(i % 3 == 0 ? vector::max_value() : 0u, v[i]) << i;
+    }
+    for (std::size_t i = 0; i < v.size(); i += 3) {
+        v.set(i, 0);
+    }
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        ASSERT_EQ(0u, v[i]) << i;
+    }
+}
+
+TYPED_TEST(PackedVector, resize_and_pop_back_zero_removed_elements) {
+    using vector = packed_vector<TypeParam::value>;
+    const auto values = random_values(300, vector::max_value());
+    vector v;
+    v.append(const_view(values));
+    v.pop_back();
+    v.resize(100);
+    v.resize(300);
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        ASSERT_EQ(i < 100 ? values[i] : 0u, v[i]) << i;
+    }
+    const std::size_t capacity = v.capacity();
+    v.clear();
+    EXPECT_TRUE(v.empty());
+    EXPECT_EQ(capacity, v.capacity());
+    v.resize(10);
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        ASSERT_EQ(0u, v[i]) << i;
+    }
+}
+
+TYPED_TEST(PackedVector, every_unpack_variant_matches_get) {
+    using vector = packed_vector<TypeParam::value>;
+    const auto values = random_values(517, vector::max_value());
+    vector v;
+    v.append(const_view(values));
+    const simd_isa levels[] = { simd_isa::scalar, simd_isa::sse2, simd_isa::avx2, 
+                                simd_isa::avx512 };
+    for (simd_isa isa : levels) {
+        if (isa > detected_simd_isa()) {
+            break;
+        }
+        auto unpack = detail::unpack_kernels<TypeParam::value>().resolve(isa);
+        // unaligned starts and lengths exercise the scalar head and tail, 
+        // the end of the vector the padding
+        for (std::size_t first : {std::size_t(0), std::size_t(3), std::size_t(8), std::size_t(61)}) {
+            std::vector<u32> out(values.size() - first, 0xdeadbeef);
+            unpack(v.words(), first, out.size(), out.data());
+            for (std::size_t i = 0; i < out.size(); ++i) {
+                ASSERT_EQ(values[first + i], out[i]) << simd_isa_name(isa) << " " << first + i;
+            }
+        }
+    }
+    std::vector<u32> out(5);
+    v.unpack(11, mem_view<u32>(out.data(), out.data() + out.size()));
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        EXPECT_EQ(values[11 + i], out[i]);
+    }
+}
+
+TYPED_TEST(PackedVector, pack_overwrites_range_only) {
+    using vector = packed_vector<TypeParam::value>;
+    const auto values = random_values(400, vector::max_value(), 1);
+    const auto update = random_values(123, vector::max_value(), 2);
+    vector v;
+    v.append(const_view(values));
+    v.pack(77, const_view(update));
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        const u32 expected = i >= 77 && i < 200 ? update[i - 77] : values[i];
+        ASSERT_EQ(expected, v[i]) << i;
+    }
+}
+
+TYPED_TEST(PackedVector, copy_and_move) {
+    using vector = packed_vector<TypeParam::value>;
+    const auto values = random_values(70, vector::max_value());
+    vector v;
+    v.append(const_view(values));
+    vector copy(v);
+    vector assigned;
+    assigned.push_back(1);
+    assigned = copy;
+    vector moved(std::move(copy));
+    EXPECT_TRUE(copy.empty());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(values[i], moved[i]);
+        ASSERT_EQ(values[i], assigned[i]);
+    }
+    v = vector();
+    EXPECT_TRUE(v.empty());
+    EXPECT_EQ(values.size(), vector(assigned).size());
+}
@@ -0,0 +1,114 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <typus/packed_vector.hh>
+
+namespace ty = typus;
+
+template <typename F>
+double best_ms(F &&f) {
+    double best = 1e30;
+    for (int run = 0; run < 5; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    return best;
+}
+
+static double values_per_ns(std::size_t n, double ms) {
+    return n / (ms * 1e6);
+}
+
+static volatile ty::u32 sink;
+
+template <unsigned Bits>
+static void run(std::size_t n, const std::vector<ty::u32> &random, std::vector<ty::u32> &out) {
+    std::vector<ty::u32> values(n), index(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        values[i] = random[i] & ty::packed_vector<Bits>::max_value();
+        index[i] = random[n - 1 - i] % n;
+    }
+    ty::mem_view<const ty::u32> in(values.data(), values.data() + n);
+    ty::mem_view<ty::u32> dst(out.data(), out.data() + n);
+    ty::packed_vector<Bits> v(n);
+    const double pack_ms = best_ms([&]() { v.pack(0, in); });
+    auto scalar = ty::detail::unpack_kernels<Bits>().resolve(ty::simd_isa::scalar);
+    const double scalar_ms = best_ms([&]() { scalar(v.words(), 0, n, out.data()); });
+    const double unpack_ms = best_ms([&]() { v.unpack(0, dst); });
+    if (out != values) {
+        std::cout << "unpack mismatch at " << Bits << " bits" << std::endl;
+    }
+    // random access through operator[], at random positions
+    const std::size_t lookups = n;
+    const double get_ms = best_ms([&]() {
+        ty::u32 sum = 0;
+        for (std::size_t k = 0; k < lookups; ++k) {
+            sum += v[index[k]];
+        }
+        sink = sum;
+    });
+    std::cout << std::setw(4) << Bits << std::setw(10) << std::setprecision(3) 
+              << v.storage_bytes() / 1048576.0 
+              << std::setw(10) << values_per_ns(n, pack_ms) 
+              << std::setw(10) << values_per_ns(n, scalar_ms) 
+              << std::setw(10) << values_per_ns(n, unpack_ms) 
+              << std::setw(10) << get_ms * 1e6 / lookups << std::endl;
+}
+
+template <unsigned Bits>
+struct run_widths {
+    static void run_all(std::size_t n, const std::vector<ty::u32> &random, 
+                        std::vector<ty::u32> &out) {
+        run_widths<Bits - 1>::run_all(n, random, out);
+        run<Bits>(n, random, out);
+    }
+};
+
+template <>
+struct run_widths<0> {
+    static void run_all(std::size_t, const std::vector<ty::u32> &, std::vector<ty::u32> &) {
+    }
+};
+
+// Built for the baseline target, so unpack() shows the variant picked at 
+// run time; set TYPUS_SIMD_ISA=scalar to compare.
+int main(int argc, const char **argv) {
+    const std::size_t n = argc > 1 ? std::atoll(argv[1]) : 4000000;
+    std::mt19937 rng(42);
+    std::vector<ty::u32> random(n), out(n);
+    for (auto &r : random) {
+        r = rng();
+    }
+    std::vector<ty::u32> copy(n);
+    const double memcpy_ms = best_ms([&]() { 
+        std::memcpy(copy.data(), random.data(), n * sizeof(ty::u32)); 
+    });
+    std::cout << n << " values, active level " << ty::simd_isa_name(ty::active_simd_isa()) 
+              << ", memcpy of u32: " << values_per_ns(n, memcpy_ms) << " values/ns, " 
+              << n * sizeof(ty::u32) / 1048576.0 << " MiB" << std::endl;
+    std::cout << "bits       MiB      pack    scalar    unpack  get (ns)" << std::endl;
+    std::cout << "                (values/ns)" << std::endl;
+    run_widths<32>::run_all(n, random, out);
+    return 0;
+}
@@ -0,0 +1,166 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/reduce.hh>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+namespace {
+
+std::vector<vec3_f> random_points(std::size_t n, f32 offset = 0.0f) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<f32> dist(-1.0f, 1.0f);
+    std::vector<vec3_f> points(n);
+    for (auto &p : points) {
+        p = vec3_f(offset + dist(rng), offset + 2.0f * dist(rng), offset + 0.5f * dist(rng));
+    }
+    return points;
+}
+
+mem_view<const vec3_f> view(const std::vector<vec3_f> &v) {
+    return mem_view<const vec3_f>(v.data(), v.data() + v.size());
+}
+
+reduce_options options(summation mode, unsigned num_threads) {
+    reduce_options o;
+    o.mode = mode;
+    o.num_threads = num_threads;
+    return o;
+}
+
+const summation modes[] = { summation::naive, summation::kahan, summation::pairwise };
+
+}
+
+TEST(Reduce, sum_and_centroid) {
+    for (std::size_t n : {std::size_t(1), std::size_t(7), std::size_t(50001)}) {
+        auto points = random_points(n);
+        double x = 0, y = 0, z = 0;
+        for (const auto &p : points) {
+            x += p.x;
+            y += p.y;
+            z += p.z;
+        }
+        for (summation mode : modes) {
+            for (unsigned threads : {1u, 3u}) {
+                vec3_f s = sum(view(points), options(mode, threads));
+                EXPECT_NEAR(x, s.x, 1e-2);
+                EXPECT_NEAR(y, s.y, 1e-2);
+                EXPECT_NEAR(z, s.z, 1e-2);
+                vec3_f c = centroid(view(points), options(mode, threads));
+                EXPECT_NEAR(x / n, c.x, 1e-5);
+                EXPECT_NEAR(z / n, c.z, 1e-5);
+            }
+        }
+    }
+    ASSERT_EQ(vec3_f(0.0f, 0.0f, 0.0f), sum(view(std::vector<vec3_f>())));
+}
+
+TEST(Reduce, compensated_summation_is_accurate) {
+    // 0.1f is not exact in binary, and once the sum is large, most of each 
+    // addition is rounded away in naive f32 summation.
+    std::vector<vec3_f> points(1 << 21, vec3_f(0.1f, 1.0f, 3.3f));
+    const double expected = double(0.1f) * points.size();
+    auto error = [&](summation mode) {
+        return std::fabs(sum(view(points), options(mode, 1)).x - expected) / expected;
+    };
+    EXPECT_LT(error(summation::kahan), 1e-7);
+    EXPECT_LT(error(summation::pairwise), 1e-6);
+    EXPECT_GT(error(summation::naive), 1e-4);
+}
+
+TEST(Reduce, bounds) {
+    for (std::size_t n : {std::size_t(1), std::size_t(13), std::size_t(70001)}) {
+        auto points = random_points(n, 5.0f);
+        aabb_f expected;
+        for (const auto &p : points) {
+            expected.extend(p);
+        }
+        ASSERT_EQ(expected, bounds(view(points)));
+        ASSERT_EQ(expected, bounds(view(points), options(summation::naive, 4)));
+    }
+    ASSERT_TRUE(bounds(view(std::vector<vec3_f>())).empty());
+}
+
+TEST(Reduce, covariance_far_from_origin) {
+    // a one-pass formula loses all digits at this offset in f32
+    auto points = random_points(40000, 10000.0f);
+    double mean[3] = {0, 0, 0};
+    for (const auto &p : points) {
+        mean[0] += p.x;
+        mean[1] += p.y;
+        mean[2] += p.z;
+    }
+    for (double &m : mean) {
+        m /= points.size();
+    }
+    double expected[3][3] = {};
+    for (const auto &p : points) {
+        const double d[3] = { p.x - mean[0], p.y - mean[1], p.z - mean[2] };
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                expected[i][j] += d[i] * d[j] / points.size();
+            }
+        }
+    }
+    for (summation mode : modes) {
+        mat3_f cov = covariance(view(points), options(mode, 2));
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                EXPECT_NEAR(expected[i][j], cov(i, j), 1e-3) << i << ", " << j;
+            }
+        }
+    }
+    // variances of uniform distributions of half-widths 1, 2 and 0.5
+    mat3_f cov = covariance(view(points));
+    EXPECT_NEAR(1.0 / 3.0, cov(0, 0), 1e-2);
+    EXPECT_NEAR(4.0 / 3.0, cov(1, 1), 2e-2);
+    EXPECT_NEAR(0.25 / 3.0, cov(2, 2), 1e-2);
+}
+
+TEST(Reduce, principal_axis_of_points) {
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<f32> along(-10.0f, 10.0f), noise(-0.1f, 0.1f);
+    const vec3_f dir = vec3_f(2.0f, -3.0f, 6.0f) * (1.0f / 7.0f);
+    std::vector<vec3_f> points(10000);
+    for (auto &p : points) {
+        p = dir * along(rng) + vec3_f(noise(rng) + 3.0f, noise(rng), noise(rng));
+    }
+    vec3_f axis = principal_axis(view(points));
+    EXPECT_NEAR(1.0f, axis.norm(), 1e-5f);
+    EXPECT_GT(std::fabs(dot(axis, dir)), 0.9999f);
+    // the sign convention makes the largest component positive
+    EXPECT_GT(axis.z, 0.0f);
+}
+
+TEST(Reduce, principal_axis_of_matrices) {
+    ASSERT_EQ(vec3_f(0.0f, 1.0f, 0.0f), 
+              principal_axis(mat3_f::scale(vec3_f(1.0f, 3.0f, 2.0f))));
+    ASSERT_EQ(vec3_f(0.0f, 0.0f, 1.0f), 
+              principal_axis(mat3_f::scale(vec3_f(1.0f, 3.0f, 5.0f))));
+    // a repeated largest eigenvalue: any axis orthogonal to the third 
+    // eigenvector will do
+    const mat3_f r = mat3_f::rotation(vec3_f(0.6f, 0.8f, 0.0f), 0.5f);
+    const mat3_f m = r * mat3_f::scale(vec3_f(2.0f, 2.0f, 1.0f)) * r.transposed();
+    vec3_f axis = principal_axis(m);
+    EXPECT_NEAR(1.0f, axis.norm(), 1e-5f);
+    EXPECT_NEAR(0.0f, dot(axis, r.col(2)), 1e-4f);
+}
@@ -0,0 +1,118 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <typus/reduce.hh>
+
+namespace ty = typus;
+
+template <typename F>
+double time_ms(F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+static ty::reduce_options options(ty::summation mode, unsigned num_threads) {
+    ty::reduce_options o;
+    o.mode = mode;
+    o.num_threads = num_threads;
+    return o;
+}
+
+int main(int argc, const char **argv) {
+    const std::size_t n = argc > 1 ? std::atoll(argv[1]) : 10000000;
+    const unsigned max_threads = argc > 2 ? std::atoi(argv[2]) : ty::default_thread_count();
+    // points in a box away from the origin, as e.g. in georeferenced scans
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<ty::f32> dist(1000.0f, 1100.0f);
+    std::vector<ty::vec3_f> points(n);
+    for (auto &p : points) {
+        p = ty::vec3_f(dist(rng), dist(rng), dist(rng));
+    }
+    ty::mem_view<const ty::vec3_f> view(points.data(), points.data() + n);
+
+    double reference = 0.0;
+    for (const auto &p : points) {
+        reference += p.x;
+    }
+    reference /= n;
+    double reference_variance = 0.0;
+    for (const auto &p : points) {
+        reference_variance += (p.x - reference) * (p.x - reference);
+    }
+    reference_variance /= n;
+    std::cout << n << " points" << std::endl;
+
+    ty::vec3_f serial;
+    double serial_ms = time_ms([&]() {
+        ty::vec3_f s(0.0f, 0.0f, 0.0f);
+        for (const auto &p : points) {
+            s += p;
+        }
+        serial = s * (1.0f / n);
+    });
+    std::cout << "serial operator+= centroid: " << serial_ms << " ms, relative error " 
+              << std::fabs(serial.x - reference) / reference << std::endl;
+
+    const struct {
+        const char *name;
+        ty::summation mode;
+    } modes[] = {
+        { "naive", ty::summation::naive },
+        { "kahan", ty::summation::kahan },
+        { "pairwise", ty::summation::pairwise },
+    };
+    // powers of two, followed by max_threads itself
+    std::vector<unsigned> thread_counts;
+    for (unsigned t = 1; t < max_threads; t *= 2) {
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(max_threads);
+    std::cout << "threads, kernel, ms, relative error" << std::endl;
+    for (unsigned threads : thread_counts) {
+        for (const auto &mode : modes) {
+            ty::vec3_f c;
+            double ms = time_ms([&]() { c = ty::centroid(view, options(mode.mode, threads)); });
+            std::cout << threads << ", centroid " << mode.name << ", " << ms << ", " 
+                      << std::fabs(c.x - reference) / reference << std::endl;
+        }
+        ty::aabb_f box;
+        double bounds_ms = time_ms([&]() { 
+            box = ty::bounds(view, options(ty::summation::naive, threads)); 
+        });
+        std::cout << threads << ", bounds, " << bounds_ms << ", " << box << std::endl;
+        ty::mat3_f cov;
+        double cov_ms = time_ms([&]() { 
+            cov = ty::covariance(view, options(ty::summation::pairwise, threads)); 
+        });
+        std::cout << threads << ", covariance pairwise, " << cov_ms << ", " 
+                  << std::fabs(cov(0, 0) - reference_variance) / reference_variance 
+                  << std::endl;
+        ty::vec3_f axis;
+        double axis_ms = time_ms([&]() { 
+            axis = ty::principal_axis(view, options(ty::summation::pairwise, threads)); 
+        });
+        std::cout << threads << ", principal axis, " << axis_ms << ", " << axis << std::endl;
+    }
+    return 0;
+}
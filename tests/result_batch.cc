@@ -0,0 +1,139 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/result_batch.hh>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+enum class Error {
+    Negative, TooLarge
+};
+
+TEST(ResultBatch, push_and_access) {
+    result_batch<int, Error> batch;
+    ASSERT_TRUE(batch.empty());
+    ASSERT_TRUE(batch.all_ok());
+    batch.push_back(1);
+    batch.push_error(Error::Negative);
+    batch.push_back(3);
+    ASSERT_EQ(3u, batch.size());
+    ASSERT_FALSE(batch.all_ok());
+    ASSERT_EQ(1u, batch.error_count());
+    ASSERT_TRUE(batch.ok(0));
+    ASSERT_FALSE(batch.ok(1));
+    ASSERT_EQ(1, batch.value(0));
+    ASSERT_EQ(Error::Negative, batch.error(1));
+    ASSERT_EQ(3, batch.value(2));
+}
+
+TEST(ResultBatch, conversion_from_and_to_results) {
+    std::vector<result<std::string, Error>> results;
+    for (int i = 0; i < 200; ++i) {
+        if (i % 7 == 0) {
+            results.push_back(result<std::string, Error>::fail(Error::TooLarge));
+        } else {
+            results.push_back(std::to_string(i));
+        }
+    }
+    result_batch<std::string, Error> batch(results.begin(), results.end());
+    ASSERT_EQ(200u, batch.size());
+    ASSERT_EQ(29u, batch.error_count());
+    std::vector<result<std::string, Error>> back = batch.to_results();
+    ASSERT_EQ(results.size(), back.size());
+    for (std::size_t i = 0; i < back.size(); ++i) {
+        ASSERT_EQ(results[i].ok(), back[i].ok());
+        if (back[i].ok()) {
+            ASSERT_EQ(results[i].value(), back[i].value());
+        } else {
+            ASSERT_EQ(Error::TooLarge, back[i].error());
+        }
+    }
+}
+
+TEST(ResultBatch, iterate_successes_and_failures) {
+    result_batch<int, Error> batch;
+    for (int i = 0; i < 150; ++i) {
+        if (i % 3 == 0) {
+            batch.push_error(Error::Negative);
+        } else {
+            batch.push_back(i);
+        }
+    }
+    std::vector<std::size_t> ok_indices;
+    batch.for_each_ok([&](std::size_t i, int value) {
+        ASSERT_EQ(static_cast<int>(i), value);
+        ok_indices.push_back(i);
+    });
+    ASSERT_EQ(100u, ok_indices.size());
+    ASSERT_EQ(1u, ok_indices.front());
+    ASSERT_EQ(149u, ok_indices.back());
+    std::vector<std::size_t> error_indices;
+    batch.for_each_error([&](std::size_t i, Error) {
+        error_indices.push_back(i);
+    });
+    ASSERT_EQ(50u, error_indices.size());
+    ASSERT_EQ(0u, error_indices.front());
+    ASSERT_EQ(147u, error_indices.back());
+}
+
+TEST(ResultBatch, fail_after_validation) {
+    result_batch<int, Error> batch;
+    for (int i = -5; i < 95; ++i) {
+        batch.push_back(i);
+    }
+    ASSERT_TRUE(batch.all_ok());
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        if (batch.values()[i] < 0) {
+            batch.fail(i, Error::Negative);
+        }
+    }
+    batch.fail(99, Error::TooLarge);
+    ASSERT_EQ(6u, batch.error_count());
+    ASSERT_EQ(Error::Negative, batch.error(4));
+    ASSERT_EQ(Error::TooLarge, batch.error(99));
+    ASSERT_TRUE(batch.ok(5));
+    ASSERT_FALSE(batch[0].ok());
+    ASSERT_EQ(0, batch[5].value());
+    std::size_t last = 0;
+    batch.for_each_error([&](std::size_t i, Error) {
+        ASSERT_LE(last, i);
+        last = i;
+    });
+}
+
+TEST(ResultBatch, fail_if) {
+    result_batch<int, Error> batch;
+    for (int i = 0; i < 130; ++i) {
+        if (i == 64) {
+            batch.push_error(Error::Negative);
+        } else {
+            batch.push_back(i);
+        }
+    }
+    batch.fail_if([](int v) { return v >= 100 || v == 64; }, Error::TooLarge);
+    ASSERT_EQ(31u, batch.error_count());
+    ASSERT_EQ(Error::Negative, batch.error(64));
+    ASSERT_EQ(Error::TooLarge, batch.error(100));
+    ASSERT_EQ(Error::TooLarge, batch.error(129));
+    ASSERT_TRUE(batch.ok(99));
+    std::size_t count = 0;
+    batch.for_each_ok([&](std::size_t, int) { ++count; });
+    ASSERT_EQ(99u, count);
+}
@@ -0,0 +1,96 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+// Compares result<T, E> against exceptions and out-parameter error codes 
+// across call depth, error rate and payload size. Writes one CSV row per 
+// configuration to stdout:
+//
+//   strategy,depth,error_rate,payload_bytes,calls,ns_per_call,calls_per_sec
+//
+// Pass --quick for a reduced number of calls per configuration. The size of 
+// the code generated for each strategy is reported by the 
+// result-benchmark-size target.
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "result_benchmark_kernels.hh"
+
+namespace {
+
+const int depths[] = { 1, 2, 4, 8, 16, 32 };
+const double error_rates[] = { 0.0, 0.001, 0.1, 0.5 };
+const bench::u32 input_range = 1000000;
+
+double ns_per_call(bench::kernel k, const bench::run_args & args, 
+                   bench::u64 & checksum) {
+    auto start = std::chrono::steady_clock::now();
+    checksum = k(args);
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / 
+           args.count;
+}
+
+}
+
+int main(int argc, const char **argv) {
+    bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+    const std::size_t frames_per_run = quick ? 200000 : 4000000;
+    std::vector<bench::u32> inputs(frames_per_run);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<bench::u32> dist(0, input_range - 1);
+    for (auto & x : inputs) {
+        x = dist(rng);
+    }
+    const bench::strategy *strategies[] = {
+        &bench::result_strategy, 
+        &bench::exception_strategy, 
+        &bench::error_code_strategy
+    };
+    std::cout << "strategy,depth,error_rate,payload_bytes,calls,"
+              << "ns_per_call,calls_per_sec\n";
+    int status = 0;
+    for (int depth : depths) {
+        for (double rate : error_rates) {
+            for (std::size_t p = 0; p < 3; ++p) {
+                bench::run_args args;
+                args.inputs = inputs.data();
+                args.count = frames_per_run / depth;
+                args.threshold = static_cast<bench::u32>(rate * input_range);
+                args.depth = depth;
+                bench::u64 expected = 0;
+                for (std::size_t s = 0; s < 3; ++s) {
+                    bench::u64 checksum = 0;
+                    double ns = ns_per_call(strategies[s]->by_payload[p], 
+                                            args, checksum);
+                    if (s == 0) {
+                        expected = checksum;
+                    } else if (checksum != expected) {
+                        std::cerr << "checksum mismatch for " 
+                                  << strategies[s]->name << "\n";
+                        status = 1;
+                    }
+                    std::cout << strategies[s]->name << "," << depth << "," 
+                              << rate << "," << bench::payload_sizes[p] << ","
+                              << args.count << "," << ns << "," 
+                              << 1e9 / ns << "\n";
+                }
+            }
+        }
+    }
+    return status;
+}
@@ -0,0 +1,60 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include "result_benchmark_kernels.hh"
+
+namespace bench {
+
+namespace {
+
+// returns zero on success and writes the value to out.
+template <std::size_t N>
+BENCH_NOINLINE u32 chain(int depth, u32 input, u32 threshold, 
+                         payload<N> & out) {
+    if (depth == 0) {
+        if (input < threshold) {
+            return input + 1;
+        }
+        for (u64 & d : out.data) {
+            d = input;
+        }
+        return 0;
+    }
+    u32 code = chain<N>(depth - 1, input, threshold, out);
+    if (code != 0) {
+        return code;
+    }
+    out.data[0] += 1;
+    return 0;
+}
+
+template <std::size_t N>
+u64 run(const run_args & args) {
+    u64 checksum = 0;
+    for (std::size_t i = 0; i < args.count; ++i) {
+        payload<N> p;
+        u32 code = chain<N>(args.depth - 1, args.inputs[i], args.threshold, p);
+        checksum += code == 0 ? p.data[0] : code;
+    }
+    return checksum;
+}
+
+}
+
+const strategy error_code_strategy = {
+    "error_code", { &run<8>, &run<64>, &run<256> }
+};
+
+}
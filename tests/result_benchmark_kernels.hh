@@ -0,0 +1,69 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+// Kernels for result-benchmark. Each error handling strategy lives in its own
+// translation unit, so the size of the generated code can be compared with 
+// the result-benchmark-size target.
+#ifndef TYPUS_RESULT_BENCHMARK_KERNELS_HH
+#define TYPUS_RESULT_BENCHMARK_KERNELS_HH
+
+#include <cstddef>
+
+#include <typus/numbers.hh>
+
+namespace bench {
+
+using typus::u32;
+using typus::u64;
+
+#if defined(__GNUC__) || defined(__clang__)
+#   define BENCH_NOINLINE __attribute__((noinline))
+#else
+#   define BENCH_NOINLINE
+#endif
+
+// value returned by the innermost frame. 
+template <std::size_t N>
+struct payload {
+    u64 data[N / sizeof(u64)];
+};
+
+struct run_args {
+    const u32 *inputs;
+    std::size_t count;
+    // inputs below the threshold fail in the innermost frame
+    u32 threshold;
+    // number of frames between the caller and the failing function
+    int depth;
+};
+
+// runs the call chain once per input and returns a checksum over the 
+// values and errors seen by the caller.
+using kernel = u64 (*)(const run_args &);
+
+const std::size_t payload_sizes[] = { 8, 64, 256 };
+
+struct strategy {
+    const char *name;
+    kernel by_payload[3];
+};
+
+extern const strategy result_strategy;
+extern const strategy exception_strategy;
+extern const strategy error_code_strategy;
+
+} // namespace bench
+
+#endif // TYPUS_RESULT_BENCHMARK_KERNELS_HH
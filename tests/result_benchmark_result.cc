@@ -0,0 +1,61 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include "result_benchmark_kernels.hh"
+
+#include <typus/result.hh>
+
+namespace bench {
+
+namespace {
+
+template <std::size_t N>
+BENCH_NOINLINE typus::result<payload<N>, u32> chain(int depth, u32 input, 
+                                                    u32 threshold) {
+    if (depth == 0) {
+        if (input < threshold) {
+            return typus::result<payload<N>, u32>::fail(input + 1);
+        }
+        payload<N> p;
+        for (u64 & d : p.data) {
+            d = input;
+        }
+        return p;
+    }
+    typus::result<payload<N>, u32> r = chain<N>(depth - 1, input, threshold);
+    if (!r.ok()) {
+        return r;
+    }
+    r.value().data[0] += 1;
+    return r;
+}
+
+template <std::size_t N>
+u64 run(const run_args & args) {
+    u64 checksum = 0;
+    for (std::size_t i = 0; i < args.count; ++i) {
+        auto r = chain<N>(args.depth - 1, args.inputs[i], args.threshold);
+        checksum += r.ok() ? r.value().data[0] : r.error();
+    }
+    return checksum;
+}
+
+}
+
+const strategy result_strategy = {
+    "result", { &run<8>, &run<64>, &run<256> }
+};
+
+}
@@ -0,0 +1,218 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/simd.hh>
+
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+template <typename P>
+class Simd : public ::testing::Test {
+};
+
+using SimdTypes = ::testing::Types<
+    simd<f32, 4>, simd<f32, 8>, simd<f32, 16>,
+    simd<f64, 2>, simd<f64, 4>, simd<f64, 8>,
+    simd<i32, 4>, simd<i32, 8>, simd<i32, 16>, simd<u32, 8>,
+    simd<i64, 4>, simd<i16, 8>, simd<i8, 16>, simd<u8, 32>
+>;
+TYPED_TEST_SUITE(Simd, SimdTypes);
+
+namespace {
+
+// values small enough to not overflow i8 when multiplied
+template <typename T>
+T value(std::size_t i) {
+    return T(i % 9) + T(1);
+}
+
+}
+
+TYPED_TEST(Simd, load_store_and_broadcast) {
+    using P = TypeParam;
+    using T = typename P::value_type;
+    constexpr std::size_t N = P::size();
+    alignas(64) T in[N], out[N];
+    for (std::size_t i = 0; i < N; ++i) {
+        in[i] = value<T>(i);
+    }
+    P a = P::load(in), b = P::load_aligned(in);
+    a.store(out);
+    for (std::size_t i = 0; i < N; ++i) {
+        EXPECT_EQ(in[i], out[i]);
+        EXPECT_EQ(in[i], b[i]);
+    }
+    P(T(3)).store_aligned(out);
+    for (std::size_t i = 0; i < N; ++i) {
+        EXPECT_EQ(T(3), out[i]);
+        EXPECT_EQ(T(0), P()[i]);
+        EXPECT_EQ(T(i), P::iota()[i]);
+    }
+}
+
+TYPED_TEST(Simd, masked_load_store) {
+    using P = TypeParam;
+    using T = typename P::value_type;
+    constexpr std::size_t N = P::size();
+    for (std::size_t count = 0; count <= N; ++count) {
+        T in[N], out[N + 1];
+        for (std::size_t i = 0; i < N; ++i) {
+            in[i] = value<T>(i);
+            out[i] = T(0);
+        }
+        out[N] = T(0);
+        const auto m = P::mask_type::first(count);
+        P v = P::load_masked(in, m);
+        for (std::size_t i = 0; i < N; ++i) {
+            EXPECT_EQ(i < count ? in[i] : T(0), v[i]);
+        }
+        // writing from out + 1 checks unaligned stores leave inactive lanes
+        P(T(7)).store_masked(out + 1, m);
+        EXPECT_EQ(T(0), out[0]);
+        for (std::size_t i = 0; i < N; ++i) {
+            EXPECT_EQ(i < count ? T(7) : T(0), out[i + 1]);
+        }
+    }
+}
+
+TYPED_TEST(Simd, arithmetic) {
+    using P = TypeParam;
+    using T = typename P::value_type;
+    constexpr std::size_t N = P::size();
+    T a[N], b[N];
+    for (std::size_t i = 0; i < N; ++i) {
+        a[i] = value<T>(i);
+        b[i] = value<T>(i + 4);
+    }
+    const P va = P::load(a), vb = P::load(b);
+    const P sum = va + vb, diff = vb - va, prod = va * vb, quot = prod / vb;
+    P acc = va;
+    acc += vb;
+    acc *= T(2);
+    for (std::size_t i = 0; i < N; ++i) {
+        EXPECT_EQ(T(a[i] + b[i]), sum[i]);
+        EXPECT_EQ(T(b[i] - a[i]), diff[i]);
+        EXPECT_EQ(T(a[i] * b[i]), prod[i]);
+        EXPECT_EQ(a[i], quot[i]);
+        EXPECT_EQ(T((a[i] + b[i]) * 2), acc[i]);
+        EXPECT_EQ(T(T(0) - a[i]), (-va)[i]);
+    }
+}
+
+TYPED_TEST(Simd, compare_and_select) {
+    using P = TypeParam;
+    using T = typename P::value_type;
+    constexpr std::size_t N = P::size();
+    T a[N], b[N];
+    for (std::size_t i = 0; i < N; ++i) {
+        a[i] = value<T>(i);
+        b[i] = value<T>(i * 5);
+    }
+    const P va = P::load(a), vb = P::load(b);
+    const auto lt = va < vb, eq = va == vb;
+    const P lo = min(va, vb), hi = max(va, vb), sel = select(lt, va, vb);
+    u64 bits = 0;
+    for (std::size_t i = 0; i < N; ++i) {
+        EXPECT_EQ(a[i] < b[i], lt[i]);
+        EXPECT_EQ(a[i] == b[i], eq[i]);
+        EXPECT_EQ(a[i] >= b[i], (va >= vb)[i]);
+        EXPECT_EQ(a[i] != b[i], (va != vb)[i]);
+        EXPECT_EQ(a[i] < b[i] ? a[i] : b[i], lo[i]);
+        EXPECT_EQ(a[i] > b[i] ? a[i] : b[i], hi[i]);
+        EXPECT_EQ(a[i] < b[i] ? a[i] : b[i], sel[i]);
+        bits |= u64(a[i] < b[i]) << i;
+    }
+    EXPECT_EQ(bits, lt.to_bits());
+    EXPECT_EQ(bits, P::mask_type::from_bits(bits).to_bits());
+    EXPECT_EQ(bits != 0, lt.any());
+    EXPECT_TRUE((va == va).all());
+    EXPECT_TRUE((va != va).none());
+    EXPECT_TRUE((lt | ~lt).all());
+    EXPECT_TRUE((lt & ~lt).none());
+    EXPECT_TRUE(P::mask_type::first(N).all());
+    EXPECT_TRUE(P::mask_type::first(0).none());
+}
+
+TYPED_TEST(Simd, reductions) {
+    using P = TypeParam;
+    using T = typename P::value_type;
+    constexpr std::size_t N = P::size();
+    T a[N];
+    T sum = 0, lo = value<T>(0), hi = lo;
+    for (std::size_t i = 0; i < N; ++i) {
+        a[i] = value<T>(i * 7);
+        sum = T(sum + a[i]);
+        lo = std::min(lo, a[i]);
+        hi = std::max(hi, a[i]);
+    }
+    const P v = P::load(a);
+    EXPECT_EQ(sum, reduce_add(v));
+    EXPECT_EQ(lo, reduce_min(v));
+    EXPECT_EQ(hi, reduce_max(v));
+}
+
+TYPED_TEST(Simd, gather_and_shuffle) {
+    using P = TypeParam;
+    using T = typename P::value_type;
+    constexpr std::size_t N = P::size();
+    T table[3 * N], a[N];
+    i32 index[N];
+    for (std::size_t i = 0; i < 3 * N; ++i) {
+        table[i] = T(i % 100);
+    }
+    for (std::size_t i = 0; i < N; ++i) {
+        a[i] = value<T>(i);
+        index[i] = i32((i * 7 + 3) % N);
+    }
+    const auto idx = simd<i32, N>::load(index);
+    const P g = gather(table, idx * 3);
+    const P s = shuffle(P::load(a), idx);
+    for (std::size_t i = 0; i < N; ++i) {
+        EXPECT_EQ(table[index[i] * 3], g[i]);
+        EXPECT_EQ(a[index[i]], s[i]);
+    }
+}
+
+TEST(Simd, integer_bit_operations) {
+    using P = simd<u32, 8>;
+    const P a = P::iota(), b = P(0xf0u);
+    const P counts = P::iota();
+    for (std::size_t i = 0; i < P::size(); ++i) {
+        EXPECT_EQ(u32(i & 0xf0u), (a & b)[i]);
+        EXPECT_EQ(u32(i | 0xf0u), (a | b)[i]);
+        EXPECT_EQ(u32(i ^ 0xf0u), (a ^ b)[i]);
+        EXPECT_EQ(~u32(i), (~a)[i]);
+        EXPECT_EQ(u32(i << 3), (a << 3)[i]);
+        EXPECT_EQ(u32(0xf0u >> 4), (b >> 4)[i]);
+        EXPECT_EQ(u32(0xf0u << i), (b << counts)[i]);
+    }
+}
+
+TEST(Simd, native_width_and_dispatch) {
+    EXPECT_EQ(native_simd_bytes, sizeof(native_simd<f32>));
+    EXPECT_EQ(native_simd_bytes / 8, native_simd<f64>::size());
+    // the compiled level can't exceed what the CPU supports, or we wouldn't 
+    // be running
+    EXPECT_LE(compiled_simd_isa(), detected_simd_isa());
+    using fn = int (*)();
+    const fn scalar = [] { return 0; };
+    const fn sse2 = [] { return 1; };
+    EXPECT_EQ(scalar(), select_simd<fn>(scalar, nullptr)());
+    const int expected = active_simd_isa() >= simd_isa::sse2 ? 1 : 0;
+    EXPECT_EQ(expected, select_simd(scalar, sse2)());
+}
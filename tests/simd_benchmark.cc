@@ -0,0 +1,261 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <typus/simd.hh>
+
+namespace ty = typus;
+
+template <typename F>
+double best_ns_per_element(std::size_t n, std::size_t repeat, F &&f) {
+    double best = 1e30;
+    for (int run = 0; run < 5; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t r = 0; r < repeat; ++r) {
+            f();
+        }
+        auto stop = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        best = std::min(best, ns / (n * repeat));
+    }
+    return best;
+}
+
+// the widest pack benchmarked. The arrays are a multiple of twice its size 
+// long, so every pack loop covers them without a remainder.
+constexpr std::size_t max_lanes = ty::native_simd<ty::f32>::size() > 8 ? 
+                                  ty::native_simd<ty::f32>::size() : 8;
+
+struct data {
+    std::vector<ty::f32> a, b, c, out;
+    std::vector<ty::i32> index;
+    std::vector<ty::u32> bits, bits_out;
+    // a copy of a and an output array, both aligned to the widest pack
+    std::vector<ty::f32> aligned_buffer;
+    ty::f32 *aligned_a;
+    ty::f32 *aligned_out;
+};
+
+static volatile ty::f32 sink;
+
+static void report(const char *op, const char *variant, double ns) {
+    std::cout << "  " << op << ", " << variant << ": " << ns << " ns/element" << std::endl;
+}
+
+// The plain loops are what the compiler makes of them on its own: it 
+// vectorizes the element-wise ones and the count, but not the float sum 
+// (that would reorder additions) nor the gather.
+static void run_scalar(data &d, std::size_t repeat) {
+    const std::size_t n = d.a.size();
+    std::cout << "plain loops" << std::endl;
+    report("a * b + c", "loop", best_ns_per_element(n, repeat, [&]() {
+        for (std::size_t i = 0; i < n; ++i) {
+            d.out[i] = d.a[i] * d.b[i] + d.c[i];
+        }
+        sink = d.out[n / 2];
+    }));
+    report("clamp", "loop", best_ns_per_element(n, repeat, [&]() {
+        for (std::size_t i = 0; i < n; ++i) {
+            d.out[i] = std::min(std::max(d.a[i], -0.5f), 0.5f);
+        }
+        sink = d.out[n / 2];
+    }));
+    report("sum", "loop", best_ns_per_element(n, repeat, [&]() {
+        ty::f32 s = 0.0f;
+        for (std::size_t i = 0; i < n; ++i) {
+            s += d.a[i];
+        }
+        sink = s;
+    }));
+    report("count a < b", "loop", best_ns_per_element(n, repeat, [&]() {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            count += d.a[i] < d.b[i];
+        }
+        sink = ty::f32(count);
+    }));
+    report("gather", "loop", best_ns_per_element(n, repeat, [&]() {
+        for (std::size_t i = 0; i < n; ++i) {
+            d.out[i] = d.b[d.index[i]];
+        }
+        sink = d.out[n / 2];
+    }));
+    report("min and max", "loop", best_ns_per_element(n, repeat, [&]() {
+        ty::f32 lo = d.a[0], hi = d.a[0];
+        for (std::size_t i = 0; i < n; ++i) {
+            lo = d.a[i] < lo ? d.a[i] : lo;
+            hi = d.a[i] > hi ? d.a[i] : hi;
+        }
+        sink = lo + hi;
+    }));
+    report("2 * a, aligned", "loop", best_ns_per_element(n, repeat, [&]() {
+        for (std::size_t i = 0; i < n; ++i) {
+            d.aligned_out[i] = 2.0f * d.aligned_a[i];
+        }
+        sink = d.aligned_out[n / 2];
+    }));
+    report("xorshift", "loop", best_ns_per_element(n, repeat, [&]() {
+        for (std::size_t i = 0; i < n; ++i) {
+            ty::u32 x = d.bits[i];
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << (x & 7);
+            d.bits_out[i] = (x & 0xffffff) | ~d.bits[i];
+        }
+        sink = ty::f32(d.bits_out[n / 2]);
+    }));
+}
+
+template <typename P>
+static void run_simd(const char *name, data &d, std::size_t repeat) {
+    const std::size_t n = d.a.size();
+    constexpr std::size_t N = P::size();
+    using index_type = typename P::index_type;
+    using bits_type = ty::simd<ty::u32, N>;
+    std::cout << name << std::endl;
+    // the arrays are a multiple of 2 * N long, except for the masked test
+    report("a * b + c", "pack", best_ns_per_element(n, repeat, [&]() {
+        for (std::size_t i = 0; i < n; i += N) {
+            (P::load(&d.a[i]) * P::load(&d.b[i]) + P::load(&d.c[i])).store(&d.out[i]);
+        }
+        sink = d.out[n / 2];
+    }));
+    report("clamp", "pack", best_ns_per_element(n, repeat, [&]() {
+        const P lo(-0.5f), hi(0.5f);
+        for (std::size_t i = 0; i < n; i += N) {
+            ty::min(ty::max(P::load(&d.a[i]), lo), hi).store(&d.out[i]);
+        }
+        sink = d.out[n / 2];
+    }));
+    report("sum", "pack", best_ns_per_element(n, repeat, [&]() {
+        P s0, s1;
+        for (std::size_t i = 0; i < n; i += 2 * N) {
+            s0 += P::load(&d.a[i]);
+            s1 += P::load(&d.a[i + N]);
+        }
+        sink = ty::reduce_add(s0 + s1);
+    }));
+    report("count a < b", "pack", best_ns_per_element(n, repeat, [&]() {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < n; i += N) {
+            count += __builtin_popcountll((P::load(&d.a[i]) < P::load(&d.b[i])).to_bits());
+        }
+        sink = ty::f32(count);
+    }));
+    report("gather", "pack", best_ns_per_element(n, repeat, [&]() {
+        for (std::size_t i = 0; i < n; i += N) {
+            ty::gather(d.b.data(), index_type::load(&d.index[i])).store(&d.out[i]);
+        }
+        sink = d.out[n / 2];
+    }));
+    report("shuffle, reverse", "pack", best_ns_per_element(n, repeat, [&]() {
+        const index_type reverse = index_type(ty::i32(N - 1)) - index_type::iota();
+        for (std::size_t i = 0; i < n; i += N) {
+            ty::shuffle(P::load(&d.a[i]), reverse).store(&d.out[i]);
+        }
+        sink = d.out[n / 2];
+    }));
+    report("min and max", "pack", best_ns_per_element(n, repeat, [&]() {
+        P lo(d.a[0]), hi(d.a[0]);
+        for (std::size_t i = 0; i < n; i += N) {
+            const P v = P::load(&d.a[i]);
+            lo = ty::min(lo, v);
+            hi = ty::max(hi, v);
+        }
+        sink = ty::reduce_min(lo) + ty::reduce_max(hi);
+    }));
+    report("2 * a, aligned", "pack", best_ns_per_element(n, repeat, [&]() {
+        const P two(2.0f);
+        for (std::size_t i = 0; i < n; i += N) {
+            (two * P::load_aligned(d.aligned_a + i)).store_aligned(d.aligned_out + i);
+        }
+        sink = d.aligned_out[n / 2];
+    }));
+    report("xorshift", "pack", best_ns_per_element(n, repeat, [&]() {
+        const bits_type low(0xffffff), seven(7);
+        for (std::size_t i = 0; i < n; i += N) {
+            const bits_type in = bits_type::load(&d.bits[i]);
+            bits_type x = in;
+            x = x ^ (x << 13);
+            x = x ^ (x >> 17);
+            x = x ^ (x << (x & seven));
+            ((x & low) | ~in).store(&d.bits_out[i]);
+        }
+        sink = ty::f32(d.bits_out[n / 2]);
+    }));
+    const std::size_t odd = n - 3;
+    report("a * b + c, masked tail", "pack", best_ns_per_element(odd, repeat, [&]() {
+        std::size_t i = 0;
+        for (; i + N <= odd; i += N) {
+            (P::load(&d.a[i]) * P::load(&d.b[i]) + P::load(&d.c[i])).store(&d.out[i]);
+        }
+        const auto m = P::mask_type::first(odd - i);
+        (P::load_masked(&d.a[i], m) * P::load_masked(&d.b[i], m) 
+            + P::load_masked(&d.c[i], m)).store_masked(&d.out[i], m);
+        sink = d.out[n / 2];
+    }));
+}
+
+int main(int argc, const char **argv) {
+    // small enough to stay in L1/L2, so the arithmetic is measured rather 
+    // than the memory bandwidth
+    const long long requested = argc > 1 ? std::atoll(argv[1]) : 4096;
+    const std::size_t repeat = argc > 2 ? std::atoll(argv[2]) : 20000;
+    if (requested <= 0 || repeat == 0) {
+        std::cerr << "usage: simd-benchmark [elements > 0] [repetitions > 0]" << std::endl;
+        return 1;
+    }
+    // round up, so that the pack loops need no remainder
+    const std::size_t step = 2 * max_lanes;
+    const std::size_t n = (std::size_t(requested) + step - 1) / step * step;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<ty::f32> dist(-1.0f, 1.0f);
+    std::uniform_int_distribution<ty::i32> index(0, ty::i32(n) - 1);
+    data d;
+    d.a.resize(n);
+    d.b.resize(n);
+    d.c.resize(n);
+    d.out.resize(n);
+    d.index.resize(n);
+    d.bits.resize(n);
+    d.bits_out.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        d.a[i] = dist(rng);
+        d.b[i] = dist(rng);
+        d.c[i] = dist(rng);
+        d.index[i] = index(rng);
+        d.bits[i] = ty::u32(rng());
+    }
+    const std::size_t align = max_lanes * sizeof(ty::f32);
+    d.aligned_buffer.resize(2 * n + align / sizeof(ty::f32));
+    const std::size_t offset = reinterpret_cast<std::uintptr_t>(d.aligned_buffer.data()) % align;
+    d.aligned_a = d.aligned_buffer.data() + (offset ? (align - offset) / sizeof(ty::f32) : 0);
+    d.aligned_out = d.aligned_a + n;
+    std::copy(d.a.begin(), d.a.end(), d.aligned_a);
+    std::cout << n << " f32 elements, " << repeat << " repetitions, native packs of " 
+              << ty::native_simd_bytes << " bytes" << std::endl;
+    run_scalar(d, repeat);
+    run_simd<ty::simd<ty::f32, 4>>("simd<f32, 4>", d, repeat);
+    run_simd<ty::simd<ty::f32, 8>>("simd<f32, 8>", d, repeat);
+    run_simd<ty::native_simd<ty::f32>>("native_simd<f32>", d, repeat);
+    return 0;
+}
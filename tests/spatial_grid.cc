@@ -0,0 +1,219 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/spatial_grid.hh>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+namespace {
+
+std::vector<vec3_f> random_points(std::size_t n, f32 extent, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<f32> dist(-extent, extent);
+    std::vector<vec3_f> points;
+    for (std::size_t i = 0; i < n; ++i) {
+        points.push_back(vec3_f(dist(rng), dist(rng), dist(rng)));
+    }
+    return points;
+}
+
+mem_view<const vec3_f> view(const std::vector<vec3_f> &points) {
+    return mem_view<const vec3_f>(points.data(), points.data() + points.size());
+}
+
+std::vector<u32> brute_force_radius(const std::vector<vec3_f> &points, 
+                                    const vec3_f &p, f32 radius) {
+    std::vector<u32> result;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        if ((points[i] - p).normSquared() <= radius * radius) {
+            result.push_back(u32(i));
+        }
+    }
+    return result;
+}
+
+std::vector<u32> brute_force_knn(const std::vector<vec3_f> &points, 
+                                 const vec3_f &p, std::size_t k) {
+    std::vector<std::pair<f32, u32>> all;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        all.emplace_back((points[i] - p).normSquared(), u32(i));
+    }
+    std::sort(all.begin(), all.end());
+    std::vector<u32> result;
+    for (std::size_t i = 0; i < std::min(k, all.size()); ++i) {
+        result.push_back(all[i].second);
+    }
+    return result;
+}
+
+void expect_matches_brute_force(const spatial_grid<f32> &grid, 
+                                const std::vector<vec3_f> &points) {
+    std::vector<vec3_f> queries = random_points(50, 12.0f, 7);
+    queries.push_back(vec3_f(100.0f, -100.0f, 0.0f));
+    for (const vec3_f &q : queries) {
+        for (f32 radius : {0.5f, 1.0f, 3.5f}) {
+            std::vector<u32> found;
+            grid.query_radius(q, radius, found);
+            std::sort(found.begin(), found.end());
+            ASSERT_EQ(brute_force_radius(points, q, radius), found);
+        }
+        for (std::size_t k : {1, 5, 32}) {
+            std::vector<u32> found;
+            grid.query_knn(q, k, found);
+            ASSERT_EQ(brute_force_knn(points, q, k), found);
+        }
+    }
+}
+
+}
+
+TEST(SpatialGrid, empty) {
+    spatial_grid<f32> grid(1.0f);
+    std::vector<vec3_f> none;
+    grid.build(view(none));
+    ASSERT_TRUE(grid.empty());
+    std::vector<u32> found;
+    grid.query_radius(vec3_f(), 10.0f, found);
+    grid.query_knn(vec3_f(), 3, found);
+    ASSERT_TRUE(found.empty());
+}
+
+TEST(SpatialGrid, fewer_points_than_k) {
+    std::vector<vec3_f> points{vec3_f(0.0f, 0.0f, 0.0f), vec3_f(5.0f, 5.0f, 5.0f),
+                               vec3_f(-20.0f, 1.0f, 2.0f)};
+    spatial_grid<f32> grid(1.0f);
+    grid.build(view(points));
+    std::vector<u32> found;
+    grid.query_knn(vec3_f(4.0f, 4.0f, 4.0f), 10, found);
+    ASSERT_EQ(std::vector<u32>({1, 0, 2}), found);
+}
+
+TEST(SpatialGrid, queries_match_brute_force) {
+    std::vector<vec3_f> points = random_points(3000, 10.0f, 1);
+    spatial_grid<f32> grid(1.0f);
+    grid.build(view(points));
+    ASSERT_EQ(points.size(), grid.size());
+    expect_matches_brute_force(grid, points);
+}
+
+TEST(SpatialGrid, parallel_build) {
+    std::vector<vec3_f> points = random_points(100000, 10.0f, 2);
+    spatial_grid<f32> serial(0.5f), parallel(0.5f);
+    serial.build(view(points), 1);
+    parallel.build(view(points), 4);
+    std::vector<vec3_f> queries = random_points(20, 10.0f, 3);
+    for (const vec3_f &q : queries) {
+        std::vector<u32> a, b;
+        serial.query_radius(q, 0.7f, a);
+        parallel.query_radius(q, 0.7f, b);
+        ASSERT_EQ(a, b);
+        serial.query_knn(q, 16, a);
+        parallel.query_knn(q, 16, b);
+        ASSERT_EQ(a, b);
+    }
+}
+
+TEST(SpatialGrid, update) {
+    std::vector<vec3_f> points = random_points(3000, 10.0f, 4);
+    spatial_grid<f32> grid(1.0f);
+    grid.build(view(points));
+    // moving to the cell centers never crosses a cell boundary
+    for (vec3_f &p : points) {
+        p = vec3_f(std::floor(p.x) + 0.5f, std::floor(p.y) + 0.5f, 
+                   std::floor(p.z) + 0.5f);
+    }
+    spatial_grid_update stats = grid.update(view(points));
+    ASSERT_EQ(0u, stats.moved);
+    ASSERT_FALSE(stats.rebuilt);
+    expect_matches_brute_force(grid, points);
+    for (vec3_f &p : points) {
+        p += vec3_f(0.7f, -0.2f, 0.1f);
+    }
+    stats = grid.update(view(points));
+    ASSERT_EQ(points.size(), stats.moved);
+    ASSERT_TRUE(stats.rebuilt);
+    expect_matches_brute_force(grid, points);
+}
+
+TEST(SpatialGrid, incremental_update) {
+    std::vector<vec3_f> points = random_points(3000, 10.0f, 5);
+    spatial_grid<f32> grid(1.0f);
+    grid.build(view(points));
+    // results of queries far away from the moved points, in bucket order
+    const vec3_f far(-7.0f, -7.0f, -7.0f);
+    std::vector<u32> before_radius, before_knn;
+    grid.query_radius(far, 2.0f, before_radius);
+    grid.query_knn(far, 16, before_knn);
+
+    // move a few points, all with x > 2, across cell boundaries. One of them 
+    // moves far out of the previously occupied cells.
+    std::vector<u32> moved;
+    for (u32 i = 0; i < points.size() && moved.size() < 8; ++i) {
+        if (points[i].x > 2.0f) {
+            moved.push_back(i);
+        }
+    }
+    for (u32 i : moved) {
+        points[i] += vec3_f(1.0f, 0.0f, -1.0f);
+    }
+    points[moved.back()] = vec3_f(30.0f, 30.0f, 30.0f);
+    spatial_grid_update stats = grid.update(view(points));
+    ASSERT_EQ(moved.size(), stats.moved);
+    ASSERT_FALSE(stats.rebuilt);
+
+    std::vector<u32> after_radius, after_knn;
+    grid.query_radius(far, 2.0f, after_radius);
+    grid.query_knn(far, 16, after_knn);
+    ASSERT_EQ(before_radius, after_radius);
+    ASSERT_EQ(before_knn, after_knn);
+    expect_matches_brute_force(grid, points);
+    std::vector<u32> found;
+    grid.query_knn(vec3_f(29.0f, 29.0f, 29.0f), 1, found);
+    ASSERT_EQ(std::vector<u32>({moved.back()}), found);
+
+    // and back again, mostly into the buckets they came from
+    for (u32 i : moved) {
+        points[i] -= vec3_f(1.0f, 0.0f, -1.0f);
+    }
+    points[moved.back()] = random_points(3000, 10.0f, 5)[moved.back()];
+    stats = grid.update(view(points));
+    ASSERT_EQ(moved.size(), stats.moved);
+    ASSERT_FALSE(stats.rebuilt);
+    expect_matches_brute_force(grid, points);
+}
+
+TEST(SpatialGrid, update_into_full_bucket) {
+    std::vector<vec3_f> points = random_points(3000, 10.0f, 6);
+    spatial_grid<f32> grid(1.0f);
+    grid.build(view(points));
+    // crowd many points into a single cell, far more than its free slots
+    std::vector<vec3_f> offsets = random_points(300, 0.4f, 8);
+    for (std::size_t i = 0; i < offsets.size(); ++i) {
+        points[i * 10] = vec3_f(0.5f, 0.5f, 0.5f) + offsets[i];
+    }
+    spatial_grid_update stats = grid.update(view(points));
+    ASSERT_FALSE(stats.rebuilt);
+    ASSERT_EQ(points.size(), grid.size());
+    expect_matches_brute_force(grid, points);
+    std::vector<u32> found;
+    grid.query_radius(vec3_f(0.5f, 0.5f, 0.5f), 0.7f, found);
+    ASSERT_LE(offsets.size(), found.size());
+}
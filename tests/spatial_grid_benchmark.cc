@@ -0,0 +1,110 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <typus/spatial_grid.hh>
+
+namespace ty = typus;
+
+template <typename F>
+double time_ms(F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// Points uniformly distributed in a cube such that a query of the given 
+// radius finds about 30 neighbours on average.
+int main(int argc, const char **argv) {
+    const std::size_t n = argc > 1 ? std::atoll(argv[1]) : 1000000;
+    const unsigned threads = argc > 2 ? std::atoi(argv[2]) : ty::default_thread_count();
+    const std::size_t num_queries = 10000;
+    const std::size_t brute_force_queries = 20;
+    const ty::f32 extent = 100.0f;
+    const ty::f32 radius = extent * std::cbrt(30.0f / (4.18879f * n));
+    const std::size_t k = 8;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<ty::f32> dist(0.0f, extent);
+    std::vector<ty::vec3_f> points(n), queries(num_queries);
+    for (auto &p : points) {
+        p = ty::vec3_f(dist(rng), dist(rng), dist(rng));
+    }
+    for (auto &q : queries) {
+        q = ty::vec3_f(dist(rng), dist(rng), dist(rng));
+    }
+    ty::mem_view<const ty::vec3_f> view(points.data(), points.data() + n);
+
+    ty::spatial_grid<ty::f32> grid(radius);
+    double build_serial = time_ms([&]() { grid.build(view, 1); });
+    double build_parallel = time_ms([&]() { grid.build(view, threads); });
+
+    std::size_t found = 0;
+    std::vector<ty::u32> result;
+    double radius_ms = time_ms([&]() {
+        for (const auto &q : queries) {
+            result.clear();
+            grid.query_radius(q, radius, result);
+            found += result.size();
+        }
+    });
+    double knn_ms = time_ms([&]() {
+        for (const auto &q : queries) {
+            grid.query_knn(q, k, result);
+        }
+    });
+    // the O(N^2) baseline, on a few queries only
+    std::size_t brute_found = 0;
+    double brute_ms = time_ms([&]() {
+        for (std::size_t i = 0; i < brute_force_queries; ++i) {
+            for (const auto &p : points) {
+                brute_found += (p - queries[i]).normSquared() <= radius * radius;
+            }
+        }
+    });
+
+    // unchanged positions take the in-place path, a small jitter moves a few 
+    // percent of the points across cell boundaries
+    double update_in_place_ms = time_ms([&]() { grid.update(view, threads); });
+    std::uniform_real_distribution<ty::f32> jitter(-radius * 0.01f, radius * 0.01f);
+    for (auto &p : points) {
+        p += ty::vec3_f(jitter(rng), jitter(rng), jitter(rng));
+    }
+    ty::spatial_grid_update stats;
+    double update_ms = time_ms([&]() { stats = grid.update(view, threads); });
+
+    std::cout << n << " points, radius " << radius << ", " << threads << " threads\n"
+              << "  build, 1 thread (ms):        " << build_serial << "\n"
+              << "  build, " << threads << " threads (ms):       " << build_parallel << "\n"
+              << "  update, in place (ms):       " << update_in_place_ms << "\n"
+              << "  update after jitter (ms):    " << update_ms 
+              << " (" << stats.moved << " moved" 
+              << (stats.rebuilt ? ", rebuilt" : "") << ")\n"
+              << "  radius query (us):           " << radius_ms * 1e3 / num_queries 
+              << " (" << double(found) / num_queries << " neighbours)\n"
+              << "  kNN query, k=" << k << " (us):         " << knn_ms * 1e3 / num_queries << "\n"
+              << "  brute-force radius query (us): " 
+              << brute_ms * 1e3 / brute_force_queries << "\n";
+    if (brute_found == 0) {
+        std::cerr << "unexpected checksum\n";
+    }
+    return 0;
+}
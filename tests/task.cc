@@ -0,0 +1,121 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/task.hh>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+enum class Error {
+    NotANumber, Overflow
+};
+
+static result<int, Error> parse(const std::string & s) {
+    if (s.empty() || s.find_first_not_of("0123456789") != std::string::npos) {
+        return result<int, Error>::fail(Error::NotANumber);
+    }
+    return std::stoi(s);
+}
+
+static task<result<int, Error>> parse_and_add(std::string a, std::string b) {
+    int x = co_await parse(a);
+    int y = co_await parse(b);
+    co_return x + y;
+}
+
+TEST(Task, co_return_value) {
+    auto t = []() -> task<int> { co_return 3; }();
+    ASSERT_FALSE(t.done());
+    ASSERT_EQ(3, t.get());
+}
+
+TEST(Task, co_await_result_with_value) {
+    result<int, Error> r = parse_and_add("1", "2").get();
+    ASSERT_TRUE(r.ok());
+    ASSERT_EQ(3, r.value());
+}
+
+TEST(Task, co_await_result_short_circuits_on_error) {
+    int reached = 0;
+    auto body = [&reached]() -> task<result<int, Error>> {
+        int x = co_await parse("x");
+        reached = 1;
+        co_return x;
+    };
+    task<result<int, Error>> t = body();
+    result<int, Error> r = t.get();
+    ASSERT_TRUE(t.done());
+    ASSERT_FALSE(r.ok());
+    ASSERT_EQ(Error::NotANumber, r.error());
+    ASSERT_EQ(0, reached);
+}
+
+static task<result<int, Error>> sum_all(std::vector<std::string> values) {
+    int sum = 0;
+    for (std::size_t i = 0; i + 1 < values.size(); i += 2) {
+        sum += co_await co_await parse_and_add(values[i], values[i + 1]);
+    }
+    co_return sum;
+}
+
+TEST(Task, co_await_task) {
+    result<int, Error> r = sum_all({"1", "2", "3", "4"}).get();
+    ASSERT_TRUE(r.ok());
+    ASSERT_EQ(10, r.value());
+}
+
+TEST(Task, error_propagates_through_awaiting_tasks) {
+    result<int, Error> r = sum_all({"1", "2", "3", "four"}).get();
+    ASSERT_FALSE(r.ok());
+    ASSERT_EQ(Error::NotANumber, r.error());
+}
+
+struct counted {
+    static int alive;
+    counted() { ++alive; }
+    counted(const counted &) { ++alive; }
+    ~counted() { --alive; }
+};
+
+int counted::alive = 0;
+
+TEST(Task, frame_of_failed_coroutine_is_released) {
+    {
+        auto body = []() -> task<result<int, Error>> {
+            counted c;
+            int x = co_await parse("");
+            co_return x;
+        };
+        task<result<int, Error>> t = body();
+        ASSERT_FALSE(t.get().ok());
+        ASSERT_EQ(1, counted::alive);
+    }
+    ASSERT_EQ(0, counted::alive);
+}
+
+TEST(Task, co_await_lvalue_result) {
+    auto body = []() -> task<result<int, Error>> {
+        result<int, Error> a = parse("5");
+        const result<int, Error> b = parse("6");
+        int x = co_await a;
+        int y = co_await b;
+        co_return x * y;
+    };
+    ASSERT_EQ(30, body().get().value());
+}
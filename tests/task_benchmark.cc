@@ -0,0 +1,149 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include <typus/task.hh>
+
+namespace ty = typus;
+
+enum class error {
+    invalid
+};
+
+using int_result = ty::result<int, error>;
+
+// keep the compiler from constant-folding the workloads away
+static volatile int sink;
+
+static int_result check(int i) {
+    if (i < 0) {
+        return int_result::fail(error::invalid);
+    }
+    return i;
+}
+
+static ty::task<int_result> leaf_task(int i) {
+    co_return check(i);
+}
+
+static ty::task<int_result> await_tasks(int n) {
+    int sum = 0;
+    for (int i = 0; i < n; ++i) {
+        sum += co_await co_await leaf_task(i);
+    }
+    co_return sum;
+}
+
+static ty::task<int_result> await_results(int n) {
+    int sum = 0;
+    for (int i = 0; i < n; ++i) {
+        sum += co_await check(i);
+    }
+    co_return sum;
+}
+
+static void leaf_callback(int i, const std::function<void(int_result)> & k) {
+    k(check(i));
+}
+
+static int_result chain_callbacks(int n) {
+    int sum = 0;
+    bool failed = false;
+    for (int i = 0; i < n && !failed; ++i) {
+        leaf_callback(i, [&](int_result r) {
+            if (!r.ok()) {
+                failed = true;
+                return;
+            }
+            sum += r.value();
+        });
+    }
+    if (failed) {
+        return int_result::fail(error::invalid);
+    }
+    return sum;
+}
+
+static int_result check_results(int n) {
+    int sum = 0;
+    for (int i = 0; i < n; ++i) {
+        int_result r = check(i);
+        if (!r.ok()) {
+            return r;
+        }
+        sum += r.value();
+    }
+    return sum;
+}
+
+template <typename F>
+double ns_per_op(int n, F && func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / n;
+}
+
+// allocate and release blocks of the given size in a LIFO pattern, as
+// coroutine frames of nested tasks are.
+template <typename A, typename D>
+double alloc_cost(int n, std::size_t size, A && allocate, D && deallocate) {
+    return ns_per_op(n, [&]() {
+        for (int i = 0; i < n; ++i) {
+            void *a = allocate(size);
+            void *b = allocate(size);
+            deallocate(b, size);
+            deallocate(a, size);
+        }
+    }) / 2;
+}
+
+int main(int argc, const char **argv) {
+    const int n = argc > 1 ? std::atoi(argv[1]) : 10000000;
+    double task_await = ns_per_op(n, [n]() { 
+        sink = await_tasks(n).get().value(); 
+    });
+    double callback = ns_per_op(n, [n]() { 
+        sink = chain_callbacks(n).value(); 
+    });
+    double result_await = ns_per_op(n, [n]() { 
+        sink = await_results(n).get().value(); 
+    });
+    double result_check = ns_per_op(n, [n]() { 
+        sink = check_results(n).value(); 
+    });
+    const std::size_t frame_size = 128;
+    double pooled = alloc_cost(n, frame_size, 
+        [](std::size_t s) { return ty::detail::allocate_block(s); },
+        [](void *p, std::size_t s) { ty::detail::deallocate_block(p, s); });
+    double heap = alloc_cost(n, frame_size, 
+        [](std::size_t s) { return ::operator new(s); },
+        [](void *p, std::size_t) { ::operator delete(p); });
+
+    std::cout << "per step (ns)\n"
+              << "  co_await task<result>:     " << task_await << "\n"
+              << "  std::function callback:    " << callback << "\n"
+              << "  co_await result:           " << result_await << "\n"
+              << "  manual ok() check:         " << result_check << "\n"
+              << "frame allocation (ns)\n"
+              << "  pooled:                    " << pooled << "\n"
+              << "  operator new:              " << heap << "\n";
+    return 0;
+}
@@ -0,0 +1,119 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/transform.hh>
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+namespace {
+
+template <typename T>
+std::vector<vec3<T>> random_points(std::size_t n) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<T> dist(-10, 10);
+    std::vector<vec3<T>> points(n);
+    for (auto &p : points) {
+        p = vec3<T>(dist(rng), dist(rng), dist(rng));
+    }
+    return points;
+}
+
+template <typename T>
+mat4<T> some_transform() {
+    vec3<T> axis = vec3<T>(2, -1, 2) * T(1.0 / 3.0);
+    return mat4<T>(mat3<T>::rotation(axis, T(0.8)) * mat3<T>::scale(vec3<T>(1, 2, 3)), 
+                   vec3<T>(4, -5, 6));
+}
+
+template <typename T>
+void expect_near(const vec3<T> &expected, const vec3<T> &actual) {
+    EXPECT_NEAR(expected.x, actual.x, 1e-4);
+    EXPECT_NEAR(expected.y, actual.y, 1e-4);
+    EXPECT_NEAR(expected.z, actual.z, 1e-4);
+}
+
+template <typename T>
+mem_view<const vec3<T>> const_view(const std::vector<vec3<T>> &v) {
+    return mem_view<const vec3<T>>(v.data(), v.data() + v.size());
+}
+
+template <typename T>
+mem_view<vec3<T>> view(std::vector<vec3<T>> &v) {
+    return mem_view<vec3<T>>(v.data(), v.data() + v.size());
+}
+
+}
+
+template <typename T>
+class Transform : public ::testing::Test {
+};
+
+using TransformTypes = ::testing::Types<f32, f64>;
+TYPED_TEST_SUITE(Transform, TransformTypes);
+
+TYPED_TEST(Transform, aos_matches_scalar) {
+    using T = TypeParam;
+    const mat4<T> m = some_transform<T>();
+    // odd size for the scalar tail, large enough to be split over threads
+    for (std::size_t n : {std::size_t(7), std::size_t(40003)}) {
+        auto points = random_points<T>(n);
+        std::vector<vec3<T>> out(n), directions(n);
+        transform_points(m, const_view(points), view(out), 3);
+        transform_directions(m, const_view(points), view(directions));
+        for (std::size_t i = 0; i < n; ++i) {
+            expect_near(m.transform_point(points[i]), out[i]);
+            expect_near(m.transform_direction(points[i]), directions[i]);
+        }
+    }
+}
+
+TYPED_TEST(Transform, aos_in_place_and_rotations) {
+    using T = TypeParam;
+    auto points = random_points<T>(29);
+    auto copy = points;
+    const quat<T> q = quat<T>::from_axis_angle(vec3<T>(0, 1, 0), T(0.3));
+    std::vector<vec3<T>> by_matrix(points.size());
+    transform_points(q.to_mat3(), const_view(points), view(by_matrix));
+    transform_points(q, const_view(points), view(points));
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        expect_near(q.rotate(copy[i]), points[i]);
+        expect_near(q.rotate(copy[i]), by_matrix[i]);
+    }
+}
+
+TYPED_TEST(Transform, soa_matches_scalar) {
+    using T = TypeParam;
+    const mat4<T> m = some_transform<T>();
+    auto points = random_points<T>(40003);
+    vec3_soa<T> soa, out, directions;
+    to_soa(const_view(points), soa);
+    transform_points(m, soa, out, 2);
+    transform_directions(m, soa, directions);
+    ASSERT_EQ(points.size(), out.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        expect_near(m.transform_point(points[i]), out[i]);
+        expect_near(m.transform_direction(points[i]), directions[i]);
+    }
+    const quat<T> q = quat<T>::from_axis_angle(vec3<T>(1, 0, 0), T(-0.5));
+    transform_points(q, soa, soa);
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        expect_near(q.rotate(points[i]), soa[i]);
+    }
+}
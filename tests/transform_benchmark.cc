@@ -0,0 +1,98 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <typus/transform.hh>
+
+namespace ty = typus;
+
+template <typename F>
+double time_ms(F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// the fastest of several runs, to filter out noise on in-cache sizes
+template <typename F>
+double best_ms(int runs, F &&f) {
+    double best = time_ms(f);
+    for (int i = 1; i < runs; ++i) {
+        best = std::min(best, time_ms(f));
+    }
+    return best;
+}
+
+static void report(const char *name, std::size_t n, double ms, const ty::vec3_f &check) {
+    std::cout << name << ": " << ms << " ms, " << n / ms / 1e3 << " Mpoints/s (" 
+              << check << ")" << std::endl;
+}
+
+int main(int argc, const char **argv) {
+    const std::size_t n = argc > 1 ? std::atoll(argv[1]) : 10000000;
+    const unsigned threads = argc > 2 ? std::atoi(argv[2]) : ty::default_thread_count();
+    const int runs = argc > 3 ? std::atoi(argv[3]) : 5;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<ty::f32> dist(-100.0f, 100.0f);
+    std::vector<ty::vec3_f> points(n), out(n);
+    for (auto &p : points) {
+        p = ty::vec3_f(dist(rng), dist(rng), dist(rng));
+    }
+    ty::mem_view<const ty::vec3_f> in_view(points.data(), points.data() + n);
+    ty::mem_view<ty::vec3_f> out_view(out.data(), out.data() + n);
+    const ty::quat_f q = ty::quat_f::from_axis_angle(ty::vec3_f(0.6f, 0.0f, 0.8f), 0.9f);
+    const ty::mat4_f m(q.to_mat3(), ty::vec3_f(1.0f, 2.0f, 3.0f));
+
+    std::cout << n << " points, " << threads << " threads, best of " << runs 
+              << " runs" << std::endl;
+    // warm up the output pages
+    ty::transform_points(m, in_view, out_view);
+    double scalar_ms = best_ms(runs, [&]() {
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = m.transform_point(points[i]);
+        }
+    });
+    report("scalar mat4 loop", n, scalar_ms, out[n / 2]);
+    double quat_ms = best_ms(runs, [&]() {
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = q.rotate(points[i]);
+        }
+    });
+    report("scalar quat::rotate loop", n, quat_ms, out[n / 2]);
+    double aos_ms = best_ms(runs, [&]() { ty::transform_points(m, in_view, out_view, 1); });
+    report("transform_points, AoS", n, aos_ms, out[n / 2]);
+    double aos_mt_ms = best_ms(runs, [&]() { 
+        ty::transform_points(m, in_view, out_view, threads); 
+    });
+    report("transform_points, AoS, threaded", n, aos_mt_ms, out[n / 2]);
+    double dir_ms = best_ms(runs, [&]() { ty::transform_directions(m, in_view, out_view, 1); });
+    report("transform_directions, AoS", n, dir_ms, out[n / 2]);
+
+    ty::vec3_soa_f soa, soa_out;
+    ty::to_soa(in_view, soa);
+    ty::transform_points(m, soa, soa_out);
+    double soa_ms = best_ms(runs, [&]() { ty::transform_points(m, soa, soa_out, 1); });
+    report("transform_points, SoA", n, soa_ms, soa_out[n / 2]);
+    double soa_mt_ms = best_ms(runs, [&]() { ty::transform_points(m, soa, soa_out, threads); });
+    report("transform_points, SoA, threaded", n, soa_mt_ms, soa_out[n / 2]);
+    return 0;
+}
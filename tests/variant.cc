@@ -83,3 +83,236 @@ TEST(Variant, assignment) {
     ASSERT_EQ(2u, var.index());
     ASSERT_EQ('b', var.get<2>());
 }
+
+struct size_of_alternative {
+    template <typename T>
+    std::size_t operator()(const T &) const { return sizeof(T); }
+};
+
+struct increment {
+    void operator()(std::string & s) { s += "+"; }
+    void operator()(int & i) { ++i; }
+    void operator()(char & c) { ++c; }
+};
+
+TEST(Variant, visit_returns_value) {
+    using V = variant<std::string, int, char>;
+    const V a('b');
+    ASSERT_EQ(sizeof(char), a.visit(size_of_alternative{}));
+    V b(1);
+    size_of_alternative visitor;
+    ASSERT_EQ(sizeof(int), b.visit(visitor));
+}
+
+TEST(Variant, visit_modifies_selected_alternative) {
+    using V = variant<std::string, int, char>;
+    V a(std::string("a"));
+    a.visit(increment{});
+    ASSERT_EQ(std::string("a+"), a.get<std::string>());
+    V b(1);
+    b.visit(increment{});
+    ASSERT_EQ(2, b.get<int>());
+}
+
+template <int I>
+struct alt {
+    int value;
+};
+
+struct alt_index {
+    template <int I>
+    int operator()(const alt<I> & a) const { return I * 100 + a.value; }
+};
+
+TEST(Variant, visit_many_alternatives) {
+    using V = variant<alt<0>, alt<1>, alt<2>, alt<3>, alt<4>, alt<5>, alt<6>,
+                      alt<7>, alt<8>, alt<9>, alt<10>, alt<11>, alt<12>,
+                      alt<13>, alt<14>, alt<15>, alt<16>, alt<17>, alt<18>,
+                      alt<19>>;
+    V a(alt<0>{ 1 });
+    ASSERT_EQ(1, a.visit(alt_index{}));
+    V b(alt<13>{ 2 });
+    ASSERT_EQ(1302, b.visit(alt_index{}));
+    V c(alt<19>{ 3 });
+    ASSERT_EQ(1903, c.visit(alt_index{}));
+}
+
+struct counting {
+    counting() = default;
+    counting(const counting & rhs): copies(rhs.copies + 1), moves(rhs.moves) {}
+    counting(counting && rhs): copies(rhs.copies), moves(rhs.moves + 1) {}
+    counting &operator=(const counting & rhs) {
+        copies = rhs.copies + 1;
+        moves = rhs.moves;
+        return *this;
+    }
+    counting &operator=(counting && rhs) {
+        copies = rhs.copies;
+        moves = rhs.moves + 1;
+        return *this;
+    }
+    int copies = 0;
+    int moves = 0;
+};
+
+TEST(Variant, construction_from_rvalue_moves) {
+    using V = variant<int, counting>;
+    V var{ counting{} };
+    ASSERT_EQ(1u, var.index());
+    ASSERT_EQ(0, var.get<counting>().copies);
+    ASSERT_EQ(1, var.get<counting>().moves);
+
+    counting c;
+    V var2{ c };
+    ASSERT_EQ(1, var2.get<counting>().copies);
+}
+
+TEST(Variant, move_construction_and_assignment) {
+    using V = variant<int, counting>;
+    V a{ counting{} };
+    V b(std::move(a));
+    ASSERT_EQ(1u, b.index());
+    ASSERT_EQ(0, b.get<counting>().copies);
+    ASSERT_EQ(2, b.get<counting>().moves);
+    V c{ 1 };
+    c = std::move(b);
+    ASSERT_EQ(1u, c.index());
+    ASSERT_EQ(0, c.get<counting>().copies);
+    ASSERT_EQ(3, c.get<counting>().moves);
+    c = counting{};
+    ASSERT_EQ(1u, c.index());
+    ASSERT_EQ(0, c.get<counting>().copies);
+    ASSERT_EQ(1, c.get<counting>().moves);
+    V d{ 2 };
+    d = c;
+    ASSERT_EQ(1, d.get<counting>().copies);
+}
+
+TEST(Variant, emplace) {
+    using V = variant<int, std::string, counting>;
+    V var;
+    std::string & s = var.emplace<1>(3u, 'x');
+    ASSERT_EQ(1u, var.index());
+    ASSERT_EQ(std::string("xxx"), s);
+    counting & c = var.emplace<counting>();
+    ASSERT_EQ(2u, var.index());
+    ASSERT_EQ(0, c.copies);
+    ASSERT_EQ(0, c.moves);
+    var.emplace<int>(4);
+    ASSERT_EQ(0u, var.index());
+    ASSERT_EQ(4, var.get<int>());
+}
+
+TEST(Variant, self_assignment) {
+    using V = variant<int, std::string>;
+    V var{ std::string("one") };
+    V & ref = var;
+    var = ref;
+    ASSERT_EQ(std::string("one"), var.get<std::string>());
+}
+
+TEST(Variant, nothrow_move_when_all_alternatives_are) {
+    static_assert(std::is_nothrow_move_constructible<
+                    variant<int, std::string>>::value, "");
+}
+
+TEST(Variant, compact_index) {
+    static_assert(sizeof(variant<std::uint8_t, std::uint16_t>) == 4, "");
+    static_assert(sizeof(variant<std::uint8_t, char>) == 2, "");
+    static_assert(sizeof(variant<std::uint32_t, float>) == 8, "");
+    // the index is rounded up to the alignment of the alternatives
+    static_assert(sizeof(variant<std::uint16_t, std::uint32_t>) == 8, "");
+    static_assert(sizeof(variant<std::uint32_t, std::uint64_t>) == 16, "");
+}
+
+TEST(Variant, trivially_copyable_when_all_alternatives_are) {
+    using T = variant<int, char, double>;
+    static_assert(std::is_trivially_copyable<T>::value, "");
+    static_assert(std::is_trivially_destructible<T>::value, "");
+    static_assert(!std::is_trivially_copyable<variant<int, std::string>>::value, 
+                  "");
+    T a{ 2.5 };
+    T b{ 'x' };
+    b = a;
+    ASSERT_EQ(2u, b.index());
+    ASSERT_EQ(2.5, b.get<double>());
+    T c(b);
+    ASSERT_EQ(2.5, c.get<double>());
+}
+
+TEST(Variant, many_alternatives_index) {
+    using V = variant<alt<0>, alt<1>, alt<2>, alt<3>, alt<4>, alt<5>, alt<6>,
+                      alt<7>, alt<8>, alt<9>, alt<10>, alt<11>, alt<12>,
+                      alt<13>, alt<14>, alt<15>, alt<16>, alt<17>, alt<18>,
+                      alt<19>>;
+    static_assert(sizeof(V) == 2 * sizeof(int), "");
+    V v(alt<19>{ 1 });
+    ASSERT_EQ(19u, v.index());
+}
+
+struct describe_pair {
+    std::string operator()(int a, int b) const { 
+        return "ii" + std::to_string(a + b); 
+    }
+    std::string operator()(int a, const std::string & b) const { 
+        return "is" + std::to_string(a) + b; 
+    }
+    std::string operator()(const std::string & a, int b) const { 
+        return "si" + a + std::to_string(b); 
+    }
+    std::string operator()(const std::string & a, const std::string & b) const { 
+        return "ss" + a + b; 
+    }
+};
+
+TEST(Variant, visit_two_variants) {
+    using V = variant<int, std::string>;
+    V i{ 1 };
+    V s{ std::string("x") };
+    ASSERT_EQ(std::string("ii2"), visit(describe_pair{}, i, i));
+    ASSERT_EQ(std::string("is1x"), visit(describe_pair{}, i, s));
+    ASSERT_EQ(std::string("six1"), visit(describe_pair{}, s, i));
+    const V cs{ std::string("y") };
+    ASSERT_EQ(std::string("ssxy"), visit(describe_pair{}, s, cs));
+}
+
+struct sum_indices {
+    template <int I, int J, int K>
+    int operator()(const alt<I> &, const alt<J> &, alt<K> & c) const { 
+        c.value += 1;
+        return I * 100 + J * 10 + K; 
+    }
+};
+
+TEST(Variant, visit_three_variants_of_different_sizes) {
+    using A = variant<alt<0>, alt<1>, alt<2>>;
+    using B = variant<alt<0>, alt<1>, alt<2>, alt<3>, alt<4>>;
+    using C = variant<alt<0>, alt<1>>;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            for (int k = 0; k < 2; ++k) {
+                A a;
+                B b;
+                C c;
+                a.emplace<0>();
+                switch (i) {
+                    case 1: a.emplace<1>(); break;
+                    case 2: a.emplace<2>(); break;
+                }
+                switch (j) {
+                    case 1: b.emplace<1>(); break;
+                    case 2: b.emplace<2>(); break;
+                    case 3: b.emplace<3>(); break;
+                    case 4: b.emplace<4>(); break;
+                }
+                if (k == 1) {
+                    c.emplace<1>(alt<1>{ 0 });
+                } else {
+                    c.emplace<0>(alt<0>{ 0 });
+                }
+                ASSERT_EQ(i * 100 + j * 10 + k, visit(sum_indices{}, a, b, c));
+                ASSERT_EQ(1, c.visit(alt_index{}) % 100);
+            }
+        }
+    }
+}
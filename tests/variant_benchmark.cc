@@ -0,0 +1,174 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+// Sweeps the number of alternatives and compares the cost of visiting a 
+// typus::variant with std::visit on std::variant, with virtual dispatch and 
+// with a linear if-chain over the alternatives (the previous implementation
+// of variant::visit).
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <typus/variant.hh>
+
+namespace ty = typus;
+
+template <int I>
+struct alt {
+    unsigned value;
+};
+
+struct eval {
+    template <int I>
+    unsigned operator()(const alt<I> & a) const { 
+        return a.value * (I + 1) + I; 
+    }
+};
+
+struct base {
+    virtual ~base() = default;
+    virtual unsigned eval() const = 0;
+};
+
+template <int I>
+struct derived : base {
+    explicit derived(unsigned v): value(v) {}
+    unsigned eval() const override { return value * (I + 1) + I; }
+    unsigned value;
+};
+
+template <typename Seq>
+struct alternatives;
+
+template <std::size_t ...Is>
+struct alternatives<std::index_sequence<Is...>> {
+    using ty_variant = ty::variant<alt<Is>...>;
+    using std_variant = std::variant<alt<Is>...>;
+
+    template <typename V>
+    static V make(std::size_t index, unsigned value) {
+        using maker = V (*)(unsigned);
+        static const maker makers[] = {
+            [](unsigned v) { return V(alt<Is>{ v }); }...
+        };
+        return makers[index](value);
+    }
+
+    static std::unique_ptr<base> make_derived(std::size_t index, unsigned value) {
+        using maker = std::unique_ptr<base> (*)(unsigned);
+        static const maker makers[] = {
+            [](unsigned v) { 
+                return std::unique_ptr<base>(new derived<Is>(v)); 
+            }...
+        };
+        return makers[index](value);
+    }
+};
+
+template <std::size_t I, typename V>
+unsigned linear_visit(const V &, std::integral_constant<std::size_t, I>,
+                      std::integral_constant<std::size_t, I>) {
+    return 0;
+}
+
+template <std::size_t I, std::size_t N, typename V>
+unsigned linear_visit(const V & v, std::integral_constant<std::size_t, I>,
+                      std::integral_constant<std::size_t, N> n) {
+    unsigned r = 0;
+    if (I == v.index()) {
+        r = eval{}(v.template get<I>());
+    }
+    return r + linear_visit(v, std::integral_constant<std::size_t, I + 1>{}, n);
+}
+
+template <typename F>
+double ns_per_element(std::size_t n, unsigned & checksum, F && func) {
+    auto start = std::chrono::steady_clock::now();
+    checksum = func();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / n;
+}
+
+template <std::size_t N>
+void run(std::size_t count) {
+    using A = alternatives<std::make_index_sequence<N>>;
+    std::mt19937 rng(N);
+    std::uniform_int_distribution<std::size_t> index_dist(0, N - 1);
+    std::vector<typename A::ty_variant> ty_values;
+    std::vector<typename A::std_variant> std_values;
+    std::vector<std::unique_ptr<base>> objects;
+    ty_values.reserve(count);
+    std_values.reserve(count);
+    objects.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::size_t index = index_dist(rng);
+        unsigned value = static_cast<unsigned>(rng());
+        ty_values.push_back(A::template make<typename A::ty_variant>(index, value));
+        std_values.push_back(A::template make<typename A::std_variant>(index, value));
+        objects.push_back(A::make_derived(index, value));
+    }
+    unsigned c1, c2, c3, c4;
+    double table = ns_per_element(count, c1, [&]() {
+        unsigned sum = 0;
+        for (const auto & v : ty_values) {
+            sum += v.visit(eval{});
+        }
+        return sum;
+    });
+    double linear = ns_per_element(count, c2, [&]() {
+        unsigned sum = 0;
+        for (const auto & v : ty_values) {
+            sum += linear_visit(v, std::integral_constant<std::size_t, 0>{},
+                                std::integral_constant<std::size_t, N>{});
+        }
+        return sum;
+    });
+    double std_visit = ns_per_element(count, c3, [&]() {
+        unsigned sum = 0;
+        for (const auto & v : std_values) {
+            sum += std::visit(eval{}, v);
+        }
+        return sum;
+    });
+    double virt = ns_per_element(count, c4, [&]() {
+        unsigned sum = 0;
+        for (const auto & o : objects) {
+            sum += o->eval();
+        }
+        return sum;
+    });
+    if (c1 != c2 || c1 != c3 || c1 != c4) {
+        std::cerr << "checksum mismatch for " << N << " alternatives\n";
+    }
+    std::cout << N << "," << table << "," << linear << "," << std_visit << "," 
+              << virt << "\n";
+}
+
+int main(int argc, const char **argv) {
+    const std::size_t count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    std::cout << "alternatives,table_ns,if_chain_ns,std_visit_ns,virtual_ns\n";
+    run<2>(count);
+    run<4>(count);
+    run<8>(count);
+    run<16>(count);
+    run<20>(count);
+    run<32>(count);
+    return 0;
+}
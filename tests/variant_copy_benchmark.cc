@@ -0,0 +1,99 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+// Counts the deep copies of a heavy alternative when filling and shuffling
+// variants through the copy-only paths (construction from const references,
+// copy assignment), compared with moves and in-place construction.
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <typus/variant.hh>
+
+namespace ty = typus;
+
+static std::size_t deep_copies = 0;
+
+struct heavy {
+    heavy() = default;
+    explicit heavy(std::size_t n): data(n, 'x') {}
+    heavy(const heavy & rhs): data(rhs.data) { ++deep_copies; }
+    heavy(heavy && rhs) = default;
+    heavy &operator=(const heavy & rhs) {
+        data = rhs.data;
+        ++deep_copies;
+        return *this;
+    }
+    heavy &operator=(heavy && rhs) = default;
+
+    std::string data;
+};
+
+using value = ty::variant<int, double, heavy>;
+
+template <typename F>
+void measure(const char *name, std::size_t n, F && func) {
+    deep_copies = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::size_t checksum = func();
+    auto stop = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    std::cout << name << "," << deep_copies << "," << ns / n << "," 
+              << checksum << "\n";
+}
+
+int main(int argc, const char **argv) {
+    const std::size_t n = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const std::size_t payload = 256;
+    std::cout << "path,deep_copies,ns_per_element,checksum\n";
+    measure("copy", n, [&]() {
+        std::vector<value> values(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const heavy h(payload);
+            const value v(h);
+            values[i] = v;
+        }
+        std::vector<value> rotated(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            rotated[(i + 1) % n] = values[i];
+        }
+        return rotated[0].get<heavy>().data.size();
+    });
+    measure("move", n, [&]() {
+        std::vector<value> values(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            values[i] = value(heavy(payload));
+        }
+        std::vector<value> rotated(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            rotated[(i + 1) % n] = std::move(values[i]);
+        }
+        return rotated[0].get<heavy>().data.size();
+    });
+    measure("emplace", n, [&]() {
+        std::vector<value> values(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            values[i].emplace<heavy>(payload);
+        }
+        std::vector<value> rotated(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            rotated[(i + 1) % n] = std::move(values[i]);
+        }
+        return rotated[0].get<heavy>().data.size();
+    });
+    return 0;
+}
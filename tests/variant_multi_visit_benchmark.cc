@@ -0,0 +1,135 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+// Binary-operator interpreter loop over values with 6 alternatives. Compares
+// the flattened 6x6 dispatch of typus::visit(f, a, b) with nested 
+// single-variant visits and with std::visit on std::variant.
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <variant>
+#include <vector>
+
+#include <typus/variant.hh>
+
+namespace ty = typus;
+
+using value = ty::variant<std::int32_t, std::int64_t, std::uint32_t, float, 
+                          double, bool>;
+using std_value = std::variant<std::int32_t, std::int64_t, std::uint32_t, 
+                               float, double, bool>;
+
+struct add {
+    template <typename A, typename B>
+    double operator()(const A & a, const B & b) const {
+        return static_cast<double>(a) + static_cast<double>(b);
+    }
+};
+
+// second level of the nested visit: the left operand is already known
+template <typename A>
+struct add_to {
+    const A & a;
+
+    template <typename B>
+    double operator()(const B & b) const {
+        return add{}(a, b);
+    }
+};
+
+struct nested_add {
+    const value & rhs;
+
+    template <typename A>
+    double operator()(const A & a) const {
+        return rhs.visit(add_to<A>{ a });
+    }
+};
+
+struct instruction {
+    std::uint32_t lhs;
+    std::uint32_t rhs;
+};
+
+value make_value(int kind, std::mt19937 & rng) {
+    value v;
+    switch (kind) {
+        case 0: v = std::int32_t(rng() % 100); break;
+        case 1: v = std::int64_t(rng() % 100); break;
+        case 2: v = std::uint32_t(rng() % 100); break;
+        case 3: v = float(rng() % 100) * 0.5f; break;
+        case 4: v = double(rng() % 100) * 0.25; break;
+        default: v = bool(rng() % 2); break;
+    }
+    return v;
+}
+
+template <typename F>
+double ns_per_op(std::size_t n, double & checksum, F && func) {
+    auto start = std::chrono::steady_clock::now();
+    checksum = func();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / n;
+}
+
+int main(int argc, const char **argv) {
+    const std::size_t n = argc > 1 ? std::atoi(argv[1]) : 10000000;
+    const std::size_t registers = 1024;
+    std::mt19937 rng(3);
+    std::vector<value> regs;
+    std::vector<std_value> std_regs;
+    for (std::size_t i = 0; i < registers; ++i) {
+        value v = make_value(rng() % 6, rng);
+        regs.push_back(v);
+        std_regs.push_back(v.visit([](auto x) { return std_value(x); }));
+    }
+    std::vector<instruction> program(n);
+    for (auto & inst : program) {
+        inst.lhs = rng() % registers;
+        inst.rhs = rng() % registers;
+    }
+    double c1, c2, c3;
+    double flat = ns_per_op(n, c1, [&]() {
+        double sum = 0;
+        for (const auto & inst : program) {
+            sum += ty::visit(add{}, regs[inst.lhs], regs[inst.rhs]);
+        }
+        return sum;
+    });
+    double nested = ns_per_op(n, c2, [&]() {
+        double sum = 0;
+        for (const auto & inst : program) {
+            sum += regs[inst.lhs].visit(nested_add{ regs[inst.rhs] });
+        }
+        return sum;
+    });
+    double std_visit = ns_per_op(n, c3, [&]() {
+        double sum = 0;
+        for (const auto & inst : program) {
+            sum += std::visit(add{}, std_regs[inst.lhs], std_regs[inst.rhs]);
+        }
+        return sum;
+    });
+    if (c1 != c2 || c1 != c3) {
+        std::cerr << "checksum mismatch\n";
+    }
+    std::cout << "dispatch,ns_per_op\n"
+              << "flat_6x6," << flat << "\n"
+              << "nested," << nested << "\n"
+              << "std_visit," << std_visit << "\n";
+    return 0;
+}
@@ -0,0 +1,125 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/variant_vector.hh>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+TEST(VariantVector, push_back_partitions_by_type) {
+    variant_vector<int, std::string, double> vec;
+    ASSERT_TRUE(vec.empty());
+    vec.push_back(1);
+    vec.push_back(std::string("one"));
+    vec.push_back(2);
+    vec.push_back(1.5);
+    vec.emplace_back<std::string>(2u, 'x');
+    ASSERT_EQ(5u, vec.size());
+    ASSERT_EQ(2u, vec.count<int>());
+    ASSERT_EQ(2u, vec.count<std::string>());
+    ASSERT_EQ(1u, vec.count<double>());
+    ASSERT_EQ(2, vec.items<int>()[1]);
+    ASSERT_EQ(std::string("xx"), vec.items<std::string>()[1]);
+    vec.clear();
+    ASSERT_TRUE(vec.empty());
+}
+
+TEST(VariantVector, for_each) {
+    variant_vector<int, double> vec;
+    for (int i = 0; i < 10; ++i) {
+        vec.push_back(i);
+        vec.push_back(i * 0.5);
+    }
+    int sum = 0;
+    vec.for_each<int>([&sum](int v) { sum += v; });
+    ASSERT_EQ(45, sum);
+    vec.for_each<double>([](double & v) { v *= 2; });
+    ASSERT_EQ(9.0, vec.items<double>().back());
+}
+
+struct describe {
+    std::vector<std::string> & out;
+
+    void operator()(int v) { out.push_back("i" + std::to_string(v)); }
+    void operator()(const std::string & v) { out.push_back("s" + v); }
+};
+
+TEST(VariantVector, visit_all_groups_by_type) {
+    variant_vector<int, std::string> vec;
+    vec.push_back(std::string("a"));
+    vec.push_back(1);
+    vec.push_back(std::string("b"));
+    vec.push_back(2);
+    std::vector<std::string> out;
+    vec.visit_all(describe{ out });
+    std::vector<std::string> expected = { "i1", "i2", "sa", "sb" };
+    ASSERT_EQ(expected, out);
+}
+
+TEST(VariantVector, visit_in_order) {
+    variant_vector<int, std::string> vec(true);
+    ASSERT_TRUE(vec.keeps_order());
+    vec.push_back(std::string("a"));
+    vec.push_back(1);
+    vec.push_back(std::string("b"));
+    vec.emplace_back<int>(2);
+    std::vector<std::string> out;
+    vec.visit_in_order(describe{ out });
+    std::vector<std::string> expected = { "sa", "i1", "sb", "i2" };
+    ASSERT_EQ(expected, out);
+    const variant_vector<int, std::string> & cvec = vec;
+    out.clear();
+    cvec.visit_in_order(describe{ out });
+    ASSERT_EQ(expected, out);
+}
+
+struct throws_on_copy {
+    int value;
+
+    explicit throws_on_copy(int v): value(v) {}
+    throws_on_copy(const throws_on_copy & rhs): value(rhs.value) {
+        if (value < 0) {
+            throw std::runtime_error("copy");
+        }
+    }
+};
+
+struct describe_throwing {
+    std::vector<int> & out;
+
+    void operator()(int v) { out.push_back(v); }
+    void operator()(const throws_on_copy & v) { out.push_back(100 + v.value); }
+};
+
+TEST(VariantVector, throwing_constructor_keeps_order_intact) {
+    variant_vector<int, throws_on_copy> vec(true);
+    vec.push_back(1);
+    vec.push_back(throws_on_copy(2));
+    const throws_on_copy bad(-1);
+    ASSERT_THROW(vec.push_back(bad), std::runtime_error);
+    ASSERT_THROW(vec.emplace_back<throws_on_copy>(bad), std::runtime_error);
+    vec.push_back(3);
+    ASSERT_EQ(3u, vec.size());
+    ASSERT_EQ(1u, vec.count<throws_on_copy>());
+    std::vector<int> out;
+    vec.visit_in_order(describe_throwing{ out });
+    std::vector<int> expected = { 1, 102, 3 };
+    ASSERT_EQ(expected, out);
+}
@@ -0,0 +1,154 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+// Mixed shape workload: sums the area of randomly interleaved circles, 
+// rectangles and triangles stored as a variant_vector, as a std::vector of 
+// variants and as a std::vector of unique_ptr to a common base.
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <typus/variant.hh>
+#include <typus/variant_vector.hh>
+
+namespace ty = typus;
+
+struct circle {
+    float r;
+};
+
+struct rect {
+    float w, h;
+};
+
+struct triangle {
+    float x0, y0, x1, y1, x2, y2;
+};
+
+struct area {
+    float operator()(const circle & c) const { 
+        return 3.14159265f * c.r * c.r; 
+    }
+    float operator()(const rect & r) const { 
+        return r.w * r.h; 
+    }
+    float operator()(const triangle & t) const {
+        return 0.5f * std::abs((t.x1 - t.x0) * (t.y2 - t.y0) - 
+                               (t.x2 - t.x0) * (t.y1 - t.y0));
+    }
+};
+
+struct shape {
+    virtual ~shape() = default;
+    virtual float area() const = 0;
+};
+
+template <typename T>
+struct shape_impl : shape {
+    explicit shape_impl(const T & v): value(v) {}
+    float area() const override { return ::area{}(value); }
+    T value;
+};
+
+// accumulates in a member, so visit_all can be used with a stateful visitor
+struct area_sum {
+    float sum = 0;
+
+    template <typename T>
+    void operator()(const T & s) { sum += area{}(s); }
+};
+
+template <typename F>
+double ns_per_shape(std::size_t n, float & checksum, F && func) {
+    auto start = std::chrono::steady_clock::now();
+    checksum = func();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / n;
+}
+
+int main(int argc, const char **argv) {
+    const std::size_t n = argc > 1 ? std::atoi(argv[1]) : 4000000;
+    using shape_variant = ty::variant<circle, rect, triangle>;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::uniform_int_distribution<int> kind(0, 2);
+
+    ty::variant_vector<circle, rect, triangle> partitioned;
+    std::vector<shape_variant> variants;
+    std::vector<std::unique_ptr<shape>> objects;
+    variants.reserve(n);
+    objects.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        switch (kind(rng)) {
+            case 0: {
+                circle c{ dist(rng) };
+                partitioned.push_back(c);
+                variants.emplace_back(c);
+                objects.emplace_back(new shape_impl<circle>(c));
+                break;
+            }
+            case 1: {
+                rect r{ dist(rng), dist(rng) };
+                partitioned.push_back(r);
+                variants.emplace_back(r);
+                objects.emplace_back(new shape_impl<rect>(r));
+                break;
+            }
+            default: {
+                triangle t{ dist(rng), dist(rng), dist(rng), 
+                            dist(rng), dist(rng), dist(rng) };
+                partitioned.push_back(t);
+                variants.emplace_back(t);
+                objects.emplace_back(new shape_impl<triangle>(t));
+                break;
+            }
+        }
+    }
+    float c1, c2, c3;
+    double by_type = ns_per_shape(n, c1, [&]() {
+        area_sum sum;
+        partitioned.visit_all(sum);
+        return sum.sum;
+    });
+    double by_variant = ns_per_shape(n, c2, [&]() {
+        float sum = 0;
+        for (const auto & v : variants) {
+            sum += v.visit(area{});
+        }
+        return sum;
+    });
+    double by_pointer = ns_per_shape(n, c3, [&]() {
+        float sum = 0;
+        for (const auto & o : objects) {
+            sum += o->area();
+        }
+        return sum;
+    });
+    std::cout << "container,ns_per_shape,bytes_per_shape,checksum\n"
+              << "variant_vector," << by_type << "," 
+              << (partitioned.count<circle>() * sizeof(circle) + 
+                  partitioned.count<rect>() * sizeof(rect) + 
+                  partitioned.count<triangle>() * sizeof(triangle)) / 
+                 static_cast<double>(n) << "," << c1 << "\n"
+              << "vector<variant>," << by_variant << "," 
+              << sizeof(shape_variant) << "," << c2 << "\n"
+              << "vector<unique_ptr>," << by_pointer << "," 
+              << sizeof(std::unique_ptr<shape>) << "+heap," << c3 << "\n";
+    return 0;
+}
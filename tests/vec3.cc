@@ -71,3 +71,9 @@ TEST(Vec3, swizzle) {
     ASSERT_EQ(vec3_f(3.0f, 2.0f, 1.0f), vec3_f(1.0f, 2.0f, 3.0f).zyx());
 }
 
+TEST(Vec3, cross) {
+    ASSERT_EQ(vec3_f(0.0f, 0.0f, 1.0f), 
+              cross(vec3_f(1.0f, 0.0f, 0.0f), vec3_f(0.0f, 1.0f, 0.0f)));
+    ASSERT_EQ(vec3_f(-3.0f, 6.0f, -3.0f), 
+              cross(vec3_f(1.0f, 2.0f, 3.0f), vec3_f(4.0f, 5.0f, 6.0f)));
+}
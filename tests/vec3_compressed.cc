@@ -0,0 +1,104 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/vec3_compressed.hh>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+TEST(Vec3H, arithmetic_and_conversion) {
+    vec3_h a(1.0f, 2.0f, 3.0f);
+    vec3_h b = to_vec3_h(vec3_f(0.5f, 0.25f, -1.0f));
+    a += b;
+    ASSERT_EQ(vec3_f(1.5f, 2.25f, 2.0f), to_vec3_f(a));
+    ASSERT_EQ(vec3_f(0.0f, 0.0f, 0.0f), to_vec3_f(vec3_h()));
+}
+
+TEST(Vec3H, bulk_encode_decode) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<f32> dist(-100.0f, 100.0f);
+    std::vector<vec3_f> points(13);
+    for (auto &p : points) {
+        p = vec3_f(dist(rng), dist(rng), dist(rng));
+    }
+    std::vector<vec3_h> halfs(points.size());
+    std::vector<vec3_f> decoded(points.size());
+    encode_f16(mem_view<const vec3_f>(points.data(), points.data() + points.size()),
+               mem_view<vec3_h>(halfs.data(), halfs.data() + halfs.size()));
+    decode_f16(mem_view<const vec3_h>(halfs.data(), halfs.data() + halfs.size()),
+               mem_view<vec3_f>(decoded.data(), decoded.data() + decoded.size()));
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        ASSERT_EQ(to_vec3_f(to_vec3_h(points[i])), decoded[i]);
+        // relative error of at most 2^-11 per component
+        ASSERT_LE(std::fabs(points[i].x - decoded[i].x), std::fabs(points[i].x) / 2048.0f);
+        ASSERT_LE(std::fabs(points[i].y - decoded[i].y), std::fabs(points[i].y) / 2048.0f);
+        ASSERT_LE(std::fabs(points[i].z - decoded[i].z), std::fabs(points[i].z) / 2048.0f);
+    }
+}
+
+TEST(Q16Quantizer, corners_and_clamping) {
+    q16_quantizer q(aabb_f(vec3_f(-1.0f, 0.0f, 10.0f), vec3_f(1.0f, 5.0f, 20.0f)));
+    vec3_q16 lo = q.encode(vec3_f(-1.0f, 0.0f, 10.0f));
+    vec3_q16 hi = q.encode(vec3_f(1.0f, 5.0f, 20.0f));
+    ASSERT_EQ(0, lo.x + lo.y + lo.z);
+    ASSERT_EQ(65535, hi.x);
+    ASSERT_EQ(65535, hi.y);
+    ASSERT_EQ(65535, hi.z);
+    ASSERT_EQ(lo, q.encode(vec3_f(-5.0f, -5.0f, -5.0f)));
+    ASSERT_EQ(hi, q.encode(vec3_f(50.0f, 50.0f, 50.0f)));
+    ASSERT_EQ(vec3_f(-1.0f, 0.0f, 10.0f), q.decode(lo));
+}
+
+TEST(Q16Quantizer, flat_axis) {
+    q16_quantizer q(aabb_f(vec3_f(0.0f, 2.0f, 0.0f), vec3_f(1.0f, 2.0f, 1.0f)));
+    vec3_f p(0.5f, 2.0f, 0.25f);
+    ASSERT_EQ(0, q.encode(p).y);
+    ASSERT_EQ(2.0f, q.decode(q.encode(p)).y);
+}
+
+TEST(Q16Quantizer, bulk_matches_scalar_within_error_bound) {
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<f32> dist(-1000.0f, 1000.0f);
+    std::vector<vec3_f> points(103);
+    aabb_f bounds;
+    for (auto &p : points) {
+        p = vec3_f(dist(rng), dist(rng) * 0.01f, dist(rng) + 5000.0f);
+        bounds.extend(p);
+    }
+    q16_quantizer q(bounds);
+    std::vector<vec3_q16> encoded(points.size());
+    std::vector<vec3_f> decoded(points.size());
+    q.encode(mem_view<const vec3_f>(points.data(), points.data() + points.size()),
+             mem_view<vec3_q16>(encoded.data(), encoded.data() + encoded.size()));
+    q.decode(mem_view<const vec3_q16>(encoded.data(), encoded.data() + encoded.size()),
+             mem_view<vec3_f>(decoded.data(), decoded.data() + decoded.size()));
+    // allow for f32 rounding on top of the quantization error
+    vec3_f bound = q.max_error() * 1.01f + vec3_f(1e-4f, 1e-4f, 1e-3f);
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        ASSERT_EQ(q.encode(points[i]), encoded[i]) << i;
+        vec3_f scalar = q.decode(encoded[i]);
+        ASSERT_NEAR(scalar.x, decoded[i].x, 1e-4f);
+        ASSERT_NEAR(scalar.y, decoded[i].y, 1e-4f);
+        ASSERT_NEAR(scalar.z, decoded[i].z, 1e-3f);
+        ASSERT_NEAR(points[i].x, decoded[i].x, bound.x);
+        ASSERT_NEAR(points[i].y, decoded[i].y, bound.y);
+        ASSERT_NEAR(points[i].z, decoded[i].z, bound.z);
+    }
+}
@@ -0,0 +1,165 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <typus/vec3_compressed.hh>
+
+namespace ty = typus;
+
+template <typename F>
+double time_ms(F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+struct error_stats {
+    double max = 0.0;
+    double rms = 0.0;
+};
+
+static error_stats reconstruction_error(const std::vector<ty::vec3_f> &points, 
+                                        const std::vector<ty::vec3_f> &decoded) {
+    error_stats e;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        double d = std::sqrt((points[i] - decoded[i]).normSquared());
+        e.max = std::max(e.max, d);
+        e.rms += d * d;
+    }
+    e.rms = std::sqrt(e.rms / points.size());
+    return e;
+}
+
+// The kernel is a centroid over all points, which is bound by memory 
+// bandwidth in f32 form. The compressed forms are decoded block by block 
+// into a buffer that stays in L1.
+template <typename Decode>
+static ty::vec3_f streaming_centroid(std::size_t n, Decode &&decode) {
+    const std::size_t block = 1024;
+    std::vector<ty::vec3_f> buffer(block);
+    double sx = 0.0, sy = 0.0, sz = 0.0;
+    for (std::size_t begin = 0; begin < n; begin += block) {
+        std::size_t count = std::min(block, n - begin);
+        ty::mem_view<ty::vec3_f> out(buffer.data(), buffer.data() + count);
+        decode(begin, out);
+        // twelve independent sums over the flat components, four per axis, 
+        // so the compiler can vectorize the loop
+        const ty::f32 *c = reinterpret_cast<const ty::f32*>(buffer.data());
+        ty::f32 sums[12] = {};
+        std::size_t i = 0;
+        for (; i + 12 <= 3 * count; i += 12) {
+            for (std::size_t j = 0; j < 12; ++j) {
+                sums[j] += c[i + j];
+            }
+        }
+        for (; i < 3 * count; ++i) {
+            sums[i % 3] += c[i];
+        }
+        for (std::size_t j = 0; j < 12; j += 3) {
+            sx += sums[j];
+            sy += sums[j + 1];
+            sz += sums[j + 2];
+        }
+    }
+    return ty::vec3_f(ty::f32(sx / n), ty::f32(sy / n), ty::f32(sz / n));
+}
+
+static void report(const char *name, std::size_t bytes, double ms, 
+                   const error_stats &error, const ty::vec3_f &centroid) {
+    std::cout << "  " << name << ": " << bytes / (1024 * 1024) << " MiB, centroid pass " 
+              << ms << " ms (" << bytes / ms / 1e6 << " GB/s of storage), error max " 
+              << error.max << " rms " << error.rms << ", centroid " << centroid 
+              << std::endl;
+}
+
+static void run(const char *label, std::size_t n, ty::f32 offset, ty::f32 extent) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<ty::f32> dist(offset, offset + extent);
+    std::vector<ty::vec3_f> points(n);
+    ty::aabb_f bounds;
+    for (auto &p : points) {
+        p = ty::vec3_f(dist(rng), dist(rng), dist(rng));
+        bounds.extend(p);
+    }
+    ty::mem_view<const ty::vec3_f> view(points.data(), points.data() + n);
+    std::vector<ty::vec3_f> decoded(n);
+    ty::mem_view<ty::vec3_f> decoded_view(decoded.data(), decoded.data() + n);
+
+    std::vector<ty::vec3_h> halfs(n);
+    ty::mem_view<ty::vec3_h> half_view(halfs.data(), halfs.data() + n);
+    double f16_encode_ms = time_ms([&]() { ty::encode_f16(view, half_view); });
+    double f16_decode_ms = time_ms([&]() { 
+        ty::decode_f16(ty::mem_view<const ty::vec3_h>(halfs.data(), halfs.data() + n), 
+                       decoded_view); 
+    });
+    error_stats f16_error = reconstruction_error(points, decoded);
+
+    ty::q16_quantizer quantizer(bounds);
+    std::vector<ty::vec3_q16> quantized(n);
+    ty::mem_view<ty::vec3_q16> q16_view(quantized.data(), quantized.data() + n);
+    double q16_encode_ms = time_ms([&]() { quantizer.encode(view, q16_view); });
+    double q16_decode_ms = time_ms([&]() { 
+        quantizer.decode(ty::mem_view<const ty::vec3_q16>(quantized.data(), 
+                                                          quantized.data() + n), 
+                         decoded_view); 
+    });
+    error_stats q16_error = reconstruction_error(points, decoded);
+
+    ty::vec3_f c32, c16, cq16;
+    double f32_ms = time_ms([&]() {
+        c32 = streaming_centroid(n, [&](std::size_t begin, ty::mem_view<ty::vec3_f> out) {
+            std::copy(points.begin() + begin, points.begin() + begin + out.size(), 
+                      out.begin());
+        });
+    });
+    double f16_ms = time_ms([&]() {
+        c16 = streaming_centroid(n, [&](std::size_t begin, ty::mem_view<ty::vec3_f> out) {
+            ty::decode_f16(ty::mem_view<const ty::vec3_h>(halfs.data() + begin, 
+                                                          halfs.data() + begin + out.size()), 
+                           out);
+        });
+    });
+    double q16_ms = time_ms([&]() {
+        cq16 = streaming_centroid(n, [&](std::size_t begin, ty::mem_view<ty::vec3_f> out) {
+            quantizer.decode(ty::mem_view<const ty::vec3_q16>(quantized.data() + begin, 
+                                                              quantized.data() + begin + out.size()), 
+                             out);
+        });
+    });
+
+    std::cout << label << ", bounds " << bounds << std::endl;
+    std::cout << "  encode f16 " << f16_encode_ms << " ms, q16 " << q16_encode_ms 
+              << " ms; decode f16 " << f16_decode_ms << " ms, q16 " << q16_decode_ms 
+              << " ms" << std::endl;
+    report("f32", n * sizeof(ty::vec3_f), f32_ms, error_stats(), c32);
+    report("f16", n * sizeof(ty::vec3_h), f16_ms, f16_error, c16);
+    report("q16", n * sizeof(ty::vec3_q16), q16_ms, q16_error, cq16);
+}
+
+int main(int argc, const char **argv) {
+    const std::size_t n = argc > 1 ? std::atoll(argv[1]) : 10000000;
+    std::cout << n << " points" << std::endl;
+    run("around the origin", n, -50.0f, 100.0f);
+    run("far from the origin", n, 10000.0f, 100.0f);
+    return 0;
+}
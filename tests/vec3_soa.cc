@@ -0,0 +1,126 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/vec3_soa.hh>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+namespace {
+
+// a size that is not a multiple of any SIMD width, so the scalar tail runs
+const std::size_t N = 37;
+
+vec3_f test_vec(std::size_t i) {
+    return vec3_f(f32(i) * 0.5f + 1.0f, 2.0f - f32(i), f32(i % 7) + 0.25f);
+}
+
+vec3_soa_f make_soa(std::size_t n, std::size_t offset) {
+    vec3_soa_f soa;
+    for (std::size_t i = 0; i < n; ++i) {
+        soa.push_back(test_vec(i + offset));
+    }
+    return soa;
+}
+
+void expect_near(const vec3_f &expected, const vec3_f &actual) {
+    EXPECT_NEAR(expected.x, actual.x, 1e-5f);
+    EXPECT_NEAR(expected.y, actual.y, 1e-5f);
+    EXPECT_NEAR(expected.z, actual.z, 1e-5f);
+}
+
+}
+
+TEST(Vec3Soa, storage) {
+    vec3_soa_f soa(N);
+    ASSERT_EQ(N, soa.size());
+    ASSERT_EQ(0u, reinterpret_cast<std::size_t>(soa.x()) % 64);
+    ASSERT_EQ(0u, reinterpret_cast<std::size_t>(soa.y()) % 64);
+    ASSERT_EQ(0u, reinterpret_cast<std::size_t>(soa.z()) % 64);
+    soa.set(3, vec3_f(1.0f, 2.0f, 3.0f));
+    ASSERT_EQ(vec3_f(1.0f, 2.0f, 3.0f), soa[3]);
+    ASSERT_EQ(vec3_f(), soa[4]);
+    soa.clear();
+    ASSERT_TRUE(soa.empty());
+}
+
+TEST(Vec3Soa, transpose) {
+    std::vector<vec3_f> aos;
+    for (std::size_t i = 0; i < N; ++i) {
+        aos.push_back(test_vec(i));
+    }
+    vec3_soa_f soa;
+    to_soa(mem_view<const vec3_f>(aos.data(), aos.data() + aos.size()), soa);
+    ASSERT_EQ(N, soa.size());
+    for (std::size_t i = 0; i < N; ++i) {
+        ASSERT_EQ(aos[i], soa[i]);
+    }
+    std::vector<vec3_f> back(N);
+    to_aos(soa, mem_view<vec3_f>(back.data(), back.data() + back.size()));
+    ASSERT_EQ(aos, back);
+}
+
+TEST(Vec3Soa, kernels_match_scalar_vec3) {
+    vec3_soa_f a = make_soa(N, 0), b = make_soa(N, 5), out;
+    std::vector<f32> scalars(N);
+    mem_view<f32> scalar_view(scalars.data(), scalars.data() + N);
+
+    add(a, b, out);
+    for (std::size_t i = 0; i < N; ++i) {
+        expect_near(a[i] + b[i], out[i]);
+    }
+    scale(a, 3.0f, out);
+    for (std::size_t i = 0; i < N; ++i) {
+        expect_near(a[i] * 3.0f, out[i]);
+    }
+    cross(a, b, out);
+    for (std::size_t i = 0; i < N; ++i) {
+        expect_near(cross(a[i], b[i]), out[i]);
+    }
+    normalize(a, out);
+    for (std::size_t i = 0; i < N; ++i) {
+        expect_near(a[i].normalized(), out[i]);
+    }
+    reflect(a, b, out);
+    for (std::size_t i = 0; i < N; ++i) {
+        expect_near(reflect(a[i], b[i]), out[i]);
+    }
+    dot(a, b, scalar_view);
+    for (std::size_t i = 0; i < N; ++i) {
+        EXPECT_NEAR(dot(a[i], b[i]), scalars[i], 1e-4f);
+    }
+    norm(a, scalar_view);
+    for (std::size_t i = 0; i < N; ++i) {
+        EXPECT_NEAR(a[i].norm(), scalars[i], 1e-5f);
+    }
+}
+
+TEST(Vec3Soa, in_place_and_double) {
+    vec3_soa<f64> a;
+    for (std::size_t i = 0; i < N; ++i) {
+        vec3_f v = test_vec(i);
+        a.push_back(vec3<f64>(v.x, v.y, v.z));
+    }
+    vec3_soa<f64> expected = a;
+    normalize(a, a);
+    // vec3::normalize computes the norm in f32, hence the tolerance
+    for (std::size_t i = 0; i < N; ++i) {
+        EXPECT_NEAR(expected[i].normalized().x, a[i].x, 1e-6);
+        EXPECT_NEAR(expected[i].normalized().z, a[i].z, 1e-6);
+    }
+}
@@ -0,0 +1,94 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <typus/vec3_soa.hh>
+
+namespace ty = typus;
+
+template <typename F>
+double time_ns_per_vec(std::size_t n, int repeats, F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        f();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / 
+           (double(repeats) * n);
+}
+
+// Per-element vec3_f math over arrays of vec3_f compared to the batch 
+// kernels on vec3_soa_f.
+int main(int argc, const char **argv) {
+    const std::size_t n = argc > 1 ? std::atoll(argv[1]) : 1000000;
+    const int repeats = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<ty::f32> dist(-1.0f, 1.0f);
+    std::vector<ty::vec3_f> a(n), b(n), out(n);
+    std::vector<ty::f32> scalars(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        a[i] = ty::vec3_f(dist(rng), dist(rng), dist(rng));
+        b[i] = ty::vec3_f(dist(rng), dist(rng), dist(rng));
+    }
+    ty::vec3_soa_f sa, sb, sout;
+    ty::to_soa(ty::mem_view<const ty::vec3_f>(a.data(), a.data() + n), sa);
+    ty::to_soa(ty::mem_view<const ty::vec3_f>(b.data(), b.data() + n), sb);
+    ty::mem_view<ty::f32> scalar_view(scalars.data(), scalars.data() + n);
+
+    double aos_add = time_ns_per_vec(n, repeats, [&]() {
+        for (std::size_t i = 0; i < n; ++i) { out[i] = a[i] + b[i]; }
+    });
+    double soa_add = time_ns_per_vec(n, repeats, [&]() { 
+        ty::add(sa, sb, sout); 
+    });
+    double aos_dot = time_ns_per_vec(n, repeats, [&]() {
+        for (std::size_t i = 0; i < n; ++i) { scalars[i] = ty::dot(a[i], b[i]); }
+    });
+    double soa_dot = time_ns_per_vec(n, repeats, [&]() { 
+        ty::dot(sa, sb, scalar_view); 
+    });
+    double aos_normalize = time_ns_per_vec(n, repeats, [&]() {
+        for (std::size_t i = 0; i < n; ++i) { out[i] = a[i].normalized(); }
+    });
+    double soa_normalize = time_ns_per_vec(n, repeats, [&]() { 
+        ty::normalize(sa, sout); 
+    });
+    double aos_reflect = time_ns_per_vec(n, repeats, [&]() {
+        for (std::size_t i = 0; i < n; ++i) { out[i] = ty::reflect(a[i], b[i]); }
+    });
+    double soa_reflect = time_ns_per_vec(n, repeats, [&]() { 
+        ty::reflect(sa, sb, sout); 
+    });
+    double transpose = time_ns_per_vec(n, repeats, [&]() {
+        ty::to_aos(sout, ty::mem_view<ty::vec3_f>(out.data(), out.data() + n));
+    });
+
+    std::cout << n << " vectors, ns per vector (vec3_f / vec3_soa_f)\n"
+              << "  add:       " << aos_add << " / " << soa_add << "\n"
+              << "  dot:       " << aos_dot << " / " << soa_dot << "\n"
+              << "  normalize: " << aos_normalize << " / " << soa_normalize << "\n"
+              << "  reflect:   " << aos_reflect << " / " << soa_reflect << "\n"
+              << "  to_aos:    " << transpose << "\n";
+    if (out[0].x != out[0].x) {
+        std::cerr << "unexpected NaN\n";
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <typus/vec3a.hh>
+
+#include <cmath>
+#include <type_traits>
+
+#include <gtest/gtest.h>
+
+using namespace typus;
+
+static_assert(sizeof(vec3a_f) == 16 && alignof(vec3a_f) == 16, 
+              "vec3a_f must fit a SIMD register");
+static_assert(std::is_trivially_copyable<vec3a_f>::value, 
+              "vec3a_f must be trivially copyable");
+
+template <typename T>
+class Vec3a : public ::testing::Test {};
+
+using Vec3aTypes = ::testing::Types<f32, f64>;
+TYPED_TEST_SUITE(Vec3a, Vec3aTypes);
+
+TYPED_TEST(Vec3a, construction) {
+    using V = vec3a<TypeParam>;
+    V v;
+    ASSERT_EQ(TypeParam(0), v.x());
+    ASSERT_EQ(TypeParam(0), v.z());
+    V w(1, 2, 3);
+    ASSERT_EQ(TypeParam(1), w.x());
+    ASSERT_EQ(TypeParam(2), w.y());
+    ASSERT_EQ(TypeParam(3), w.z());
+    ASSERT_EQ(vec3<TypeParam>(1, 2, 3), w.to_vec3());
+    ASSERT_EQ(w, V(vec3<TypeParam>(1, 2, 3)));
+}
+
+TYPED_TEST(Vec3a, arithmetic) {
+    using V = vec3a<TypeParam>;
+    V a(1, 2, 3), b(4, 5, 6);
+    ASSERT_EQ(V(5, 7, 9), a + b);
+    ASSERT_EQ(V(3, 3, 3), b - a);
+    ASSERT_EQ(V(2, 4, 6), a * TypeParam(2));
+    ASSERT_EQ(V(2, 4, 6), TypeParam(2) * a);
+    V c(b);
+    c /= TypeParam(2);
+    ASSERT_EQ(V(2, TypeParam(2.5), 3), c);
+    ASSERT_NE(a, b);
+    ASSERT_EQ(TypeParam(32), dot(a, b));
+    ASSERT_EQ(TypeParam(14), a.normSquared());
+    ASSERT_EQ(V(-3, 6, -3), cross(a, b));
+}
+
+TYPED_TEST(Vec3a, normalize) {
+    using V = vec3a<TypeParam>;
+    V v(2, 3, 6);
+    V n = v.normalized();
+    ASSERT_NEAR(7.0, v.norm(), 1e-5);
+    ASSERT_NEAR(7.0, v.normalize(), 1e-5);
+    ASSERT_EQ(n, v);
+    ASSERT_NEAR(2.0 / 7.0, v.x(), 1e-6);
+    ASSERT_NEAR(3.0 / 7.0, v.y(), 1e-6);
+    ASSERT_NEAR(6.0 / 7.0, v.z(), 1e-6);
+    // (2 * dot(v, n) * n - v).normalized() = (-1, 2, -3) / sqrt(14)
+    V r = reflect(V(1, 2, 3), V(0, 1, 0));
+    ASSERT_NEAR(-1.0 / std::sqrt(14.0), r.x(), 1e-6);
+    ASSERT_NEAR(2.0 / std::sqrt(14.0), r.y(), 1e-6);
+    ASSERT_NEAR(-3.0 / std::sqrt(14.0), r.z(), 1e-6);
+}
+
+TYPED_TEST(Vec3a, swizzle) {
+    using V = vec3a<TypeParam>;
+    ASSERT_EQ(V(1, 1, 1), V(1, 2, 3).xxx());
+    ASSERT_EQ(V(2, 2, 2), V(1, 2, 3).yyy());
+    ASSERT_EQ(V(3, 3, 3), V(1, 2, 3).zzz());
+    ASSERT_EQ(V(3, 2, 1), V(1, 2, 3).zyx());
+    // the padding stays zero
+    ASSERT_EQ(TypeParam(9), dot(V(1, 2, 3).zzz(), V(1, 0, 0).xxx()));
+}
@@ -0,0 +1,124 @@
+// -----------------------------------------------------------------------------
+// Copyright 2016 Marco Biasini
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//  
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// -----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <typus/vec3a.hh>
+
+namespace ty = typus;
+
+template <typename F>
+double time_ns_per_vec(std::size_t n, int repeats, F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        f();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / 
+           (double(repeats) * n);
+}
+
+template <typename V>
+V make(ty::f32 x, ty::f32 y, ty::f32 z) { return V(x, y, z); }
+
+inline ty::f32 get_x(const ty::vec3_f &v) { return v.x; }
+inline ty::f32 get_x(const ty::vec3a_f &v) { return v.x(); }
+
+// The same transform kernels, instantiated for vec3_f and vec3a_f.
+template <typename V>
+struct workloads {
+    std::vector<V> points, normals, out;
+    V center, offset;
+
+    // move to the origin, scale and translate
+    void rigid() {
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            out[i] = (points[i] - center) * 0.5f + offset;
+        }
+    }
+
+    void normalize() {
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            out[i] = (points[i] - center).normalized();
+        }
+    }
+
+    void reflect() {
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            out[i] = ty::reflect(points[i], normals[i]);
+        }
+    }
+
+    // face normals of the triangles (center, p[i], p[i + 1])
+    void face_normals() {
+        for (std::size_t i = 0; i + 1 < points.size(); ++i) {
+            out[i] = ty::cross(points[i] - center, points[i + 1] - center);
+        }
+    }
+
+    ty::f32 checksum() const {
+        ty::f32 sum = 0.0f;
+        for (const V &v : out) {
+            sum += get_x(v);
+        }
+        return sum;
+    }
+};
+
+template <typename V>
+workloads<V> make_workloads(std::size_t n) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<ty::f32> dist(-1.0f, 1.0f);
+    workloads<V> w;
+    for (std::size_t i = 0; i < n; ++i) {
+        w.points.push_back(make<V>(dist(rng), dist(rng), dist(rng)));
+        w.normals.push_back(make<V>(dist(rng), dist(rng), dist(rng)).normalized());
+    }
+    w.out.resize(n);
+    w.center = make<V>(0.1f, 0.2f, 0.3f);
+    w.offset = make<V>(1.0f, 2.0f, 3.0f);
+    return w;
+}
+
+int main(int argc, const char **argv) {
+    const std::size_t n = argc > 1 ? std::atoll(argv[1]) : 100000;
+    const int repeats = argc > 2 ? std::atoi(argv[2]) : 100;
+
+    auto s = make_workloads<ty::vec3_f>(n);
+    auto a = make_workloads<ty::vec3a_f>(n);
+
+    double rigid_s = time_ns_per_vec(n, repeats, [&]() { s.rigid(); });
+    double rigid_a = time_ns_per_vec(n, repeats, [&]() { a.rigid(); });
+    double normalize_s = time_ns_per_vec(n, repeats, [&]() { s.normalize(); });
+    double normalize_a = time_ns_per_vec(n, repeats, [&]() { a.normalize(); });
+    double reflect_s = time_ns_per_vec(n, repeats, [&]() { s.reflect(); });
+    double reflect_a = time_ns_per_vec(n, repeats, [&]() { a.reflect(); });
+    double normals_s = time_ns_per_vec(n, repeats, [&]() { s.face_normals(); });
+    double normals_a = time_ns_per_vec(n, repeats, [&]() { a.face_normals(); });
+
+    std::cout << n << " vectors, ns per vector (vec3_f / vec3a_f)\n"
+              << "  scale+translate: " << rigid_s << " / " << rigid_a << "\n"
+              << "  normalize:       " << normalize_s << " / " << normalize_a << "\n"
+              << "  reflect:         " << reflect_s << " / " << reflect_a << "\n"
+              << "  face normals:    " << normals_s << " / " << normals_a << "\n";
+    if (s.checksum() != s.checksum() || a.checksum() != a.checksum()) {
+        std::cerr << "unexpected NaN\n";
+    }
+    return 0;
+}